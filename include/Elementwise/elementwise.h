@@ -0,0 +1,182 @@
+#ifndef ELEMENTWISE_ELEMENTWISE_H
+#define ELEMENTWISE_ELEMENTWISE_H
+
+#include <CL/cl.h>
+
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace elementwise
+{
+    enum class ElementType
+    {
+        Float,
+        Int,
+        Uint
+    };
+
+    enum class ArgKind
+    {
+        Input,  // A buffer that is only read.
+        Output, // A buffer that is only written.
+        InOut,  // A buffer that is read, then written.
+        Scalar  // One value shared by every element.
+    };
+
+    struct Arg
+    {
+        std::string name;
+        ElementType type;
+        ArgKind     kind;
+    };
+
+    // An operation applied independently to each element, e.g. "z = a * x + y". The body is OpenCL C written in terms
+    // of the argument names. Each work-item evaluates it once on vectors of `vectorWidth` elements and scalar
+    // arguments, so it must also be valid for vectors: write float literals with the `f` suffix, as in
+    // "max(x, 0.0f)". OpenCL C has no overload of `max` taking a float vector and an int literal.
+    struct Definition
+    {
+        std::string      name;
+        std::string      body;
+        std::vector<Arg> args;
+        cl_uint          vectorWidth;
+    };
+
+    [[nodiscard]] cl_int GenerateSource(const Definition& definition,
+                                        std::string&      clSource);
+
+    // A built elementwise operation. Launches set kernel arguments, so one `Kernel` must not be launched from several
+    // threads at once.
+    class Kernel
+    {
+    public:
+        Kernel() = default;
+        ~Kernel() noexcept;
+
+        Kernel(Kernel&& other) noexcept;
+        Kernel& operator=(Kernel&& other) noexcept;
+
+        Kernel(const Kernel&)            = delete;
+        Kernel& operator=(const Kernel&) = delete;
+
+        // Generates, then builds the operation through `program::Build`, so its binaries are cached like any other.
+        [[nodiscard]] cl_int Build(cl_context        context,
+                                   const Definition& definition);
+
+        void Release() noexcept;
+
+        [[nodiscard]] cl_int SetArg(cl_uint     index,
+                                    size_t      sizeInBytes,
+                                    const void* pValue);
+
+        // Launches over `len` elements, once the arguments of the definition have been set.
+        [[nodiscard]] cl_int Enqueue(cl_command_queue          queue,
+                                     size_t                    len,
+                                     std::span<const cl_event> eventsToWaitOn,
+                                     cl_event&                 complete);
+
+    private:
+        cl_program m_program     = nullptr;
+        cl_kernel  m_kernel      = nullptr;
+        cl_uint    m_nArgs       = 0;
+        cl_uint    m_vectorWidth = 1;
+    };
+
+
+    template<typename T>
+    inline constexpr bool IsElement = std::is_same_v<T, cl_float> ||
+                                      std::is_same_v<T, cl_int>   ||
+                                      std::is_same_v<T, cl_uint>;
+
+    template<ArgKind Kind, typename T>
+    struct TypedArg
+    {
+        static_assert(IsElement<T>, "Elementwise arguments are float, int or uint.");
+
+        // What a launch passes for the argument: a buffer, or the value of a scalar.
+        using LaunchType = std::conditional_t<Kind == ArgKind::Scalar, T, cl_mem>;
+
+        std::string name;
+    };
+
+    template<typename T> using Input  = TypedArg<ArgKind::Input,  T>;
+    template<typename T> using Output = TypedArg<ArgKind::Output, T>;
+    template<typename T> using InOut  = TypedArg<ArgKind::InOut,  T>;
+    template<typename T> using Scalar = TypedArg<ArgKind::Scalar, T>;
+
+
+    // Launches an elementwise operation with arguments checked at compile time against its definition.
+    template<typename... LaunchArgs>
+    class Launcher
+    {
+    public:
+        [[nodiscard]] Kernel& GetKernel() noexcept { return m_kernel; }
+
+        [[nodiscard]] cl_int Enqueue(const cl_command_queue          queue,
+                                     const size_t                    len,
+                                     const std::span<const cl_event> eventsToWaitOn,
+                                     cl_event&                       complete,
+                                     const LaunchArgs&...            args)
+        {
+            cl_int  result = CL_SUCCESS;
+            cl_uint index  = 0;
+
+            ((result = (result == CL_SUCCESS) ? m_kernel.SetArg(index++, sizeof(args), &args) : result), ...);
+
+            if (result != CL_SUCCESS)
+            {
+                return result;
+            }
+
+            return m_kernel.Enqueue(queue, len, eventsToWaitOn, complete);
+        }
+
+    private:
+        Kernel m_kernel = {};
+    };
+
+
+    template<typename T>
+    [[nodiscard]] constexpr ElementType GetElementType() noexcept
+    {
+        if constexpr (std::is_same_v<T, cl_float>)
+        {
+            return ElementType::Float;
+        }
+        else if constexpr (std::is_same_v<T, cl_int>)
+        {
+            return ElementType::Int;
+        }
+        else
+        {
+            return ElementType::Uint;
+        }
+    }
+
+    // E.g. `Create(context, "axpy", "z = a * x + y", 4, launcher, Scalar<float>{ "a" }, Input<float>{ "x" },
+    // Input<float>{ "y" }, Output<float>{ "z" })` with a `Launcher<float, cl_mem, cl_mem, cl_mem>`.
+    template<ArgKind... Kinds, typename... Types>
+    [[nodiscard]] cl_int Create(const cl_context                                          context,
+                                const std::string&                                        name,
+                                const std::string&                                        body,
+                                const cl_uint                                             vectorWidth,
+                                Launcher<typename TypedArg<Kinds, Types>::LaunchType...>& launcher,
+                                const TypedArg<Kinds, Types>&...                          args)
+    {
+        const Definition definition =
+        {
+            .name        = name,
+            .body        = body,
+            .args        = { Arg{ .name = args.name, .type = GetElementType<Types>(), .kind = Kinds }... },
+            .vectorWidth = vectorWidth
+        };
+
+        return launcher.GetKernel().Build(context, definition);
+    }
+}
+
+
+#endif // ELEMENTWISE_ELEMENTWISE_H
\ No newline at end of file
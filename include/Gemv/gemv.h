@@ -0,0 +1,80 @@
+#ifndef GEMV_GEMV_H
+#define GEMV_GEMV_H
+
+#include <CL/cl.h>
+
+#include <span>
+
+
+namespace gemv
+{
+    enum class Layout
+    {
+        RowMajor,
+        ColumnMajor
+    };
+
+    // y = alpha * A * x + beta * y, where A is m x n, x has n elements and y has m. The leading dimension is in
+    // elements: between consecutive rows of row-major, and columns of column-major, storage.
+    struct Problem
+    {
+        Layout layout;
+        size_t m;
+        size_t n;
+        float  alpha;
+        float  beta;
+        size_t lda;
+    };
+
+    // The matrices of a batch all share the shape of one problem, and follow each other `strideA` elements apart,
+    // as do the vectors at `strideX` and `strideY`.
+    struct Batch
+    {
+        size_t count;
+        size_t strideA;
+        size_t strideX;
+        size_t strideY;
+    };
+
+    // `gemvKernels` are created from `build::gemv::clKernelNames`. Row-major problems run one work-group per row,
+    // reducing in local memory; column-major ones one work-item per row, walking the columns in blocks. Problems of
+    // more than `launch::MaxWorkItemsPerLaunch` work-items are split into launches at increasing global offsets, and
+    // `gemvComplete` always covers the whole problem. A `beta` of zero leaves y unread.
+    [[nodiscard]] cl_int EnqueueKernel(const Problem&             problem,
+                                       cl_mem                     aDevice,
+                                       cl_mem                     xDevice,
+                                       cl_mem                     yDevice,
+                                       cl_command_queue           gemvQueue,
+                                       std::span<const cl_kernel> gemvKernels,
+                                       std::span<const cl_event>  eventsToWaitOn,
+                                       cl_event&                  gemvComplete);
+
+    // Runs every problem of `batch` in one go, with one work-item per row of each matrix, for the many small
+    // matrices that would leave most of the device idle one at a time.
+    [[nodiscard]] cl_int EnqueueKernel(const Problem&             problem,
+                                       const Batch&               batch,
+                                       cl_mem                     aDevice,
+                                       cl_mem                     xDevice,
+                                       cl_mem                     yDevice,
+                                       cl_command_queue           gemvQueue,
+                                       std::span<const cl_kernel> gemvKernels,
+                                       std::span<const cl_event>  eventsToWaitOn,
+                                       cl_event&                  gemvComplete);
+
+    // The number of elements A spans in memory, given its leading dimension.
+    [[nodiscard]] size_t GetSizeA(const Problem& problem) noexcept;
+
+    void HostExec(const Problem& problem,
+                  const float*   pAHost,
+                  const float*   pXHost,
+                  float*         pYHost);
+
+    void HostExec(const Problem& problem,
+                  const Batch&   batch,
+                  const float*   pAHost,
+                  const float*   pXHost,
+                  float*         pYHost);
+}
+
+
+#endif // GEMV_GEMV_H
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef SAXPY_COALESCER_H
+#define SAXPY_COALESCER_H
+
+#include <CL/cl.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+
+namespace saxpy
+{
+    // Accumulates many small saxpy requests and flushes them as one packed launch per distinct `a`, once enough
+    // elements are pending or the oldest request has waited long enough. This trades a bounded delay for throughput.
+    class Coalescer
+    {
+    public:
+        struct Options
+        {
+            size_t                    maxBatchSizeInElements;
+            std::chrono::microseconds maxDelay;
+        };
+
+        struct Statistics
+        {
+            size_t                    nRequests;
+            size_t                    nLaunches;
+            std::chrono::microseconds p50Latency;
+            std::chrono::microseconds p99Latency;
+        };
+
+        // Flushes are enqueued on `queue` with `kernel`, which must not be used elsewhere while the coalescer lives.
+        Coalescer(cl_context       context,
+                  cl_command_queue queue,
+                  cl_kernel        kernel,
+                  const Options&   options);
+
+        // Flushes the requests still pending.
+        ~Coalescer() noexcept;
+
+        Coalescer(const Coalescer&)            = delete;
+        Coalescer& operator=(const Coalescer&) = delete;
+
+        // The spans must stay valid until the returned future, which yields the result of the request's launch, is
+        // ready. Once it is, `z` holds a * x + y.
+        [[nodiscard]] std::future<cl_int> Submit(float                  a,
+                                                 std::span<const float> x,
+                                                 std::span<const float> y,
+                                                 std::span<float>       z);
+
+        // Latencies span submission to completion, over the most recent requests.
+        [[nodiscard]] Statistics GetStatistics() const;
+
+    private:
+        struct Request
+        {
+            float                                 a;
+            std::span<const float>                x;
+            std::span<const float>                y;
+            std::span<float>                      z;
+            std::promise<cl_int>                  completion;
+            std::chrono::steady_clock::time_point submitted;
+        };
+
+        void FlushContinuously();
+        void Flush(std::vector<Request>& batch);
+        void Launch(std::span<Request* const> group);
+        void RecordLatencies(std::span<Request* const> group,
+                             bool                      launched);
+
+        const cl_context       m_context;
+        const cl_command_queue m_queue;
+        const cl_kernel        m_kernel;
+        const Options          m_options;
+
+        std::mutex              m_mutex             = {};
+        std::condition_variable m_requestsAvailable = {};
+        std::vector<Request>    m_pending           = {};
+        size_t                  m_pendingElements   = 0;
+        bool                    m_stopping          = false;
+
+        mutable std::mutex                     m_statisticsMutex = {};
+        std::vector<std::chrono::microseconds> m_latencies       = {};
+        size_t                                 m_nRequests       = 0;
+        size_t                                 m_nLaunches       = 0;
+
+        // Started last, once every other member is initialized.
+        std::thread m_flushThread = {};
+    };
+}
+
+
+#endif // SAXPY_COALESCER_H
\ No newline at end of file
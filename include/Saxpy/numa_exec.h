@@ -0,0 +1,78 @@
+#ifndef SAXPY_NUMA_EXEC_H
+#define SAXPY_NUMA_EXEC_H
+
+#include "memory.h"
+
+#include <CL/cl.h>
+
+#include <span>
+#include <vector>
+
+
+namespace saxpy
+{
+    // Executes saxpy on a CPU device partitioned into one sub-device per NUMA node. The vectors are split into one
+    // slice per sub-device, whose pages it touches first so they land on its node, and no core streams memory across
+    // sockets.
+    // Devices that cannot be partitioned by NUMA node, or hosts with a single node, compute as one partition.
+    class NumaExec
+    {
+    public:
+        NumaExec() = default;
+        ~NumaExec() noexcept;
+
+        NumaExec(const NumaExec&)            = delete;
+        NumaExec& operator=(const NumaExec&) = delete;
+
+        // Creates a context over the sub-devices of `device`, builds saxpy for it, and allocates `len` elements of
+        // each vector, split across the partitions by their compute units. Without `partitionByNuma`, the device
+        // computes as one partition, e.g. as a baseline.
+        [[nodiscard]] cl_int Init(cl_device_id device,
+                                  size_t       len,
+                                  bool         partitionByNuma = true);
+
+        void Release() noexcept;
+
+        struct Slice
+        {
+            std::span<float> x;
+            std::span<float> y;
+            std::span<float> z;
+        };
+
+        // Slices are consecutive in element order. The caller fills `x` and `y` from a thread of any node, which
+        // leaves the pages where they are.
+        [[nodiscard]] Slice GetSlice(size_t partition) const noexcept;
+
+        // Returns once every `z` slice holds its result.
+        [[nodiscard]] cl_int Exec(float a);
+
+        [[nodiscard]] size_t GetPartitionCount() const noexcept { return m_partitions.size(); }
+        [[nodiscard]] bool   IsNumaPartitioned() const noexcept { return m_ownsSubDevices; }
+
+    private:
+        struct Partition
+        {
+            cl_device_id           device  = nullptr;
+            cl_command_queue       queue   = nullptr;
+            cl_kernel              kernel  = nullptr;
+            memory::HostAllocation xHost   = {};
+            memory::HostAllocation yHost   = {};
+            memory::HostAllocation zHost   = {};
+            cl_mem                 xDevice = nullptr;
+            cl_mem                 yDevice = nullptr;
+            cl_mem                 zDevice = nullptr;
+            size_t                 len     = 0;
+        };
+
+        [[nodiscard]] cl_int InitPartition(Partition& partition);
+
+        cl_context             m_context        = nullptr;
+        cl_program             m_program        = nullptr;
+        std::vector<Partition> m_partitions     = {};
+        bool                   m_ownsSubDevices = false;
+    };
+}
+
+
+#endif // SAXPY_NUMA_EXEC_H
\ No newline at end of file
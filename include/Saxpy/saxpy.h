@@ -3,11 +3,46 @@
 
 #include <CL/cl.h>
 
+#include <optional>
 #include <span>
+#include <stdint.h>
+#include <string>
+
+
+namespace concurrency
+{
+    class ThreadPool;
+}
 
 
 namespace saxpy
 {
+    // Values baked into a specialized saxpy program through "-D" build options.
+    struct Specialization
+    {
+        std::optional<float> a;           // Replaces the `a` argument, which the kernel then ignores.
+        bool                 exactLaunch; // Launches cover exactly `len` elements, so bounds checks go.
+        cl_uint              vectorWidth; // 1, 2, 4, 8 or 16.
+        cl_uint              unroll;      // Vectors per work-item.
+    };
+
+    // Limits below those of the device, e.g. to run small problems as several launches and buffers.
+    struct Limits
+    {
+        size_t maxWorkItemsPerLaunch;
+        size_t maxElementsPerBuffer;
+    };
+
+    // Leaves every limit to the device.
+    inline constexpr Limits DeviceLimits =
+    {
+        .maxWorkItemsPerLaunch = SIZE_MAX,
+        .maxElementsPerBuffer  = SIZE_MAX
+    };
+
+    [[nodiscard]] cl_int GetSpecializationOptions(const Specialization& specialization,
+                                                  std::string&          clBuildOptions);
+
     [[nodiscard]] cl_int EnqueueKernel(float                     a,
                                        cl_mem                    xDevice,
                                        cl_mem                    yDevice,
@@ -18,11 +53,70 @@ namespace saxpy
                                        std::span<const cl_event> eventsToWaitOn,
                                        cl_event&                 saxpyComplete);
 
+    // Launches a kernel built with the options of `specialization`. An exact launch requires `len` to be a multiple of
+    // `vectorWidth * unroll`. It enqueues exactly the work-items needed: in one launch with non-uniform work-groups on
+    // devices supporting them, otherwise in a uniform main launch plus a tail launch of a single smaller work-group.
+    // Problems of more than `launch::MaxWorkItemsPerLaunch` work-items are split into launches at increasing global
+    // offsets. `saxpyComplete` always covers the whole problem.
+    [[nodiscard]] cl_int EnqueueKernel(const Specialization&     specialization,
+                                       float                     a,
+                                       cl_mem                    xDevice,
+                                       cl_mem                    yDevice,
+                                       cl_mem                    zDevice,
+                                       size_t                    len,
+                                       cl_command_queue          saxpyQueue,
+                                       cl_kernel                 saxpyKernel,
+                                       std::span<const cl_event> eventsToWaitOn,
+                                       cl_event&                 saxpyComplete);
+
+    // Splits launches at `limits.maxWorkItemsPerLaunch` where that is below the global size limit.
+    [[nodiscard]] cl_int EnqueueKernel(const Specialization&     specialization,
+                                       const Limits&             limits,
+                                       float                     a,
+                                       cl_mem                    xDevice,
+                                       cl_mem                    yDevice,
+                                       cl_mem                    zDevice,
+                                       size_t                    len,
+                                       cl_command_queue          saxpyQueue,
+                                       cl_kernel                 saxpyKernel,
+                                       std::span<const cl_event> eventsToWaitOn,
+                                       cl_event&                 saxpyComplete);
+
+    // Runs saxpy on the device of `saxpyQueue` and blocks until `zHost` holds the result. How host data reaches the
+    // device follows its capabilities: in place or through mapped memory where it shares memory with the host,
+    // through asynchronous copies otherwise. Operands larger than `CL_DEVICE_MAX_MEM_ALLOC_SIZE` run in consecutive
+    // parts, each with buffers of its own. All spans must have the same size.
+    [[nodiscard]] cl_int Exec(float                  a,
+                              std::span<const float> xHost,
+                              std::span<const float> yHost,
+                              std::span<float>       zHost,
+                              cl_command_queue       saxpyQueue,
+                              cl_kernel              saxpyKernel);
+
+    // Runs a kernel built with the options of `specialization` within `limits`, which also caps the elements per
+    // buffer. Parts of an exact launch hold whole work-items, so only `len` must be a multiple of their elements.
+    [[nodiscard]] cl_int Exec(const Specialization&  specialization,
+                              const Limits&          limits,
+                              float                  a,
+                              std::span<const float> xHost,
+                              std::span<const float> yHost,
+                              std::span<float>       zHost,
+                              cl_command_queue       saxpyQueue,
+                              cl_kernel              saxpyKernel);
+
     void HostExec(float        a,
                   const float* pXHost,
                   const float* pYHost,
                   float*       pZHost,
                   size_t       len);
+
+    // Splits the work across `pool` in the chunks `memory::FirstTouch` uses, so each thread reads NUMA-local pages.
+    void HostExec(float                    a,
+                  const float*             pXHost,
+                  const float*             pYHost,
+                  float*                   pZHost,
+                  size_t                   len,
+                  concurrency::ThreadPool& pool);
 }
 
 
@@ -0,0 +1,54 @@
+#ifndef SAXPY_SHARDED_EXEC_H
+#define SAXPY_SHARDED_EXEC_H
+
+#include <CL/cl.h>
+
+#include <span>
+#include <vector>
+
+
+namespace saxpy
+{
+    // Executes one saxpy problem across every device of several contexts, which may belong to different platforms,
+    // e.g. a vendor GPU and a CPU runtime. Each device computes a contiguous slice sized by its estimated throughput.
+    class ShardedExec
+    {
+    public:
+        ShardedExec() = default;
+        ~ShardedExec() noexcept;
+
+        ShardedExec(const ShardedExec&)            = delete;
+        ShardedExec& operator=(const ShardedExec&) = delete;
+
+        // Builds the saxpy program for all contexts concurrently, then creates a queue and kernel per device.
+        // The contexts must outlive the executor.
+        [[nodiscard]] cl_int Init(std::span<const cl_context> contexts);
+
+        void Release() noexcept;
+
+        // Returns once every slice of `pZHost` has been gathered from its device, or CL_INVALID_OPERATION without any
+        // shard, i.e. before a successful `Init` or after `Release`.
+        [[nodiscard]] cl_int Exec(float        a,
+                                  const float* pXHost,
+                                  const float* pYHost,
+                                  float*       pZHost,
+                                  size_t       len);
+
+        [[nodiscard]] size_t GetShardCount() const noexcept { return m_shards.size(); }
+
+    private:
+        struct Shard
+        {
+            cl_context       context;
+            cl_command_queue queue;
+            cl_kernel        kernel;
+            double           throughput;
+        };
+
+        std::vector<cl_program> m_programs = {};
+        std::vector<Shard>      m_shards   = {};
+    };
+}
+
+
+#endif // SAXPY_SHARDED_EXEC_H
\ No newline at end of file
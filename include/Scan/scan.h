@@ -0,0 +1,45 @@
+#ifndef SCAN_SCAN_H
+#define SCAN_SCAN_H
+
+#include <CL/cl.h>
+
+#include <span>
+
+
+namespace scan
+{
+    enum class Kind
+    {
+        Exclusive, // y[i] = x[0] + ... + x[i - 1], as `std::exclusive_scan` from zero.
+        Inclusive  // y[i] = x[0] + ... + x[i], as `std::inclusive_scan`.
+    };
+
+    // Prefix sums of `len` cl_uints, wrapping around as unsigned additions do. x and y may be the same buffer.
+    // `scanKernels` are created from `build::scan::clKernelNames`. Tiles of one work-group each are scanned in local
+    // memory, with subgroup scans where the device supports them. Problems of several tiles take three phases: the
+    // sums of the tiles, their exclusive scan, recursively, and the scan of each tile from its carry.
+    [[nodiscard]] cl_int EnqueueKernel(Kind                       kind,
+                                       cl_mem                     xDevice,
+                                       cl_mem                     yDevice,
+                                       size_t                     len,
+                                       cl_command_queue           scanQueue,
+                                       std::span<const cl_kernel> scanKernels,
+                                       std::span<const cl_event>  eventsToWaitOn,
+                                       cl_event&                  scanComplete);
+
+    // Stream compaction: copies the floats of `valuesDevice` whose cl_uint flag is non-zero to the front of
+    // `outDevice`, in their order, and their count to `countDevice`, a buffer of one cl_uint. Built on the scan of the
+    // flags, whose last phase scatters the values directly instead of writing the offsets. `len` is below 2^32.
+    [[nodiscard]] cl_int EnqueueCompact(cl_mem                     valuesDevice,
+                                        cl_mem                     flagsDevice,
+                                        size_t                     len,
+                                        cl_mem                     outDevice,
+                                        cl_mem                     countDevice,
+                                        cl_command_queue           scanQueue,
+                                        std::span<const cl_kernel> scanKernels,
+                                        std::span<const cl_event>  eventsToWaitOn,
+                                        cl_event&                  compactComplete);
+}
+
+
+#endif // SCAN_SCAN_H
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef SGEMM_SGEMM_H
+#define SGEMM_SGEMM_H
+
+#include <CL/cl.h>
+
+#include <span>
+#include <string>
+
+
+namespace sgemm
+{
+    enum class Layout
+    {
+        RowMajor,
+        ColumnMajor
+    };
+
+    enum class Transpose
+    {
+        No,
+        Yes
+    };
+
+    // Tile sizes, baked into a program through "-D" build options. A work-group computes a `tileM` x `tileN` tile
+    // of C, stepping through the shared dimension `tileK` at a time, and each of its work-items accumulates a
+    // `workPerItemM` x `workPerItemN` block of that tile in registers.
+    struct Tiling
+    {
+        cl_uint tileM;
+        cl_uint tileN;
+        cl_uint tileK;
+        cl_uint workPerItemM;
+        cl_uint workPerItemN;
+        cl_uint vectorWidth;  // Elements per load from global memory: 1, 2, 4 or 8.
+    };
+
+    // 16 x 16 work-items staging 8 KiB of local memory, which suits most GPUs.
+    inline constexpr Tiling DefaultTiling =
+    {
+        .tileM        = 64,
+        .tileN        = 64,
+        .tileK        = 16,
+        .workPerItemM = 4,
+        .workPerItemN = 4,
+        .vectorWidth  = 4
+    };
+
+    // C = alpha * op(A) * op(B) + beta * C, as in BLAS, where op(A) is m x k, op(B) is k x n and C is m x n. The
+    // leading dimensions are in elements: between consecutive rows of row-major, and columns of column-major, storage.
+    struct Problem
+    {
+        Layout    layout;
+        Transpose transposeA;
+        Transpose transposeB;
+        size_t    m;
+        size_t    n;
+        size_t    k;
+        float     alpha;
+        float     beta;
+        size_t    lda;
+        size_t    ldb;
+        size_t    ldc;
+    };
+
+    [[nodiscard]] cl_int GetTilingOptions(const Tiling& tiling,
+                                          std::string&  clBuildOptions);
+
+    // Builds the program of `tiling`, whose binary is cached apart from those of other tilings.
+    [[nodiscard]] cl_int Build(cl_context    context,
+                               const Tiling& tiling,
+                               cl_program&   program);
+
+    // The work-group of a program built for `tiling` must fit on the device of `sgemmQueue`. `sgemmKernels` are
+    // created from `build::sgemm::clKernelNames`, and the one matching the transposes of `problem` is launched.
+    // A `beta` of zero leaves C unread.
+    [[nodiscard]] cl_int EnqueueKernel(const Tiling&              tiling,
+                                       const Problem&             problem,
+                                       cl_mem                     aDevice,
+                                       cl_mem                     bDevice,
+                                       cl_mem                     cDevice,
+                                       cl_command_queue           sgemmQueue,
+                                       std::span<const cl_kernel> sgemmKernels,
+                                       std::span<const cl_event>  eventsToWaitOn,
+                                       cl_event&                  sgemmComplete);
+
+    // The number of elements each matrix spans in memory, given its leading dimension.
+    [[nodiscard]] size_t GetSizeA(const Problem& problem) noexcept;
+    [[nodiscard]] size_t GetSizeB(const Problem& problem) noexcept;
+    [[nodiscard]] size_t GetSizeC(const Problem& problem) noexcept;
+
+    // Computes `problem` block by block, so the operands of each block stay in cache.
+    void HostExec(const Problem& problem,
+                  const float*   pAHost,
+                  const float*   pBHost,
+                  float*         pCHost);
+}
+
+
+#endif // SGEMM_SGEMM_H
\ No newline at end of file
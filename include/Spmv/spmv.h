@@ -0,0 +1,104 @@
+#ifndef SPMV_SPMV_H
+#define SPMV_SPMV_H
+
+#include <CL/cl.h>
+
+#include <array>
+#include <span>
+#include <vector>
+
+
+namespace spmv
+{
+    // A sparse matrix in compressed sparse row format: the non-zeros of row i are those from `rowOffsets[i]` up to
+    // `rowOffsets[i + 1]`, so a matrix of m rows has m + 1 offsets. Column indices need not be sorted within a row.
+    struct HostCsr
+    {
+        size_t                   n;
+        std::span<const cl_uint> rowOffsets;
+        std::span<const cl_uint> columnIndices;
+        std::span<const float>   values;
+    };
+
+    // Rows of up to `MaxScalarRowLength` non-zeros are computed by one work-item each, those of up to
+    // `MaxVectorRowLength` by a few neighbouring work-items each, and longer ones by a whole work-group each.
+    inline constexpr size_t MaxScalarRowLength = 8;
+    inline constexpr size_t MaxVectorRowLength = 1024;
+
+    struct RowBins
+    {
+        std::vector<cl_uint> scalar;
+        std::vector<cl_uint> vector;
+        std::vector<cl_uint> workGroup;
+    };
+
+    // Sorts the rows into bins by their number of non-zeros, as CSR-Adaptive does, so that each kernel only sees rows
+    // it handles well. Rows keep their order within a bin.
+    [[nodiscard]] RowBins BinRows(std::span<const cl_uint> rowOffsets);
+
+    // A CSR matrix in device memory, along with its rows binned by length.
+    class AdaptiveCsr
+    {
+    public:
+        AdaptiveCsr() = default;
+        ~AdaptiveCsr() noexcept;
+
+        AdaptiveCsr(const AdaptiveCsr&)            = delete;
+        AdaptiveCsr& operator=(const AdaptiveCsr&) = delete;
+
+        // Fails with `CL_INVALID_VALUE` unless `csr` is well-formed: offsets start at zero, never decrease and end at
+        // the number of non-zeros, and every column index is below `n`. A failed call leaves the matrix empty.
+        [[nodiscard]] cl_int Init(cl_context     context,
+                                  const HostCsr& csr);
+
+        void Release() noexcept;
+
+        // y = A * x. `spmvKernels` are created from `build::spmv::clKernelNames`, and each bin of rows runs on its
+        // own kernel. `spmvComplete` covers every bin.
+        [[nodiscard]] cl_int EnqueueKernel(cl_mem                     xDevice,
+                                           cl_mem                     yDevice,
+                                           cl_command_queue           spmvQueue,
+                                           std::span<const cl_kernel> spmvKernels,
+                                           std::span<const cl_event>  eventsToWaitOn,
+                                           cl_event&                  spmvComplete) const;
+
+        // y = alpha * A * x + beta * y, so the product composes with axpy-style updates. A `beta` of zero leaves y
+        // unread.
+        [[nodiscard]] cl_int EnqueueKernel(float                      alpha,
+                                           cl_mem                     xDevice,
+                                           float                      beta,
+                                           cl_mem                     yDevice,
+                                           cl_command_queue           spmvQueue,
+                                           std::span<const cl_kernel> spmvKernels,
+                                           std::span<const cl_event>  eventsToWaitOn,
+                                           cl_event&                  spmvComplete) const;
+
+        [[nodiscard]] size_t GetRowCount() const noexcept { return m_rowCount; }
+        [[nodiscard]] size_t GetColumnCount() const noexcept { return m_columnCount; }
+        [[nodiscard]] size_t GetNonZeroCount() const noexcept { return m_nonZeroCount; }
+
+    private:
+        struct Bin
+        {
+            cl_mem rows     = nullptr;
+            size_t rowCount = 0;
+        };
+
+        cl_mem             m_rowOffsets    = nullptr;
+        cl_mem             m_columnIndices = nullptr;
+        cl_mem             m_values        = nullptr;
+        std::array<Bin, 3> m_bins          = {};
+        size_t             m_rowCount      = 0;
+        size_t             m_columnCount   = 0;
+        size_t             m_nonZeroCount  = 0;
+    };
+
+    void HostExec(const HostCsr& csr,
+                  float          alpha,
+                  const float*   pXHost,
+                  float          beta,
+                  float*         pYHost);
+}
+
+
+#endif // SPMV_SPMV_H
\ No newline at end of file
@@ -0,0 +1,122 @@
+#ifndef UTILITIES_CONCURRENCY_H
+#define UTILITIES_CONCURRENCY_H
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace concurrency
+{
+    // A fixed-size pool of host threads that execute submitted tasks in FIFO order.
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(size_t nThreads);
+        ~ThreadPool() noexcept;
+
+        ThreadPool(const ThreadPool&)            = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template<typename Task>
+        [[nodiscard]] std::future<std::invoke_result_t<Task>> Submit(Task&& task)
+        {
+            return Enqueue(m_tasks, std::forward<Task>(task));
+        }
+
+        // Runs the task on one particular thread of the pool, which takes it before any task submitted to all threads.
+        // Repeatedly running the same share of some work on the same thread keeps e.g. its first-touched memory local.
+        template<typename Task>
+        [[nodiscard]] std::future<std::invoke_result_t<Task>> SubmitTo(const size_t threadIndex,
+                                                                       Task&&       task)
+        {
+            return Enqueue(m_threadTasks[threadIndex], std::forward<Task>(task));
+        }
+
+        [[nodiscard]] size_t GetThreadCount() const noexcept { return m_threads.size(); }
+
+    private:
+        template<typename Task>
+        [[nodiscard]] std::future<std::invoke_result_t<Task>> Enqueue(std::deque<std::function<void()>>& tasks,
+                                                                      Task&&                             task)
+        {
+            using ResultType = std::invoke_result_t<Task>;
+
+            // `std::function` requires copyable targets, hence the shared ownership of the packaged task.
+            auto packagedTask = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Task>(task));
+            auto future       = packagedTask->get_future();
+
+            {
+                const std::lock_guard lock(m_mutex);
+                tasks.emplace_back([packagedTask]() { (*packagedTask)(); });
+            }
+
+            // Only one particular thread can take a task meant for it, so every thread has to check.
+            if (&tasks == &m_tasks)
+            {
+                m_tasksAvailable.notify_one();
+            }
+            else
+            {
+                m_tasksAvailable.notify_all();
+            }
+
+            return future;
+        }
+
+        void ExecuteTasks(size_t threadIndex);
+
+        std::mutex                                     m_mutex          = {};
+        std::condition_variable                        m_tasksAvailable = {};
+        std::deque<std::function<void()>>              m_tasks          = {};
+        std::vector<std::deque<std::function<void()>>> m_threadTasks    = {};
+        bool                                           m_stopping       = false;
+        std::vector<std::thread>                       m_threads        = {};
+    };
+
+    // Splits [0, count) into one contiguous chunk per thread of `pool`, with boundaries on multiples of `granularity`,
+    // and waits until `function(begin, end)` has run for each. Chunk `i` always runs on thread `i`, so this must not be
+    // called from a thread of `pool` itself. `granularity` must be positive.
+    template<typename Function>
+    void ParallelFor(ThreadPool&  pool,
+                     const size_t count,
+                     const size_t granularity,
+                     Function&&   function)
+    {
+        assert(granularity > 0);
+
+        const size_t nThreads   = pool.GetThreadCount();
+        const size_t chunkCount = (((count + nThreads - 1) / nThreads + granularity - 1) / granularity) * granularity;
+
+        std::vector<std::future<void>> chunks = {};
+        chunks.reserve(nThreads);
+
+        for (size_t i = 0; (i < nThreads) && (i * chunkCount < count); i++)
+        {
+            const size_t begin = i * chunkCount;
+            const size_t end   = std::min(begin + chunkCount, count);
+
+            chunks.push_back(pool.SubmitTo(i, [&function, begin, end]() { function(begin, end); }));
+        }
+
+        for (std::future<void>& chunk : chunks)
+        {
+            chunk.get();
+        }
+    }
+
+    // The process-wide pool, sized to the hardware concurrency of the host.
+    [[nodiscard]] ThreadPool& GetHostThreadPool();
+}
+
+
+#endif // UTILITIES_CONCURRENCY_H
\ No newline at end of file
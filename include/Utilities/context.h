@@ -17,6 +17,11 @@ namespace context
     [[nodiscard]] cl_int Create(platform::UniSelectionStrategy strategy,
                                 std::optional<cl_platform_id>& selectedPlatform,
                                 std::optional<cl_context>&     context);
+
+    // Creates one context per selected platform, in the order the strategy selected them.
+    [[nodiscard]] cl_int Create(platform::PolySelectionStrategy strategy,
+                                std::vector<cl_platform_id>&    selectedPlatforms,
+                                std::vector<cl_context>&        contexts);
 }
 
 
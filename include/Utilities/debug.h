@@ -1,6 +1,8 @@
 #ifndef UTILITIES_DEBUG_H
 #define UTILITIES_DEBUG_H
 
+#include "logging.h"
+
 #include <CL/cl.h>
 
 #include <iostream>
@@ -9,13 +11,13 @@
 
 #define UNUSED_PARAMETER(p) static_cast<void>(p)
 
-#define MSG_STD_OUT(...) debug::DisplayMessage(std::cout, "MESSAGE", __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define MSG_STD_ERR(...) debug::DisplayMessage(std::cerr, "ERROR"  , __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#define MSG_STD_OUT(...) LOGGING_WRITE(logging::Level::Info , std::cout, "MESSAGE", __VA_ARGS__)
+#define MSG_STD_ERR(...) LOGGING_WRITE(logging::Level::Error, std::cerr, "ERROR"  , __VA_ARGS__)
 
 #ifdef _DEBUG
 
-#define DBG_MSG_STD_OUT(...) debug::DisplayMessage(std::cout, "DEBUG MESSAGE", __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define DBG_MSG_STD_ERR(...) debug::DisplayMessage(std::cerr, "DEBUG ERROR"  , __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#define DBG_MSG_STD_OUT(...) LOGGING_WRITE(logging::Level::Debug, std::cout, "DEBUG MESSAGE", __VA_ARGS__)
+#define DBG_MSG_STD_ERR(...) LOGGING_WRITE(logging::Level::Debug, std::cerr, "DEBUG ERROR"  , __VA_ARGS__)
 
 #define DBG_CL_COND_MSG_STD_OUT(result, ...) if ((result) == CL_SUCCESS) DBG_MSG_STD_OUT(__VA_ARGS__)
 #define DBG_CL_COND_MSG_STD_ERR(result, ...) if ((result) != CL_SUCCESS) DBG_MSG_STD_ERR(__VA_ARGS__)
@@ -51,23 +53,7 @@
 
 namespace debug
 {
-    template<typename... Args>
-    inline void DisplayMessage(std::ostream&          oStream,
-                               const std::string_view title,
-                               const std::string_view fileName,
-                               const std::string_view callerName,
-                               const uint32_t         lineNumber,
-                               Args&&...              args)
-    {
-        oStream << "\n" << title << "\n";
-    
-        oStream << "File: "     << fileName   << "\n";
-        oStream << "Function: " << callerName << "\n";
-        oStream << "Line: "     << lineNumber << "\n";
-    
-        (oStream << ... << args) << "\n";
-    }
-
+    // `fileName` and `callerName` must be literals, as logging defers formatting to another thread.
     void DisplayOpenClError(const cl_int           error,
                             const std::string_view fileName,
                             const std::string_view callerName,
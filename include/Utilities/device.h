@@ -4,10 +4,19 @@
 #include <CL/cl.h>
 
 #include <filesystem>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 
+namespace discovery
+{
+    struct DeviceInfo;
+}
+
+
 namespace program
 {
     struct BinaryCreator;
@@ -28,11 +37,26 @@ namespace device
                                          cl_device_info paramName,
                                          std::string&   paramValue);
 
+    [[nodiscard]] cl_int QueryParamValue(cl_device_id         device,
+                                         cl_device_info       paramName,
+                                         std::vector<size_t>& paramValue);
+
     [[nodiscard]] cl_int DisplayGeneralInfo(cl_device_id device);
 
     [[nodiscard]] cl_int IsGpu(cl_device_id device,
                                bool&        isGpu);
 
+    [[nodiscard]] cl_int SupportsIl(cl_device_id     device,
+                                    std::string_view ilPrefix,
+                                    bool&            supportsIl);
+
+    [[nodiscard]] cl_int GetOpenClVersion(cl_device_id device,
+                                          cl_uint&     major,
+                                          cl_uint&     minor);
+
+    [[nodiscard]] cl_int SupportsNonUniformWorkGroups(cl_device_id device,
+                                                      bool&        supportsNonUniformWorkGroups);
+
     [[nodiscard]] cl_int GetUniqueId(cl_device_id device,
                                      std::string& uniqueId);
 
@@ -40,9 +64,70 @@ namespace device
                                         cl_device_id                 device,
                                         std::filesystem::path&       clBinaryDir);
 
-    [[nodiscard]] cl_int GetClBinaryFilePath(const program::BinaryCreator& binCreator,
-                                             cl_device_id                  device,
-                                             std::filesystem::path&        clBinaryFilePath);
+    [[nodiscard]] cl_int GetClBinaryKey(const program::BinaryCreator& binCreator,
+                                        cl_device_id                  device,
+                                        std::string&                  clBinaryKey);
+
+    struct MeasuredProfile
+    {
+        double computeInGflops;
+        double memoryBandwidthInGBps;
+        double zeroCopyBandwidthInGBps; // A kernel streaming host memory in place; 0 if not measured.
+        double transferBandwidthInGBps; // Explicit copies between host and device memory; 0 if not measured.
+    };
+
+    // By the unique ID of the device.
+    using MeasuredProfiles = std::unordered_map<std::string, MeasuredProfile>;
+
+    // Each line of the profile file is "<unique ID> <compute in GFLOP/s> <memory bandwidth in GB/s>", optionally
+    // followed by "<zero-copy bandwidth in GB/s> <transfer bandwidth in GB/s>"; lines starting with '#' are comments.
+    [[nodiscard]] MeasuredProfiles LoadMeasuredProfiles(const std::filesystem::path& profilesFilePath);
+
+    // The profiles of `settings::deviceProfilesFilePath`, loaded on first use.
+    [[nodiscard]] const MeasuredProfiles& GetMeasuredProfiles();
+
+    // Estimates the throughput of a streaming kernel in GFLOP/s, preferring a measured profile of the device when
+    // one is listed in `settings::deviceProfilesFilePath`.
+    [[nodiscard]] cl_int EstimateThroughput(cl_device_id device,
+                                            double&      throughputInGflops);
+
+    // As above, from the properties of a device and the profiles to prefer; 0 for a device without compute units.
+    [[nodiscard]] double EstimateThroughput(const discovery::DeviceInfo& deviceInfo,
+                                            const MeasuredProfiles&      profiles) noexcept;
+
+    // Whether the device should access host data in place rather than through explicit copies into its own memory.
+    // A measured profile decides when it lists transfer bandwidths, otherwise the kind of device does.
+    [[nodiscard]] cl_int PrefersZeroCopy(cl_device_id device,
+                                         bool&        prefersZeroCopy);
+
+    // Whether the device, typically a CPU, can be split into sub-devices by `partitionType`, e.g.
+    // `CL_DEVICE_PARTITION_EQUALLY`. For `CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN`, see `SupportsAffinityDomain`.
+    [[nodiscard]] cl_int SupportsPartitioning(cl_device_id                 device,
+                                              cl_device_partition_property partitionType,
+                                              bool&                        supportsPartitioning);
+
+    [[nodiscard]] cl_int SupportsAffinityDomain(cl_device_id              device,
+                                                cl_device_affinity_domain affinityDomain,
+                                                bool&                     supportsAffinityDomain);
+
+    // Each function below creates sub-devices that pin work to a subset of the compute units of `device`, e.g. to the
+    // cores of one socket. The caller releases every sub-device with `clReleaseDevice`.
+
+    // As many sub-devices of `computeUnitsPerSubDevice` as fit.
+    [[nodiscard]] cl_int PartitionEqually(cl_device_id               device,
+                                          cl_uint                    computeUnitsPerSubDevice,
+                                          std::vector<cl_device_id>& subDevices);
+
+    // One sub-device per count, in the same order.
+    [[nodiscard]] cl_int PartitionByCounts(cl_device_id               device,
+                                           std::span<const cl_uint>   computeUnitCounts,
+                                           std::vector<cl_device_id>& subDevices);
+
+    // One sub-device per domain sharing e.g. a NUMA node or an L3 cache. OpenCL does not tell which domain each
+    // sub-device covers, so memory meant for one is best placed by its first touch.
+    [[nodiscard]] cl_int PartitionByAffinityDomain(cl_device_id               device,
+                                                   cl_device_affinity_domain  affinityDomain,
+                                                   std::vector<cl_device_id>& subDevices);
 }
 
 
@@ -0,0 +1,32 @@
+#ifndef UTILITIES_DISCOVERY_H
+#define UTILITIES_DISCOVERY_H
+
+#include "discovery_types.h"
+
+#include <CL/cl.h>
+
+#include <filesystem>
+#include <optional>
+
+
+namespace discovery
+{
+    // Enumerates every platform and device on first use, after which the same snapshot is returned.
+    // When persistence is enabled, the properties of a previous process are reused if the hardware is unchanged.
+    [[nodiscard]] cl_int GetSnapshot(const Snapshot*& snapshot);
+
+    [[nodiscard]] cl_int GetDeviceInfo(cl_device_id       device,
+                                       const DeviceInfo*& deviceInfo);
+
+    // Writes `snapshot` to a temporary file first, which then replaces `snapshotFilePath` as a whole.
+    void Persist(const Snapshot&              snapshot,
+                 const std::filesystem::path& snapshotFilePath);
+
+    // Leaves `snapshot` empty when there is no persisted snapshot, or when it no longer matches the platforms and
+    // devices enumerated now.
+    [[nodiscard]] cl_int Restore(const std::filesystem::path& snapshotFilePath,
+                                 std::optional<Snapshot>&     snapshot);
+}
+
+
+#endif // UTILITIES_DISCOVERY_H
\ No newline at end of file
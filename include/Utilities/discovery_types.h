@@ -0,0 +1,59 @@
+#ifndef UTILITIES_DISCOVERY_TYPES_H
+#define UTILITIES_DISCOVERY_TYPES_H
+
+#include <CL/cl.h>
+
+#include <string>
+#include <vector>
+
+
+namespace discovery
+{
+    struct DeviceInfo
+    {
+        cl_device_id        id;
+        cl_device_type      type;
+        std::string         name;
+        std::string         vendor;
+        std::string         version;
+        std::string         driverVersion;
+        std::string         openClCVersion;
+        std::string         ilVersions;
+        std::string         uniqueId;
+        cl_uint             maxComputeUnits;
+        cl_uint             maxClockFrequencyInMHz;
+        cl_uint             addressBits;
+        cl_uint             memBaseAddrAlignInBits;
+        cl_uint             preferredVectorWidthFloat;
+        cl_ulong            globalMemSizeInBytes;
+        cl_ulong            globalMemCacheSizeInBytes;
+        cl_ulong            maxMemAllocSizeInBytes;
+        cl_ulong            localMemSizeInBytes;
+        size_t              maxWorkGroupSize;
+        std::vector<size_t> maxWorkItemSizes;
+        bool                hostUnifiedMemory;
+    };
+
+    struct PlatformInfo
+    {
+        cl_platform_id          id;
+        std::string             profile;
+        std::string             version;
+        std::string             name;
+        std::string             vendor;
+        bool                    isConformant;
+        std::vector<DeviceInfo> devices;
+    };
+
+    // Every platform and device of the process, as enumerated once. Immutable after creation.
+    struct Snapshot
+    {
+        std::vector<PlatformInfo> platforms;
+
+        [[nodiscard]] const PlatformInfo* FindPlatform(cl_platform_id platform) const noexcept;
+        [[nodiscard]] const DeviceInfo*   FindDevice(cl_device_id device) const noexcept;
+    };
+}
+
+
+#endif // UTILITIES_DISCOVERY_TYPES_H
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef UTILITIES_FILE_H
+#define UTILITIES_FILE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+
+namespace file
+{
+    // A read-only view of an entire file, mapped into the address space of the process.
+    class ReadOnlyMapping
+    {
+    public:
+        ReadOnlyMapping() noexcept = default;
+        ~ReadOnlyMapping() noexcept;
+
+        ReadOnlyMapping(const ReadOnlyMapping&)            = delete;
+        ReadOnlyMapping& operator=(const ReadOnlyMapping&) = delete;
+
+        ReadOnlyMapping(ReadOnlyMapping&& other) noexcept;
+        ReadOnlyMapping& operator=(ReadOnlyMapping&& other) noexcept;
+
+        [[nodiscard]] bool Map(const std::filesystem::path& filePath);
+        void Unmap() noexcept;
+
+        [[nodiscard]] std::span<const std::byte> View() const noexcept;
+
+    private:
+        void*  m_pView       = nullptr;
+        size_t m_sizeInBytes = 0;
+    };
+
+    // An advisory, inter-process exclusive lock held on a dedicated lock file.
+    // Acquisition blocks until every other holder has released the lock.
+    class ExclusiveLock
+    {
+    public:
+        ExclusiveLock() noexcept = default;
+        ~ExclusiveLock() noexcept;
+
+        ExclusiveLock(const ExclusiveLock&)            = delete;
+        ExclusiveLock& operator=(const ExclusiveLock&) = delete;
+
+        [[nodiscard]] bool Acquire(const std::filesystem::path& lockFilePath);
+        void Release() noexcept;
+
+    private:
+#ifdef _WIN32
+        void* m_handle = nullptr;
+#else
+        int   m_fd     = -1;
+#endif // _WIN32
+    };
+
+    // Writes the data of a closed file through to the storage device, e.g. before renaming it over another file, so a
+    // crash cannot leave the renamed file empty or partially written.
+    [[nodiscard]] bool FlushToDisk(const std::filesystem::path& filePath);
+
+    // A temporary path next to `filePath`, unique to the process, to write a file to before renaming it over
+    // `filePath`. Processes writing the same file concurrently then never write into each other's temporary file.
+    [[nodiscard]] std::filesystem::path GetTempPath(const std::filesystem::path& filePath);
+}
+
+
+#endif // UTILITIES_FILE_H
\ No newline at end of file
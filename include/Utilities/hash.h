@@ -0,0 +1,46 @@
+#ifndef UTILITIES_HASH_H
+#define UTILITIES_HASH_H
+
+#include <cstddef>
+#include <span>
+#include <stdint.h>
+#include <string_view>
+
+
+namespace hash
+{
+    inline constexpr uint64_t Fnv1aOffsetBasis = 0xCBF29CE484222325;
+    inline constexpr uint64_t Fnv1aPrime       = 0x00000100000001B3;
+
+    // 64-bit FNV-1a. `seed` allows a hash to be continued over several non-contiguous ranges.
+    [[nodiscard]] constexpr uint64_t Fnv1a(const std::string_view bytes,
+                                           const uint64_t         seed = Fnv1aOffsetBasis) noexcept
+    {
+        uint64_t hash = seed;
+
+        for (const char byte : bytes)
+        {
+            hash ^= static_cast<unsigned char>(byte);
+            hash *= Fnv1aPrime;
+        }
+
+        return hash;
+    }
+
+    [[nodiscard]] constexpr uint64_t Fnv1a(const std::span<const std::byte> bytes,
+                                           const uint64_t                   seed = Fnv1aOffsetBasis) noexcept
+    {
+        uint64_t hash = seed;
+
+        for (const std::byte byte : bytes)
+        {
+            hash ^= static_cast<unsigned char>(byte);
+            hash *= Fnv1aPrime;
+        }
+
+        return hash;
+    }
+}
+
+
+#endif // UTILITIES_HASH_H
\ No newline at end of file
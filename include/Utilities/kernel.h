@@ -0,0 +1,72 @@
+#ifndef UTILITIES_KERNEL_H
+#define UTILITIES_KERNEL_H
+
+#include <CL/cl.h>
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+
+namespace kernel
+{
+    // One argument of a kernel, as `clSetKernelArg` takes it. A null `pValue` declares `sizeInBytes` of local memory.
+    struct Arg
+    {
+        cl_uint     index;
+        size_t      sizeInBytes;
+        const void* pValue;
+    };
+
+    [[nodiscard]] cl_int SetArgs(cl_kernel            kernel,
+                                 std::span<const Arg> args);
+
+    // Creates an instance of `kernel` whose arguments can be set independently of the original. Devices supporting
+    // OpenCL 2.1 clone the kernel together with its arguments; otherwise the same function is created anew from the
+    // same program, with no arguments set.
+    [[nodiscard]] cl_int Clone(cl_kernel  kernel,
+                               cl_kernel& clone);
+
+    // Hands each host thread its own instance of a kernel and its own command queue, since setting kernel arguments
+    // is not thread-safe. Threads can then enqueue the same kernel concurrently without any locking.
+    class Pool
+    {
+    public:
+        struct Instance
+        {
+            cl_kernel        kernel;
+            cl_command_queue queue;
+        };
+
+        // `prototype` must outlive the pool. `queueProperties` are passed to `clCreateCommandQueueWithProperties`,
+        // so unless empty they must end with 0.
+        Pool(cl_kernel                        prototype,
+             cl_device_id                     device,
+             std::vector<cl_queue_properties> queueProperties = {});
+
+        ~Pool() noexcept;
+
+        Pool(const Pool&)            = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        // The first call of a thread creates its instance, cloning the prototype under the lock of the pool, and every
+        // later call of that thread returns it without taking a lock. Instances live as long as the pool.
+        [[nodiscard]] cl_int Acquire(const Instance*& instance);
+
+        [[nodiscard]] size_t GetInstanceCount() const;
+
+    private:
+        const uint64_t                         m_id;
+        const cl_kernel                        m_prototype;
+        const cl_device_id                     m_device;
+        const std::vector<cl_queue_properties> m_queueProperties;
+
+        mutable std::mutex                     m_mutex     = {};
+        std::vector<std::unique_ptr<Instance>> m_instances = {};
+    };
+}
+
+
+#endif // UTILITIES_KERNEL_H
\ No newline at end of file
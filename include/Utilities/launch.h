@@ -0,0 +1,104 @@
+#ifndef UTILITIES_LAUNCH_H
+#define UTILITIES_LAUNCH_H
+
+#include <CL/cl.h>
+
+#include <span>
+#include <stddef.h>
+#include <vector>
+
+
+namespace launch
+{
+    // Global sizes beyond 32 bits overflow the work-item indices of many runtimes, and of every 32-bit device.
+    inline constexpr size_t MaxWorkItemsPerLaunch = 0xFFFFFFFF;
+
+    // What a 1-D launch of a kernel on a device has to respect, as reported by the kernel and the device.
+    struct KernelResources
+    {
+        size_t   maxWorkGroupSize;               // `CL_KERNEL_WORK_GROUP_SIZE`.
+        size_t   preferredWorkGroupSizeMultiple; // `CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE`, e.g. a warp.
+        cl_ulong localMemSizeInBytes;            // `CL_KERNEL_LOCAL_MEM_SIZE`, per work-group.
+        cl_ulong privateMemSizeInBytes;          // `CL_KERNEL_PRIVATE_MEM_SIZE`, per work-item.
+        cl_ulong deviceLocalMemSizeInBytes;      // `CL_DEVICE_LOCAL_MEM_SIZE`, per compute unit.
+        cl_uint  computeUnits;                   // `CL_DEVICE_MAX_COMPUTE_UNITS`.
+        size_t   maxWorkItemSize;                // `CL_DEVICE_MAX_WORK_ITEM_SIZES` of the first dimension.
+    };
+
+    struct Config
+    {
+        size_t localWorkSize;
+        size_t globalWorkSize; // The work-items rounded up to whole work-groups.
+    };
+
+    [[nodiscard]] cl_int QueryKernelResources(cl_kernel        kernel,
+                                              cl_device_id     device,
+                                              KernelResources& resources);
+
+    // Picks the work-group size that keeps the most work-items resident per compute unit, without any trial run.
+    // Sizes are multiples of the preferred multiple within the limits of kernel and device. Work-groups are capped
+    // at a typical hardware residency, and on-chip memory may further limit how many fit on a compute unit. A
+    // problem too small to fill every compute unit that way gets narrower work-groups instead.
+    [[nodiscard]] size_t ChooseLocalWorkSize(const KernelResources& resources,
+                                             size_t                 nWorkItems) noexcept;
+
+    [[nodiscard]] Config Plan(const KernelResources& resources,
+                              size_t                 nWorkItems) noexcept;
+
+    struct Range
+    {
+        size_t offset;
+        size_t count;
+    };
+
+    // Splits `count` into consecutive ranges of at most `maxCountPerRange`, e.g. the work-items of one launch or the
+    // elements of one buffer. All ranges but the last are as large as possible while a multiple of `multiple`, e.g. a
+    // work-group size; a `maxCountPerRange` below `multiple` yields ranges of exactly `multiple`.
+    [[nodiscard]] std::vector<Range> Split(size_t count,
+                                           size_t multiple,
+                                           size_t maxCountPerRange);
+
+    // Queries and plans in one go, for kernels launched over `nWorkItems` in one dimension.
+    [[nodiscard]] cl_int Plan(cl_kernel    kernel,
+                              cl_device_id device,
+                              size_t       nWorkItems,
+                              Config&      config);
+
+    // A 1-D launch, possibly one of several covering a problem together.
+    struct NdRange
+    {
+        size_t globalWorkOffset;
+        size_t globalWorkSize;
+        size_t localWorkSize;
+    };
+
+    // Enqueues every launch of `ndRanges`, each waiting on `eventsToWaitOn`. One event stands for all of them, so
+    // callers need not know that a problem was split; without any launch, it completes once `eventsToWaitOn` do.
+    [[nodiscard]] cl_int EnqueueNdRanges(cl_command_queue          queue,
+                                         cl_kernel                 kernel,
+                                         std::span<const NdRange>  ndRanges,
+                                         std::span<const cl_event> eventsToWaitOn,
+                                         cl_event&                 complete);
+
+    // Launches `nWorkItems`, rounded up to whole work-groups of `localWorkSize`, as the ranges of `Split` at the
+    // global size limit. Each launch starts at the global offset of its range, and the kernel bounds-checks the
+    // work-items rounding up the last work-group.
+    [[nodiscard]] cl_int EnqueueSplit(cl_command_queue          queue,
+                                      cl_kernel                 kernel,
+                                      size_t                    nWorkItems,
+                                      size_t                    localWorkSize,
+                                      std::span<const cl_event> eventsToWaitOn,
+                                      cl_event&                 complete);
+
+    // Splits at `maxWorkItemsPerLaunch` instead where that is lower, e.g. to run small problems as several launches.
+    [[nodiscard]] cl_int EnqueueSplit(cl_command_queue          queue,
+                                      cl_kernel                 kernel,
+                                      size_t                    nWorkItems,
+                                      size_t                    localWorkSize,
+                                      size_t                    maxWorkItemsPerLaunch,
+                                      std::span<const cl_event> eventsToWaitOn,
+                                      cl_event&                 complete);
+}
+
+
+#endif // UTILITIES_LAUNCH_H
\ No newline at end of file
@@ -0,0 +1,164 @@
+#ifndef UTILITIES_LOGGING_H
+#define UTILITIES_LOGGING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// The least severe level compiled in, named by a `logging::Level` enumerator, e.g. "-DLOGGING_COMPILE_TIME_LEVEL=Error".
+#ifndef LOGGING_COMPILE_TIME_LEVEL
+#ifdef _DEBUG
+#define LOGGING_COMPILE_TIME_LEVEL Debug
+#else
+#define LOGGING_COMPILE_TIME_LEVEL Info
+#endif // _DEBUG
+#endif // LOGGING_COMPILE_TIME_LEVEL
+
+// Arguments are only evaluated when the level is enabled, and not compiled at all below the compile-time level.
+#define LOGGING_WRITE(level, oStream, title, ...) (logging::IsEnabled<level>() ? logging::Write(oStream, title, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__) : void())
+
+
+namespace logging
+{
+    enum class Level : uint8_t
+    {
+        Debug = 0,
+        Info,
+        Error,
+        Off
+    };
+
+    inline constexpr Level CompileTimeLevel = Level::LOGGING_COMPILE_TIME_LEVEL;
+
+    namespace detail
+    {
+        inline std::atomic<Level> runtimeLevel = CompileTimeLevel;
+
+        // Formats the arguments into the stream, then destroys them.
+        using Emitter = void (*)(std::ostream& oStream, std::byte* pArgs);
+
+        // Arguments are formatted later on another thread, so they are captured by value. Character pointers and
+        // views are copied into strings, as whatever they refer to may be gone by then.
+        template<typename Arg>
+        using Captured = std::conditional_t<std::is_convertible_v<const std::decay_t<Arg>&, std::string_view>,
+                                            std::string,
+                                            std::decay_t<Arg>>;
+
+        struct Record
+        {
+            static constexpr size_t ArgsCapacityInBytes = 192;
+
+            std::ostream*    oStream;
+            std::string_view title;
+            std::string_view fileName;
+            std::string_view callerName;
+            uint32_t         lineNumber;
+            Emitter          emit;
+
+            alignas(std::max_align_t) std::array<std::byte, ArgsCapacityInBytes> args;
+        };
+
+        // Claims the next record of the ring buffer, waiting while it is full. Lock-free otherwise.
+        [[nodiscard]] Record& Reserve(size_t& position);
+
+        // Hands the record over to the drain thread.
+        void Commit(size_t position);
+
+        template<typename Tuple>
+        void EmitInline(std::ostream& oStream,
+                        std::byte*    pArgs)
+        {
+            Tuple& args = *std::launder(reinterpret_cast<Tuple*>(pArgs));
+
+            std::apply([&oStream](const auto&... arg) { (oStream << ... << arg); }, args);
+            args.~Tuple();
+        }
+
+        template<typename Tuple>
+        void EmitAllocated(std::ostream& oStream,
+                           std::byte*    pArgs)
+        {
+            Tuple* const pTuple = *std::launder(reinterpret_cast<Tuple**>(pArgs));
+
+            std::apply([&oStream](const auto&... arg) { (oStream << ... << arg); }, *pTuple);
+            delete pTuple;
+        }
+    }
+
+    // Messages less severe than `level` are dropped from now on. Levels below `CompileTimeLevel` stay compiled out.
+    inline void SetLevel(const Level level) noexcept
+    {
+        detail::runtimeLevel.store(level, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline Level GetLevel() noexcept
+    {
+        return detail::runtimeLevel.load(std::memory_order_relaxed);
+    }
+
+    template<Level level>
+    [[nodiscard]] bool IsEnabled() noexcept
+    {
+        if constexpr (level < CompileTimeLevel)
+        {
+            return false;
+        }
+        else
+        {
+            return level >= GetLevel();
+        }
+    }
+
+    // Captures the message into a lock-free ring buffer, from which a background thread formats and writes it.
+    // Messages of all threads are written in the order they were captured. `title`, `fileName` and `callerName`
+    // must be literals, as they are not copied.
+    template<typename... Args>
+    void Write(std::ostream&          oStream,
+               const std::string_view title,
+               const std::string_view fileName,
+               const std::string_view callerName,
+               const uint32_t         lineNumber,
+               Args&&...              args)
+    {
+        using Tuple = std::tuple<detail::Captured<Args>...>;
+
+        size_t          position = 0;
+        detail::Record& record   = detail::Reserve(position);
+
+        record.oStream    = &oStream;
+        record.title      = title;
+        record.fileName   = fileName;
+        record.callerName = callerName;
+        record.lineNumber = lineNumber;
+
+        // Arguments too large for the record, which are rare, cost an allocation.
+        if constexpr ((sizeof(Tuple) <= detail::Record::ArgsCapacityInBytes) &&
+                      (alignof(Tuple) <= alignof(std::max_align_t)))
+        {
+            new (record.args.data()) Tuple(std::forward<Args>(args)...);
+            record.emit = &detail::EmitInline<Tuple>;
+        }
+        else
+        {
+            new (record.args.data()) Tuple*(new Tuple(std::forward<Args>(args)...));
+            record.emit = &detail::EmitAllocated<Tuple>;
+        }
+
+        detail::Commit(position);
+    }
+
+    // Blocks until every message captured before the call has been written and the streams flushed. Messages other
+    // threads capture meanwhile are not waited for, so a flush returns even while they keep logging.
+    void Flush();
+}
+
+
+#endif // UTILITIES_LOGGING_H
\ No newline at end of file
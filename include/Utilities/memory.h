@@ -0,0 +1,132 @@
+#ifndef UTILITIES_MEMORY_H
+#define UTILITIES_MEMORY_H
+
+#include "concurrency.h"
+
+#include <CL/cl.h>
+
+#include <cstddef>
+#include <optional>
+#include <span>
+
+
+namespace memory
+{
+    inline constexpr size_t HugePageSizeInBytes = 2 * 1024 * 1024;
+
+    // Host memory reserved in whole, aligned 2 MiB pages. These are huge pages wherever the OS grants them, which
+    // relieves the TLB when streaming through gigabytes. Optionally, the memory is bound to one NUMA node.
+    class HostAllocation
+    {
+    public:
+        HostAllocation() noexcept = default;
+        ~HostAllocation() noexcept;
+
+        HostAllocation(const HostAllocation&)            = delete;
+        HostAllocation& operator=(const HostAllocation&) = delete;
+
+        HostAllocation(HostAllocation&& other) noexcept;
+        HostAllocation& operator=(HostAllocation&& other) noexcept;
+
+        // Without a NUMA node, each page is placed on the node of the thread that first touches it.
+        [[nodiscard]] bool Allocate(size_t                      sizeInBytes,
+                                    std::optional<unsigned int> numaNode = std::nullopt);
+
+        void Free() noexcept;
+
+        [[nodiscard]] std::span<std::byte> View() const noexcept;
+
+        template<typename T>
+        [[nodiscard]] std::span<T> ViewAs() const noexcept
+        {
+            return { static_cast<T*>(m_pView), m_sizeInBytes / sizeof(T) };
+        }
+
+        [[nodiscard]] bool IsHugePageBacked() const noexcept { return m_isHugePageBacked; }
+
+    private:
+        void*  m_pAllocation           = nullptr;
+        void*  m_pView                 = nullptr;
+        size_t m_allocationSizeInBytes = 0;
+        size_t m_sizeInBytes           = 0;
+        bool   m_isHugePageBacked      = false;
+    };
+
+    // Writes every element from the threads of `pool`, in the same chunks `concurrency::ParallelFor` hands to them
+    // when processing `elements`. Pages are thus placed on the NUMA node of the thread that later consumes them.
+    template<typename T>
+    void FirstTouch(const std::span<T>       elements,
+                    concurrency::ThreadPool& pool)
+    {
+        concurrency::ParallelFor(pool,
+                                 elements.size(),
+                                 HugePageSizeInBytes / sizeof(T),
+                                 [elements](const size_t begin, const size_t end)
+                                 {
+                                     std::fill(elements.begin() + begin, elements.begin() + end, T{});
+                                 });
+    }
+
+    // Wraps host memory as a `CL_MEM_USE_HOST_PTR` buffer, which devices may then access without copies. Fails with
+    // `CL_INVALID_VALUE` unless the memory meets the base address alignment of every device of `context`.
+    [[nodiscard]] cl_int CreateBuffer(cl_context                 context,
+                                      cl_mem_flags               flags,
+                                      std::span<const std::byte> hostMemory,
+                                      cl_mem&                    buffer);
+
+    enum class Strategy
+    {
+        InPlace,       // The device accesses the host memory itself, through `CL_MEM_USE_HOST_PTR`.
+        MappedStaging, // Host data is copied through a mapping of `CL_MEM_ALLOC_HOST_PTR` memory.
+        ExplicitCopy   // Host data is copied asynchronously to and from memory of the device.
+    };
+
+    // A buffer mirroring a span of host memory for the device of a queue. Where the device prefers zero-copy access,
+    // it uses the host memory in place if aligned, or host-accessible staging memory otherwise; elsewhere it holds a
+    // copy in device memory. The host memory must outlive the buffer.
+    class HostBuffer
+    {
+    public:
+        HostBuffer() noexcept = default;
+        ~HostBuffer() noexcept;
+
+        HostBuffer(const HostBuffer&)            = delete;
+        HostBuffer& operator=(const HostBuffer&) = delete;
+
+        HostBuffer(HostBuffer&& other) noexcept;
+        HostBuffer& operator=(HostBuffer&& other) noexcept;
+
+        // Creates a buffer the device reads, and enqueues whatever brings `hostInput` into it. The device may read
+        // the buffer once `uploaded` completes, which the caller releases.
+        [[nodiscard]] cl_int InitInput(cl_command_queue           queue,
+                                       std::span<const std::byte> hostInput,
+                                       cl_event&                  uploaded);
+
+        // Creates a buffer the device writes, whose contents `Download` brings into `hostOutput`.
+        [[nodiscard]] cl_int InitOutput(cl_command_queue     queue,
+                                        std::span<std::byte> hostOutput);
+
+        void Release() noexcept;
+
+        // Blocks until the host output holds the contents of the buffer after `eventsToWaitOn`.
+        [[nodiscard]] cl_int Download(std::span<const cl_event> eventsToWaitOn);
+
+        [[nodiscard]] cl_mem   Get() const noexcept { return m_buffer; }
+        [[nodiscard]] Strategy GetStrategy() const noexcept { return m_strategy; }
+
+    private:
+        [[nodiscard]] cl_int Init(cl_command_queue queue,
+                                  cl_mem_flags     access,
+                                  std::byte*       pHost,
+                                  size_t           sizeInBytes);
+
+        cl_command_queue m_queue       = nullptr;
+        cl_mem           m_buffer      = nullptr;
+        std::byte*       m_pHost       = nullptr;
+        size_t           m_sizeInBytes = 0;
+        Strategy         m_strategy    = Strategy::ExplicitCopy;
+    };
+}
+
+
+#endif // UTILITIES_MEMORY_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef UTILITIES_METRICS_H
+#define UTILITIES_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <span>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace metrics
+{
+    // Updates from different threads land on different cache lines, so hot paths never contend.
+    inline constexpr size_t ShardCount = 16;
+
+    [[nodiscard]] size_t GetThreadShard() noexcept;
+
+    class Counter
+    {
+    public:
+        void Increment(const uint64_t value = 1) noexcept
+        {
+            m_shards[GetThreadShard()].value.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] uint64_t Read() const noexcept;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<uint64_t> value = 0;
+        };
+
+        std::array<Shard, ShardCount> m_shards = {};
+    };
+
+    // Counts observations into buckets of ascending upper bounds, plus one for everything above the last bound.
+    class Histogram
+    {
+    public:
+        // Counts live inside the shards rather than on the heap, so they share their cache lines with nothing else.
+        static constexpr size_t MaxBoundCount = 15;
+
+        explicit Histogram(std::span<const double> upperBounds);
+
+        void Observe(double value) noexcept;
+
+        struct Snapshot
+        {
+            std::vector<double>   upperBounds;
+            std::vector<uint64_t> bucketCounts; // Not cumulative; one more than `upperBounds`.
+            double                sum;
+            uint64_t              count;
+        };
+
+        [[nodiscard]] Snapshot Read() const;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::array<std::atomic<uint64_t>, MaxBoundCount + 1> bucketCounts = {};
+            std::atomic<double>                                  sum          = 0.0;
+        };
+
+        std::vector<double>           m_upperBounds = {};
+        std::array<Shard, ShardCount> m_shards      = {};
+    };
+
+    // Observes the seconds elapsed between construction and destruction.
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram& histogram) noexcept :
+            m_histogram(histogram),
+            m_start(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~ScopedTimer() noexcept
+        {
+            m_histogram.Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count());
+        }
+
+        ScopedTimer(const ScopedTimer&)            = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Histogram&                                  m_histogram;
+        const std::chrono::steady_clock::time_point m_start;
+    };
+
+    // `count` bounds, starting at `start` and growing by `factor`.
+    [[nodiscard]] std::vector<double> ExponentialBuckets(double start,
+                                                         double factor,
+                                                         size_t count);
+
+    // Registers a metric on first use and returns the same one for the same name ever after, so call sites keep the
+    // reference in a static. Names follow Prometheus conventions, e.g. "program_builds_total".
+    [[nodiscard]] Counter& GetCounter(std::string_view name,
+                                      std::string_view help);
+
+    [[nodiscard]] Histogram& GetHistogram(std::string_view        name,
+                                          std::string_view        help,
+                                          std::span<const double> upperBounds);
+
+    enum class Format
+    {
+        Prometheus, // The text exposition format, e.g. for the textfile collector of the node exporter.
+        Json
+    };
+
+    // Snapshots every registered metric, each one consistent in itself but not with the others.
+    [[nodiscard]] std::string FormatSnapshot(Format format);
+
+    // Replaces the file atomically, so collectors never read a partial snapshot.
+    [[nodiscard]] bool ExportSnapshot(const std::filesystem::path& filePath,
+                                      Format                       format);
+}
+
+
+#endif // UTILITIES_METRICS_H
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef UTILITIES_PLATFORM_H
 #define UTILITIES_PLATFORM_H
 
+#include "device.h"
+#include "discovery_types.h"
+
 #include <CL/cl.h>
 
 #include <optional>
@@ -27,6 +30,26 @@ namespace platform
     [[nodiscard]] cl_int MostGpus(std::span<const cl_platform_id> platforms,
                                   std::optional<cl_platform_id>&  selectedPlatform,
                                   std::vector<cl_device_id>&      selectedDevices);
+
+    // Devices are only grouped with devices of the same type, so that e.g. a CPU does not hold back the GPUs sharing
+    // its context. The group with the fastest device represents the platform, fastest device first, and scores as that
+    // device. Summing over the group would scale uncalibrated throughput estimates by the device count instead.
+    void SelectFastestDeviceGroup(const discovery::PlatformInfo&  platformInfo,
+                                  const device::MeasuredProfiles& profiles,
+                                  std::vector<cl_device_id>&      selectedDevices,
+                                  double&                         selectedThroughput);
+
+    // Selects the platform whose fastest GPU, accelerator or CPU promises the highest throughput, along with the other
+    // devices of its type, so machines without GPUs fall back to CPU implementations such as PoCL.
+    [[nodiscard]] cl_int HighestThroughput(std::span<const cl_platform_id> platforms,
+                                           std::optional<cl_platform_id>&  selectedPlatform,
+                                           std::vector<cl_device_id>&      selectedDevices);
+
+    // Selects the fastest device group of every platform, fastest platform first, so one problem can be distributed
+    // across all compute resources of a heterogeneous node.
+    [[nodiscard]] cl_int HighestThroughputPerPlatform(std::span<const cl_platform_id>         platforms,
+                                                      std::vector<cl_platform_id>&            selectedPlatforms,
+                                                      std::vector<std::vector<cl_device_id>>& selectedDevices);
 }
 
 
@@ -4,9 +4,11 @@
 #include <CL/cl.h>
 
 #include <functional>
+#include <future>
 #include <optional>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -25,9 +27,22 @@ namespace program
                                const std::string&                                         clBuildOptions,
                                cl_program&                                                program);
 
+    // Builds on the host thread pool, so many programs can build concurrently while the caller prepares data.
+    // `binCreator`, `srcCreator` and `program` must outlive the returned future, which yields the build result.
+    [[nodiscard]] std::future<cl_int> BuildAsync(cl_context                                                 context,
+                                                 std::optional<std::reference_wrapper<const BinaryCreator>> binCreator,
+                                                 const SourceCreator&                                       srcCreator,
+                                                 const std::string&                                         clBuildOptions,
+                                                 cl_program&                                                program);
+
     [[nodiscard]] cl_int CreateKernels(cl_program                   program,
                                        std::span<const std::string> kernelNames,
                                        std::span<cl_kernel>         kernels);
+
+    // Tags `clBinaryFileName` with a hash of `clBuildOptions`, e.g. "a_ClBinary_Debug_0123456789abcdef.cl.bin". Binaries
+    // built with other options then keep cache slots of their own, rather than evicting one another as stale versions.
+    [[nodiscard]] std::string GetBinaryFileName(std::string_view clBinaryFileName,
+                                                std::string_view clBuildOptions);
 }
 
 
@@ -2,7 +2,9 @@
 #define UTILITIES_PROGRAM_TYPES_H
 
 #include <filesystem>
+#include <stdint.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -12,12 +14,15 @@ namespace program
     {
         std::filesystem::path clBinaryRoot;
         std::string           clBinaryFileName;
+        uint64_t              clSourceHash;
     };
 
     struct SourceCreator
     {
-        std::filesystem::path    clSourceRoot;
-        std::vector<std::string> clSourceFileNames;
+        std::filesystem::path         clSourceRoot;
+        std::vector<std::string>      clSourceFileNames;
+        std::vector<std::string_view> clSources;
+        std::string_view              clIl;
     };
 }
 
@@ -0,0 +1,83 @@
+#ifndef UTILITIES_SPECIALIZATION_H
+#define UTILITIES_SPECIALIZATION_H
+
+#include "program_types.h"
+
+#include <CL/cl.h>
+
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+
+namespace specialization
+{
+    // Programs built from one source with values baked in through additional "-D" options. Specialized programs are
+    // kept in memory per context and options, and their binaries are cached on disk under a hash of those options.
+    class Cache
+    {
+    public:
+        // Specializes after `settings::specializationHitsBeforeBuild` hits.
+        Cache(const program::BinaryCreator& binCreator,
+              const program::SourceCreator& srcCreator,
+              std::string                   clBuildOptions);
+
+        Cache(const program::BinaryCreator& binCreator,
+              const program::SourceCreator& srcCreator,
+              std::string                   clBuildOptions,
+              uint32_t                      hitsBeforeSpecializing);
+
+        ~Cache() noexcept;
+
+        Cache(const Cache&)            = delete;
+        Cache& operator=(const Cache&) = delete;
+
+        // Never blocks: yields the specialized program once it is built, and nothing before. Each call counts as a hit;
+        // the hit that reaches the threshold starts an asynchronous build, so only hot specializations are compiled.
+        [[nodiscard]] cl_int Find(cl_context                 context,
+                                  const std::string&         specializationOptions,
+                                  std::optional<cl_program>& program);
+
+        // Builds the specialization right away, regardless of hits, and waits for it without holding up `Find`.
+        [[nodiscard]] cl_int Specialize(cl_context         context,
+                                        const std::string& specializationOptions,
+                                        cl_program&        program);
+
+    private:
+        enum class State
+        {
+            Counting,
+            Building,
+            Built,
+            Failed
+        };
+
+        struct Entry
+        {
+            program::BinaryCreator     binCreator;
+            std::string                clBuildOptions;
+            uint32_t                   hits;
+            State                      state;
+            std::shared_future<cl_int> build;
+            cl_program                 program;
+        };
+
+        Entry& GetEntry(cl_context context, const std::string& specializationOptions);
+        void   StartBuild(cl_context context, Entry& entry);
+        void   CompleteBuild(Entry& entry);
+
+        const program::BinaryCreator m_binCreator;
+        const program::SourceCreator m_srcCreator;
+        const std::string            m_clBuildOptions;
+        const uint32_t               m_hitsBeforeSpecializing;
+
+        std::mutex                                           m_mutex   = {};
+        std::map<std::pair<cl_context, std::string>, Entry> m_entries = {};
+    };
+}
+
+
+#endif // UTILITIES_SPECIALIZATION_H
\ No newline at end of file
@@ -0,0 +1,145 @@
+#ifndef UTILITIES_TRACING_H
+#define UTILITIES_TRACING_H
+
+// Included by every translation unit of the libraries that calls OpenCL, after which each call below is timed and
+// traced when configured with OPENCL_API_TRACING. Otherwise, this header only includes the OpenCL API.
+
+#include <CL/cl.h>
+
+#ifdef OPENCL_API_TRACING
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+namespace tracing
+{
+    // Lets the name of an API be a template argument, so every API gets its own static histogram.
+    template<size_t N>
+    struct ApiName
+    {
+        constexpr ApiName(const char (&name)[N])
+        {
+            std::copy_n(name, N, value);
+        }
+
+        char value[N];
+    };
+
+    // Registered as "opencl_api_<name>_seconds".
+    [[nodiscard]] metrics::Histogram& GetLatencyHistogram(std::string_view apiName);
+
+    // `apiName` must outlive the process, as template argument objects do.
+    void RecordEvent(std::string_view                      apiName,
+                     std::chrono::steady_clock::time_point start,
+                     std::chrono::steady_clock::time_point end,
+                     std::string&&                         argsSummary);
+
+    template<typename Arg>
+    void SummarizeArg(std::ostream& oStream,
+                      const Arg     arg)
+    {
+        if constexpr (std::is_same_v<Arg, const char*>)
+        {
+            // Build options and kernel names.
+            oStream << ((arg != nullptr) ? arg : "null");
+        }
+        else if constexpr (std::is_pointer_v<Arg> && std::is_function_v<std::remove_pointer_t<Arg>>)
+        {
+            oStream << ((arg != nullptr) ? "callback" : "null");
+        }
+        else if constexpr (std::is_pointer_v<Arg>)
+        {
+            oStream << static_cast<const void*>(arg);
+        }
+        else
+        {
+            oStream << arg;
+        }
+    }
+
+    template<ApiName apiName, typename Result, typename... Params>
+    Result Call(Result (CL_API_CALL* function)(Params...),
+                const std::type_identity_t<Params>... args)
+    {
+        static metrics::Histogram& latency = GetLatencyHistogram(apiName.value);
+
+        const auto   start  = std::chrono::steady_clock::now();
+        const Result result = function(args...);
+        const auto   end    = std::chrono::steady_clock::now();
+
+        latency.Observe(std::chrono::duration<double>(end - start).count());
+
+        std::ostringstream argsSummary = {};
+        bool               isFirst     = true;
+
+        ((argsSummary << (isFirst ? "" : ", "), SummarizeArg(argsSummary, args), isFirst = false), ...);
+
+        if constexpr (std::is_same_v<Result, cl_int>)
+        {
+            argsSummary << " -> " << result;
+        }
+
+        RecordEvent(apiName.value, start, end, std::move(argsSummary).str());
+
+        return result;
+    }
+
+    // Writes the events of all threads in the Chrome trace event format, which Perfetto and chrome://tracing open.
+    // This also happens at exit, into `settings::apiTraceFilePath`.
+    [[nodiscard]] bool WriteTrace(const std::filesystem::path& traceFilePath);
+}
+
+// Inside its own expansion, the name of a macro is not expanded again, so `::api` names the actual entry point.
+#define clBuildProgram(...)                     tracing::Call<"clBuildProgram">(::clBuildProgram, __VA_ARGS__)
+#define clCloneKernel(...)                      tracing::Call<"clCloneKernel">(::clCloneKernel, __VA_ARGS__)
+#define clCreateBuffer(...)                     tracing::Call<"clCreateBuffer">(::clCreateBuffer, __VA_ARGS__)
+#define clCreateCommandQueueWithProperties(...) tracing::Call<"clCreateCommandQueueWithProperties">(::clCreateCommandQueueWithProperties, __VA_ARGS__)
+#define clCreateContext(...)                    tracing::Call<"clCreateContext">(::clCreateContext, __VA_ARGS__)
+#define clCreateKernel(...)                     tracing::Call<"clCreateKernel">(::clCreateKernel, __VA_ARGS__)
+#define clCreateProgramWithBinary(...)          tracing::Call<"clCreateProgramWithBinary">(::clCreateProgramWithBinary, __VA_ARGS__)
+#define clCreateProgramWithIL(...)              tracing::Call<"clCreateProgramWithIL">(::clCreateProgramWithIL, __VA_ARGS__)
+#define clCreateProgramWithSource(...)          tracing::Call<"clCreateProgramWithSource">(::clCreateProgramWithSource, __VA_ARGS__)
+#define clCreateSubDevices(...)                 tracing::Call<"clCreateSubDevices">(::clCreateSubDevices, __VA_ARGS__)
+#define clEnqueueBarrierWithWaitList(...)       tracing::Call<"clEnqueueBarrierWithWaitList">(::clEnqueueBarrierWithWaitList, __VA_ARGS__)
+#define clEnqueueFillBuffer(...)                tracing::Call<"clEnqueueFillBuffer">(::clEnqueueFillBuffer, __VA_ARGS__)
+#define clEnqueueMapBuffer(...)                 tracing::Call<"clEnqueueMapBuffer">(::clEnqueueMapBuffer, __VA_ARGS__)
+#define clEnqueueMarkerWithWaitList(...)        tracing::Call<"clEnqueueMarkerWithWaitList">(::clEnqueueMarkerWithWaitList, __VA_ARGS__)
+#define clEnqueueNDRangeKernel(...)             tracing::Call<"clEnqueueNDRangeKernel">(::clEnqueueNDRangeKernel, __VA_ARGS__)
+#define clEnqueueReadBuffer(...)                tracing::Call<"clEnqueueReadBuffer">(::clEnqueueReadBuffer, __VA_ARGS__)
+#define clEnqueueUnmapMemObject(...)            tracing::Call<"clEnqueueUnmapMemObject">(::clEnqueueUnmapMemObject, __VA_ARGS__)
+#define clEnqueueWriteBuffer(...)               tracing::Call<"clEnqueueWriteBuffer">(::clEnqueueWriteBuffer, __VA_ARGS__)
+#define clFinish(...)                           tracing::Call<"clFinish">(::clFinish, __VA_ARGS__)
+#define clFlush(...)                            tracing::Call<"clFlush">(::clFlush, __VA_ARGS__)
+#define clGetCommandQueueInfo(...)              tracing::Call<"clGetCommandQueueInfo">(::clGetCommandQueueInfo, __VA_ARGS__)
+#define clGetContextInfo(...)                   tracing::Call<"clGetContextInfo">(::clGetContextInfo, __VA_ARGS__)
+#define clGetDeviceIDs(...)                     tracing::Call<"clGetDeviceIDs">(::clGetDeviceIDs, __VA_ARGS__)
+#define clGetDeviceInfo(...)                    tracing::Call<"clGetDeviceInfo">(::clGetDeviceInfo, __VA_ARGS__)
+#define clGetKernelInfo(...)                    tracing::Call<"clGetKernelInfo">(::clGetKernelInfo, __VA_ARGS__)
+#define clGetKernelWorkGroupInfo(...)           tracing::Call<"clGetKernelWorkGroupInfo">(::clGetKernelWorkGroupInfo, __VA_ARGS__)
+#define clGetPlatformIDs(...)                   tracing::Call<"clGetPlatformIDs">(::clGetPlatformIDs, __VA_ARGS__)
+#define clGetPlatformInfo(...)                  tracing::Call<"clGetPlatformInfo">(::clGetPlatformInfo, __VA_ARGS__)
+#define clGetProgramBuildInfo(...)              tracing::Call<"clGetProgramBuildInfo">(::clGetProgramBuildInfo, __VA_ARGS__)
+#define clGetProgramInfo(...)                   tracing::Call<"clGetProgramInfo">(::clGetProgramInfo, __VA_ARGS__)
+#define clReleaseCommandQueue(...)              tracing::Call<"clReleaseCommandQueue">(::clReleaseCommandQueue, __VA_ARGS__)
+#define clReleaseContext(...)                   tracing::Call<"clReleaseContext">(::clReleaseContext, __VA_ARGS__)
+#define clReleaseDevice(...)                    tracing::Call<"clReleaseDevice">(::clReleaseDevice, __VA_ARGS__)
+#define clReleaseEvent(...)                     tracing::Call<"clReleaseEvent">(::clReleaseEvent, __VA_ARGS__)
+#define clReleaseKernel(...)                    tracing::Call<"clReleaseKernel">(::clReleaseKernel, __VA_ARGS__)
+#define clReleaseMemObject(...)                 tracing::Call<"clReleaseMemObject">(::clReleaseMemObject, __VA_ARGS__)
+#define clReleaseProgram(...)                   tracing::Call<"clReleaseProgram">(::clReleaseProgram, __VA_ARGS__)
+#define clSetKernelArg(...)                     tracing::Call<"clSetKernelArg">(::clSetKernelArg, __VA_ARGS__)
+#define clUnloadPlatformCompiler(...)           tracing::Call<"clUnloadPlatformCompiler">(::clUnloadPlatformCompiler, __VA_ARGS__)
+#define clWaitForEvents(...)                    tracing::Call<"clWaitForEvents">(::clWaitForEvents, __VA_ARGS__)
+
+#endif // OPENCL_API_TRACING
+
+
+#endif // UTILITIES_TRACING_H
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef ELEMENTWISE_BUILD_H
+#define ELEMENTWISE_BUILD_H
+
+#include <filesystem>
+#include <string>
+
+
+namespace build::elementwise
+{
+    inline extern const std::filesystem::path clBinaryRoot = std::filesystem::current_path() / "Elementwise_CL_Binaries";
+
+#ifdef _DEBUG
+    inline extern const std::string clBinaryFileNameSuffix = "_ClBinary_Debug.cl.bin";
+    inline extern const std::string options                = "-D _DEBUG -cl-opt-disable -Werror -cl-std=CL2.0 -g";
+#elif defined(_RELEASE)
+    inline extern const std::string clBinaryFileNameSuffix = "_ClBinary_Release.cl.bin";
+    inline extern const std::string options                = "-D _RELEASE -Werror -cl-std=CL2.0";
+#endif // _RELEASE
+}
+
+
+#endif // ELEMENTWISE_BUILD_H
\ No newline at end of file
@@ -0,0 +1,368 @@
+#include "build.h"
+#include "debug.h"
+#include "elementwise.h"
+#include "hash.h"
+#include "launch.h"
+#include "program.h"
+#include "program_types.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <string_view>
+#include <utility>
+
+
+namespace
+{
+    // Generated identifiers carry this prefix, so they never collide with the names of arguments.
+    constexpr std::string_view ReservedPrefix = "elementwise_";
+
+
+    bool IsIdentifier(const std::string_view name)
+    {
+        const auto isIdentifierChar = [](const char c)
+        {
+            return (c == '_') || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9'));
+        };
+
+        return !name.empty() && !((name[0] >= '0') && (name[0] <= '9')) && std::ranges::all_of(name, isIdentifierChar);
+    }
+
+
+    std::string_view GetTypeName(const elementwise::ElementType type)
+    {
+        switch (type)
+        {
+        case elementwise::ElementType::Float: return "float";
+        case elementwise::ElementType::Int:   return "int";
+        case elementwise::ElementType::Uint:  return "uint";
+        }
+
+        return {};
+    }
+
+
+    bool IsBuffer(const elementwise::Arg& arg)
+    {
+        return arg.kind != elementwise::ArgKind::Scalar;
+    }
+
+
+    bool IsRead(const elementwise::Arg& arg)
+    {
+        return (arg.kind == elementwise::ArgKind::Input) || (arg.kind == elementwise::ArgKind::InOut);
+    }
+
+
+    bool IsWritten(const elementwise::Arg& arg)
+    {
+        return (arg.kind == elementwise::ArgKind::Output) || (arg.kind == elementwise::ArgKind::InOut);
+    }
+
+
+    bool IsValid(const elementwise::Definition& definition)
+    {
+        const bool isValidVectorWidth = (definition.vectorWidth == 1) || (definition.vectorWidth == 2)  ||
+                                        (definition.vectorWidth == 4) || (definition.vectorWidth == 8)  ||
+                                        (definition.vectorWidth == 16);
+
+        if (!isValidVectorWidth || !IsIdentifier(definition.name) || definition.body.empty())
+        {
+            MSG_STD_ERR("Invalid elementwise operation: ", definition.name);
+            return false;
+        }
+
+        std::set<std::string_view> names = {};
+
+        for (const elementwise::Arg& arg : definition.args)
+        {
+            if (!IsIdentifier(arg.name) || arg.name.starts_with(ReservedPrefix) || !names.insert(arg.name).second)
+            {
+                MSG_STD_ERR("Invalid argument of elementwise operation ", definition.name, ": ", arg.name);
+                return false;
+            }
+        }
+
+        if (std::ranges::none_of(definition.args, IsWritten))
+        {
+            MSG_STD_ERR("Elementwise operation ", definition.name, " writes no output.");
+            return false;
+        }
+
+        return true;
+    }
+
+
+    // Declares the body's variables for one element (`vectorWidth` of 1) or one vector, evaluates the body, and
+    // stores the outputs.
+    void GenerateEvaluation(const elementwise::Definition& definition,
+                            const cl_uint                  vectorWidth,
+                            const std::string_view         index,
+                            const std::string_view         indent,
+                            std::ostringstream&            clSource)
+    {
+        const std::string vectorSuffix = (vectorWidth > 1) ? std::to_string(vectorWidth) : std::string();
+
+        for (const elementwise::Arg& arg : definition.args)
+        {
+            if (!IsBuffer(arg))
+            {
+                continue;
+            }
+
+            clSource << indent << GetTypeName(arg.type) << vectorSuffix << " " << arg.name;
+
+            if (!IsRead(arg))
+            {
+                clSource << ";\n";
+            }
+            else if (vectorWidth > 1)
+            {
+                clSource << " = vload" << vectorWidth << "(0, " << ReservedPrefix << arg.name << " + " << index << ");\n";
+            }
+            else
+            {
+                clSource << " = " << ReservedPrefix << arg.name << "[" << index << "];\n";
+            }
+        }
+
+        clSource << indent << "{ " << definition.body << "; }\n";
+
+        for (const elementwise::Arg& arg : definition.args)
+        {
+            if (!IsWritten(arg))
+            {
+                continue;
+            }
+
+            if (vectorWidth > 1)
+            {
+                clSource << indent << "vstore" << vectorWidth << "(" << arg.name << ", 0, "
+                         << ReservedPrefix << arg.name << " + " << index << ");\n";
+            }
+            else
+            {
+                clSource << indent << ReservedPrefix << arg.name << "[" << index << "] = " << arg.name << ";\n";
+            }
+        }
+    }
+}
+
+
+cl_int elementwise::GenerateSource(const Definition& definition,
+                                   std::string&      clSource)
+{
+    if (!IsValid(definition))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    std::ostringstream source = {};
+
+    source << "__kernel void " << definition.name << "(";
+
+    for (const Arg& arg : definition.args)
+    {
+        if (!IsBuffer(arg))
+        {
+            source << "const " << GetTypeName(arg.type) << " " << arg.name << ", ";
+        }
+        else
+        {
+            source << "__global " << (IsWritten(arg) ? "" : "const ") << GetTypeName(arg.type)
+                   << "* const restrict " << ReservedPrefix << arg.name << ", ";
+        }
+    }
+
+    source << "const ulong " << ReservedPrefix << "len)\n"
+           << "{\n"
+           << "    const size_t " << ReservedPrefix << "offset = get_global_id(0) * " << definition.vectorWidth << ";\n"
+           << "\n"
+           << "    if (" << ReservedPrefix << "offset + " << definition.vectorWidth << " <= " << ReservedPrefix << "len)\n"
+           << "    {\n";
+
+    GenerateEvaluation(definition, definition.vectorWidth, std::string(ReservedPrefix) + "offset", "        ", source);
+
+    // The tail of a problem that is no multiple of the vector width is evaluated one element at a time.
+    source << "    }\n"
+           << "    else\n"
+           << "    {\n"
+           << "        for (size_t " << ReservedPrefix << "i = " << ReservedPrefix << "offset; "
+           << ReservedPrefix << "i < " << ReservedPrefix << "len; " << ReservedPrefix << "i++)\n"
+           << "        {\n";
+
+    GenerateEvaluation(definition, 1, std::string(ReservedPrefix) + "i", "            ", source);
+
+    source << "        }\n"
+           << "    }\n"
+           << "}\n";
+
+    clSource = source.str();
+
+    return CL_SUCCESS;
+}
+
+
+elementwise::Kernel::~Kernel() noexcept
+{
+    Release();
+}
+
+
+elementwise::Kernel::Kernel(Kernel&& other) noexcept :
+    m_program(std::exchange(other.m_program, nullptr)),
+    m_kernel(std::exchange(other.m_kernel, nullptr)),
+    m_nArgs(std::exchange(other.m_nArgs, 0)),
+    m_vectorWidth(std::exchange(other.m_vectorWidth, 1))
+{
+}
+
+
+elementwise::Kernel& elementwise::Kernel::operator=(Kernel&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+
+        m_program     = std::exchange(other.m_program, nullptr);
+        m_kernel      = std::exchange(other.m_kernel, nullptr);
+        m_nArgs       = std::exchange(other.m_nArgs, 0);
+        m_vectorWidth = std::exchange(other.m_vectorWidth, 1);
+    }
+
+    return *this;
+}
+
+
+cl_int elementwise::Kernel::Build(const cl_context  context,
+                                  const Definition& definition)
+{
+    Release();
+
+    cl_int      result   = CL_SUCCESS;
+    std::string clSource = {};
+
+    result = GenerateSource(definition, clSource);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // The generated source is hashed like an embedded one, so a changed body never loads a stale binary.
+    const program::BinaryCreator binCreator
+    {
+        .clBinaryRoot     = build::elementwise::clBinaryRoot,
+        .clBinaryFileName = definition.name + build::elementwise::clBinaryFileNameSuffix,
+        .clSourceHash     = hash::Fnv1a(clSource)
+    };
+
+    const program::SourceCreator srcCreator
+    {
+        .clSourceRoot      = {},
+        .clSourceFileNames = {},
+        .clSources         = { clSource },
+        .clIl              = {}
+    };
+
+    result = program::Build(context,
+                            std::cref(binCreator),
+                            srcCreator,
+                            build::elementwise::options,
+                            m_program);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    const std::array<const std::string, 1> kernelNames = { definition.name };
+    std::array<cl_kernel, 1>               kernels     = {};
+
+    result = program::CreateKernels(m_program, kernelNames, kernels);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    m_kernel      = kernels[0];
+    m_nArgs       = static_cast<cl_uint>(definition.args.size());
+    m_vectorWidth = definition.vectorWidth;
+
+    return result;
+}
+
+
+void elementwise::Kernel::Release() noexcept
+{
+    if (m_kernel != nullptr)
+    {
+        clReleaseKernel(m_kernel);
+        m_kernel = nullptr;
+    }
+
+    if (m_program != nullptr)
+    {
+        clReleaseProgram(m_program);
+        m_program = nullptr;
+    }
+
+    m_nArgs       = 0;
+    m_vectorWidth = 1;
+}
+
+
+cl_int elementwise::Kernel::SetArg(const cl_uint     index,
+                                   const size_t      sizeInBytes,
+                                   const void* const pValue)
+{
+    // The trailing length argument is owned by `Enqueue`.
+    if (index >= m_nArgs)
+    {
+        return CL_INVALID_ARG_INDEX;
+    }
+
+    cl_int result = CL_SUCCESS;
+
+    result = clSetKernelArg(m_kernel, index, sizeInBytes, pValue);
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
+
+
+cl_int elementwise::Kernel::Enqueue(const cl_command_queue          queue,
+                                    const size_t                    len,
+                                    const std::span<const cl_event> eventsToWaitOn,
+                                    cl_event&                       complete)
+{
+    cl_int         result          = CL_SUCCESS;
+    const cl_ulong clLen           = len;
+    cl_device_id   executingDevice = nullptr;
+    launch::Config config          = {};
+
+    result = clSetKernelArg(m_kernel, m_nArgs, sizeof(clLen), &clLen);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = clGetCommandQueueInfo(queue,
+                                   CL_QUEUE_DEVICE,
+                                   sizeof(executingDevice),
+                                   &executingDevice,
+                                   nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = launch::Plan(m_kernel,
+                          executingDevice,
+                          (len + m_vectorWidth - 1) / m_vectorWidth,
+                          config);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = clEnqueueNDRangeKernel(queue,
+                                    m_kernel,
+                                    1,
+                                    nullptr,
+                                    &config.globalWorkSize,
+                                    &config.localWorkSize,
+                                    static_cast<cl_uint>(eventsToWaitOn.size()),
+                                    eventsToWaitOn.data(),
+                                    &complete);
+
+    OPENCL_PRINT_ON_ERROR(result);
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "elementwise.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+
+class ElementwiseTest : public test_fixture::ContextTest
+{
+protected:
+    template<typename T>
+    cl_mem CreateBuffer(std::vector<T>& host)
+    {
+        cl_int       result = CL_SUCCESS;
+        const cl_mem buffer = clCreateBuffer(s_context,
+                                             CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                             host.size() * sizeof(T),
+                                             host.data(),
+                                             &result);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        return buffer;
+    }
+
+    template<typename T>
+    void ReadBuffer(const cl_mem buffer, const cl_event launch, std::vector<T>& host)
+    {
+        cl_int result = CL_SUCCESS;
+
+        result = clEnqueueReadBuffer(m_queue,
+                                     buffer,
+                                     CL_TRUE,
+                                     0,
+                                     host.size() * sizeof(T),
+                                     host.data(),
+                                     1,
+                                     &launch,
+                                     nullptr);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        result = clReleaseEvent(launch);
+        EXPECT_EQ(result, CL_SUCCESS);
+    }
+
+    static const std::array<size_t, 6> ProblemSizes;
+};
+
+const std::array<size_t, 6> ElementwiseTest::ProblemSizes =
+{
+    1, 33, 1024, (1024 + 1), (1024 + 31), 1000000
+};
+
+
+TEST(Elementwise, RejectsInvalidDefinitions)
+{
+    const std::array<elementwise::Definition, 4> definitions =
+    { {
+            { .name = "1st",  .body = "y = x", .args = { { "x", elementwise::ElementType::Float, elementwise::ArgKind::Input  },
+                                                         { "y", elementwise::ElementType::Float, elementwise::ArgKind::Output } }, .vectorWidth = 4 },
+            { .name = "copy", .body = "y = x", .args = { { "x", elementwise::ElementType::Float, elementwise::ArgKind::Input  },
+                                                         { "x", elementwise::ElementType::Float, elementwise::ArgKind::Output } }, .vectorWidth = 4 },
+            { .name = "copy", .body = "y = x", .args = { { "x", elementwise::ElementType::Float, elementwise::ArgKind::Input  },
+                                                         { "y", elementwise::ElementType::Float, elementwise::ArgKind::Scalar } }, .vectorWidth = 4 },
+            { .name = "copy", .body = "y = x", .args = { { "x", elementwise::ElementType::Float, elementwise::ArgKind::Input  },
+                                                         { "y", elementwise::ElementType::Float, elementwise::ArgKind::Output } }, .vectorWidth = 3 }
+    } };
+
+    for (const elementwise::Definition& definition : definitions)
+    {
+        std::string clSource = {};
+
+        EXPECT_EQ(elementwise::GenerateSource(definition, clSource), CL_INVALID_VALUE);
+    }
+}
+
+
+TEST_F(ElementwiseTest, Axpy)
+{
+    const float A = 2.75;
+
+    elementwise::Launcher<float, cl_mem, cl_mem, cl_mem> axpy = {};
+
+    cl_int result = elementwise::Create(s_context,
+                                        "axpy",
+                                        "z = a * x + y",
+                                        4,
+                                        axpy,
+                                        elementwise::Scalar<float>{ "a" },
+                                        elementwise::Input<float>{ "x" },
+                                        elementwise::Input<float>{ "y" },
+                                        elementwise::Output<float>{ "z" });
+
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    for (const size_t problemSize : ProblemSizes)
+    {
+        std::vector<float> xHost(problemSize);
+        std::vector<float> yHost(problemSize);
+        std::vector<float> zHost(problemSize);
+        std::vector<float> solution(problemSize);
+        cl_event           launch = nullptr;
+
+        std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandCenteredFloat);
+        std::generate(yHost.begin(), yHost.end(), test_fixture::GetRandCenteredFloat);
+
+        const cl_mem xDevice = CreateBuffer(xHost);
+        const cl_mem yDevice = CreateBuffer(yHost);
+        const cl_mem zDevice = CreateBuffer(zHost);
+
+        result = axpy.Enqueue(m_queue, problemSize, {}, launch, A, xDevice, yDevice, zDevice);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        ReadBuffer(zDevice, launch, zHost);
+
+        std::transform(xHost.cbegin(), xHost.cend(),
+                       yHost.cbegin(),
+                       solution.begin(),
+                       [=](float x, float y) { return (A * x) + y; });
+
+        EXPECT_EQ(solution, zHost) << "Host and generated axpy results are not equal";
+
+        for (const cl_mem buffer : { xDevice, yDevice, zDevice })
+        {
+            result = clReleaseMemObject(buffer);
+            EXPECT_EQ(result, CL_SUCCESS);
+        }
+    }
+}
+
+
+TEST_F(ElementwiseTest, Relu)
+{
+    elementwise::Launcher<cl_mem, cl_mem> relu = {};
+
+    cl_int result = elementwise::Create(s_context,
+                                        "relu",
+                                        "y = max(x, 0.0f)",
+                                        8,
+                                        relu,
+                                        elementwise::Input<float>{ "x" },
+                                        elementwise::Output<float>{ "y" });
+
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    for (const size_t problemSize : ProblemSizes)
+    {
+        std::vector<float> xHost(problemSize);
+        std::vector<float> yHost(problemSize);
+        std::vector<float> solution(problemSize);
+        cl_event           launch = nullptr;
+
+        std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandCenteredFloat);
+
+        const cl_mem xDevice = CreateBuffer(xHost);
+        const cl_mem yDevice = CreateBuffer(yHost);
+
+        result = relu.Enqueue(m_queue, problemSize, {}, launch, xDevice, yDevice);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        ReadBuffer(yDevice, launch, yHost);
+
+        std::transform(xHost.cbegin(), xHost.cend(),
+                       solution.begin(),
+                       [](float x) { return std::max(x, 0.0f); });
+
+        EXPECT_EQ(solution, yHost) << "Host and generated relu results are not equal";
+
+        for (const cl_mem buffer : { xDevice, yDevice })
+        {
+            result = clReleaseMemObject(buffer);
+            EXPECT_EQ(result, CL_SUCCESS);
+        }
+    }
+}
+
+
+TEST_F(ElementwiseTest, InPlaceIntegerScale)
+{
+    const cl_int K = -3;
+
+    elementwise::Launcher<cl_int, cl_mem> scale = {};
+
+    cl_int result = elementwise::Create(s_context,
+                                        "scale",
+                                        "x = k * x",
+                                        4,
+                                        scale,
+                                        elementwise::Scalar<cl_int>{ "k" },
+                                        elementwise::InOut<cl_int>{ "x" });
+
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    for (const size_t problemSize : ProblemSizes)
+    {
+        std::vector<cl_int> xHost(problemSize);
+        std::vector<cl_int> solution(problemSize);
+        cl_event            launch = nullptr;
+
+        std::generate(xHost.begin(), xHost.end(), []() { return static_cast<cl_int>(std::rand() % 1000); });
+
+        std::transform(xHost.cbegin(), xHost.cend(),
+                       solution.begin(),
+                       [=](cl_int x) { return K * x; });
+
+        const cl_mem xDevice = CreateBuffer(xHost);
+
+        result = scale.Enqueue(m_queue, problemSize, {}, launch, K, xDevice);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        ReadBuffer(xDevice, launch, xHost);
+
+        EXPECT_EQ(solution, xHost) << "Host and generated in-place scale results are not equal";
+
+        result = clReleaseMemObject(xDevice);
+        EXPECT_EQ(result, CL_SUCCESS);
+    }
+}
\ No newline at end of file
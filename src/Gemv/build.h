@@ -0,0 +1,63 @@
+#ifndef GEMV_BUILD_H
+#define GEMV_BUILD_H
+
+#include "gemv.cl.h"
+#include "program_types.h"
+
+#ifdef EMBEDDED_SPIRV_GEMV
+#include "gemv.spv.h"
+#endif // EMBEDDED_SPIRV_GEMV
+
+#include <array>
+#include <filesystem>
+#include <string>
+
+
+namespace build::gemv
+{
+    inline extern const std::filesystem::path clBinaryRoot = std::filesystem::current_path() / "Gemv_CL_Binaries";
+
+    inline extern const std::array<const std::string, 3> clKernelNames
+    {
+        "gemv_row_major",
+        "gemv_column_major",
+        "gemv_batched"
+    };
+
+    inline extern const program::BinaryCreator binaryCreator
+    {
+        .clBinaryRoot = std::filesystem::current_path() / "Gemv_CL_Binaries",
+#ifdef _DEBUG
+        .clBinaryFileName = "gemv_ClBinary_Debug.cl.bin",
+#elif defined(_RELEASE)
+        .clBinaryFileName = "gemv_ClBinary_Release.cl.bin",
+#endif // _RELEASE
+#ifdef EMBEDDED_SPIRV_GEMV
+        // Programs are built from the SPIR-V module when devices accept it, so a new module versions the binaries too.
+        .clSourceHash     = embedded::cl::gemv::sourceHash ^ embedded::spirv::gemv::ilHash
+#else
+        .clSourceHash     = embedded::cl::gemv::sourceHash
+#endif // EMBEDDED_SPIRV_GEMV
+    };
+
+    inline extern const program::SourceCreator sourceCreator
+    {
+        .clSourceRoot      = {},
+        .clSourceFileNames = {},
+        .clSources         = { embedded::cl::gemv::source },
+#ifdef EMBEDDED_SPIRV_GEMV
+        .clIl              = embedded::spirv::gemv::il
+#else
+        .clIl              = {}
+#endif // EMBEDDED_SPIRV_GEMV
+    };
+
+#ifdef _DEBUG
+    inline extern const std::string options = "-D _DEBUG -cl-opt-disable -Werror -cl-std=CL2.0 -g";
+#elif defined(_RELEASE)
+    inline extern const std::string options = "-D _RELEASE -Werror -cl-std=CL2.0";
+#endif // _RELEASE
+}
+
+
+#endif // GEMV_BUILD_H
\ No newline at end of file
@@ -0,0 +1,145 @@
+// y = alpha * A * x + beta * y, where A is m x n. As in BLAS, a zero beta leaves y unread.
+float gemv_result(const float alpha,
+                  const float dot,
+                  const float beta,
+                  const float y)
+{
+    return (beta == 0.0f) ? (alpha * dot) : fma(alpha, dot, beta * y);
+}
+
+
+// One work-group per row, whose work-items read the row in neighbouring elements and reduce their partial dot
+// products in local memory. The work-group size must be a power of two. Launches beyond the first start at a
+// global offset of whole work-groups.
+__kernel void gemv_row_major(         const ulong                 m,
+                                      const ulong                 n,
+                                      const float                 alpha,
+                             __global const float* const restrict pADevice,
+                                      const ulong                 lda,
+                             __global const float* const restrict pXDevice,
+                                      const float                 beta,
+                             __global       float* const restrict pYDevice,
+                             __local        float* const restrict partials)
+{
+    const uint  localId   = get_local_id(0);
+    const uint  localSize = get_local_size(0);
+    const ulong row       = (get_global_offset(0) / localSize) + get_group_id(0);
+
+    __global const float* const pRow = pADevice + (row * lda);
+
+    float dot = 0.0f;
+
+    for (ulong col = localId; col < n; col += localSize)
+    {
+        dot = fma(pRow[col], pXDevice[col], dot);
+    }
+
+    partials[localId] = dot;
+
+    for (uint active = localSize / 2; active > 0; active /= 2)
+    {
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (localId < active)
+        {
+            partials[localId] += partials[localId + active];
+        }
+    }
+
+    if ((localId == 0) && (row < m))
+    {
+        pYDevice[row] = gemv_result(alpha, partials[0], beta, pYDevice[row]);
+    }
+}
+
+
+// One work-item per row, so neighbouring work-items read neighbouring elements of each column. The columns are
+// walked in blocks of one element of x per work-item, staged in local memory for the whole work-group to share.
+__kernel void gemv_column_major(         const ulong                 m,
+                                         const ulong                 n,
+                                         const float                 alpha,
+                                __global const float* const restrict pADevice,
+                                         const ulong                 lda,
+                                __global const float* const restrict pXDevice,
+                                         const float                 beta,
+                                __global       float* const restrict pYDevice,
+                                __local        float* const restrict xBlock)
+{
+    const uint  localId   = get_local_id(0);
+    const uint  localSize = get_local_size(0);
+    const ulong row       = get_global_id(0);
+
+    float dot = 0.0f;
+
+    for (ulong col0 = 0; col0 < n; col0 += localSize)
+    {
+        const uint blockCols = (uint)min((ulong)localSize, n - col0);
+
+        // The previous block must be consumed by every work-item before it is overwritten.
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (localId < blockCols)
+        {
+            xBlock[localId] = pXDevice[col0 + localId];
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (row < m)
+        {
+            __global const float* const pBlock = pADevice + (col0 * lda) + row;
+
+            for (uint col = 0; col < blockCols; col++)
+            {
+                dot = fma(pBlock[col * lda], xBlock[col], dot);
+            }
+        }
+    }
+
+    if (row < m)
+    {
+        pYDevice[row] = gemv_result(alpha, dot, beta, pYDevice[row]);
+    }
+}
+
+
+// One work-item per row of every matrix in the batch, so small matrices keep the whole device busy. Matrices,
+// and vectors, follow each other `stride*` elements apart. The element at `row` and `col` of a matrix lies at
+// `row * rowStride + col * colStride`, which covers both layouts; reads are coalesced for column-major ones.
+__kernel void gemv_batched(         const ulong                 m,
+                                    const ulong                 n,
+                                    const float                 alpha,
+                           __global const float* const restrict pADevice,
+                                    const ulong                 rowStride,
+                                    const ulong                 colStride,
+                                    const ulong                 strideA,
+                           __global const float* const restrict pXDevice,
+                                    const ulong                 strideX,
+                                    const float                 beta,
+                           __global       float* const restrict pYDevice,
+                                    const ulong                 strideY,
+                                    const ulong                 count)
+{
+    const ulong id = get_global_id(0);
+
+    if (id >= count * m)
+    {
+        return;
+    }
+
+    const ulong matrix = id / m;
+    const ulong row    = id % m;
+
+    __global const float* const pRow = pADevice + (matrix * strideA) + (row * rowStride);
+    __global const float* const pX   = pXDevice + (matrix * strideX);
+    __global       float* const pY   = pYDevice + (matrix * strideY);
+
+    float dot = 0.0f;
+
+    for (ulong col = 0; col < n; col++)
+    {
+        dot = fma(pRow[col * colStride], pX[col], dot);
+    }
+
+    pY[row] = gemv_result(alpha, dot, beta, pY[row]);
+}
\ No newline at end of file
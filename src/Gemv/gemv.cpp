@@ -0,0 +1,258 @@
+#include "build.h"
+#include "debug.h"
+#include "gemv.h"
+#include "kernel.h"
+#include "launch.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+
+namespace
+{
+    // Indices into `build::gemv::clKernelNames`.
+    enum KernelIndex : size_t
+    {
+        RowMajor = 0,
+        ColumnMajor,
+        Batched,
+        Count,
+    };
+
+
+    // A row of 256 work-items already streams at full bandwidth; wider work-groups only lengthen its reduction.
+    constexpr size_t MaxRowWorkGroupSize = 256;
+
+
+    size_t GetLineLength(const gemv::Problem& problem) noexcept
+    {
+        return (problem.layout == gemv::Layout::RowMajor) ? problem.n : problem.m;
+    }
+
+
+    bool IsValid(const gemv::Problem& problem)
+    {
+        return problem.lda >= GetLineLength(problem);
+    }
+
+
+    // Problems of a batch must not overlap in y, which they write.
+    bool IsValid(const gemv::Problem& problem,
+                 const gemv::Batch&   batch)
+    {
+        return IsValid(problem) &&
+               ((batch.count <= 1) || ((batch.strideA >= gemv::GetSizeA(problem)) &&
+                                       (batch.strideX >= problem.n)               &&
+                                       (batch.strideY >= problem.m)));
+    }
+
+
+    cl_int QueryKernelResources(const cl_command_queue   gemvQueue,
+                                const cl_kernel          gemvKernel,
+                                launch::KernelResources& resources)
+    {
+        cl_int       result          = CL_SUCCESS;
+        cl_device_id executingDevice = nullptr;
+
+        result = clGetCommandQueueInfo(gemvQueue,
+                                       CL_QUEUE_DEVICE,
+                                       sizeof(executingDevice),
+                                       &executingDevice,
+                                       nullptr);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        result = launch::QueryKernelResources(gemvKernel, executingDevice, resources);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        return result;
+    }
+
+
+    // The reduction halves the work-group, so its size is a power of two. Short rows get narrower work-groups, so
+    // fewer work-items idle.
+    size_t ChooseRowWorkGroupSize(const launch::KernelResources& resources,
+                                  const size_t                   n) noexcept
+    {
+        const size_t maxLocalWorkSize = std::min({ resources.maxWorkGroupSize, resources.maxWorkItemSize, MaxRowWorkGroupSize });
+
+        return std::min(std::bit_floor(std::max<size_t>(maxLocalWorkSize, 1)),
+                        std::bit_ceil(std::max<size_t>(n, 1)));
+    }
+}
+
+
+cl_int gemv::EnqueueKernel(const Problem&                   problem,
+                           const cl_mem                     aDevice,
+                           const cl_mem                     xDevice,
+                           const cl_mem                     yDevice,
+                           const cl_command_queue           gemvQueue,
+                           const std::span<const cl_kernel> gemvKernels,
+                           const std::span<const cl_event>  eventsToWaitOn,
+                           cl_event&                        gemvComplete)
+{
+    if (!IsValid(problem) || (gemvKernels.size() != KernelIndex::Count))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    cl_int                  result     = CL_SUCCESS;
+    launch::KernelResources resources  = {};
+    const bool              isRowMajor = (problem.layout == Layout::RowMajor);
+    const cl_kernel         gemvKernel = gemvKernels[isRowMajor ? KernelIndex::RowMajor : KernelIndex::ColumnMajor];
+    const cl_ulong          m          = problem.m;
+    const cl_ulong          n          = problem.n;
+    const cl_ulong          lda        = problem.lda;
+
+    result = QueryKernelResources(gemvQueue, gemvKernel, resources);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // Row-major problems launch a work-group per row, column-major ones a work-item per row.
+    const size_t localWorkSize = isRowMajor ? ChooseRowWorkGroupSize(resources, problem.n)
+                                            : launch::ChooseLocalWorkSize(resources, problem.m);
+    const size_t nWorkItems    = isRowMajor ? (problem.m * localWorkSize) : problem.m;
+
+    // Both kernels take one float of local memory per work-item: partial dot products, or a block of x.
+    const std::array<kernel::Arg, 9> kernelArgs =
+    { {
+            { .index = 0, .sizeInBytes = sizeof(m),                     .pValue = &m             },
+            { .index = 1, .sizeInBytes = sizeof(n),                     .pValue = &n             },
+            { .index = 2, .sizeInBytes = sizeof(problem.alpha),         .pValue = &problem.alpha },
+            { .index = 3, .sizeInBytes = sizeof(aDevice),               .pValue = &aDevice       },
+            { .index = 4, .sizeInBytes = sizeof(lda),                   .pValue = &lda           },
+            { .index = 5, .sizeInBytes = sizeof(xDevice),               .pValue = &xDevice       },
+            { .index = 6, .sizeInBytes = sizeof(problem.beta),          .pValue = &problem.beta  },
+            { .index = 7, .sizeInBytes = sizeof(yDevice),               .pValue = &yDevice       },
+            { .index = 8, .sizeInBytes = localWorkSize * sizeof(float), .pValue = nullptr        }
+    } };
+
+    result = kernel::SetArgs(gemvKernel, kernelArgs);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = launch::EnqueueSplit(gemvQueue,
+                                  gemvKernel,
+                                  nWorkItems,
+                                  localWorkSize,
+                                  eventsToWaitOn,
+                                  gemvComplete);
+
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
+
+
+cl_int gemv::EnqueueKernel(const Problem&                   problem,
+                           const Batch&                     batch,
+                           const cl_mem                     aDevice,
+                           const cl_mem                     xDevice,
+                           const cl_mem                     yDevice,
+                           const cl_command_queue           gemvQueue,
+                           const std::span<const cl_kernel> gemvKernels,
+                           const std::span<const cl_event>  eventsToWaitOn,
+                           cl_event&                        gemvComplete)
+{
+    if (!IsValid(problem, batch) || (gemvKernels.size() != KernelIndex::Count))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    cl_int                  result     = CL_SUCCESS;
+    launch::KernelResources resources  = {};
+    const bool              isRowMajor = (problem.layout == Layout::RowMajor);
+    const cl_kernel         gemvKernel = gemvKernels[KernelIndex::Batched];
+    const cl_ulong          m          = problem.m;
+    const cl_ulong          n          = problem.n;
+    const cl_ulong          rowStride  = isRowMajor ? problem.lda : 1;
+    const cl_ulong          colStride  = isRowMajor ? 1 : problem.lda;
+    const cl_ulong          strideA    = batch.strideA;
+    const cl_ulong          strideX    = batch.strideX;
+    const cl_ulong          strideY    = batch.strideY;
+    const cl_ulong          batchCount = batch.count;
+
+    const std::array<kernel::Arg, 13> kernelArgs =
+    { {
+            { .index = 0,  .sizeInBytes = sizeof(m),             .pValue = &m             },
+            { .index = 1,  .sizeInBytes = sizeof(n),             .pValue = &n             },
+            { .index = 2,  .sizeInBytes = sizeof(problem.alpha), .pValue = &problem.alpha },
+            { .index = 3,  .sizeInBytes = sizeof(aDevice),       .pValue = &aDevice       },
+            { .index = 4,  .sizeInBytes = sizeof(rowStride),     .pValue = &rowStride     },
+            { .index = 5,  .sizeInBytes = sizeof(colStride),     .pValue = &colStride     },
+            { .index = 6,  .sizeInBytes = sizeof(strideA),       .pValue = &strideA       },
+            { .index = 7,  .sizeInBytes = sizeof(xDevice),       .pValue = &xDevice       },
+            { .index = 8,  .sizeInBytes = sizeof(strideX),       .pValue = &strideX       },
+            { .index = 9,  .sizeInBytes = sizeof(problem.beta),  .pValue = &problem.beta  },
+            { .index = 10, .sizeInBytes = sizeof(yDevice),       .pValue = &yDevice       },
+            { .index = 11, .sizeInBytes = sizeof(strideY),       .pValue = &strideY       },
+            { .index = 12, .sizeInBytes = sizeof(batchCount),    .pValue = &batchCount    }
+    } };
+
+    result = kernel::SetArgs(gemvKernel, kernelArgs);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = QueryKernelResources(gemvQueue, gemvKernel, resources);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    const size_t nWorkItems = batch.count * problem.m;
+
+    result = launch::EnqueueSplit(gemvQueue,
+                                  gemvKernel,
+                                  nWorkItems,
+                                  launch::ChooseLocalWorkSize(resources, nWorkItems),
+                                  eventsToWaitOn,
+                                  gemvComplete);
+
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
+
+
+size_t gemv::GetSizeA(const Problem& problem) noexcept
+{
+    const size_t lines = (problem.layout == Layout::RowMajor) ? problem.m : problem.n;
+
+    return ((lines == 0) || (GetLineLength(problem) == 0)) ? 0 : ((lines - 1) * problem.lda) + GetLineLength(problem);
+}
+
+
+void gemv::HostExec(const Problem&     problem,
+                    const float* const pAHost,
+                    const float* const pXHost,
+                    float* const       pYHost)
+{
+    const bool   isRowMajor = (problem.layout == Layout::RowMajor);
+    const size_t rowStride  = isRowMajor ? problem.lda : 1;
+    const size_t colStride  = isRowMajor ? 1 : problem.lda;
+
+    for (size_t row = 0; row < problem.m; row++)
+    {
+        float dot = 0.0f;
+
+        for (size_t col = 0; col < problem.n; col++)
+        {
+            dot += pAHost[(row * rowStride) + (col * colStride)] * pXHost[col];
+        }
+
+        // As in BLAS, a zero beta leaves y unread.
+        pYHost[row] = (problem.beta == 0.0f) ? (problem.alpha * dot) : (problem.alpha * dot) + (problem.beta * pYHost[row]);
+    }
+}
+
+
+void gemv::HostExec(const Problem&     problem,
+                    const Batch&       batch,
+                    const float* const pAHost,
+                    const float* const pXHost,
+                    float* const       pYHost)
+{
+    for (size_t i = 0; i < batch.count; i++)
+    {
+        HostExec(problem,
+                 pAHost + (i * batch.strideA),
+                 pXHost + (i * batch.strideX),
+                 pYHost + (i * batch.strideY));
+    }
+}
\ No newline at end of file
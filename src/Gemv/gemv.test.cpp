@@ -0,0 +1,351 @@
+#include "build.h"
+#include "gemv.h"
+#include "program.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <vector>
+
+
+namespace
+{
+    struct Shape
+    {
+        size_t m;
+        size_t n;
+    };
+
+
+    gemv::Problem MakeProblem(const gemv::Layout layout,
+                              const Shape&       shape,
+                              const float        beta,
+                              const size_t       ldPadding) noexcept
+    {
+        return
+        {
+            .layout = layout,
+            .m      = shape.m,
+            .n      = shape.n,
+            .alpha  = 1.5f,
+            .beta   = beta,
+            .lda    = ((layout == gemv::Layout::RowMajor) ? shape.n : shape.m) + ldPadding
+        };
+    }
+}
+
+
+class GemvTest : public test_fixture::ContextTest
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        ContextTest::SetUpTestSuite();
+
+        if (s_context != nullptr)
+        {
+            BuildProgram(build::gemv::binaryCreator,
+                         build::gemv::sourceCreator,
+                         build::gemv::options);
+        }
+    }
+
+    void SetUp() override final
+    {
+        cl_int result = CL_SUCCESS;
+
+        result = program::CreateKernels(s_program,
+                                        build::gemv::clKernelNames,
+                                        m_kernels);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        ContextTest::SetUp();
+    }
+
+    void TearDown() noexcept override final
+    {
+        ReleaseKernels(m_kernels);
+
+        ContextTest::TearDown();
+    }
+
+    cl_mem CreateBuffer(const std::vector<float>& host,
+                        const cl_mem_flags        flags) noexcept
+    {
+        cl_int result = CL_SUCCESS;
+
+        const cl_mem device = clCreateBuffer(s_context,
+                                             flags | CL_MEM_COPY_HOST_PTR,
+                                             host.size() * sizeof(float),
+                                             const_cast<float*>(host.data()),
+                                             &result);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        return device;
+    }
+
+    // Uploads the operands, runs `problem`, or `batch` of it, `iterations` times and downloads y into `yHost`.
+    // Returns the seconds the runs took.
+    double ExecOnDevice(const gemv::Problem&             problem,
+                        const std::optional<gemv::Batch> batch,
+                        const std::vector<float>&        aHost,
+                        const std::vector<float>&        xHost,
+                        std::vector<float>&              yHost,
+                        const size_t                     iterations = 1) noexcept
+    {
+        cl_int result = CL_SUCCESS;
+
+        const cl_mem aDevice = CreateBuffer(aHost, CL_MEM_READ_ONLY);
+        const cl_mem xDevice = CreateBuffer(xHost, CL_MEM_READ_ONLY);
+        const cl_mem yDevice = CreateBuffer(yHost, CL_MEM_READ_WRITE);
+
+        EXPECT_EQ(clFinish(m_queue), CL_SUCCESS);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; i++)
+        {
+            cl_event gemvComplete = nullptr;
+
+            result = batch.has_value() ? gemv::EnqueueKernel(problem,
+                                                             batch.value(),
+                                                             aDevice,
+                                                             xDevice,
+                                                             yDevice,
+                                                             m_queue,
+                                                             m_kernels,
+                                                             {},
+                                                             gemvComplete)
+                                       : gemv::EnqueueKernel(problem,
+                                                             aDevice,
+                                                             xDevice,
+                                                             yDevice,
+                                                             m_queue,
+                                                             m_kernels,
+                                                             {},
+                                                             gemvComplete);
+
+            EXPECT_EQ(result, CL_SUCCESS);
+
+            if (result == CL_SUCCESS)
+            {
+                EXPECT_EQ(clReleaseEvent(gemvComplete), CL_SUCCESS);
+            }
+        }
+
+        EXPECT_EQ(clFinish(m_queue), CL_SUCCESS);
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        result = clEnqueueReadBuffer(m_queue,
+                                     yDevice,
+                                     CL_TRUE,
+                                     0,
+                                     yHost.size() * sizeof(float),
+                                     yHost.data(),
+                                     0,
+                                     nullptr,
+                                     nullptr);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        EXPECT_EQ(clReleaseMemObject(aDevice), CL_SUCCESS);
+        EXPECT_EQ(clReleaseMemObject(xDevice), CL_SUCCESS);
+        EXPECT_EQ(clReleaseMemObject(yDevice), CL_SUCCESS);
+
+        return elapsed.count();
+    }
+
+    // Summation orders differ between host and device, and each of the `n` products may round differently.
+    static void ExpectNear(const std::vector<float>& yHost,
+                           const std::vector<float>& solution,
+                           const size_t              n) noexcept
+    {
+        const float tolerance = 4.0f * static_cast<float>(n + 1) * std::numeric_limits<float>::epsilon();
+
+        for (size_t i = 0; i < yHost.size(); i++)
+        {
+            ASSERT_NEAR(yHost[i], solution[i], tolerance) <<
+                "Host and device gemv execution results differ at element " << i;
+        }
+    }
+
+    std::array<cl_kernel, build::gemv::clKernelNames.size()> m_kernels = {};
+
+    static const std::array<Shape, 7> Shapes;
+};
+
+// Single elements, single rows and columns, rows shorter and longer than a work-group, and empty rows.
+const std::array<Shape, 7> GemvTest::Shapes =
+{ {
+    { .m = 1,    .n = 1    },
+    { .m = 7,    .n = 1    },
+    { .m = 1,    .n = 300  },
+    { .m = 33,   .n = 17   },
+    { .m = 100,  .n = 1025 },
+    { .m = 1055, .n = 5    },
+    { .m = 64,   .n = 0    }
+} };
+
+
+TEST_F(GemvTest, MatchesHostReferenceInBothLayouts)
+{
+    for (const Shape& shape : Shapes)
+    {
+        for (const gemv::Layout layout : { gemv::Layout::RowMajor, gemv::Layout::ColumnMajor })
+        {
+            // A zero beta must not propagate the NaNs of y.
+            for (const float beta : { 0.0f, 0.5f })
+            {
+                for (const size_t ldPadding : { size_t(0), size_t(3) })
+                {
+                    const gemv::Problem problem = MakeProblem(layout, shape, beta, ldPadding);
+
+                    // Zero-sized buffers are invalid, so every buffer holds at least one element.
+                    std::vector<float> aHost(std::max<size_t>(gemv::GetSizeA(problem), 1));
+                    std::vector<float> xHost(std::max<size_t>(shape.n, 1));
+                    std::vector<float> yHost(shape.m, (beta == 0.0f) ? std::numeric_limits<float>::quiet_NaN() : 1.0f);
+
+                    std::generate(aHost.begin(), aHost.end(), test_fixture::GetRandUnitFloat);
+                    std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandUnitFloat);
+
+                    std::vector<float> solution = yHost;
+
+                    gemv::HostExec(problem, aHost.data(), xHost.data(), solution.data());
+                    ExecOnDevice(problem, std::nullopt, aHost, xHost, yHost);
+
+                    ExpectNear(yHost, solution, shape.n);
+                }
+            }
+        }
+    }
+}
+
+
+TEST_F(GemvTest, BatchedMatchesHostReference)
+{
+    constexpr size_t BatchCount = 1000;
+
+    for (const Shape& shape : { Shape{ .m = 4, .n = 4 }, Shape{ .m = 3, .n = 17 }, Shape{ .m = 16, .n = 1 } })
+    {
+        for (const gemv::Layout layout : { gemv::Layout::RowMajor, gemv::Layout::ColumnMajor })
+        {
+            const gemv::Problem problem = MakeProblem(layout, shape, 0.5f, 1);
+
+            // Padding between the problems of the batch must be left alone.
+            const gemv::Batch batch =
+            {
+                .count   = BatchCount,
+                .strideA = gemv::GetSizeA(problem) + 1,
+                .strideX = shape.n + 2,
+                .strideY = shape.m + 3
+            };
+
+            std::vector<float> aHost(batch.count * batch.strideA);
+            std::vector<float> xHost(batch.count * batch.strideX);
+            std::vector<float> yHost(batch.count * batch.strideY);
+
+            std::generate(aHost.begin(), aHost.end(), test_fixture::GetRandUnitFloat);
+            std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandUnitFloat);
+            std::generate(yHost.begin(), yHost.end(), test_fixture::GetRandUnitFloat);
+
+            std::vector<float> solution = yHost;
+
+            gemv::HostExec(problem, batch, aHost.data(), xHost.data(), solution.data());
+            ExecOnDevice(problem, batch, aHost, xHost, yHost);
+
+            ExpectNear(yHost, solution, shape.n);
+        }
+    }
+}
+
+
+TEST_F(GemvTest, DISABLED_ThroughputBenchmark)
+{
+    constexpr Shape  BenchmarkShape = { .m = 4096, .n = 4096 };
+    constexpr size_t BatchCount     = 1 << 18;
+    constexpr Shape  BatchShape     = { .m = 4, .n = 4 };
+    constexpr size_t Iterations     = 16;
+
+    // Reading A and x, and reading and writing y.
+    const auto measureGBps = [this](const gemv::Problem&             problem,
+                                    const std::optional<gemv::Batch> batch)
+    {
+        const size_t count = batch.has_value() ? batch->count : 1;
+
+        std::vector<float> aHost(count * gemv::GetSizeA(problem));
+        std::vector<float> xHost(count * problem.n);
+        std::vector<float> yHost(count * problem.m);
+
+        std::generate(aHost.begin(), aHost.end(), test_fixture::GetRandUnitFloat);
+        std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandUnitFloat);
+        std::generate(yHost.begin(), yHost.end(), test_fixture::GetRandUnitFloat);
+
+        const double seconds = ExecOnDevice(problem, batch, aHost, xHost, yHost, Iterations);
+
+        return ((aHost.size() + xHost.size() + (2 * yHost.size())) * sizeof(float) * Iterations) / seconds / 1e9;
+    };
+
+    for (const gemv::Layout layout : { gemv::Layout::RowMajor, gemv::Layout::ColumnMajor })
+    {
+        const gemv::Problem problem = MakeProblem(layout, BenchmarkShape, 0.5f, 0);
+        const gemv::Problem small   = MakeProblem(layout, BatchShape, 0.5f, 0);
+
+        const gemv::Batch batch =
+        {
+            .count   = BatchCount,
+            .strideA = gemv::GetSizeA(small),
+            .strideX = small.n,
+            .strideY = small.m
+        };
+
+        std::cout << "[ BENCHMARK] " << ((layout == gemv::Layout::RowMajor) ? "Row-major " : "Column-major ")
+                  << BenchmarkShape.m << " x " << BenchmarkShape.n << ": " << measureGBps(problem, std::nullopt) << " GB/s, "
+                  << BatchCount << " batched " << BatchShape.m << " x " << BatchShape.n << ": " << measureGBps(small, batch)
+                  << " GB/s\n";
+    }
+}
+
+
+TEST(Gemv, RejectsInvalidProblems)
+{
+    std::array<cl_kernel, build::gemv::clKernelNames.size()> kernels      = {};
+    cl_event                                                 gemvComplete = nullptr;
+
+    gemv::Problem problem = MakeProblem(gemv::Layout::RowMajor, { .m = 4, .n = 8 }, 1.0f, 0);
+
+    // Rows of a row-major matrix cannot be closer together than they are long.
+    problem.lda = 7;
+
+    EXPECT_EQ(gemv::EnqueueKernel(problem, nullptr, nullptr, nullptr, nullptr, kernels, {}, gemvComplete),
+              CL_INVALID_VALUE);
+
+    problem.lda = 8;
+
+    // Problems of a batch must not write each other's y.
+    const gemv::Batch overlapping =
+    {
+        .count   = 2,
+        .strideA = gemv::GetSizeA(problem),
+        .strideX = problem.n,
+        .strideY = problem.m - 1
+    };
+
+    EXPECT_EQ(gemv::EnqueueKernel(problem, overlapping, nullptr, nullptr, nullptr, nullptr, kernels, {}, gemvComplete),
+              CL_INVALID_VALUE);
+
+    // Every kernel of the program is needed.
+    EXPECT_EQ(gemv::EnqueueKernel(problem, nullptr, nullptr, nullptr, nullptr, std::span(kernels).first(2), {}, gemvComplete),
+              CL_INVALID_VALUE);
+}
\ No newline at end of file
@@ -2,6 +2,11 @@
 #define SAXPY_BUILD_H
 
 #include "program_types.h"
+#include "saxpy.cl.h"
+
+#ifdef EMBEDDED_SPIRV_SAXPY
+#include "saxpy.spv.h"
+#endif // EMBEDDED_SPIRV_SAXPY
 
 #include <array>
 #include <filesystem>
@@ -25,12 +30,24 @@ namespace build::saxpy
 #elif defined(_RELEASE)
         .clBinaryFileName = "saxpy_ClBinary_Release.cl.bin",
 #endif // _RELEASE
+#ifdef EMBEDDED_SPIRV_SAXPY
+        // Programs are built from the SPIR-V module when devices accept it, so a new module versions the binaries too.
+        .clSourceHash     = embedded::cl::saxpy::sourceHash ^ embedded::spirv::saxpy::ilHash
+#else
+        .clSourceHash     = embedded::cl::saxpy::sourceHash
+#endif // EMBEDDED_SPIRV_SAXPY
     };
 
     inline extern const program::SourceCreator sourceCreator
     {
-        .clSourceRoot      = std::filesystem::path(__FILE__).remove_filename(),
-        .clSourceFileNames = {"saxpy.cl"}
+        .clSourceRoot      = {},
+        .clSourceFileNames = {},
+        .clSources         = { embedded::cl::saxpy::source },
+#ifdef EMBEDDED_SPIRV_SAXPY
+        .clIl              = embedded::spirv::saxpy::il
+#else
+        .clIl              = {}
+#endif // EMBEDDED_SPIRV_SAXPY
     };
 
 #ifdef _DEBUG
@@ -0,0 +1,324 @@
+#include "coalescer.h"
+#include "debug.h"
+#include "saxpy.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <bit>
+#include <map>
+#include <stdint.h>
+
+
+namespace
+{
+    // Latency percentiles describe this many of the most recent requests.
+    constexpr size_t LatencySampleCapacity = 1 << 16;
+}
+
+
+saxpy::Coalescer::Coalescer(const cl_context       context,
+                            const cl_command_queue queue,
+                            const cl_kernel        kernel,
+                            const Options&         options) :
+    m_context(context),
+    m_queue(queue),
+    m_kernel(kernel),
+    m_options(options)
+{
+    m_flushThread = std::thread(&Coalescer::FlushContinuously, this);
+}
+
+
+saxpy::Coalescer::~Coalescer() noexcept
+{
+    {
+        const std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_requestsAvailable.notify_one();
+    m_flushThread.join();
+}
+
+
+std::future<cl_int> saxpy::Coalescer::Submit(const float                  a,
+                                             const std::span<const float> x,
+                                             const std::span<const float> y,
+                                             const std::span<float>       z)
+{
+    Request request =
+    {
+        .a          = a,
+        .x          = x,
+        .y          = y,
+        .z          = z,
+        .completion = {},
+        .submitted  = std::chrono::steady_clock::now()
+    };
+
+    std::future<cl_int> completion = request.completion.get_future();
+
+    if ((x.size() != y.size()) || (x.size() != z.size()))
+    {
+        request.completion.set_value(CL_INVALID_VALUE);
+        return completion;
+    }
+
+    bool notify = false;
+
+    {
+        const std::lock_guard lock(m_mutex);
+
+        // The flush thread only needs waking to start timing a new batch, or to flush a full one early.
+        notify             = m_pending.empty() || (m_pendingElements + x.size() >= m_options.maxBatchSizeInElements);
+        m_pendingElements += x.size();
+
+        m_pending.push_back(std::move(request));
+    }
+
+    if (notify)
+    {
+        m_requestsAvailable.notify_one();
+    }
+
+    return completion;
+}
+
+
+void saxpy::Coalescer::FlushContinuously()
+{
+    std::unique_lock lock(m_mutex);
+
+    while (true)
+    {
+        if (m_pending.empty())
+        {
+            if (m_stopping)
+            {
+                return;
+            }
+
+            m_requestsAvailable.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+            continue;
+        }
+
+        const auto deadline = m_pending.front().submitted + m_options.maxDelay;
+
+        m_requestsAvailable.wait_until(lock, deadline, [this]()
+        {
+            return m_stopping || (m_pendingElements >= m_options.maxBatchSizeInElements);
+        });
+
+        std::vector<Request> batch = std::move(m_pending);
+
+        m_pending.clear();
+        m_pendingElements = 0;
+
+        // Requests keep accumulating for the next batch while this one executes.
+        lock.unlock();
+        Flush(batch);
+        lock.lock();
+    }
+}
+
+
+void saxpy::Coalescer::Flush(std::vector<Request>& batch)
+{
+    // The kernel scales every element by the same `a`, so requests are packed per distinct value. The bit pattern
+    // keys the groups, as floating-point comparisons cannot tell apart e.g. 0 and -0.
+    std::map<uint32_t, std::vector<Request*>> groups = {};
+
+    for (Request& request : batch)
+    {
+        groups[std::bit_cast<uint32_t>(request.a)].push_back(&request);
+    }
+
+    for (const auto& [a, group] : groups)
+    {
+        Launch(group);
+    }
+}
+
+
+void saxpy::Coalescer::Launch(const std::span<Request* const> group)
+{
+    size_t len = 0;
+
+    for (const Request* const request : group)
+    {
+        len += request->x.size();
+    }
+
+    cl_int result = CL_SUCCESS;
+
+    if (len > 0)
+    {
+        std::vector<float> xPacked(len);
+        std::vector<float> yPacked(len);
+        std::vector<float> zPacked(len);
+
+        size_t offset = 0;
+
+        for (const Request* const request : group)
+        {
+            std::ranges::copy(request->x, xPacked.begin() + offset);
+            std::ranges::copy(request->y, yPacked.begin() + offset);
+
+            offset += request->x.size();
+        }
+
+        const size_t sizeInBytes = len * sizeof(float);
+        cl_mem       xDevice     = nullptr;
+        cl_mem       yDevice     = nullptr;
+        cl_mem       zDevice     = nullptr;
+        cl_event     saxpyExec   = nullptr;
+
+        xDevice = clCreateBuffer(m_context,
+                                 CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS | CL_MEM_COPY_HOST_PTR,
+                                 sizeInBytes,
+                                 xPacked.data(),
+                                 &result);
+
+        if (result == CL_SUCCESS)
+        {
+            yDevice = clCreateBuffer(m_context,
+                                     CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS | CL_MEM_COPY_HOST_PTR,
+                                     sizeInBytes,
+                                     yPacked.data(),
+                                     &result);
+        }
+
+        if (result == CL_SUCCESS)
+        {
+            zDevice = clCreateBuffer(m_context,
+                                     CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY,
+                                     sizeInBytes,
+                                     nullptr,
+                                     &result);
+        }
+
+        if (result == CL_SUCCESS)
+        {
+            result = saxpy::EnqueueKernel(group.front()->a,
+                                          xDevice,
+                                          yDevice,
+                                          zDevice,
+                                          len,
+                                          m_queue,
+                                          m_kernel,
+                                          {},
+                                          saxpyExec);
+        }
+
+        if (result == CL_SUCCESS)
+        {
+            result = clEnqueueReadBuffer(m_queue,
+                                         zDevice,
+                                         CL_TRUE,
+                                         0,
+                                         sizeInBytes,
+                                         zPacked.data(),
+                                         1,
+                                         &saxpyExec,
+                                         nullptr);
+        }
+
+        OPENCL_PRINT_ON_ERROR(result);
+
+        if (saxpyExec != nullptr)
+        {
+            clReleaseEvent(saxpyExec);
+        }
+
+        for (const cl_mem buffer : { xDevice, yDevice, zDevice })
+        {
+            if (buffer != nullptr)
+            {
+                clReleaseMemObject(buffer);
+            }
+        }
+
+        if (result == CL_SUCCESS)
+        {
+            offset = 0;
+
+            for (Request* const request : group)
+            {
+                std::copy_n(zPacked.begin() + offset, request->z.size(), request->z.begin());
+
+                offset += request->z.size();
+            }
+        }
+    }
+
+    RecordLatencies(group, len > 0);
+
+    for (Request* const request : group)
+    {
+        request->completion.set_value(result);
+    }
+}
+
+
+void saxpy::Coalescer::RecordLatencies(const std::span<Request* const> group,
+                                       const bool                      launched)
+{
+    const auto            completed = std::chrono::steady_clock::now();
+    const std::lock_guard lock(m_statisticsMutex);
+
+    for (const Request* const request : group)
+    {
+        const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(completed - request->submitted);
+
+        // Once full, the samples form a ring buffer indexed by the request count.
+        if (m_latencies.size() < LatencySampleCapacity)
+        {
+            m_latencies.push_back(latency);
+        }
+        else
+        {
+            m_latencies[m_nRequests % LatencySampleCapacity] = latency;
+        }
+
+        m_nRequests++;
+    }
+
+    if (launched)
+    {
+        m_nLaunches++;
+    }
+}
+
+
+saxpy::Coalescer::Statistics saxpy::Coalescer::GetStatistics() const
+{
+    std::vector<std::chrono::microseconds> latencies  = {};
+    Statistics                             statistics = {};
+
+    {
+        const std::lock_guard lock(m_statisticsMutex);
+
+        latencies            = m_latencies;
+        statistics.nRequests = m_nRequests;
+        statistics.nLaunches = m_nLaunches;
+    }
+
+    if (latencies.empty())
+    {
+        return statistics;
+    }
+
+    const auto getPercentile = [&latencies](const size_t percentile)
+    {
+        const auto nth = latencies.begin() + ((latencies.size() - 1) * percentile) / 100;
+
+        std::ranges::nth_element(latencies, nth);
+
+        return *nth;
+    };
+
+    statistics.p50Latency = getPercentile(50);
+    statistics.p99Latency = getPercentile(99);
+
+    return statistics;
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "build.h"
+#include "coalescer.h"
+#include "program.h"
+#include "saxpy.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+
+class CoalescerTest : public test_fixture::ContextTest
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        ContextTest::SetUpTestSuite();
+
+        if (s_context != nullptr)
+        {
+            BuildProgram(build::saxpy::binaryCreator,
+                         build::saxpy::sourceCreator,
+                         build::saxpy::options);
+        }
+    }
+
+    void SetUp() override final
+    {
+        cl_int                                                    result  = CL_SUCCESS;
+        std::array<cl_kernel, build::saxpy::clKernelNames.size()> kernels = {};
+
+        result = program::CreateKernels(s_program,
+                                        build::saxpy::clKernelNames,
+                                        kernels);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        m_kernel = kernels[0];
+
+        ContextTest::SetUp();
+    }
+
+    void TearDown() noexcept override final
+    {
+        ReleaseKernels({ &m_kernel, 1 });
+
+        ContextTest::TearDown();
+    }
+
+    cl_kernel m_kernel = nullptr;
+};
+
+
+TEST_F(CoalescerTest, CompletesEveryRequestFromPackedLaunches)
+{
+    constexpr size_t                nThreads          = 4;
+    constexpr size_t                RequestsPerThread = 256;
+    constexpr std::array<float, 2>  As                = { 2.75f, -0.5f };
+    constexpr std::array<size_t, 4> RequestSizes      = { 1, 7, 64, 333 };
+
+    struct Request
+    {
+        float               a;
+        std::vector<float>  x;
+        std::vector<float>  y;
+        std::vector<float>  z;
+        std::future<cl_int> completion;
+    };
+
+    std::vector<std::vector<Request>> threadRequests(nThreads);
+
+    for (size_t i = 0; i < nThreads; i++)
+    {
+        for (size_t j = 0; j < RequestsPerThread; j++)
+        {
+            const size_t requestSize = RequestSizes[j % RequestSizes.size()];
+            Request      request     =
+            {
+                .a          = As[(i + j) % As.size()],
+                .x          = std::vector<float>(requestSize),
+                .y          = std::vector<float>(requestSize),
+                .z          = std::vector<float>(requestSize),
+                .completion = {}
+            };
+
+            std::generate(request.x.begin(), request.x.end(), test_fixture::GetRandFloat);
+            std::generate(request.y.begin(), request.y.end(), test_fixture::GetRandFloat);
+
+            threadRequests[i].push_back(std::move(request));
+        }
+    }
+
+    saxpy::Coalescer coalescer(s_context,
+                               m_queue,
+                               m_kernel,
+                               { .maxBatchSizeInElements = 1 << 14, .maxDelay = std::chrono::microseconds(500) });
+
+    {
+        std::vector<std::thread> threads = {};
+
+        for (std::vector<Request>& requests : threadRequests)
+        {
+            threads.emplace_back([&coalescer, &requests]()
+            {
+                for (Request& request : requests)
+                {
+                    request.completion = coalescer.Submit(request.a, request.x, request.y, request.z);
+                }
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    for (std::vector<Request>& requests : threadRequests)
+    {
+        for (Request& request : requests)
+        {
+            std::vector<float> solution(request.x.size());
+
+            ASSERT_EQ(request.completion.get(), CL_SUCCESS);
+
+            saxpy::HostExec(request.a,
+                            request.x.data(),
+                            request.y.data(),
+                            solution.data(),
+                            solution.size());
+
+            EXPECT_EQ(solution, request.z) << "Host and coalesced device saxpy execution results are not equal";
+        }
+    }
+
+    const saxpy::Coalescer::Statistics statistics = coalescer.GetStatistics();
+
+    EXPECT_EQ(statistics.nRequests, nThreads * RequestsPerThread);
+    EXPECT_LT(statistics.nLaunches, statistics.nRequests);
+    EXPECT_LE(statistics.p50Latency, statistics.p99Latency);
+
+    // Latencies depend on the machine, so they are only recorded alongside the results, e.g. with --gtest_output=xml.
+    RecordProperty("launches",       static_cast<int>(statistics.nLaunches));
+    RecordProperty("p50LatencyInUs", static_cast<int>(statistics.p50Latency.count()));
+    RecordProperty("p99LatencyInUs", static_cast<int>(statistics.p99Latency.count()));
+}
+
+
+TEST_F(CoalescerTest, RejectsMismatchedSpans)
+{
+    const std::vector<float> x(4);
+    const std::vector<float> y(3);
+    std::vector<float>       z(4);
+
+    saxpy::Coalescer coalescer(s_context,
+                               m_queue,
+                               m_kernel,
+                               { .maxBatchSizeInElements = 1024, .maxDelay = std::chrono::microseconds(100) });
+
+    EXPECT_EQ(coalescer.Submit(1.0f, x, y, z).get(), CL_INVALID_VALUE);
+}
\ No newline at end of file
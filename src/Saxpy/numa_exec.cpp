@@ -0,0 +1,353 @@
+#include "build.h"
+#include "debug.h"
+#include "device.h"
+#include "numa_exec.h"
+#include "program.h"
+#include "saxpy.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+
+
+saxpy::NumaExec::~NumaExec() noexcept
+{
+    Release();
+}
+
+
+cl_int saxpy::NumaExec::Init(const cl_device_id device,
+                             const size_t       len,
+                             const bool         partitionByNuma)
+{
+    Release();
+
+    cl_int                    result   = CL_SUCCESS;
+    cl_platform_id            platform = nullptr;
+    std::vector<cl_device_id> devices  = {};
+
+    result = clGetDeviceInfo(device,
+                             CL_DEVICE_PLATFORM,
+                             sizeof(platform),
+                             &platform,
+                             nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    if (partitionByNuma)
+    {
+        bool supportsNuma = false;
+
+        result = device::SupportsAffinityDomain(device,
+                                                CL_DEVICE_AFFINITY_DOMAIN_NUMA,
+                                                supportsNuma);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        // Partitioning a host with a single node either fails or yields one sub-device; both leave the device whole.
+        if (supportsNuma && (device::PartitionByAffinityDomain(device, CL_DEVICE_AFFINITY_DOMAIN_NUMA, devices) == CL_SUCCESS))
+        {
+            if (devices.size() == 1)
+            {
+                clReleaseDevice(devices.front());
+                devices.resize(0);
+            }
+        }
+    }
+
+    m_ownsSubDevices = !devices.empty();
+
+    if (!m_ownsSubDevices)
+    {
+        devices.push_back(device);
+    }
+
+    // Partitions own their sub-devices from here on, so that `Release` lets go of them whatever fails next.
+    m_partitions.resize(devices.size());
+
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        m_partitions[i].device = devices[i];
+    }
+
+    const std::array<const cl_context_properties, 3> properties
+    {
+        CL_CONTEXT_PLATFORM,
+        reinterpret_cast<cl_context_properties>(platform),
+        0
+    };
+
+    m_context = clCreateContext(properties.data(),
+                                static_cast<cl_uint>(devices.size()),
+                                devices.data(),
+                                nullptr,
+                                nullptr,
+                                &result);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = program::Build(m_context,
+                            std::cref(build::saxpy::binaryCreator),
+                            build::saxpy::sourceCreator,
+                            build::saxpy::options,
+                            m_program);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // Slices are proportional to compute units, since sockets of one machine may have been given different numbers.
+    std::vector<cl_uint> computeUnits(devices.size(), 0);
+    size_t               totalComputeUnits = 0;
+
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        result = device::QueryParamValue(devices[i],
+                                         CL_DEVICE_MAX_COMPUTE_UNITS,
+                                         computeUnits[i]);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        totalComputeUnits += computeUnits[i];
+    }
+
+    size_t sliceOffset            = 0;
+    size_t cumulativeComputeUnits = 0;
+
+    for (size_t i = 0; i < m_partitions.size(); i++)
+    {
+        cumulativeComputeUnits += computeUnits[i];
+
+        const size_t sliceEnd = (i + 1 == m_partitions.size()) ? len
+                                                               : (len * cumulativeComputeUnits) / std::max<size_t>(totalComputeUnits, 1);
+
+        m_partitions[i].len = sliceEnd - sliceOffset;
+        sliceOffset         = sliceEnd;
+
+        result = InitPartition(m_partitions[i]);
+
+        OPENCL_RETURN_ON_ERROR(result);
+    }
+
+    return result;
+}
+
+
+cl_int saxpy::NumaExec::InitPartition(Partition& partition)
+{
+    cl_int       result      = CL_SUCCESS;
+    const size_t sizeInBytes = partition.len * sizeof(float);
+
+    if (partition.len == 0)
+    {
+        return result;
+    }
+
+    partition.queue = clCreateCommandQueueWithProperties(m_context,
+                                                         partition.device,
+                                                         nullptr,
+                                                         &result);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // Each sub-device has its own kernel object, so the arguments of concurrent slices never alias.
+    result = program::CreateKernels(m_program,
+                                    build::saxpy::clKernelNames,
+                                    std::span(&partition.kernel, 1));
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    for (memory::HostAllocation* const pHost : { &partition.xHost, &partition.yHost, &partition.zHost })
+    {
+        if (!pHost->Allocate(sizeInBytes))
+        {
+            MSG_STD_ERR("Failed to allocate host memory for a NUMA partition of: ", sizeInBytes, " bytes");
+            return CL_OUT_OF_HOST_MEMORY;
+        }
+    }
+
+    // The sub-device computes on the memory of its node in place.
+    result = memory::CreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS, partition.xHost.View(), partition.xDevice);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = memory::CreateBuffer(m_context, CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS, partition.yHost.View(), partition.yDevice);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = memory::CreateBuffer(m_context, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, partition.zHost.View(), partition.zDevice);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // OpenCL does not tell which NUMA node a sub-device covers, so its pages are placed by first touch instead. The
+    // sub-device writes them before anyone else does, which CPU runtimes carry out on the cores of the sub-device.
+    const float zero = 0.0f;
+
+    for (const cl_mem buffer : { partition.xDevice, partition.yDevice, partition.zDevice })
+    {
+        result = clEnqueueFillBuffer(partition.queue,
+                                     buffer,
+                                     &zero,
+                                     sizeof(zero),
+                                     0,
+                                     sizeInBytes,
+                                     0,
+                                     nullptr,
+                                     nullptr);
+
+        OPENCL_RETURN_ON_ERROR(result);
+    }
+
+    result = clFinish(partition.queue);
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
+
+
+void saxpy::NumaExec::Release() noexcept
+{
+    for (Partition& partition : m_partitions)
+    {
+        for (const cl_mem buffer : { partition.xDevice, partition.yDevice, partition.zDevice })
+        {
+            if (buffer != nullptr)
+            {
+                clReleaseMemObject(buffer);
+            }
+        }
+
+        if (partition.kernel != nullptr)
+        {
+            clReleaseKernel(partition.kernel);
+        }
+
+        if (partition.queue != nullptr)
+        {
+            clReleaseCommandQueue(partition.queue);
+        }
+
+        if (m_ownsSubDevices)
+        {
+            clReleaseDevice(partition.device);
+        }
+    }
+
+    if (m_program != nullptr)
+    {
+        clReleaseProgram(m_program);
+    }
+
+    if (m_context != nullptr)
+    {
+        clReleaseContext(m_context);
+    }
+
+    m_context        = nullptr;
+    m_program        = nullptr;
+    m_ownsSubDevices = false;
+
+    m_partitions.clear();
+}
+
+
+saxpy::NumaExec::Slice saxpy::NumaExec::GetSlice(const size_t partition) const noexcept
+{
+    return
+    {
+        .x = m_partitions[partition].xHost.ViewAs<float>(),
+        .y = m_partitions[partition].yHost.ViewAs<float>(),
+        .z = m_partitions[partition].zHost.ViewAs<float>()
+    };
+}
+
+
+cl_int saxpy::NumaExec::Exec(const float a)
+{
+    cl_int                result     = CL_SUCCESS;
+    std::vector<cl_event> saxpyExecs(m_partitions.size(), nullptr);
+
+    for (size_t i = 0; i < m_partitions.size(); i++)
+    {
+        const Partition& partition = m_partitions[i];
+
+        if (partition.len == 0)
+        {
+            continue;
+        }
+
+        result = saxpy::EnqueueKernel(a,
+                                      partition.xDevice,
+                                      partition.yDevice,
+                                      partition.zDevice,
+                                      partition.len,
+                                      partition.queue,
+                                      partition.kernel,
+                                      {},
+                                      saxpyExecs[i]);
+
+        if (result != CL_SUCCESS)
+        {
+            break;
+        }
+
+        // Mapping synchronizes the host memory with the device, and is free where the device uses it in place.
+        void* const pZMapped = clEnqueueMapBuffer(partition.queue,
+                                                  partition.zDevice,
+                                                  CL_FALSE,
+                                                  CL_MAP_READ,
+                                                  0,
+                                                  partition.len * sizeof(float),
+                                                  1,
+                                                  &saxpyExecs[i],
+                                                  nullptr,
+                                                  &result);
+
+        if (result != CL_SUCCESS)
+        {
+            break;
+        }
+
+        result = clEnqueueUnmapMemObject(partition.queue,
+                                         partition.zDevice,
+                                         pZMapped,
+                                         0,
+                                         nullptr,
+                                         nullptr);
+
+        if (result != CL_SUCCESS)
+        {
+            break;
+        }
+
+        // Submitting the slice right away lets the sub-devices compute concurrently instead of one after another.
+        result = clFlush(partition.queue);
+
+        if (result != CL_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    // Even after a failure, every enqueued slice must complete before returning.
+    for (const Partition& partition : m_partitions)
+    {
+        if (partition.queue != nullptr)
+        {
+            const cl_int finishResult = clFinish(partition.queue);
+
+            if (result == CL_SUCCESS)
+            {
+                result = finishResult;
+            }
+        }
+    }
+
+    for (const cl_event saxpyExec : saxpyExecs)
+    {
+        if (saxpyExec != nullptr)
+        {
+            clReleaseEvent(saxpyExec);
+        }
+    }
+
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "device.h"
+#include "numa_exec.h"
+#include "platform.h"
+#include "saxpy.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+
+class NumaExecTest : public testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        cl_int                      result    = CL_SUCCESS;
+        std::vector<cl_platform_id> platforms = {};
+
+        result = platform::GetAllConformant(platforms);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        // Sub-devices are mostly offered by CPU runtimes, e.g. PoCL.
+        for (const cl_platform_id platform : platforms)
+        {
+            std::vector<cl_device_id> devices = {};
+
+            result = device::GetAllAvailable(platform, devices);
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            for (const cl_device_id device : devices)
+            {
+                cl_device_type deviceType = 0;
+
+                result = device::QueryParamValue(device, CL_DEVICE_TYPE, deviceType);
+                ASSERT_EQ(result, CL_SUCCESS);
+
+                if ((deviceType & CL_DEVICE_TYPE_CPU) && (s_device == nullptr))
+                {
+                    s_device = device;
+                }
+            }
+        }
+
+        if (s_device == nullptr)
+        {
+            GTEST_SKIP() << "No OpenCL CPU device is available.";
+        }
+    }
+
+    static cl_device_id s_device;
+
+    static const std::array<size_t, 6> ProblemSizes;
+    static const float                 A;
+};
+
+cl_device_id NumaExecTest::s_device = nullptr;
+
+const std::array<size_t, 6> NumaExecTest::ProblemSizes =
+{
+    1, 33, 1024, (1024 + 1), (1024 + 31), 1000000
+};
+
+const float NumaExecTest::A = 2.75;
+
+
+TEST_F(NumaExecTest, PartitionsEquallyAndByCounts)
+{
+    cl_int  result       = CL_SUCCESS;
+    cl_uint computeUnits = 0;
+    bool    supports     = false;
+
+    result = device::QueryParamValue(s_device, CL_DEVICE_MAX_COMPUTE_UNITS, computeUnits);
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    result = device::SupportsPartitioning(s_device, CL_DEVICE_PARTITION_EQUALLY, supports);
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    if (supports)
+    {
+        std::vector<cl_device_id> subDevices = {};
+
+        result = device::PartitionEqually(s_device, 1, subDevices);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        EXPECT_EQ(subDevices.size(), computeUnits);
+
+        for (const cl_device_id subDevice : subDevices)
+        {
+            EXPECT_EQ(clReleaseDevice(subDevice), CL_SUCCESS);
+        }
+    }
+
+    result = device::SupportsPartitioning(s_device, CL_DEVICE_PARTITION_BY_COUNTS, supports);
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    if (supports && (computeUnits >= 2))
+    {
+        const std::array<cl_uint, 2> computeUnitCounts = { 1, computeUnits - 1 };
+        std::vector<cl_device_id>    subDevices        = {};
+
+        result = device::PartitionByCounts(s_device, computeUnitCounts, subDevices);
+        ASSERT_EQ(result, CL_SUCCESS);
+        ASSERT_EQ(subDevices.size(), computeUnitCounts.size());
+
+        for (size_t i = 0; i < subDevices.size(); i++)
+        {
+            cl_uint subDeviceComputeUnits = 0;
+
+            result = device::QueryParamValue(subDevices[i], CL_DEVICE_MAX_COMPUTE_UNITS, subDeviceComputeUnits);
+            EXPECT_EQ(result, CL_SUCCESS);
+            EXPECT_EQ(subDeviceComputeUnits, computeUnitCounts[i]);
+
+            EXPECT_EQ(clReleaseDevice(subDevices[i]), CL_SUCCESS);
+        }
+    }
+}
+
+
+TEST_F(NumaExecTest, ComputesEverySlice)
+{
+    for (const size_t problemSize : ProblemSizes)
+    {
+        saxpy::NumaExec exec = {};
+
+        ASSERT_EQ(exec.Init(s_device, problemSize), CL_SUCCESS);
+
+        std::vector<float> solution(problemSize);
+        size_t             sliceOffset = 0;
+
+        for (size_t i = 0; i < exec.GetPartitionCount(); i++)
+        {
+            const saxpy::NumaExec::Slice slice = exec.GetSlice(i);
+
+            std::generate(slice.x.begin(), slice.x.end(), test_fixture::GetRandFloat);
+            std::generate(slice.y.begin(), slice.y.end(), test_fixture::GetRandFloat);
+
+            saxpy::HostExec(A,
+                            slice.x.data(),
+                            slice.y.data(),
+                            solution.data() + sliceOffset,
+                            slice.x.size());
+
+            sliceOffset += slice.x.size();
+        }
+
+        ASSERT_EQ(sliceOffset, problemSize);
+        ASSERT_EQ(exec.Exec(A), CL_SUCCESS);
+
+        sliceOffset = 0;
+
+        for (size_t i = 0; i < exec.GetPartitionCount(); i++)
+        {
+            const saxpy::NumaExec::Slice slice = exec.GetSlice(i);
+
+            EXPECT_TRUE(std::equal(slice.z.begin(), slice.z.end(), solution.cbegin() + sliceOffset)) <<
+                "Host and NUMA-partitioned device saxpy execution results are not equal";
+
+            sliceOffset += slice.z.size();
+        }
+    }
+}
+
+
+TEST_F(NumaExecTest, DISABLED_ScalingBenchmark)
+{
+    constexpr size_t ProblemSize = 1024 * 1024 * 16;
+    constexpr size_t Iterations  = 16;
+
+    // Moving x and y in, and z out.
+    const auto measureGBps = [](saxpy::NumaExec& exec)
+    {
+        for (size_t i = 0; i < exec.GetPartitionCount(); i++)
+        {
+            const saxpy::NumaExec::Slice slice = exec.GetSlice(i);
+
+            std::generate(slice.x.begin(), slice.x.end(), test_fixture::GetRandFloat);
+            std::generate(slice.y.begin(), slice.y.end(), test_fixture::GetRandFloat);
+        }
+
+        // The first execution absorbs one-off costs, e.g. of faulting in pages.
+        EXPECT_EQ(exec.Exec(A), CL_SUCCESS);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < Iterations; i++)
+        {
+            EXPECT_EQ(exec.Exec(A), CL_SUCCESS);
+        }
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        return (3 * ProblemSize * sizeof(float) * Iterations) / elapsed.count() / 1e9;
+    };
+
+    saxpy::NumaExec wholeExec = {};
+    ASSERT_EQ(wholeExec.Init(s_device, ProblemSize, false), CL_SUCCESS);
+
+    const double wholeGBps = measureGBps(wholeExec);
+    wholeExec.Release();
+
+    saxpy::NumaExec numaExec = {};
+    ASSERT_EQ(numaExec.Init(s_device, ProblemSize), CL_SUCCESS);
+
+    const double numaGBps = measureGBps(numaExec);
+
+    std::cout << "[ BENCHMARK] " << ProblemSize << " elements: "
+              << wholeGBps << " GB/s on the whole device, "
+              << numaGBps  << " GB/s on " << numaExec.GetPartitionCount() << " NUMA partitions"
+              << (numaExec.IsNumaPartitioned() ? "\n" : " (not partitionable)\n");
+}
\ No newline at end of file
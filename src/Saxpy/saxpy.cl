@@ -1,13 +1,65 @@
+// Specializations, all optional and passed as "-D" build options:
+//   SAXPY_A                  the scale, baked in as a constant in place of the `a` argument;
+//   SAXPY_NO_BOUNDS_CHECK    the launches cover exactly `len` elements, so no work-item needs a bounds check;
+//   SAXPY_VECTOR_WIDTH       elements per vector load and store: 1, 2, 4, 8 or 16;
+//   SAXPY_UNROLL             vectors per work-item, processed in an unrolled loop.
+#ifndef SAXPY_VECTOR_WIDTH
+#define SAXPY_VECTOR_WIDTH 1
+#endif
+
+#ifndef SAXPY_UNROLL
+#define SAXPY_UNROLL 1
+#endif
+
+#ifdef SAXPY_A
+#define SAXPY_SCALE SAXPY_A
+#else
+#define SAXPY_SCALE a
+#endif
+
+#define SAXPY_PASTE(x, y) x ## y
+#define SAXPY_EXPAND_PASTE(x, y) SAXPY_PASTE(x, y)
+
+#if SAXPY_VECTOR_WIDTH == 1
+#define SAXPY_LOAD(offset, p)         ((p)[offset])
+#define SAXPY_STORE(value, offset, p) ((p)[offset] = (value))
+#else
+#define SAXPY_LOAD(offset, p)         SAXPY_EXPAND_PASTE(vload, SAXPY_VECTOR_WIDTH)(0, (p) + (offset))
+#define SAXPY_STORE(value, offset, p) SAXPY_EXPAND_PASTE(vstore, SAXPY_VECTOR_WIDTH)(value, 0, (p) + (offset))
+#endif
+
+
 __kernel void saxpy(         const float                 a,
                     __global const float* const restrict pXDevice,
                     __global const float* const restrict pYDevice,
                     __global       float* const restrict pZDevice,
                              const ulong                 len)
 {
-    const size_t globalId = get_global_id(0);
+    // A problem may be split into a main and a tail launch, the latter starting at a global offset. Each launch
+    // covers a contiguous span of elements, beginning where the work-items before it end.
+    const size_t launchOffset = get_global_offset(0);
+    const size_t launchId     = get_global_id(0) - launchOffset;
+    const size_t launchSize   = get_global_size(0);
 
-    if (globalId < len)
+    // Each unrolled step covers a contiguous span of the whole launch, so neighbouring work-items always access
+    // neighbouring vectors.
+    __attribute__((opencl_unroll_hint(SAXPY_UNROLL)))
+    for (uint step = 0; step < SAXPY_UNROLL; step++)
     {
-        pZDevice[globalId] = (a * pXDevice[globalId]) + pYDevice[globalId];
+        const size_t offset = (launchOffset * SAXPY_UNROLL + launchId + step * launchSize) * SAXPY_VECTOR_WIDTH;
+
+#ifndef SAXPY_NO_BOUNDS_CHECK
+        if (offset + SAXPY_VECTOR_WIDTH > len)
+        {
+            for (size_t i = offset; i < len; i++)
+            {
+                pZDevice[i] = (SAXPY_SCALE * pXDevice[i]) + pYDevice[i];
+            }
+
+            continue;
+        }
+#endif // SAXPY_NO_BOUNDS_CHECK
+
+        SAXPY_STORE((SAXPY_SCALE * SAXPY_LOAD(offset, pXDevice)) + SAXPY_LOAD(offset, pYDevice), offset, pZDevice);
     }
-}
+}
\ No newline at end of file
@@ -1,18 +1,167 @@
+#include "concurrency.h"
 #include "debug.h"
+#include "device.h"
+#include "discovery.h"
+#include "kernel.h"
+#include "launch.h"
+#include "memory.h"
+#include "metrics.h"
 #include "saxpy.h"
+#include "tracing.h"
 
 #include <algorithm>
 #include <array>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include <vector>
 
 
 namespace
 {
-    struct KernelArg
+    constexpr size_t BufferAlignmentInElements = 4096 / sizeof(float);
+
+
+    constexpr saxpy::Specialization Generic =
     {
-        cl_uint     index;
-        size_t      sizeInBytes;
-        const void* pValue;
+        .a           = std::nullopt,
+        .exactLaunch = false,
+        .vectorWidth = 1,
+        .unroll      = 1
     };
+
+
+    // Each element reads x and y and writes z.
+    void RecordCall(const size_t len)
+    {
+        static metrics::Counter&   calls      = metrics::GetCounter("saxpy_calls_total",
+                                                                    "Saxpy problems enqueued.");
+        static metrics::Counter&   bytesMoved = metrics::GetCounter("saxpy_bytes_moved_total",
+                                                                    "Bytes of device memory saxpy kernels read and write.");
+        static metrics::Histogram& callBytes  = metrics::GetHistogram("saxpy_call_bytes",
+                                                                      "Bytes of device memory moved per saxpy problem.",
+                                                                      metrics::ExponentialBuckets(4096.0, 4.0, 12));
+
+        const size_t sizeInBytes = 3 * len * sizeof(float);
+
+        calls.Increment();
+        bytesMoved.Increment(sizeInBytes);
+        callBytes.Observe(static_cast<double>(sizeInBytes));
+    }
+
+
+    bool IsValid(const saxpy::Specialization& specialization)
+    {
+        const bool isValidVectorWidth = (specialization.vectorWidth == 1) || (specialization.vectorWidth == 2)  ||
+                                        (specialization.vectorWidth == 4) || (specialization.vectorWidth == 8)  ||
+                                        (specialization.vectorWidth == 16);
+
+        return isValidVectorWidth && (specialization.unroll > 0);
+    }
+
+
+    // Runs a problem whose operands each fit into one buffer.
+    cl_int ExecInBuffers(const saxpy::Specialization& specialization,
+                         const saxpy::Limits&         limits,
+                         const float                  a,
+                         const std::span<const float> xHost,
+                         const std::span<const float> yHost,
+                         const std::span<float>       zHost,
+                         const cl_command_queue       saxpyQueue,
+                         const cl_kernel              saxpyKernel)
+    {
+        cl_int                  result        = CL_SUCCESS;
+        memory::HostBuffer      xDevice       = {};
+        memory::HostBuffer      yDevice       = {};
+        memory::HostBuffer      zDevice       = {};
+        std::array<cl_event, 2> uploads       = {};
+        cl_event                saxpyComplete = nullptr;
+
+        result = xDevice.InitInput(saxpyQueue, std::as_bytes(xHost), uploads[0]);
+
+        if (result == CL_SUCCESS)
+        {
+            result = yDevice.InitInput(saxpyQueue, std::as_bytes(yHost), uploads[1]);
+        }
+
+        if (result == CL_SUCCESS)
+        {
+            result = zDevice.InitOutput(saxpyQueue, std::as_writable_bytes(zHost));
+        }
+
+        if (result == CL_SUCCESS)
+        {
+            result = saxpy::EnqueueKernel(specialization,
+                                          limits,
+                                          a,
+                                          xDevice.Get(),
+                                          yDevice.Get(),
+                                          zDevice.Get(),
+                                          zHost.size(),
+                                          saxpyQueue,
+                                          saxpyKernel,
+                                          uploads,
+                                          saxpyComplete);
+        }
+
+        if (result == CL_SUCCESS)
+        {
+            result = zDevice.Download({ &saxpyComplete, 1 });
+            clReleaseEvent(saxpyComplete);
+        }
+
+        // Non-blocking uploads may still read the spans of the caller, and the kernel write them, after a failure.
+        if (result != CL_SUCCESS)
+        {
+            OPENCL_PRINT_ON_ERROR(result);
+            clFinish(saxpyQueue);
+        }
+
+        for (const cl_event upload : uploads)
+        {
+            if (upload != nullptr)
+            {
+                clReleaseEvent(upload);
+            }
+        }
+
+        return result;
+    }
+}
+
+
+cl_int saxpy::GetSpecializationOptions(const Specialization& specialization,
+                                       std::string&          clBuildOptions)
+{
+    if (!IsValid(specialization))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    std::ostringstream options = {};
+
+    // Hexadecimal floating-point literals represent every finite float exactly.
+    if (specialization.a.has_value())
+    {
+        if (!std::isfinite(specialization.a.value()))
+        {
+            return CL_INVALID_VALUE;
+        }
+
+        options << "-D SAXPY_A=" << std::hexfloat << specialization.a.value() << std::defaultfloat << "f ";
+    }
+
+    if (specialization.exactLaunch)
+    {
+        options << "-D SAXPY_NO_BOUNDS_CHECK ";
+    }
+
+    options << "-D SAXPY_VECTOR_WIDTH=" << specialization.vectorWidth
+            << " -D SAXPY_UNROLL="      << specialization.unroll;
+
+    clBuildOptions = options.str();
+
+    return CL_SUCCESS;
 }
 
 
@@ -26,9 +175,66 @@ cl_int saxpy::EnqueueKernel(const float                     a,
                             const std::span<const cl_event> eventsToWaitOn,
                             cl_event&                       saxpyComplete)
 {
+    return EnqueueKernel(Generic,
+                         a,
+                         xDevice,
+                         yDevice,
+                         zDevice,
+                         len,
+                         saxpyQueue,
+                         saxpyKernel,
+                         eventsToWaitOn,
+                         saxpyComplete);
+}
+
+
+cl_int saxpy::EnqueueKernel(const Specialization&           specialization,
+                            const float                     a,
+                            const cl_mem                    xDevice,
+                            const cl_mem                    yDevice,
+                            const cl_mem                    zDevice,
+                            const size_t                    len,
+                            const cl_command_queue          saxpyQueue,
+                            const cl_kernel                 saxpyKernel,
+                            const std::span<const cl_event> eventsToWaitOn,
+                            cl_event&                       saxpyComplete)
+{
+    return EnqueueKernel(specialization,
+                         DeviceLimits,
+                         a,
+                         xDevice,
+                         yDevice,
+                         zDevice,
+                         len,
+                         saxpyQueue,
+                         saxpyKernel,
+                         eventsToWaitOn,
+                         saxpyComplete);
+}
+
+
+cl_int saxpy::EnqueueKernel(const Specialization&           specialization,
+                            const Limits&                   limits,
+                            const float                     a,
+                            const cl_mem                    xDevice,
+                            const cl_mem                    yDevice,
+                            const cl_mem                    zDevice,
+                            const size_t                    len,
+                            const cl_command_queue          saxpyQueue,
+                            const cl_kernel                 saxpyKernel,
+                            const std::span<const cl_event> eventsToWaitOn,
+                            cl_event&                       saxpyComplete)
+{
+    if (!IsValid(specialization))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    RecordCall(len);
+
     cl_int result = CL_SUCCESS;
 
-    const std::array<KernelArg, 5> kernelArgs =
+    const std::array<kernel::Arg, 5> kernelArgs =
     { {
             { .index = 0, .sizeInBytes = sizeof(a),       .pValue = &a       },
             { .index = 1, .sizeInBytes = sizeof(xDevice), .pValue = &xDevice },
@@ -37,18 +243,148 @@ cl_int saxpy::EnqueueKernel(const float                     a,
             { .index = 4, .sizeInBytes = sizeof(len),     .pValue = &len     }
     } };
 
-    for (const KernelArg& arg : kernelArgs)
+    result = kernel::SetArgs(saxpyKernel, kernelArgs);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    cl_device_id            executingDevice = nullptr;
+    launch::KernelResources resources       = {};
+
+    result = clGetCommandQueueInfo(saxpyQueue,
+                                   CL_QUEUE_DEVICE,
+                                   sizeof(executingDevice),
+                                   &executingDevice,
+                                   nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = launch::QueryKernelResources(saxpyKernel, executingDevice, resources);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    const size_t elementsPerWorkItem = specialization.vectorWidth * specialization.unroll;
+
+    // Without bounds checks, any work-item past `len` would write out of bounds.
+    if (specialization.exactLaunch && (len % elementsPerWorkItem != 0))
     {
-        result = clSetKernelArg(saxpyKernel,
-                                arg.index,
-                                arg.sizeInBytes,
-                                arg.pValue);
+        return CL_INVALID_GLOBAL_WORK_SIZE;
+    }
 
+    const size_t numWorkItems                 = (len + elementsPerWorkItem - 1) / elementsPerWorkItem;
+    const size_t workGroupSize                = launch::ChooseLocalWorkSize(resources, numWorkItems);
+    const size_t maxWorkItemsPerLaunch        = std::min(limits.maxWorkItemsPerLaunch, launch::MaxWorkItemsPerLaunch);
+    bool         supportsNonUniformWorkGroups = false;
+
+    if (specialization.exactLaunch && (numWorkItems % workGroupSize != 0))
+    {
+        result = device::SupportsNonUniformWorkGroups(executingDevice, supportsNonUniformWorkGroups);
         OPENCL_RETURN_ON_ERROR(result);
     }
 
-    cl_device_id executingDevice = nullptr;
-    size_t       workGroupSize   = 0;
+    // Problems beyond the global size limit run as several launches at increasing global offsets, each of which the
+    // kernel maps onto the elements following those of the launch before. Bounds checks make the work-items rounding
+    // up the last work-group harmless.
+    if (!specialization.exactLaunch)
+    {
+        result = launch::EnqueueSplit(saxpyQueue,
+                                      saxpyKernel,
+                                      numWorkItems,
+                                      workGroupSize,
+                                      maxWorkItemsPerLaunch,
+                                      eventsToWaitOn,
+                                      saxpyComplete);
+
+        OPENCL_PRINT_ON_ERROR(result);
+        return result;
+    }
+
+    std::vector<launch::NdRange> ndRanges = {};
+
+    for (const launch::Range& range : launch::Split(numWorkItems, workGroupSize, maxWorkItemsPerLaunch))
+    {
+        const size_t tailWorkItems = range.count % workGroupSize;
+
+        if ((tailWorkItems == 0) || supportsNonUniformWorkGroups)
+        {
+            ndRanges.push_back(
+            {
+                .globalWorkOffset = range.offset,
+                .globalWorkSize   = range.count,
+                .localWorkSize    = workGroupSize
+            });
+        }
+        else
+        {
+            // Older devices only launch whole work-groups, so the remainder runs as a single smaller work-group of its own.
+            const size_t mainWorkItems = range.count - tailWorkItems;
+
+            if (mainWorkItems > 0)
+            {
+                ndRanges.push_back(
+                {
+                    .globalWorkOffset = range.offset,
+                    .globalWorkSize   = mainWorkItems,
+                    .localWorkSize    = workGroupSize
+                });
+            }
+
+            ndRanges.push_back(
+            {
+                .globalWorkOffset = range.offset + mainWorkItems,
+                .globalWorkSize   = tailWorkItems,
+                .localWorkSize    = tailWorkItems
+            });
+        }
+    }
+
+    result = launch::EnqueueNdRanges(saxpyQueue,
+                                     saxpyKernel,
+                                     ndRanges,
+                                     eventsToWaitOn,
+                                     saxpyComplete);
+
+    OPENCL_PRINT_ON_ERROR(result);
+    return result;
+}
+
+
+cl_int saxpy::Exec(const float                  a,
+                   const std::span<const float> xHost,
+                   const std::span<const float> yHost,
+                   const std::span<float>       zHost,
+                   const cl_command_queue       saxpyQueue,
+                   const cl_kernel              saxpyKernel)
+{
+    return Exec(Generic, DeviceLimits, a, xHost, yHost, zHost, saxpyQueue, saxpyKernel);
+}
+
+
+cl_int saxpy::Exec(const Specialization&        specialization,
+                   const Limits&                limits,
+                   const float                  a,
+                   const std::span<const float> xHost,
+                   const std::span<const float> yHost,
+                   const std::span<float>       zHost,
+                   const cl_command_queue       saxpyQueue,
+                   const cl_kernel              saxpyKernel)
+{
+    if (!IsValid(specialization))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    if ((xHost.size() != zHost.size()) || (yHost.size() != zHost.size()))
+    {
+        MSG_STD_ERR("Saxpy operands differ in size");
+        return CL_INVALID_VALUE;
+    }
+
+    if (zHost.empty())
+    {
+        return CL_SUCCESS;
+    }
+
+    cl_int                       result          = CL_SUCCESS;
+    cl_device_id                 executingDevice = nullptr;
+    const discovery::DeviceInfo* deviceInfo      = nullptr;
 
     result = clGetCommandQueueInfo(saxpyQueue,
                                    CL_QUEUE_DEVICE,
@@ -58,29 +394,38 @@ cl_int saxpy::EnqueueKernel(const float                     a,
 
     OPENCL_RETURN_ON_ERROR(result);
 
-    result = clGetKernelWorkGroupInfo(saxpyKernel,
-                                      executingDevice,
-                                      CL_KERNEL_WORK_GROUP_SIZE,
-                                      sizeof(workGroupSize),
-                                      &workGroupSize,
-                                      nullptr);
-
+    result = discovery::GetDeviceInfo(executingDevice, deviceInfo);
     OPENCL_RETURN_ON_ERROR(result);
 
-    const size_t numWorkGroups  = (len + workGroupSize - 1) / workGroupSize;
-    const size_t globalWorkSize = numWorkGroups * workGroupSize;
+    const size_t elementsPerWorkItem = specialization.vectorWidth * specialization.unroll;
 
-    result = clEnqueueNDRangeKernel(saxpyQueue,
-                                    saxpyKernel,
-                                    1,
-                                    nullptr,
-                                    &globalWorkSize,
-                                    &workGroupSize,
-                                    static_cast<cl_uint>(eventsToWaitOn.size()),
-                                    eventsToWaitOn.data(),
-                                    &saxpyComplete);
+    // Checked up front, as otherwise only the last part would fail, after the others ran.
+    if (specialization.exactLaunch && (zHost.size() % elementsPerWorkItem != 0))
+    {
+        return CL_INVALID_GLOBAL_WORK_SIZE;
+    }
+
+    // Operands larger than one allocation of the device run in consecutive parts, each with buffers of its own. Parts
+    // start at page boundaries, so page-aligned operands stay aligned for use in place, and end after whole
+    // work-items, so exact launches stay exact.
+    const size_t partAlignment        = std::lcm(BufferAlignmentInElements, elementsPerWorkItem);
+    const size_t maxElementsPerBuffer = std::min(static_cast<size_t>(deviceInfo->maxMemAllocSizeInBytes / sizeof(float)),
+                                                 limits.maxElementsPerBuffer);
+
+    for (const launch::Range& part : launch::Split(zHost.size(), partAlignment, maxElementsPerBuffer))
+    {
+        result = ExecInBuffers(specialization,
+                               limits,
+                               a,
+                               xHost.subspan(part.offset, part.count),
+                               yHost.subspan(part.offset, part.count),
+                               zHost.subspan(part.offset, part.count),
+                               saxpyQueue,
+                               saxpyKernel);
+
+        OPENCL_RETURN_ON_ERROR(result);
+    }
 
-    OPENCL_PRINT_ON_ERROR(result);
     return result;
 }
 
@@ -96,3 +441,20 @@ void saxpy::HostExec(const float        a,
                    pZHost,
                    [=](float x, float y) { return (a * x) + y; });
 }
+
+
+void saxpy::HostExec(const float              a,
+                     const float* const       pXHost,
+                     const float* const       pYHost,
+                     float* const             pZHost,
+                     const size_t             len,
+                     concurrency::ThreadPool& pool)
+{
+    concurrency::ParallelFor(pool,
+                             len,
+                             memory::HugePageSizeInBytes / sizeof(float),
+                             [=](const size_t begin, const size_t end)
+                             {
+                                 HostExec(a, pXHost + begin, pYHost + begin, pZHost + begin, end - begin);
+                             });
+}
\ No newline at end of file
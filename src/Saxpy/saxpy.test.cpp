@@ -1,8 +1,14 @@
 #include "build.h"
-#include "context.h"
-#include "platform.h"
+#include "concurrency.h"
+#include "discovery.h"
+#include "kernel.h"
+#include "launch.h"
+#include "memory.h"
+#include "metrics.h"
 #include "program.h"
 #include "saxpy.h"
+#include "specialization.h"
+#include "test_fixture.h"
 
 #include <CL/cl.h>
 
@@ -10,8 +16,14 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <limits>
+#include <mutex>
 #include <optional>
-#include <stdlib.h>
+#include <string>
+#include <thread>
 #include <vector>
 
 
@@ -26,44 +38,25 @@ namespace
 }
 
 
-class SaxpyTest : public testing::Test
+class SaxpyTest : public test_fixture::ContextTest
 {
 protected:
     static void SetUpTestSuite()
     {
-        cl_int                        result   = CL_SUCCESS;
-        std::optional<cl_platform_id> platform = std::nullopt;
-        std::optional<cl_context>     context  = std::nullopt;
+        ContextTest::SetUpTestSuite();
 
-        result = context::Create(platform::MostGpus, platform, context);
-        ASSERT_EQ(result, CL_SUCCESS);
-
-        if (context.has_value())
+        if (s_context != nullptr)
         {
-            s_context = context.value();
+            BuildProgram(build::saxpy::binaryCreator,
+                         build::saxpy::sourceCreator,
+                         build::saxpy::options);
         }
-        else
-        {
-            GTEST_SKIP() << "No OpenCL context was created.";
-        }
-
-        result = program::Build(s_context,
-                                std::cref(build::saxpy::binaryCreator),
-                                build::saxpy::sourceCreator,
-                                build::saxpy::options,
-                                s_program);
-
-        ASSERT_EQ(result, CL_SUCCESS);
-
-        result = clUnloadPlatformCompiler(platform.value());
-        ASSERT_EQ(result, CL_SUCCESS);
     }
 
     void SetUp() override final
     {
         cl_int                                                    result  = CL_SUCCESS;
         std::array<cl_kernel, build::saxpy::clKernelNames.size()> kernels = {};
-        std::vector<cl_device_id>                                 devices = {};
 
         result = program::CreateKernels(s_program,
                                         build::saxpy::clKernelNames,
@@ -71,11 +64,7 @@ protected:
 
         ASSERT_EQ(result, CL_SUCCESS);
 
-        result = context::GetDevices(s_context, devices);
-        ASSERT_EQ(result, CL_SUCCESS);
-
-        m_kernel                  = kernels[0];
-        const cl_device_id device = devices[0];
+        m_kernel = kernels[0];
 
         const std::array<const cl_queue_properties, 3> queueProperties
         {
@@ -84,39 +73,14 @@ protected:
             0
         };
 
-        m_queue = clCreateCommandQueueWithProperties(s_context,
-                                                     device,
-                                                     queueProperties.data(),
-                                                     &result);
-
-        ASSERT_EQ(result, CL_SUCCESS);
+        CreateQueue(queueProperties);
     }
 
     void TearDown() noexcept override final
     {
-        cl_int result = CL_SUCCESS;
-
-        result = clReleaseCommandQueue(m_queue);
-        EXPECT_EQ(result, CL_SUCCESS);
-
-        result = clReleaseKernel(m_kernel);
-        EXPECT_EQ(result, CL_SUCCESS);
-    }
-
-    static void TearDownTestSuite() noexcept
-    {
-        cl_int result = CL_SUCCESS;
-
-        result = clReleaseProgram(s_program);
-        EXPECT_EQ(result, CL_SUCCESS);
+        ReleaseKernels({ &m_kernel, 1 });
 
-        result = clReleaseContext(s_context);
-        EXPECT_EQ(result, CL_SUCCESS);
-    }
-
-    static float GetRandFloat() noexcept
-    {
-        return static_cast<float>(std::rand());
+        ContextTest::TearDown();
     }
 
     void EnqueueSaxpyDeviceExecution(const size_t problemSize) noexcept
@@ -181,9 +145,8 @@ protected:
         EXPECT_EQ(result, CL_SUCCESS);
     }
 
-    cl_kernel        m_kernel    = nullptr;
-    cl_command_queue m_queue     = nullptr;
-    cl_event         m_saxpyExec = nullptr;
+    cl_kernel m_kernel    = nullptr;
+    cl_event  m_saxpyExec = nullptr;
 
     std::array<cl_event, saxpyHostToDeviceResolve::count> m_hostToDeviceResolves = {};
     cl_event                                              m_zDeviceToHostResolve = nullptr;
@@ -192,16 +155,10 @@ protected:
     cl_mem m_yDevice = nullptr;
     cl_mem m_zDevice = nullptr;
 
-    static cl_context s_context;
-    static cl_program s_program;
-
     static const std::array<size_t, 6> ProblemSizes;
     static const float                 A;
 };
 
-cl_context SaxpyTest::s_context = nullptr;
-cl_program SaxpyTest::s_program = nullptr;
-
 const std::array<size_t, 6> SaxpyTest::ProblemSizes =
 {
     1, 33, 1024, (1024 + 1), (1024 + 31), 1000000
@@ -243,7 +200,7 @@ TEST_F(SaxpyTest, UsingMappedHostMemory)
 
             std::generate(pXDeviceMappedForWrite,
                           pXDeviceMappedForWrite + problemSize,
-                          GetRandFloat);
+                          test_fixture::GetRandFloat);
 
             result = clEnqueueUnmapMemObject(m_queue,
                                              m_xDevice,
@@ -281,7 +238,7 @@ TEST_F(SaxpyTest, UsingMappedHostMemory)
 
             std::generate(pYDeviceMappedForWrite,
                           pYDeviceMappedForWrite + problemSize,
-                          GetRandFloat);
+                          test_fixture::GetRandFloat);
 
             result = clEnqueueUnmapMemObject(m_queue,
                                              m_yDevice,
@@ -412,7 +369,7 @@ TEST_F(SaxpyTest, UsingAsyncDataTransfers)
         std::vector<float> zHost(problemSize);
         std::vector<float> solution(problemSize);
 
-        std::generate(xHost.begin(), xHost.end(), GetRandFloat);
+        std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandFloat);
 
         m_xDevice = clCreateBuffer(s_context,
                                    CL_MEM_READ_ONLY | CL_MEM_HOST_WRITE_ONLY,
@@ -434,7 +391,7 @@ TEST_F(SaxpyTest, UsingAsyncDataTransfers)
 
         ASSERT_EQ(result, CL_SUCCESS);
 
-        std::generate(yHost.begin(), yHost.end(), GetRandFloat);
+        std::generate(yHost.begin(), yHost.end(), test_fixture::GetRandFloat);
 
         m_yDevice = clCreateBuffer(s_context,
                                    CL_MEM_READ_ONLY | CL_MEM_HOST_WRITE_ONLY,
@@ -494,3 +451,661 @@ TEST_F(SaxpyTest, UsingAsyncDataTransfers)
         ReleaseResolveEvents();
     }
 }
+
+
+TEST_F(SaxpyTest, UsingHostSpans)
+{
+    for (const size_t problemSize : ProblemSizes)
+    {
+        cl_int             result = CL_SUCCESS;
+        std::vector<float> xHost(problemSize);
+        std::vector<float> yHost(problemSize);
+        std::vector<float> zHost(problemSize);
+        std::vector<float> solution(problemSize);
+
+        std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandFloat);
+        std::generate(yHost.begin(), yHost.end(), test_fixture::GetRandFloat);
+
+        result = saxpy::Exec(A, xHost, yHost, zHost, m_queue, m_kernel);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        saxpy::HostExec(A,
+                        xHost.data(),
+                        yHost.data(),
+                        solution.data(),
+                        solution.size());
+
+        EXPECT_EQ(solution, zHost) << "Host and device saxpy execution results are not equal";
+    }
+}
+
+
+TEST_F(SaxpyTest, RecordsMetrics)
+{
+    metrics::Counter& calls      = metrics::GetCounter("saxpy_calls_total", "");
+    metrics::Counter& bytesMoved = metrics::GetCounter("saxpy_bytes_moved_total", "");
+
+    const uint64_t callsBefore      = calls.Read();
+    const uint64_t bytesMovedBefore = bytesMoved.Read();
+
+    std::vector<float> xHost(ProblemSizes.back(), 1.0f);
+    std::vector<float> yHost(ProblemSizes.back(), 2.0f);
+    std::vector<float> zHost(ProblemSizes.back());
+
+    const cl_int result = saxpy::Exec(A, xHost, yHost, zHost, m_queue, m_kernel);
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    EXPECT_EQ(calls.Read() - callsBefore, 1u);
+    EXPECT_EQ(bytesMoved.Read() - bytesMovedBefore, 3 * zHost.size() * sizeof(float));
+
+    const std::string snapshot = metrics::FormatSnapshot(metrics::Format::Prometheus);
+
+    EXPECT_NE(snapshot.find("# TYPE saxpy_calls_total counter"), std::string::npos);
+    EXPECT_NE(snapshot.find("saxpy_call_bytes_bucket{le=\"+Inf\"}"), std::string::npos);
+}
+
+
+TEST_F(SaxpyTest, UsingHugePageHostMemory)
+{
+    concurrency::ThreadPool& hostThreadPool = concurrency::GetHostThreadPool();
+
+    for (const size_t problemSize : ProblemSizes)
+    {
+        cl_int                 result             = CL_SUCCESS;
+        const size_t           problemSizeInBytes = problemSize * sizeof(float);
+        memory::HostAllocation xHost              = {};
+        memory::HostAllocation yHost              = {};
+        memory::HostAllocation zHost              = {};
+
+        ASSERT_TRUE(xHost.Allocate(problemSizeInBytes));
+        ASSERT_TRUE(yHost.Allocate(problemSizeInBytes));
+        ASSERT_TRUE(zHost.Allocate(problemSizeInBytes));
+
+        memory::FirstTouch(xHost.ViewAs<float>(), hostThreadPool);
+        memory::FirstTouch(yHost.ViewAs<float>(), hostThreadPool);
+        memory::FirstTouch(zHost.ViewAs<float>(), hostThreadPool);
+
+        std::generate(xHost.ViewAs<float>().begin(), xHost.ViewAs<float>().end(), test_fixture::GetRandFloat);
+        std::generate(yHost.ViewAs<float>().begin(), yHost.ViewAs<float>().end(), test_fixture::GetRandFloat);
+
+        result = memory::CreateBuffer(s_context, CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS, xHost.View(), m_xDevice);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = memory::CreateBuffer(s_context, CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS, yHost.View(), m_yDevice);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = memory::CreateBuffer(s_context, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, zHost.View(), m_zDevice);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = saxpy::EnqueueKernel(A,
+                                      m_xDevice,
+                                      m_yDevice,
+                                      m_zDevice,
+                                      problemSize,
+                                      m_queue,
+                                      m_kernel,
+                                      {},
+                                      m_saxpyExec);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        // Mapping synchronizes the host memory with the device, and is free where the device uses it in place.
+        float* const pZDeviceMappedForRead = static_cast<float*>(
+            clEnqueueMapBuffer(m_queue,
+                               m_zDevice,
+                               CL_TRUE,
+                               CL_MAP_READ,
+                               0,
+                               problemSizeInBytes,
+                               1,
+                               &m_saxpyExec,
+                               nullptr,
+                               &result)
+        );
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        std::vector<float> solution(problemSize);
+
+        saxpy::HostExec(A,
+                        xHost.ViewAs<const float>().data(),
+                        yHost.ViewAs<const float>().data(),
+                        solution.data(),
+                        solution.size(),
+                        hostThreadPool);
+
+        EXPECT_TRUE(std::equal(solution.cbegin(), solution.cend(), pZDeviceMappedForRead)) <<
+            "Host and device saxpy execution results are not equal";
+
+        result = clEnqueueUnmapMemObject(m_queue,
+                                         m_zDevice,
+                                         pZDeviceMappedForRead,
+                                         0,
+                                         nullptr,
+                                         nullptr);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        FlushQueueAndSyncHost();
+
+        ReleaseDeviceBuffers();
+
+        result = clReleaseEvent(m_saxpyExec);
+        EXPECT_EQ(result, CL_SUCCESS);
+    }
+}
+
+
+TEST_F(SaxpyTest, UsingSpecializedKernels)
+{
+    const std::array<saxpy::Specialization, 5> specializations =
+    { {
+            { .a = std::nullopt, .exactLaunch = false, .vectorWidth = 4, .unroll = 1 },
+            { .a = std::nullopt, .exactLaunch = true,  .vectorWidth = 1, .unroll = 1 },
+            { .a = A,            .exactLaunch = false, .vectorWidth = 1, .unroll = 4 },
+            { .a = A,            .exactLaunch = false, .vectorWidth = 8, .unroll = 2 },
+            { .a = A,            .exactLaunch = true,  .vectorWidth = 4, .unroll = 2 }
+    } };
+
+    specialization::Cache cache(build::saxpy::binaryCreator,
+                                build::saxpy::sourceCreator,
+                                build::saxpy::options);
+
+    cl_int result = CL_SUCCESS;
+
+    for (const saxpy::Specialization& specialization : specializations)
+    {
+        std::string                                               options = {};
+        cl_program                                                program = nullptr;
+        std::optional<cl_program>                                 cached  = std::nullopt;
+        std::array<cl_kernel, build::saxpy::clKernelNames.size()> kernels = {};
+
+        result = saxpy::GetSpecializationOptions(specialization, options);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = cache.Specialize(s_context, options, program);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = cache.Find(s_context, options, cached);
+        ASSERT_EQ(result, CL_SUCCESS);
+        EXPECT_EQ(cached, program);
+
+        result = program::CreateKernels(program,
+                                        build::saxpy::clKernelNames,
+                                        kernels);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        for (const size_t requestedProblemSize : ProblemSizes)
+        {
+            // Exact launches compute whole work-items only, whatever the work-group size.
+            const size_t elementsPerWorkItem = specialization.vectorWidth * specialization.unroll;
+            const size_t problemSize         = specialization.exactLaunch
+                                                   ? ((requestedProblemSize + elementsPerWorkItem - 1) /
+                                                      elementsPerWorkItem) * elementsPerWorkItem
+                                                   : requestedProblemSize;
+            const size_t problemSizeInBytes  = problemSize * sizeof(float);
+
+            std::vector<float> xHost(problemSize);
+            std::vector<float> yHost(problemSize);
+            std::vector<float> zHost(problemSize);
+            std::vector<float> solution(problemSize);
+
+            std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandFloat);
+            std::generate(yHost.begin(), yHost.end(), test_fixture::GetRandFloat);
+
+            m_xDevice = clCreateBuffer(s_context,
+                                       CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS | CL_MEM_COPY_HOST_PTR,
+                                       problemSizeInBytes,
+                                       xHost.data(),
+                                       &result);
+
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            m_yDevice = clCreateBuffer(s_context,
+                                       CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS | CL_MEM_COPY_HOST_PTR,
+                                       problemSizeInBytes,
+                                       yHost.data(),
+                                       &result);
+
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            m_zDevice = clCreateBuffer(s_context,
+                                       CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY,
+                                       problemSizeInBytes,
+                                       nullptr,
+                                       &result);
+
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            result = saxpy::EnqueueKernel(specialization,
+                                          A,
+                                          m_xDevice,
+                                          m_yDevice,
+                                          m_zDevice,
+                                          problemSize,
+                                          m_queue,
+                                          kernels[0],
+                                          {},
+                                          m_saxpyExec);
+
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            result = clEnqueueReadBuffer(m_queue,
+                                         m_zDevice,
+                                         CL_TRUE,
+                                         0,
+                                         problemSizeInBytes,
+                                         zHost.data(),
+                                         1,
+                                         &m_saxpyExec,
+                                         nullptr);
+
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            saxpy::HostExec(A,
+                            xHost.data(),
+                            yHost.data(),
+                            solution.data(),
+                            solution.size());
+
+            EXPECT_EQ(solution, zHost) << "Host and specialized device saxpy execution results are not equal: " <<
+                options;
+
+            ReleaseDeviceBuffers();
+
+            result = clReleaseEvent(m_saxpyExec);
+            EXPECT_EQ(result, CL_SUCCESS);
+        }
+
+        result = clReleaseKernel(kernels[0]);
+        EXPECT_EQ(result, CL_SUCCESS);
+    }
+}
+
+TEST_F(SaxpyTest, SplitsProblemsAcrossLaunchesAndBuffers)
+{
+    // Small enough that problems of a few buffers run as several launches per buffer, each of whose work-items
+    // covers several elements.
+    constexpr saxpy::Limits SmallLimits =
+    {
+        .maxWorkItemsPerLaunch = 256,
+        .maxElementsPerBuffer  = 1 << 15
+    };
+
+    const std::array<saxpy::Specialization, 5> specializations =
+    { {
+            { .a = std::nullopt, .exactLaunch = false, .vectorWidth = 1, .unroll = 1 },
+            { .a = std::nullopt, .exactLaunch = false, .vectorWidth = 4, .unroll = 3 },
+            { .a = A,            .exactLaunch = false, .vectorWidth = 8, .unroll = 2 },
+            { .a = std::nullopt, .exactLaunch = true,  .vectorWidth = 2, .unroll = 1 },
+            { .a = A,            .exactLaunch = true,  .vectorWidth = 4, .unroll = 3 }
+    } };
+
+    const std::array<size_t, 3> requestedProblemSizes =
+    {
+        1000, (1 << 17) + 33, 5 * SmallLimits.maxElementsPerBuffer
+    };
+
+    specialization::Cache cache(build::saxpy::binaryCreator,
+                                build::saxpy::sourceCreator,
+                                build::saxpy::options);
+
+    cl_int result = CL_SUCCESS;
+
+    for (const saxpy::Specialization& specialization : specializations)
+    {
+        std::string                                               options = {};
+        cl_program                                                program = nullptr;
+        std::array<cl_kernel, build::saxpy::clKernelNames.size()> kernels = {};
+
+        result = saxpy::GetSpecializationOptions(specialization, options);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = cache.Specialize(s_context, options, program);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = program::CreateKernels(program,
+                                        build::saxpy::clKernelNames,
+                                        kernels);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        for (const size_t requestedProblemSize : requestedProblemSizes)
+        {
+            const size_t elementsPerWorkItem = specialization.vectorWidth * specialization.unroll;
+            const size_t problemSize         = specialization.exactLaunch
+                                                   ? ((requestedProblemSize + elementsPerWorkItem - 1) /
+                                                      elementsPerWorkItem) * elementsPerWorkItem
+                                                   : requestedProblemSize;
+
+            // Elements no launch covers stay NaN, which equals no solution.
+            std::vector<float> xHost(problemSize);
+            std::vector<float> yHost(problemSize);
+            std::vector<float> zHost(problemSize, std::numeric_limits<float>::quiet_NaN());
+            std::vector<float> solution(problemSize);
+
+            std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandFloat);
+            std::generate(yHost.begin(), yHost.end(), test_fixture::GetRandFloat);
+
+            result = saxpy::Exec(specialization, SmallLimits, A, xHost, yHost, zHost, m_queue, kernels[0]);
+            ASSERT_EQ(result, CL_SUCCESS) << options;
+
+            saxpy::HostExec(A,
+                            xHost.data(),
+                            yHost.data(),
+                            solution.data(),
+                            solution.size());
+
+            EXPECT_EQ(solution, zHost) << "Host and split device saxpy execution results are not equal: " <<
+                options << ", " << problemSize << " elements";
+        }
+
+        result = clReleaseKernel(kernels[0]);
+        EXPECT_EQ(result, CL_SUCCESS);
+    }
+
+    // Exact launches cannot cover problems of partial work-items, which no part may run before that is known.
+    std::vector<float> operand(1001);
+
+    EXPECT_EQ(saxpy::Exec(specializations[3], SmallLimits, A, operand, operand, operand, m_queue, m_kernel),
+              CL_INVALID_GLOBAL_WORK_SIZE);
+}
+
+
+// Operands of 2^32 elements take 16 GiB each, so this needs about 64 GiB of host memory. Runs on CPU devices only,
+// whose runtimes are the ones to address that much.
+TEST_F(SaxpyTest, DISABLED_SplitsProblemsAtTheGlobalSizeLimit)
+{
+    cl_int                       result          = CL_SUCCESS;
+    cl_device_id                 executingDevice = nullptr;
+    const discovery::DeviceInfo* deviceInfo      = nullptr;
+
+    result = clGetCommandQueueInfo(m_queue,
+                                   CL_QUEUE_DEVICE,
+                                   sizeof(executingDevice),
+                                   &executingDevice,
+                                   nullptr);
+
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    result = discovery::GetDeviceInfo(executingDevice, deviceInfo);
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    if ((deviceInfo->type & CL_DEVICE_TYPE_CPU) == 0)
+    {
+        GTEST_SKIP() << "No OpenCL CPU device is available.";
+    }
+
+    // Past the signed 32-bit index range within one launch, and past the launch limit across two.
+    for (const size_t problemSize : { (size_t(1) << 31) + 33, launch::MaxWorkItemsPerLaunch + 4097 })
+    {
+        std::vector<float> xHost(problemSize);
+        std::vector<float> yHost(problemSize);
+        std::vector<float> zHost(problemSize, std::numeric_limits<float>::quiet_NaN());
+
+        // Small integers, which saxpy computes exactly however the device rounds.
+        for (size_t i = 0; i < problemSize; i++)
+        {
+            xHost[i] = static_cast<float>(i % 1024);
+            yHost[i] = static_cast<float>(i % 7);
+        }
+
+        result = saxpy::Exec(A, xHost, yHost, zHost, m_queue, m_kernel);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        // Counted rather than compared as a whole, which would print billions of elements on failure.
+        size_t nMismatches   = 0;
+        size_t firstMismatch = problemSize;
+
+        for (size_t i = 0; i < problemSize; i++)
+        {
+            if (zHost[i] != (A * xHost[i]) + yHost[i])
+            {
+                firstMismatch = std::min(firstMismatch, i);
+                nMismatches++;
+            }
+        }
+
+        EXPECT_EQ(nMismatches, size_t(0)) << "First of " << problemSize << " elements to differ: " << firstMismatch;
+    }
+}
+
+
+TEST_F(SaxpyTest, PoolHandsEachThreadItsOwnInstance)
+{
+    const size_t nThreads = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8);
+
+    cl_int       result = CL_SUCCESS;
+    cl_device_id device = nullptr;
+
+    result = clGetCommandQueueInfo(m_queue,
+                                   CL_QUEUE_DEVICE,
+                                   sizeof(device),
+                                   &device,
+                                   nullptr);
+
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    kernel::Pool                               pool(m_kernel, device);
+    std::vector<const kernel::Pool::Instance*> instances(nThreads, nullptr);
+    std::vector<std::thread>                   threads = {};
+    std::latch                                 start(static_cast<std::ptrdiff_t>(nThreads));
+
+    // Every thread acquires at once, so the first acquisitions, which clone the prototype, contend.
+    for (size_t i = 0; i < nThreads; i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            const kernel::Pool::Instance* instance = nullptr;
+
+            start.arrive_and_wait();
+
+            EXPECT_EQ(pool.Acquire(instances[i]), CL_SUCCESS);
+            EXPECT_EQ(pool.Acquire(instance), CL_SUCCESS);
+            EXPECT_EQ(instance, instances[i]) << "A thread acquired a second instance";
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(pool.GetInstanceCount(), nThreads);
+
+    for (size_t i = 0; i < nThreads; i++)
+    {
+        ASSERT_NE(instances[i], nullptr);
+        EXPECT_NE(instances[i]->kernel, m_kernel);
+
+        for (size_t j = 0; j < i; j++)
+        {
+            EXPECT_NE(instances[i]->kernel, instances[j]->kernel) << "Threads share a kernel instance";
+            EXPECT_NE(instances[i]->queue,  instances[j]->queue)  << "Threads share a command queue";
+        }
+    }
+}
+
+
+TEST_F(SaxpyTest, DISABLED_ConcurrentSubmissionBenchmark)
+{
+    constexpr size_t ProblemSize        = 1024 * 16;
+    constexpr size_t ProblemSizeInBytes = ProblemSize * sizeof(float);
+    constexpr size_t LaunchesPerThread  = 256;
+    const size_t     nThreads           = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8);
+
+    struct ThreadData
+    {
+        std::vector<float> xHost;
+        std::vector<float> yHost;
+        std::vector<float> zHost;
+        std::vector<float> solution;
+        cl_mem             xDevice;
+        cl_mem             yDevice;
+        cl_mem             zDevice;
+    };
+
+    cl_int                  result     = CL_SUCCESS;
+    cl_device_id            device     = nullptr;
+    std::vector<ThreadData> threadData(nThreads);
+
+    result = clGetCommandQueueInfo(m_queue,
+                                   CL_QUEUE_DEVICE,
+                                   sizeof(device),
+                                   &device,
+                                   nullptr);
+
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    for (ThreadData& data : threadData)
+    {
+        data.xHost.resize(ProblemSize);
+        data.yHost.resize(ProblemSize);
+        data.zHost.resize(ProblemSize);
+        data.solution.resize(ProblemSize);
+
+        std::generate(data.xHost.begin(), data.xHost.end(), test_fixture::GetRandFloat);
+        std::generate(data.yHost.begin(), data.yHost.end(), test_fixture::GetRandFloat);
+
+        saxpy::HostExec(A,
+                        data.xHost.data(),
+                        data.yHost.data(),
+                        data.solution.data(),
+                        data.solution.size());
+
+        data.xDevice = clCreateBuffer(s_context,
+                                      CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS | CL_MEM_COPY_HOST_PTR,
+                                      ProblemSizeInBytes,
+                                      data.xHost.data(),
+                                      &result);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        data.yDevice = clCreateBuffer(s_context,
+                                      CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS | CL_MEM_COPY_HOST_PTR,
+                                      ProblemSizeInBytes,
+                                      data.yHost.data(),
+                                      &result);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        data.zDevice = clCreateBuffer(s_context,
+                                      CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY,
+                                      ProblemSizeInBytes,
+                                      nullptr,
+                                      &result);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+    }
+
+    // Every thread launches saxpy on its own buffers, then reads back and checks its result.
+    const auto runThreads = [&](const auto& launch)
+    {
+        std::vector<std::thread> threads = {};
+        const auto               start   = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < nThreads; i++)
+        {
+            threads.emplace_back([&, i]()
+            {
+                ThreadData& data = threadData[i];
+
+                for (size_t launchIndex = 0; launchIndex < LaunchesPerThread; launchIndex++)
+                {
+                    cl_command_queue queue     = nullptr;
+                    cl_event         saxpyExec = nullptr;
+
+                    EXPECT_EQ(launch(data, queue, saxpyExec), CL_SUCCESS);
+
+                    EXPECT_EQ(clEnqueueReadBuffer(queue,
+                                                  data.zDevice,
+                                                  CL_TRUE,
+                                                  0,
+                                                  ProblemSizeInBytes,
+                                                  data.zHost.data(),
+                                                  1,
+                                                  &saxpyExec,
+                                                  nullptr), CL_SUCCESS);
+
+                    EXPECT_EQ(clReleaseEvent(saxpyExec), CL_SUCCESS);
+                }
+
+                EXPECT_EQ(data.solution, data.zHost) << "Host and device saxpy execution results are not equal";
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        return (nThreads * LaunchesPerThread) / elapsed.count();
+    };
+
+    // The baseline: one kernel and one queue shared by all threads, so every launch is serialized behind a mutex.
+    std::mutex sharedKernelMutex = {};
+
+    const double serializedLaunchesPerSecond = runThreads(
+        [&](ThreadData& data, cl_command_queue& queue, cl_event& saxpyExec)
+        {
+            const std::lock_guard lock(sharedKernelMutex);
+
+            queue = m_queue;
+
+            return saxpy::EnqueueKernel(A,
+                                        data.xDevice,
+                                        data.yDevice,
+                                        data.zDevice,
+                                        ProblemSize,
+                                        m_queue,
+                                        m_kernel,
+                                        {},
+                                        saxpyExec);
+        }
+    );
+
+    kernel::Pool pool(m_kernel, device);
+
+    const double pooledLaunchesPerSecond = runThreads(
+        [&](ThreadData& data, cl_command_queue& queue, cl_event& saxpyExec)
+        {
+            const kernel::Pool::Instance* instance = nullptr;
+            const cl_int                  acquired = pool.Acquire(instance);
+
+            if (acquired != CL_SUCCESS)
+            {
+                return acquired;
+            }
+
+            queue = instance->queue;
+
+            return saxpy::EnqueueKernel(A,
+                                        data.xDevice,
+                                        data.yDevice,
+                                        data.zDevice,
+                                        ProblemSize,
+                                        instance->queue,
+                                        instance->kernel,
+                                        {},
+                                        saxpyExec);
+        }
+    );
+
+    EXPECT_EQ(pool.GetInstanceCount(), nThreads);
+
+    std::cout << "[ BENCHMARK] " << nThreads << " threads, " << LaunchesPerThread << " launches each: "
+              << serializedLaunchesPerSecond << " launches/s serialized, "
+              << pooledLaunchesPerSecond     << " launches/s pooled\n";
+
+    for (ThreadData& data : threadData)
+    {
+        for (const cl_mem buffer : { data.xDevice, data.yDevice, data.zDevice })
+        {
+            result = clReleaseMemObject(buffer);
+            EXPECT_EQ(result, CL_SUCCESS);
+        }
+    }
+}
\ No newline at end of file
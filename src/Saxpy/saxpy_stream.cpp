@@ -0,0 +1,591 @@
+#include "build.h"
+#include "concurrency.h"
+#include "context.h"
+#include "debug.h"
+#include "discovery.h"
+#include "file.h"
+#include "platform.h"
+#include "program.h"
+#include "saxpy.h"
+#include "tracing.h"
+
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+
+namespace
+{
+    // One chunk being read ahead, one being computed and one being written behind.
+    constexpr size_t SlotCount = 3;
+
+    constexpr size_t DefaultChunkSizeInMiB = 32;
+
+    constexpr std::string_view Usage = "Usage: SaxpyStream <a> <x file> <y file> <z file> [chunk size in MiB]\n"
+                                       "Computes z = a * x + y over files of native-endian 32-bit floats.\n";
+
+
+    struct Arguments
+    {
+        float                 a;
+        std::filesystem::path xFilePath;
+        std::filesystem::path yFilePath;
+        std::filesystem::path zFilePath;
+        size_t                chunkSizeInElements;
+    };
+
+
+    bool ParseArguments(const int          argc,
+                        const char* const* argv,
+                        Arguments&         arguments)
+    {
+        if ((argc != 5) && (argc != 6))
+        {
+            return false;
+        }
+
+        const std::string_view aArgument = argv[1];
+        const auto             aParsed   = std::from_chars(aArgument.data(),
+                                                           aArgument.data() + aArgument.size(),
+                                                           arguments.a);
+
+        if ((aParsed.ec != std::errc()) || (aParsed.ptr != aArgument.data() + aArgument.size()))
+        {
+            return false;
+        }
+
+        arguments.xFilePath = argv[2];
+        arguments.yFilePath = argv[3];
+        arguments.zFilePath = argv[4];
+
+        size_t chunkSizeInMiB = DefaultChunkSizeInMiB;
+
+        if (argc == 6)
+        {
+            const std::string_view chunkArgument = argv[5];
+            const auto             chunkParsed   = std::from_chars(chunkArgument.data(),
+                                                                   chunkArgument.data() + chunkArgument.size(),
+                                                                   chunkSizeInMiB);
+
+            if ((chunkParsed.ec != std::errc()) || (chunkSizeInMiB == 0))
+            {
+                return false;
+            }
+        }
+
+        arguments.chunkSizeInElements = chunkSizeInMiB * 1024 * 1024 / sizeof(float);
+
+        return true;
+    }
+
+
+    // Streams chunks of the inputs through the device, or through the host when no device is available. Reading the
+    // next chunks out of the mapped files, computing the current one and writing back the previous one overlap,
+    // so only `SlotCount` chunks are ever resident, however large the files are.
+    class Pipeline
+    {
+    public:
+        Pipeline() = default;
+        ~Pipeline() noexcept;
+
+        Pipeline(const Pipeline&)            = delete;
+        Pipeline& operator=(const Pipeline&) = delete;
+
+        // Leaves the pipeline on the host unless a device is found. Chunks are shrunk to fit the device.
+        [[nodiscard]] cl_int Init(size_t chunkSizeInElements);
+
+        void Release() noexcept;
+
+        [[nodiscard]] bool Run(float                  a,
+                               std::span<const float> xHost,
+                               std::span<const float> yHost,
+                               std::ofstream&         zOfStream);
+
+        [[nodiscard]] bool IsOnDevice() const noexcept { return m_context != nullptr; }
+
+    private:
+        struct Slot
+        {
+            std::vector<float> xHost;
+            std::vector<float> yHost;
+            std::vector<float> zHost;
+            cl_command_queue   queue;
+            cl_mem             xDevice;
+            cl_mem             yDevice;
+            cl_mem             zDevice;
+            std::future<void>  read;
+            std::future<bool>  write;
+        };
+
+        [[nodiscard]] cl_int EnqueueChunk(float     a,
+                                          Slot&     slot,
+                                          size_t    len,
+                                          cl_event& zDownloaded);
+
+        void Drain() noexcept;
+
+        cl_context                  m_context             = nullptr;
+        cl_program                  m_program             = nullptr;
+        cl_kernel                   m_kernel              = nullptr;
+        size_t                      m_chunkSizeInElements = 0;
+        std::array<Slot, SlotCount> m_slots               = {};
+        std::mutex                  m_zOfStreamMutex      = {};
+    };
+
+
+    Pipeline::~Pipeline() noexcept
+    {
+        Release();
+    }
+
+
+    cl_int Pipeline::Init(const size_t chunkSizeInElements)
+    {
+        Release();
+
+        m_chunkSizeInElements = chunkSizeInElements;
+
+        cl_int                        result   = CL_SUCCESS;
+        std::optional<cl_platform_id> platform = std::nullopt;
+        std::optional<cl_context>     context  = std::nullopt;
+
+        result = context::Create(platform::HighestThroughput, platform, context);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        if (!context.has_value())
+        {
+            return result;
+        }
+
+        m_context = context.value();
+
+        std::vector<cl_device_id> devices = {};
+
+        result = context::GetDevices(m_context, devices);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        const discovery::DeviceInfo* deviceInfo = nullptr;
+
+        result = discovery::GetDeviceInfo(devices[0], deviceInfo);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        // Three buffers per slot must fit a single allocation each, and all of them half of the device memory.
+        const size_t maxAllocationInElements = deviceInfo->maxMemAllocSizeInBytes / sizeof(float);
+        const size_t maxResidentInElements   = deviceInfo->globalMemSizeInBytes / (2 * 3 * SlotCount * sizeof(float));
+
+        m_chunkSizeInElements = std::max<size_t>(std::min({ chunkSizeInElements,
+                                                            maxAllocationInElements,
+                                                            maxResidentInElements }), 1);
+
+        DBG_MSG_STD_OUT("Streaming saxpy on ", deviceInfo->name, " in chunks of ", m_chunkSizeInElements, " elements");
+
+        result = program::Build(m_context,
+                                std::cref(build::saxpy::binaryCreator),
+                                build::saxpy::sourceCreator,
+                                build::saxpy::options,
+                                m_program);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        std::array<cl_kernel, build::saxpy::clKernelNames.size()> kernels = {};
+
+        result = program::CreateKernels(m_program,
+                                        build::saxpy::clKernelNames,
+                                        kernels);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        m_kernel = kernels[0];
+
+        const size_t chunkSizeInBytes = m_chunkSizeInElements * sizeof(float);
+
+        // A queue per slot lets the transfers of one chunk overlap the kernel of another.
+        for (Slot& slot : m_slots)
+        {
+            slot.queue = clCreateCommandQueueWithProperties(m_context, devices[0], nullptr, &result);
+            OPENCL_RETURN_ON_ERROR(result);
+
+            slot.xDevice = clCreateBuffer(m_context,
+                                          CL_MEM_READ_ONLY | CL_MEM_HOST_WRITE_ONLY,
+                                          chunkSizeInBytes,
+                                          nullptr,
+                                          &result);
+
+            OPENCL_RETURN_ON_ERROR(result);
+
+            slot.yDevice = clCreateBuffer(m_context,
+                                          CL_MEM_READ_ONLY | CL_MEM_HOST_WRITE_ONLY,
+                                          chunkSizeInBytes,
+                                          nullptr,
+                                          &result);
+
+            OPENCL_RETURN_ON_ERROR(result);
+
+            slot.zDevice = clCreateBuffer(m_context,
+                                          CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY,
+                                          chunkSizeInBytes,
+                                          nullptr,
+                                          &result);
+
+            OPENCL_RETURN_ON_ERROR(result);
+        }
+
+        return result;
+    }
+
+
+    void Pipeline::Release() noexcept
+    {
+        Drain();
+
+        for (Slot& slot : m_slots)
+        {
+            for (const cl_mem buffer : { slot.xDevice, slot.yDevice, slot.zDevice })
+            {
+                if (buffer != nullptr)
+                {
+                    clReleaseMemObject(buffer);
+                }
+            }
+
+            if (slot.queue != nullptr)
+            {
+                clReleaseCommandQueue(slot.queue);
+            }
+
+            slot = {};
+        }
+
+        if (m_kernel != nullptr)
+        {
+            clReleaseKernel(m_kernel);
+            m_kernel = nullptr;
+        }
+
+        if (m_program != nullptr)
+        {
+            clReleaseProgram(m_program);
+            m_program = nullptr;
+        }
+
+        if (m_context != nullptr)
+        {
+            clReleaseContext(m_context);
+            m_context = nullptr;
+        }
+    }
+
+
+    cl_int Pipeline::EnqueueChunk(const float  a,
+                                  Slot&        slot,
+                                  const size_t len,
+                                  cl_event&    zDownloaded)
+    {
+        cl_int                  result        = CL_SUCCESS;
+        std::array<cl_event, 2> uploads       = {};
+        cl_event                saxpyComplete = nullptr;
+        const size_t            sizeInBytes   = len * sizeof(float);
+
+        result = clEnqueueWriteBuffer(slot.queue,
+                                      slot.xDevice,
+                                      CL_FALSE,
+                                      0,
+                                      sizeInBytes,
+                                      slot.xHost.data(),
+                                      0,
+                                      nullptr,
+                                      &uploads[0]);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        result = clEnqueueWriteBuffer(slot.queue,
+                                      slot.yDevice,
+                                      CL_FALSE,
+                                      0,
+                                      sizeInBytes,
+                                      slot.yHost.data(),
+                                      0,
+                                      nullptr,
+                                      &uploads[1]);
+
+        if (result == CL_SUCCESS)
+        {
+            result = saxpy::EnqueueKernel(a,
+                                          slot.xDevice,
+                                          slot.yDevice,
+                                          slot.zDevice,
+                                          len,
+                                          slot.queue,
+                                          m_kernel,
+                                          uploads,
+                                          saxpyComplete);
+        }
+
+        if (result == CL_SUCCESS)
+        {
+            result = clEnqueueReadBuffer(slot.queue,
+                                         slot.zDevice,
+                                         CL_FALSE,
+                                         0,
+                                         sizeInBytes,
+                                         slot.zHost.data(),
+                                         1,
+                                         &saxpyComplete,
+                                         &zDownloaded);
+
+            clReleaseEvent(saxpyComplete);
+        }
+
+        if (result == CL_SUCCESS)
+        {
+            result = clFlush(slot.queue);
+        }
+
+        for (const cl_event upload : uploads)
+        {
+            if (upload != nullptr)
+            {
+                clReleaseEvent(upload);
+            }
+        }
+
+        OPENCL_PRINT_ON_ERROR(result);
+
+        return result;
+    }
+
+
+    bool Pipeline::Run(const float                  a,
+                       const std::span<const float> xHost,
+                       const std::span<const float> yHost,
+                       std::ofstream&               zOfStream)
+    {
+        concurrency::ThreadPool& hostThreadPool = concurrency::GetHostThreadPool();
+
+        const size_t len        = xHost.size();
+        const size_t chunkCount = (len + m_chunkSizeInElements - 1) / m_chunkSizeInElements;
+
+        for (Slot& slot : m_slots)
+        {
+            slot.xHost.resize(std::min(m_chunkSizeInElements, len));
+            slot.yHost.resize(std::min(m_chunkSizeInElements, len));
+            slot.zHost.resize(std::min(m_chunkSizeInElements, len));
+        }
+
+        // Copying out of the mappings is what faults the file pages in, so it is the read of the pipeline.
+        const auto StartRead = [&](const size_t chunkIndex)
+        {
+            Slot&        slot  = m_slots[chunkIndex % SlotCount];
+            const size_t begin = chunkIndex * m_chunkSizeInElements;
+            const size_t end   = std::min(begin + m_chunkSizeInElements, len);
+
+            slot.read = hostThreadPool.Submit([&slot, xHost, yHost, begin, end]()
+            {
+                std::copy(xHost.begin() + begin, xHost.begin() + end, slot.xHost.begin());
+                std::copy(yHost.begin() + begin, yHost.begin() + end, slot.yHost.begin());
+            });
+        };
+
+        // Chunks may be written out of order, as each one seeks to its own offset.
+        const auto StartWrite = [&](const size_t chunkIndex,
+                                    const cl_event zDownloaded)
+        {
+            Slot&        slot  = m_slots[chunkIndex % SlotCount];
+            const size_t begin = chunkIndex * m_chunkSizeInElements;
+            const size_t end   = std::min(begin + m_chunkSizeInElements, len);
+
+            slot.write = hostThreadPool.Submit([this, &slot, &zOfStream, begin, end, zDownloaded]()
+            {
+                if (zDownloaded != nullptr)
+                {
+                    const cl_int result = clWaitForEvents(1, &zDownloaded);
+                    clReleaseEvent(zDownloaded);
+
+                    if (result != CL_SUCCESS)
+                    {
+                        return false;
+                    }
+                }
+
+                const std::lock_guard lock(m_zOfStreamMutex);
+
+                zOfStream.seekp(static_cast<std::streamoff>(begin * sizeof(float)));
+                zOfStream.write(reinterpret_cast<const char*>(slot.zHost.data()),
+                                static_cast<std::streamsize>((end - begin) * sizeof(float)));
+
+                return zOfStream.good();
+            });
+        };
+
+        bool succeeded = true;
+
+        for (size_t chunkIndex = 0; chunkIndex < std::min(SlotCount - 1, chunkCount); chunkIndex++)
+        {
+            StartRead(chunkIndex);
+        }
+
+        for (size_t chunkIndex = 0; succeeded && (chunkIndex < chunkCount); chunkIndex++)
+        {
+            Slot&        slot     = m_slots[chunkIndex % SlotCount];
+            const size_t begin    = chunkIndex * m_chunkSizeInElements;
+            const size_t chunkLen = std::min(m_chunkSizeInElements, len - begin);
+
+            slot.read.get();
+
+            cl_event zDownloaded = nullptr;
+
+            if (IsOnDevice())
+            {
+                succeeded = (EnqueueChunk(a, slot, chunkLen, zDownloaded) == CL_SUCCESS);
+            }
+            else
+            {
+                saxpy::HostExec(a,
+                                slot.xHost.data(),
+                                slot.yHost.data(),
+                                slot.zHost.data(),
+                                chunkLen,
+                                hostThreadPool);
+            }
+
+            if (succeeded)
+            {
+                StartWrite(chunkIndex, zDownloaded);
+            }
+            else if (zDownloaded != nullptr)
+            {
+                clReleaseEvent(zDownloaded);
+            }
+
+            // The slot read next was last used by the previous chunk, which must be written back first.
+            const size_t nextChunkIndex = chunkIndex + SlotCount - 1;
+
+            if (succeeded && (nextChunkIndex < chunkCount))
+            {
+                Slot& nextSlot = m_slots[nextChunkIndex % SlotCount];
+
+                if (nextSlot.write.valid())
+                {
+                    succeeded = nextSlot.write.get();
+                }
+
+                StartRead(nextChunkIndex);
+            }
+        }
+
+        for (Slot& slot : m_slots)
+        {
+            if (slot.write.valid())
+            {
+                succeeded = slot.write.get() && succeeded;
+            }
+        }
+
+        Drain();
+
+        return succeeded && zOfStream.flush().good();
+    }
+
+
+    // Every task in flight refers to a slot, so none may outlive the pipeline.
+    void Pipeline::Drain() noexcept
+    {
+        for (Slot& slot : m_slots)
+        {
+            if (slot.read.valid())
+            {
+                slot.read.wait();
+            }
+
+            if (slot.write.valid())
+            {
+                slot.write.wait();
+            }
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    Arguments arguments = {};
+
+    if (!ParseArguments(argc, argv, arguments))
+    {
+        std::cerr << Usage;
+        return EXIT_FAILURE;
+    }
+
+    file::ReadOnlyMapping xMapping = {};
+    file::ReadOnlyMapping yMapping = {};
+
+    if (!xMapping.Map(arguments.xFilePath) || !yMapping.Map(arguments.yFilePath))
+    {
+        return EXIT_FAILURE;
+    }
+
+    const std::span<const std::byte> xBytes = xMapping.View();
+    const std::span<const std::byte> yBytes = yMapping.View();
+
+    if ((xBytes.size() != yBytes.size()) || (xBytes.size() % sizeof(float) != 0))
+    {
+        MSG_STD_ERR("Input files must hold the same number of floats: ", arguments.xFilePath, ", ", arguments.yFilePath);
+        return EXIT_FAILURE;
+    }
+
+    // Mappings are page aligned, so they are suitably aligned for floats.
+    const std::span<const float> xHost(reinterpret_cast<const float*>(xBytes.data()), xBytes.size() / sizeof(float));
+    const std::span<const float> yHost(reinterpret_cast<const float*>(yBytes.data()), yBytes.size() / sizeof(float));
+
+    std::ofstream zOfStream(arguments.zFilePath, std::ios::binary | std::ios::trunc);
+
+    if (!zOfStream)
+    {
+        MSG_STD_ERR("Failed to open output file: ", arguments.zFilePath);
+        return EXIT_FAILURE;
+    }
+
+    Pipeline pipeline = {};
+
+    if (pipeline.Init(arguments.chunkSizeInElements) != CL_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (!pipeline.IsOnDevice())
+    {
+        std::cout << "No OpenCL device was found, falling back to the host.\n";
+    }
+
+    const auto start     = std::chrono::steady_clock::now();
+    const bool succeeded = pipeline.Run(arguments.a, xHost, yHost, zOfStream);
+    const auto elapsed   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    if (!succeeded)
+    {
+        MSG_STD_ERR("Failed to stream saxpy into: ", arguments.zFilePath);
+        return EXIT_FAILURE;
+    }
+
+    // Two streams are read and one is written per element.
+    const double gigabytes = 3.0 * xBytes.size() / 1e9;
+
+    std::cout << "Processed " << xHost.size() << " elements in " << elapsed.count() << " s: "
+              << (gigabytes / std::max(elapsed.count(), 1e-9)) << " GB/s\n";
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
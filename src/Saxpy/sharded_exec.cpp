@@ -0,0 +1,346 @@
+#include "build.h"
+#include "context.h"
+#include "debug.h"
+#include "device.h"
+#include "program.h"
+#include "saxpy.h"
+#include "sharded_exec.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <future>
+
+
+namespace
+{
+    enum saxpyHostToDeviceResolve : unsigned int
+    {
+        x = 0,
+        y,
+        count,
+    };
+
+
+    struct SliceExecution
+    {
+        cl_mem                                                xDevice              = nullptr;
+        cl_mem                                                yDevice              = nullptr;
+        cl_mem                                                zDevice              = nullptr;
+        std::array<cl_event, saxpyHostToDeviceResolve::count> hostToDeviceResolves = {};
+        cl_event                                              saxpyExec            = nullptr;
+        cl_event                                              zDeviceToHostResolve = nullptr;
+    };
+
+
+    void ReleaseSliceExecution(SliceExecution& execution) noexcept
+    {
+        for (const cl_mem buffer : { execution.xDevice, execution.yDevice, execution.zDevice })
+        {
+            if (buffer != nullptr)
+            {
+                clReleaseMemObject(buffer);
+            }
+        }
+
+        for (const cl_event event : execution.hostToDeviceResolves)
+        {
+            if (event != nullptr)
+            {
+                clReleaseEvent(event);
+            }
+        }
+
+        for (const cl_event event : { execution.saxpyExec, execution.zDeviceToHostResolve })
+        {
+            if (event != nullptr)
+            {
+                clReleaseEvent(event);
+            }
+        }
+
+        execution = {};
+    }
+
+
+    cl_int EnqueueSlice(const float            a,
+                        const float* const     pXHost,
+                        const float* const     pYHost,
+                        float* const           pZHost,
+                        const size_t           len,
+                        const cl_context       context,
+                        const cl_command_queue queue,
+                        const cl_kernel        kernel,
+                        SliceExecution&        execution)
+    {
+        cl_int       result      = CL_SUCCESS;
+        const size_t sizeInBytes = len * sizeof(float);
+
+        execution.xDevice = clCreateBuffer(context,
+                                           CL_MEM_READ_ONLY | CL_MEM_HOST_WRITE_ONLY,
+                                           sizeInBytes,
+                                           nullptr,
+                                           &result);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        result = clEnqueueWriteBuffer(queue,
+                                      execution.xDevice,
+                                      CL_FALSE,
+                                      0,
+                                      sizeInBytes,
+                                      pXHost,
+                                      0,
+                                      nullptr,
+                                      &execution.hostToDeviceResolves[saxpyHostToDeviceResolve::x]);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        execution.yDevice = clCreateBuffer(context,
+                                           CL_MEM_READ_ONLY | CL_MEM_HOST_WRITE_ONLY,
+                                           sizeInBytes,
+                                           nullptr,
+                                           &result);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        result = clEnqueueWriteBuffer(queue,
+                                      execution.yDevice,
+                                      CL_FALSE,
+                                      0,
+                                      sizeInBytes,
+                                      pYHost,
+                                      0,
+                                      nullptr,
+                                      &execution.hostToDeviceResolves[saxpyHostToDeviceResolve::y]);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        execution.zDevice = clCreateBuffer(context,
+                                           CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY,
+                                           sizeInBytes,
+                                           nullptr,
+                                           &result);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        result = saxpy::EnqueueKernel(a,
+                                      execution.xDevice,
+                                      execution.yDevice,
+                                      execution.zDevice,
+                                      len,
+                                      queue,
+                                      kernel,
+                                      execution.hostToDeviceResolves,
+                                      execution.saxpyExec);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        result = clEnqueueReadBuffer(queue,
+                                     execution.zDevice,
+                                     CL_FALSE,
+                                     0,
+                                     sizeInBytes,
+                                     pZHost,
+                                     1,
+                                     &execution.saxpyExec,
+                                     &execution.zDeviceToHostResolve);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        // Submitting the slice right away lets the devices compute concurrently instead of one after another.
+        result = clFlush(queue);
+        OPENCL_PRINT_ON_ERROR(result);
+
+        return result;
+    }
+}
+
+
+saxpy::ShardedExec::~ShardedExec() noexcept
+{
+    Release();
+}
+
+
+cl_int saxpy::ShardedExec::Init(const std::span<const cl_context> contexts)
+{
+    Release();
+
+    cl_int                           result = CL_SUCCESS;
+    std::vector<std::future<cl_int>> builds = {};
+
+    // Every context needs its own program; building them concurrently hides most of the compilation latency.
+    m_programs.resize(contexts.size(), nullptr);
+    builds.reserve(contexts.size());
+
+    for (size_t i = 0; i < contexts.size(); i++)
+    {
+        builds.push_back(program::BuildAsync(contexts[i],
+                                             std::cref(build::saxpy::binaryCreator),
+                                             build::saxpy::sourceCreator,
+                                             build::saxpy::options,
+                                             m_programs[i]));
+    }
+
+    for (std::future<cl_int>& build : builds)
+    {
+        const cl_int buildResult = build.get();
+
+        if (result == CL_SUCCESS)
+        {
+            result = buildResult;
+        }
+    }
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    for (size_t i = 0; i < contexts.size(); i++)
+    {
+        std::vector<cl_device_id> devices = {};
+
+        result = context::GetDevices(contexts[i], devices);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        for (const cl_device_id device : devices)
+        {
+            Shard shard =
+            {
+                .context    = contexts[i],
+                .queue      = nullptr,
+                .kernel     = nullptr,
+                .throughput = 0.0
+            };
+
+            result = device::EstimateThroughput(device, shard.throughput);
+            OPENCL_RETURN_ON_ERROR(result);
+
+            shard.queue = clCreateCommandQueueWithProperties(contexts[i],
+                                                             device,
+                                                             nullptr,
+                                                             &result);
+
+            OPENCL_RETURN_ON_ERROR(result);
+
+            m_shards.push_back(shard);
+
+            // Each device has its own kernel object, so the arguments of concurrent slices never alias.
+            result = program::CreateKernels(m_programs[i],
+                                            build::saxpy::clKernelNames,
+                                            std::span(&m_shards.back().kernel, 1));
+
+            OPENCL_RETURN_ON_ERROR(result);
+        }
+    }
+
+    return result;
+}
+
+
+void saxpy::ShardedExec::Release() noexcept
+{
+    for (const Shard& shard : m_shards)
+    {
+        if (shard.kernel != nullptr)
+        {
+            clReleaseKernel(shard.kernel);
+        }
+
+        clReleaseCommandQueue(shard.queue);
+    }
+
+    for (const cl_program program : m_programs)
+    {
+        if (program != nullptr)
+        {
+            clReleaseProgram(program);
+        }
+    }
+
+    m_shards.resize(0);
+    m_programs.resize(0);
+}
+
+
+cl_int saxpy::ShardedExec::Exec(const float        a,
+                                const float* const pXHost,
+                                const float* const pYHost,
+                                float* const       pZHost,
+                                const size_t       len)
+{
+    // Without shards nothing would write `pZHost`.
+    if (m_shards.empty())
+    {
+        return CL_INVALID_OPERATION;
+    }
+
+    cl_int                      result          = CL_SUCCESS;
+    std::vector<SliceExecution> executions(m_shards.size());
+    std::vector<size_t>         sliceOffsets(m_shards.size() + 1, 0);
+    double                      totalThroughput = 0.0;
+
+    for (const Shard& shard : m_shards)
+    {
+        totalThroughput += shard.throughput;
+    }
+
+    // Slices are proportional to throughput; without any estimate, every device gets an equal share.
+    double cumulativeThroughput = 0.0;
+
+    for (size_t i = 0; i < m_shards.size(); i++)
+    {
+        cumulativeThroughput += (totalThroughput > 0.0) ? m_shards[i].throughput : 1.0;
+
+        const double share = cumulativeThroughput / ((totalThroughput > 0.0) ? totalThroughput : m_shards.size());
+
+        sliceOffsets[i + 1] = (i + 1 == m_shards.size()) ? len
+                                                         : std::min(len, static_cast<size_t>(share * len));
+    }
+
+    for (size_t i = 0; i < m_shards.size(); i++)
+    {
+        const size_t sliceOffset = sliceOffsets[i];
+        const size_t sliceLen    = sliceOffsets[i + 1] - sliceOffset;
+
+        if (sliceLen == 0)
+        {
+            continue;
+        }
+
+        result = EnqueueSlice(a,
+                              pXHost + sliceOffset,
+                              pYHost + sliceOffset,
+                              pZHost + sliceOffset,
+                              sliceLen,
+                              m_shards[i].context,
+                              m_shards[i].queue,
+                              m_shards[i].kernel,
+                              executions[i]);
+
+        if (result != CL_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    // Even after a failure, every enqueued slice must complete before its buffers and the host memory are let go.
+    for (const Shard& shard : m_shards)
+    {
+        const cl_int finishResult = clFinish(shard.queue);
+
+        if (result == CL_SUCCESS)
+        {
+            result = finishResult;
+        }
+    }
+
+    for (SliceExecution& execution : executions)
+    {
+        ReleaseSliceExecution(execution);
+    }
+
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
\ No newline at end of file
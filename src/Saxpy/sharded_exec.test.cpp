@@ -0,0 +1,119 @@
+#include "context.h"
+#include "platform.h"
+#include "saxpy.h"
+#include "sharded_exec.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+
+class ShardedExecTest : public testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        cl_int                      result    = CL_SUCCESS;
+        std::vector<cl_platform_id> platforms = {};
+
+        result = context::Create(platform::HighestThroughputPerPlatform, platforms, s_contexts);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        if (s_contexts.empty())
+        {
+            GTEST_SKIP() << test_fixture::NoContextMessage;
+        }
+
+        result = s_exec.Init(s_contexts);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        for (const cl_platform_id platform : platforms)
+        {
+            test_fixture::UnloadCompiler(platform);
+        }
+    }
+
+    static void TearDownTestSuite() noexcept
+    {
+        s_exec.Release();
+
+        for (const cl_context context : s_contexts)
+        {
+            const cl_int result = clReleaseContext(context);
+            EXPECT_EQ(result, CL_SUCCESS);
+        }
+
+        s_contexts.clear();
+    }
+
+    static std::vector<cl_context> s_contexts;
+    static saxpy::ShardedExec      s_exec;
+
+    static const std::array<size_t, 6> ProblemSizes;
+    static const float                 A;
+};
+
+std::vector<cl_context> ShardedExecTest::s_contexts = {};
+saxpy::ShardedExec      ShardedExecTest::s_exec     = {};
+
+const std::array<size_t, 6> ShardedExecTest::ProblemSizes =
+{
+    1, 33, 1024, (1024 + 1), (1024 + 31), 1000000
+};
+
+const float ShardedExecTest::A = 2.75;
+
+
+TEST_F(ShardedExecTest, GathersEverySlice)
+{
+    for (const size_t problemSize : ProblemSizes)
+    {
+        std::vector<float> xHost(problemSize);
+        std::vector<float> yHost(problemSize);
+        std::vector<float> zHost(problemSize);
+        std::vector<float> solution(problemSize);
+
+        std::generate(xHost.begin(), xHost.end(), test_fixture::GetRandFloat);
+        std::generate(yHost.begin(), yHost.end(), test_fixture::GetRandFloat);
+
+        const cl_int result = s_exec.Exec(A,
+                                          xHost.data(),
+                                          yHost.data(),
+                                          zHost.data(),
+                                          problemSize);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        saxpy::HostExec(A,
+                        xHost.data(),
+                        yHost.data(),
+                        solution.data(),
+                        solution.size());
+
+        EXPECT_EQ(solution, zHost) << "Host and sharded device saxpy execution results are not equal";
+    }
+}
+
+
+TEST(ShardedExec, RejectsExecWithoutShards)
+{
+    saxpy::ShardedExec exec  = {};
+    std::vector<float> xHost = { 1.0f };
+    std::vector<float> yHost = { 2.0f };
+    std::vector<float> zHost = { 0.0f };
+
+    ASSERT_EQ(exec.GetShardCount(), size_t(0));
+
+    const cl_int result = exec.Exec(2.75f,
+                                    xHost.data(),
+                                    yHost.data(),
+                                    zHost.data(),
+                                    zHost.size());
+
+    EXPECT_EQ(result, CL_INVALID_OPERATION);
+}
\ No newline at end of file
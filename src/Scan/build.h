@@ -0,0 +1,53 @@
+#ifndef SCAN_BUILD_H
+#define SCAN_BUILD_H
+
+#include "program_types.h"
+#include "scan.cl.h"
+
+#include <array>
+#include <filesystem>
+#include <string>
+
+
+namespace build::scan
+{
+    inline extern const std::filesystem::path clBinaryRoot = std::filesystem::current_path() / "Scan_CL_Binaries";
+
+    inline extern const std::array<const std::string, 4> clKernelNames
+    {
+        "scan_reduce",
+        "scan_downsweep",
+        "compact_reduce",
+        "compact_scatter"
+    };
+
+    inline extern const program::BinaryCreator binaryCreator
+    {
+        .clBinaryRoot = std::filesystem::current_path() / "Scan_CL_Binaries",
+#ifdef _DEBUG
+        .clBinaryFileName = "scan_ClBinary_Debug.cl.bin",
+#elif defined(_RELEASE)
+        .clBinaryFileName = "scan_ClBinary_Release.cl.bin",
+#endif // _RELEASE
+        .clSourceHash     = embedded::cl::scan::sourceHash
+    };
+
+    // The kernels use subgroups where the device compiler defines `cl_khr_subgroups`, which SPIR-V would have fixed
+    // at compile time, so programs build from source.
+    inline extern const program::SourceCreator sourceCreator
+    {
+        .clSourceRoot      = {},
+        .clSourceFileNames = {},
+        .clSources         = { embedded::cl::scan::source },
+        .clIl              = {}
+    };
+
+#ifdef _DEBUG
+    inline extern const std::string options = "-D _DEBUG -cl-opt-disable -Werror -cl-std=CL2.0 -g";
+#elif defined(_RELEASE)
+    inline extern const std::string options = "-D _RELEASE -Werror -cl-std=CL2.0";
+#endif // _RELEASE
+}
+
+
+#endif // SCAN_BUILD_H
\ No newline at end of file
@@ -0,0 +1,385 @@
+#ifdef cl_khr_subgroups
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+#endif // cl_khr_subgroups
+
+// Elements each work-item scans sequentially, so a tile of a work-group holds `SCAN_ITEMS_PER_WORK_ITEM` elements per
+// work-item. Keep in step with `ItemsPerWorkItem` of scan.cpp.
+#define SCAN_ITEMS_PER_WORK_ITEM 8
+
+
+// Launches beyond the first start at a global offset of whole work-groups, so tiles are numbered across launches.
+ulong scan_tile_id()
+{
+    return (get_global_offset(0) / get_local_size(0)) + get_group_id(0);
+}
+
+
+// The position of a work-item in work-group scans. With subgroups it follows the subgroups, as their mapping onto
+// local ids is up to the implementation; every subgroup but the last has the maximum size.
+uint scan_position()
+{
+#ifdef cl_khr_subgroups
+    return (get_sub_group_id() * get_max_sub_group_size()) + get_sub_group_local_id();
+#else
+    return get_local_id(0);
+#endif // cl_khr_subgroups
+}
+
+
+// The sum of the values of all work-items before this one, in the order of `scan_position`, and in `pTotal` the sum
+// over the whole work-group. The work-group size is a power of two, and `sums` holds one more uint than work-items.
+// Every work-item of the work-group must call it, and may reuse `sums` once it returns.
+uint work_group_scan(const uint         value,
+                     __local uint* const sums,
+                     uint* const         pTotal)
+{
+    uint prefix = 0;
+
+#ifdef cl_khr_subgroups
+    // Each subgroup scans its own values, then the first subgroup scans the subgroup totals, a subgroup at a time.
+    const uint subGroupId    = get_sub_group_id();
+    const uint subGroupCount = get_num_sub_groups();
+
+    const uint subGroupPrefix = sub_group_scan_exclusive_add(value);
+    const uint subGroupTotal  = sub_group_reduce_add(value);
+
+    if (get_sub_group_local_id() == 0)
+    {
+        sums[subGroupId] = subGroupTotal;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (subGroupId == 0)
+    {
+        const uint subGroupSize = get_sub_group_size();
+        uint       carry        = 0;
+
+        for (uint first = 0; first < subGroupCount; first += subGroupSize)
+        {
+            const uint i       = first + get_sub_group_local_id();
+            const uint total   = (i < subGroupCount) ? sums[i] : 0;
+            const uint scanned = sub_group_scan_exclusive_add(total);
+
+            if (i < subGroupCount)
+            {
+                sums[i] = carry + scanned;
+            }
+
+            carry += sub_group_reduce_add(total);
+        }
+
+        if (get_sub_group_local_id() == 0)
+        {
+            sums[subGroupCount] = carry;
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    prefix  = sums[subGroupId] + subGroupPrefix;
+    *pTotal = sums[subGroupCount];
+#else
+    // The work-efficient scan of Blelloch: an up-sweep builds partial sums in a balanced tree, and a down-sweep
+    // turns them into prefixes, in 2 * log2(n) steps of n additions overall.
+    const uint localId   = get_local_id(0);
+    const uint localSize = get_local_size(0);
+
+    sums[localId] = value;
+
+    for (uint stride = 1; stride < localSize; stride *= 2)
+    {
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        const uint i = ((localId + 1) * stride * 2) - 1;
+
+        if (i < localSize)
+        {
+            sums[i] += sums[i - stride];
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (localId == 0)
+    {
+        sums[localSize]     = sums[localSize - 1];
+        sums[localSize - 1] = 0;
+    }
+
+    for (uint stride = localSize / 2; stride > 0; stride /= 2)
+    {
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        const uint i = ((localId + 1) * stride * 2) - 1;
+
+        if (i < localSize)
+        {
+            const uint left = sums[i - stride];
+
+            sums[i - stride]  = sums[i];
+            sums[i]          += left;
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    prefix  = sums[localId];
+    *pTotal = sums[localSize];
+#endif // cl_khr_subgroups
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    return prefix;
+}
+
+
+// The sum of the values of all work-items of the work-group, returned to each of them. It needs no order, so unlike
+// `work_group_scan` it takes a single pass over the subgroup totals, or a tree that halves the work-items adding.
+// The work-group size is a power of two, and `sums` holds one more uint than work-items. Every work-item of the
+// work-group must call it, and a barrier must pass before `sums` is reused.
+uint work_group_sum(const uint         value,
+                    __local uint* const sums)
+{
+#ifdef cl_khr_subgroups
+    const uint subGroupId    = get_sub_group_id();
+    const uint subGroupCount = get_num_sub_groups();
+    const uint subGroupTotal = sub_group_reduce_add(value);
+
+    if (get_sub_group_local_id() == 0)
+    {
+        sums[subGroupId] = subGroupTotal;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (subGroupId == 0)
+    {
+        uint total = 0;
+
+        for (uint first = 0; first < subGroupCount; first += get_sub_group_size())
+        {
+            const uint i = first + get_sub_group_local_id();
+
+            total += sub_group_reduce_add((i < subGroupCount) ? sums[i] : 0);
+        }
+
+        if (get_sub_group_local_id() == 0)
+        {
+            sums[subGroupCount] = total;
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    return sums[subGroupCount];
+#else
+    const uint localId = get_local_id(0);
+
+    sums[localId] = value;
+
+    for (uint stride = get_local_size(0) / 2; stride > 0; stride /= 2)
+    {
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (localId < stride)
+        {
+            sums[localId] += sums[localId + stride];
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    return sums[0];
+#endif // cl_khr_subgroups
+}
+
+
+// The sum over the elements of the tile of the work-group this work-item loads, read coalesced and counted as flags of
+// zero or one if `isFlags`.
+uint sum_items(__global const uint* const pXDevice,
+               const ulong                len,
+               const bool                 isFlags)
+{
+    const uint  localId   = get_local_id(0);
+    const uint  localSize = get_local_size(0);
+    const ulong tileStart = scan_tile_id() * localSize * SCAN_ITEMS_PER_WORK_ITEM;
+
+    uint total = 0;
+
+    __attribute__((opencl_unroll_hint))
+    for (uint item = 0; item < SCAN_ITEMS_PER_WORK_ITEM; item++)
+    {
+        const ulong x = tileStart + (item * localSize) + localId;
+
+        const uint value = (x < len) ? pXDevice[x] : 0;
+
+        total += isFlags ? (value != 0) : value;
+    }
+
+    return total;
+}
+
+
+// Loads the tile of the work-group coalesced into `tile`, as flags of zero or one if `isFlags`, and zero past `len`.
+void load_tile(__global const uint* const pXDevice,
+               const ulong                len,
+               const bool                 isFlags,
+               __local uint* const        tile)
+{
+    const uint  localId   = get_local_id(0);
+    const uint  localSize = get_local_size(0);
+    const ulong tileStart = scan_tile_id() * localSize * SCAN_ITEMS_PER_WORK_ITEM;
+
+    __attribute__((opencl_unroll_hint))
+    for (uint item = 0; item < SCAN_ITEMS_PER_WORK_ITEM; item++)
+    {
+        const uint  i = (item * localSize) + localId;
+        const ulong x = tileStart + i;
+
+        const uint value = (x < len) ? pXDevice[x] : 0;
+
+        tile[i] = isFlags ? (value != 0) : value;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+
+// Scans the loaded tile in place, exclusively or inclusively, starting from `carry`. Each work-item scans a run of
+// neighbouring elements sequentially, and the work-group scans the run totals. Returns the total of the tile.
+uint scan_tile(const uint          carry,
+               const bool          isInclusive,
+               __local uint* const tile,
+               __local uint* const sums)
+{
+    __local uint* const run = tile + (scan_position() * SCAN_ITEMS_PER_WORK_ITEM);
+
+    uint runTotal = 0;
+
+    __attribute__((opencl_unroll_hint))
+    for (uint item = 0; item < SCAN_ITEMS_PER_WORK_ITEM; item++)
+    {
+        runTotal += run[item];
+    }
+
+    uint tileTotal = 0;
+    uint prefix    = carry + work_group_scan(runTotal, sums, &tileTotal);
+
+    __attribute__((opencl_unroll_hint))
+    for (uint item = 0; item < SCAN_ITEMS_PER_WORK_ITEM; item++)
+    {
+        const uint value = run[item];
+
+        run[item]  = isInclusive ? (prefix + value) : prefix;
+        prefix    += value;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    return tileTotal;
+}
+
+
+// The first phase of a multi-tile scan: the sum of each tile, to be scanned into the carry of each tile.
+__kernel void scan_reduce(__global const uint* const restrict pXDevice,
+                                   const ulong                len,
+                          __global       uint* const restrict pTileSums,
+                          __local        uint* const restrict sums)
+{
+    const uint tileTotal = work_group_sum(sum_items(pXDevice, len, false), sums);
+
+    if (get_local_id(0) == 0)
+    {
+        pTileSums[scan_tile_id()] = tileTotal;
+    }
+}
+
+
+// The last phase of a scan: scans each tile from its carry, the exclusive scan of the tile sums, or from zero for a
+// single tile without `pTileCarries`. x and y may be the same buffer, as each work-group only touches its own tile.
+__kernel void scan_downsweep(__global const uint* const          pXDevice,
+                                      const ulong                len,
+                             __global const uint* const restrict pTileCarries,
+                                      const uint                 isInclusive,
+                             __global       uint* const          pYDevice,
+                             __local        uint* const restrict tile,
+                             __local        uint* const restrict sums)
+{
+    const uint localId   = get_local_id(0);
+    const uint localSize = get_local_size(0);
+    const uint carry     = (pTileCarries != 0) ? pTileCarries[scan_tile_id()] : 0;
+
+    load_tile(pXDevice, len, false, tile);
+    scan_tile(carry, isInclusive != 0, tile, sums);
+
+    const ulong tileStart = scan_tile_id() * localSize * SCAN_ITEMS_PER_WORK_ITEM;
+
+    __attribute__((opencl_unroll_hint))
+    for (uint item = 0; item < SCAN_ITEMS_PER_WORK_ITEM; item++)
+    {
+        const uint  i = (item * localSize) + localId;
+        const ulong y = tileStart + i;
+
+        if (y < len)
+        {
+            pYDevice[y] = tile[i];
+        }
+    }
+}
+
+
+// The first phase of a stream compaction: the number of non-zero flags of each tile.
+__kernel void compact_reduce(__global const uint* const restrict pFlagsDevice,
+                                      const ulong                len,
+                             __global       uint* const restrict pTileCounts,
+                             __local        uint* const restrict sums)
+{
+    const uint tileTotal = work_group_sum(sum_items(pFlagsDevice, len, true), sums);
+
+    if (get_local_id(0) == 0)
+    {
+        pTileCounts[scan_tile_id()] = tileTotal;
+    }
+}
+
+
+// The last phase of a stream compaction: the exclusive scan of the flags of a tile, from the carry of the tile, is
+// where each flagged value goes. The last tile also writes the number of flagged values.
+__kernel void compact_scatter(__global const float* const restrict pValuesDevice,
+                              __global const uint*  const restrict pFlagsDevice,
+                                       const ulong                 len,
+                              __global const uint*  const restrict pTileCarries,
+                              __global       float* const restrict pOutDevice,
+                              __global       uint*  const restrict pCountDevice,
+                              __local        uint*  const restrict tile,
+                              __local        uint*  const restrict sums)
+{
+    const uint localId   = get_local_id(0);
+    const uint localSize = get_local_size(0);
+    const uint carry     = (pTileCarries != 0) ? pTileCarries[scan_tile_id()] : 0;
+
+    load_tile(pFlagsDevice, len, true, tile);
+
+    const uint tileTotal = scan_tile(carry, false, tile, sums);
+
+    const ulong tileSize  = localSize * SCAN_ITEMS_PER_WORK_ITEM;
+    const ulong tileStart = scan_tile_id() * tileSize;
+
+    __attribute__((opencl_unroll_hint))
+    for (uint item = 0; item < SCAN_ITEMS_PER_WORK_ITEM; item++)
+    {
+        const uint  i = (item * localSize) + localId;
+        const ulong x = tileStart + i;
+
+        if ((x < len) && (pFlagsDevice[x] != 0))
+        {
+            pOutDevice[tile[i]] = pValuesDevice[x];
+        }
+    }
+
+    if ((localId == 0) && (tileStart + tileSize >= len))
+    {
+        *pCountDevice = carry + tileTotal;
+    }
+}
\ No newline at end of file
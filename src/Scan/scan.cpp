@@ -0,0 +1,447 @@
+#include "build.h"
+#include "debug.h"
+#include "kernel.h"
+#include "launch.h"
+#include "scan.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+
+namespace
+{
+    // Indices into `build::scan::clKernelNames`.
+    enum KernelIndex : size_t
+    {
+        ScanReduce = 0,
+        ScanDownsweep,
+        CompactReduce,
+        CompactScatter,
+        Count,
+    };
+
+
+    // Matches `SCAN_ITEMS_PER_WORK_ITEM` of scan.cl. Up to 256 work-items per work-group, whose scans only lengthen
+    // beyond that.
+    constexpr size_t ItemsPerWorkItem     = 8;
+    constexpr size_t MaxScanWorkGroupSize = 256;
+
+
+    // What every phase of one scan or compaction shares.
+    struct Launcher
+    {
+        cl_context       context;
+        cl_command_queue queue;
+        size_t           localWorkSize;
+
+        size_t GetTileSize() const noexcept { return localWorkSize * ItemsPerWorkItem; }
+        size_t GetTileCount(const size_t len) const noexcept { return (len + GetTileSize() - 1) / GetTileSize(); }
+    };
+
+
+    void ReleaseEvents(std::vector<cl_event>& events) noexcept
+    {
+        for (const cl_event event : events)
+        {
+            clReleaseEvent(event);
+        }
+
+        events.clear();
+    }
+
+
+    // Work-group scans halve their work-group, so its size is a power of two, small enough for every kernel and for
+    // a tile and its sums to fit local memory. The kernels declare no local memory of their own.
+    cl_int MakeLauncher(const cl_command_queue           scanQueue,
+                        const std::span<const cl_kernel> scanKernels,
+                        Launcher&                        launcher)
+    {
+        cl_int       result          = CL_SUCCESS;
+        cl_device_id executingDevice = nullptr;
+
+        launcher = { .context = nullptr, .queue = scanQueue, .localWorkSize = MaxScanWorkGroupSize };
+
+        result = clGetCommandQueueInfo(scanQueue,
+                                       CL_QUEUE_CONTEXT,
+                                       sizeof(launcher.context),
+                                       &launcher.context,
+                                       nullptr);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        result = clGetCommandQueueInfo(scanQueue,
+                                       CL_QUEUE_DEVICE,
+                                       sizeof(executingDevice),
+                                       &executingDevice,
+                                       nullptr);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        for (const cl_kernel scanKernel : scanKernels)
+        {
+            launch::KernelResources resources = {};
+
+            result = launch::QueryKernelResources(scanKernel, executingDevice, resources);
+            OPENCL_RETURN_ON_ERROR(result);
+
+            launcher.localWorkSize = std::bit_floor(std::max<size_t>(std::min({ launcher.localWorkSize,
+                                                                                 resources.maxWorkGroupSize,
+                                                                                 resources.maxWorkItemSize }), 1));
+
+            while ((launcher.localWorkSize > 1) &&
+                   ((launcher.GetTileSize() + launcher.localWorkSize + 1) * sizeof(cl_uint) > resources.deviceLocalMemSizeInBytes))
+            {
+                launcher.localWorkSize /= 2;
+            }
+        }
+
+        return result;
+    }
+
+
+    // Launches one work-group per tile of `len` elements, in as many launches as the global size limit requires, and
+    // appends an event standing for all of them to `launches`. The local memory of the work-group scans follows
+    // `kernelArgs`: a tile, if `isTiled`, and the sums.
+    cl_int EnqueueTiles(const Launcher&                    launcher,
+                        const cl_kernel                    scanKernel,
+                        const std::span<const kernel::Arg> kernelArgs,
+                        const bool                         isTiled,
+                        const size_t                       len,
+                        const std::span<const cl_event>    eventsToWaitOn,
+                        std::vector<cl_event>&             launches)
+    {
+        cl_int  result = CL_SUCCESS;
+        cl_uint index  = static_cast<cl_uint>(kernelArgs.size());
+
+        result = kernel::SetArgs(scanKernel, kernelArgs);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        if (isTiled)
+        {
+            result = clSetKernelArg(scanKernel, index++, launcher.GetTileSize() * sizeof(cl_uint), nullptr);
+            OPENCL_RETURN_ON_ERROR(result);
+        }
+
+        result = clSetKernelArg(scanKernel, index, (launcher.localWorkSize + 1) * sizeof(cl_uint), nullptr);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        cl_event launched = nullptr;
+
+        result = launch::EnqueueSplit(launcher.queue,
+                                      scanKernel,
+                                      launcher.GetTileCount(len) * launcher.localWorkSize,
+                                      launcher.localWorkSize,
+                                      eventsToWaitOn,
+                                      launched);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        launches.push_back(launched);
+
+        return result;
+    }
+
+
+    cl_int EnqueueScan(const Launcher&            launcher,
+                       std::span<const cl_kernel> scanKernels,
+                       bool                       isInclusive,
+                       cl_mem                     xDevice,
+                       cl_mem                     yDevice,
+                       size_t                     len,
+                       std::span<const cl_event>  eventsToWaitOn,
+                       std::vector<cl_event>&     launches);
+
+
+    // The first two phases over several tiles: sums `xDevice` per tile with `reduceKernel` into a new buffer of
+    // `tileCarries`, then scans that in place into the carry of each tile. A single tile needs no carries, and leaves
+    // `tileCarries` null. Releasing `tileCarries` once the last phase is enqueued is safe, as the buffer lives on until
+    // the commands using it complete.
+    cl_int EnqueueTileCarries(const Launcher&                  launcher,
+                              const std::span<const cl_kernel> scanKernels,
+                              const cl_kernel                  reduceKernel,
+                              const cl_mem                     xDevice,
+                              const size_t                     len,
+                              const std::span<const cl_event>  eventsToWaitOn,
+                              cl_mem&                          tileCarries,
+                              std::vector<cl_event>&           carried)
+    {
+        cl_int                result    = CL_SUCCESS;
+        const cl_ulong        xLen      = len;
+        const size_t          tileCount = launcher.GetTileCount(len);
+        std::vector<cl_event> reduced   = {};
+
+        tileCarries = nullptr;
+
+        if (tileCount <= 1)
+        {
+            return result;
+        }
+
+        tileCarries = clCreateBuffer(launcher.context,
+                                     CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS,
+                                     tileCount * sizeof(cl_uint),
+                                     nullptr,
+                                     &result);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        const std::array<kernel::Arg, 3> kernelArgs =
+        { {
+                { .index = 0, .sizeInBytes = sizeof(xDevice),     .pValue = &xDevice     },
+                { .index = 1, .sizeInBytes = sizeof(xLen),        .pValue = &xLen        },
+                { .index = 2, .sizeInBytes = sizeof(tileCarries), .pValue = &tileCarries }
+        } };
+
+        result = EnqueueTiles(launcher,
+                              reduceKernel,
+                              kernelArgs,
+                              false,
+                              len,
+                              eventsToWaitOn,
+                              reduced);
+
+        if (result == CL_SUCCESS)
+        {
+            result = EnqueueScan(launcher,
+                                 scanKernels,
+                                 false,
+                                 tileCarries,
+                                 tileCarries,
+                                 tileCount,
+                                 reduced,
+                                 carried);
+        }
+
+        ReleaseEvents(reduced);
+
+        OPENCL_PRINT_ON_ERROR(result);
+        return result;
+    }
+
+
+    // Appends the events of the last phase to `launches`.
+    cl_int EnqueueScan(const Launcher&                  launcher,
+                       const std::span<const cl_kernel> scanKernels,
+                       const bool                       isInclusive,
+                       const cl_mem                     xDevice,
+                       const cl_mem                     yDevice,
+                       const size_t                     len,
+                       const std::span<const cl_event>  eventsToWaitOn,
+                       std::vector<cl_event>&           launches)
+    {
+        cl_int                result      = CL_SUCCESS;
+        cl_mem                tileCarries = nullptr;
+        std::vector<cl_event> carried     = {};
+
+        result = EnqueueTileCarries(launcher,
+                                    scanKernels,
+                                    scanKernels[KernelIndex::ScanReduce],
+                                    xDevice,
+                                    len,
+                                    eventsToWaitOn,
+                                    tileCarries,
+                                    carried);
+
+        if (result == CL_SUCCESS)
+        {
+            const cl_ulong xLen      = len;
+            const cl_uint  inclusive = isInclusive;
+
+            const std::array<kernel::Arg, 5> kernelArgs =
+            { {
+                    { .index = 0, .sizeInBytes = sizeof(xDevice),     .pValue = &xDevice     },
+                    { .index = 1, .sizeInBytes = sizeof(xLen),        .pValue = &xLen        },
+                    { .index = 2, .sizeInBytes = sizeof(tileCarries), .pValue = &tileCarries },
+                    { .index = 3, .sizeInBytes = sizeof(inclusive),   .pValue = &inclusive   },
+                    { .index = 4, .sizeInBytes = sizeof(yDevice),     .pValue = &yDevice     }
+            } };
+
+            result = EnqueueTiles(launcher,
+                                  scanKernels[KernelIndex::ScanDownsweep],
+                                  kernelArgs,
+                                  true,
+                                  len,
+                                  (tileCarries != nullptr) ? std::span<const cl_event>(carried) : eventsToWaitOn,
+                                  launches);
+        }
+
+        ReleaseEvents(carried);
+
+        if (tileCarries != nullptr)
+        {
+            clReleaseMemObject(tileCarries);
+        }
+
+        OPENCL_PRINT_ON_ERROR(result);
+        return result;
+    }
+
+
+    // One event stands for every launch. Nothing launched completes once the events it waits on do.
+    cl_int EnqueueMarker(const cl_command_queue          scanQueue,
+                         std::vector<cl_event>&          launches,
+                         const std::span<const cl_event> eventsToWaitOn,
+                         cl_event&                       complete)
+    {
+        cl_int result = CL_SUCCESS;
+
+        const std::span<const cl_event> completeAfter = launches.empty() ? eventsToWaitOn
+                                                                         : std::span<const cl_event>(launches);
+
+        result = clEnqueueMarkerWithWaitList(scanQueue,
+                                             static_cast<cl_uint>(completeAfter.size()),
+                                             completeAfter.data(),
+                                             &complete);
+
+        ReleaseEvents(launches);
+
+        OPENCL_PRINT_ON_ERROR(result);
+        return result;
+    }
+}
+
+
+cl_int scan::EnqueueKernel(const Kind                       kind,
+                           const cl_mem                     xDevice,
+                           const cl_mem                     yDevice,
+                           const size_t                     len,
+                           const cl_command_queue           scanQueue,
+                           const std::span<const cl_kernel> scanKernels,
+                           const std::span<const cl_event>  eventsToWaitOn,
+                           cl_event&                        scanComplete)
+{
+    if (scanKernels.size() != KernelIndex::Count)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    cl_int                result   = CL_SUCCESS;
+    Launcher              launcher = {};
+    std::vector<cl_event> launches = {};
+
+    result = MakeLauncher(scanQueue, scanKernels, launcher);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    if (len > 0)
+    {
+        result = EnqueueScan(launcher,
+                             scanKernels,
+                             kind == Kind::Inclusive,
+                             xDevice,
+                             yDevice,
+                             len,
+                             eventsToWaitOn,
+                             launches);
+    }
+
+    if (result == CL_SUCCESS)
+    {
+        result = EnqueueMarker(scanQueue, launches, eventsToWaitOn, scanComplete);
+    }
+
+    ReleaseEvents(launches);
+
+    OPENCL_PRINT_ON_ERROR(result);
+    return result;
+}
+
+
+cl_int scan::EnqueueCompact(const cl_mem                     valuesDevice,
+                            const cl_mem                     flagsDevice,
+                            const size_t                     len,
+                            const cl_mem                     outDevice,
+                            const cl_mem                     countDevice,
+                            const cl_command_queue           scanQueue,
+                            const std::span<const cl_kernel> scanKernels,
+                            const std::span<const cl_event>  eventsToWaitOn,
+                            cl_event&                        compactComplete)
+{
+    // Positions and the count are cl_uints.
+    if ((scanKernels.size() != KernelIndex::Count) || (len > UINT32_MAX))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    cl_int                result      = CL_SUCCESS;
+    Launcher              launcher    = {};
+    cl_mem                tileCarries = nullptr;
+    std::vector<cl_event> carried     = {};
+    std::vector<cl_event> launches    = {};
+
+    result = MakeLauncher(scanQueue, scanKernels, launcher);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    if (len == 0)
+    {
+        const cl_uint zero   = 0;
+        cl_event      filled = nullptr;
+
+        result = clEnqueueFillBuffer(scanQueue,
+                                     countDevice,
+                                     &zero,
+                                     sizeof(zero),
+                                     0,
+                                     sizeof(zero),
+                                     static_cast<cl_uint>(eventsToWaitOn.size()),
+                                     eventsToWaitOn.data(),
+                                     &filled);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        launches.push_back(filled);
+    }
+    else
+    {
+        result = EnqueueTileCarries(launcher,
+                                    scanKernels,
+                                    scanKernels[KernelIndex::CompactReduce],
+                                    flagsDevice,
+                                    len,
+                                    eventsToWaitOn,
+                                    tileCarries,
+                                    carried);
+    }
+
+    if ((result == CL_SUCCESS) && (len > 0))
+    {
+        const cl_ulong flagsLen = len;
+
+        const std::array<kernel::Arg, 6> kernelArgs =
+        { {
+                { .index = 0, .sizeInBytes = sizeof(valuesDevice), .pValue = &valuesDevice },
+                { .index = 1, .sizeInBytes = sizeof(flagsDevice),  .pValue = &flagsDevice  },
+                { .index = 2, .sizeInBytes = sizeof(flagsLen),     .pValue = &flagsLen     },
+                { .index = 3, .sizeInBytes = sizeof(tileCarries),  .pValue = &tileCarries  },
+                { .index = 4, .sizeInBytes = sizeof(outDevice),    .pValue = &outDevice    },
+                { .index = 5, .sizeInBytes = sizeof(countDevice),  .pValue = &countDevice  }
+        } };
+
+        result = EnqueueTiles(launcher,
+                              scanKernels[KernelIndex::CompactScatter],
+                              kernelArgs,
+                              true,
+                              len,
+                              (tileCarries != nullptr) ? std::span<const cl_event>(carried) : eventsToWaitOn,
+                              launches);
+    }
+
+    if (result == CL_SUCCESS)
+    {
+        result = EnqueueMarker(scanQueue, launches, eventsToWaitOn, compactComplete);
+    }
+
+    ReleaseEvents(carried);
+    ReleaseEvents(launches);
+
+    if (tileCarries != nullptr)
+    {
+        clReleaseMemObject(tileCarries);
+    }
+
+    OPENCL_PRINT_ON_ERROR(result);
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,403 @@
+#include "build.h"
+#include "program.h"
+#include "scan.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+
+namespace
+{
+    // The largest tile scan.cpp launches: 256 work-items of 8 elements. Devices with smaller work-groups split it into
+    // several tiles.
+    constexpr size_t MaxTileSize = 256 * 8;
+
+    // Around the end of the largest tile, and enough tiles for the tile sums to take several tiles themselves.
+    constexpr std::array<size_t, 8> Lengths =
+    {
+        1, 1000, MaxTileSize - 1, MaxTileSize, MaxTileSize + 1, 100'003, (1 << 20) + 7, (1 << 23) + 5
+    };
+
+
+    std::vector<cl_uint> MakeRandomUints(const size_t len)
+    {
+        std::mt19937                           generator(42);
+        std::uniform_int_distribution<cl_uint> value;
+
+        std::vector<cl_uint> values(len);
+        std::generate(values.begin(), values.end(), [&]() { return value(generator); });
+
+        return values;
+    }
+}
+
+
+class ScanTest : public test_fixture::ContextTest
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        ContextTest::SetUpTestSuite();
+
+        if (s_context != nullptr)
+        {
+            BuildProgram(build::scan::binaryCreator,
+                         build::scan::sourceCreator,
+                         build::scan::options);
+        }
+    }
+
+    void SetUp() override final
+    {
+        cl_int result = CL_SUCCESS;
+
+        result = program::CreateKernels(s_program,
+                                        build::scan::clKernelNames,
+                                        m_kernels);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        ContextTest::SetUp();
+    }
+
+    void TearDown() noexcept override final
+    {
+        ReleaseKernels(m_kernels);
+
+        ContextTest::TearDown();
+    }
+
+    template <typename T>
+    cl_mem CreateBuffer(const std::vector<T>& hostData) noexcept
+    {
+        cl_int result = CL_SUCCESS;
+
+        const cl_mem buffer = clCreateBuffer(s_context,
+                                             CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                             hostData.size() * sizeof(T),
+                                             const_cast<T*>(hostData.data()),
+                                             &result);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        return buffer;
+    }
+
+    template <typename T>
+    void ReadBuffer(const cl_mem    buffer,
+                    std::vector<T>& hostData) noexcept
+    {
+        const cl_int result = clEnqueueReadBuffer(m_queue,
+                                                  buffer,
+                                                  CL_TRUE,
+                                                  0,
+                                                  hostData.size() * sizeof(T),
+                                                  hostData.data(),
+                                                  0,
+                                                  nullptr,
+                                                  nullptr);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+    }
+
+    // Scans `xHost` `iterations` times, in place if `isInPlace`, and returns the seconds the scans took.
+    double ExecScan(const scan::Kind            kind,
+                    const std::vector<cl_uint>& xHost,
+                    const bool                  isInPlace,
+                    std::vector<cl_uint>&       yHost,
+                    const size_t                iterations = 1) noexcept
+    {
+        const cl_mem xDevice = CreateBuffer(xHost);
+        const cl_mem yDevice = isInPlace ? xDevice : CreateBuffer(std::vector<cl_uint>(xHost.size()));
+
+        EXPECT_EQ(clFinish(m_queue), CL_SUCCESS);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; i++)
+        {
+            cl_event scanComplete = nullptr;
+
+            const cl_int result = scan::EnqueueKernel(kind,
+                                                      xDevice,
+                                                      yDevice,
+                                                      xHost.size(),
+                                                      m_queue,
+                                                      m_kernels,
+                                                      {},
+                                                      scanComplete);
+
+            EXPECT_EQ(result, CL_SUCCESS);
+
+            if (result == CL_SUCCESS)
+            {
+                EXPECT_EQ(clReleaseEvent(scanComplete), CL_SUCCESS);
+            }
+        }
+
+        EXPECT_EQ(clFinish(m_queue), CL_SUCCESS);
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        yHost.resize(xHost.size());
+        ReadBuffer(yDevice, yHost);
+
+        EXPECT_EQ(clReleaseMemObject(xDevice), CL_SUCCESS);
+
+        if (!isInPlace)
+        {
+            EXPECT_EQ(clReleaseMemObject(yDevice), CL_SUCCESS);
+        }
+
+        return elapsed.count();
+    }
+
+    // Compacts `valuesHost` by `flagsHost` `iterations` times, and returns the seconds the compactions took.
+    double ExecCompact(const std::vector<float>&   valuesHost,
+                       const std::vector<cl_uint>& flagsHost,
+                       std::vector<float>&         outHost,
+                       const size_t                iterations = 1) noexcept
+    {
+        const cl_mem valuesDevice = CreateBuffer(valuesHost);
+        const cl_mem flagsDevice  = CreateBuffer(flagsHost);
+        const cl_mem outDevice    = CreateBuffer(std::vector<float>(valuesHost.size()));
+        const cl_mem countDevice  = CreateBuffer(std::vector<cl_uint>(1));
+
+        EXPECT_EQ(clFinish(m_queue), CL_SUCCESS);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; i++)
+        {
+            cl_event compactComplete = nullptr;
+
+            const cl_int result = scan::EnqueueCompact(valuesDevice,
+                                                       flagsDevice,
+                                                       valuesHost.size(),
+                                                       outDevice,
+                                                       countDevice,
+                                                       m_queue,
+                                                       m_kernels,
+                                                       {},
+                                                       compactComplete);
+
+            EXPECT_EQ(result, CL_SUCCESS);
+
+            if (result == CL_SUCCESS)
+            {
+                EXPECT_EQ(clReleaseEvent(compactComplete), CL_SUCCESS);
+            }
+        }
+
+        EXPECT_EQ(clFinish(m_queue), CL_SUCCESS);
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::vector<cl_uint> count(1);
+        ReadBuffer(countDevice, count);
+
+        // Reads of zero bytes are invalid.
+        outHost.resize(count[0]);
+
+        if (!outHost.empty())
+        {
+            ReadBuffer(outDevice, outHost);
+        }
+
+        for (const cl_mem buffer : { valuesDevice, flagsDevice, outDevice, countDevice })
+        {
+            EXPECT_EQ(clReleaseMemObject(buffer), CL_SUCCESS);
+        }
+
+        return elapsed.count();
+    }
+
+    std::array<cl_kernel, build::scan::clKernelNames.size()> m_kernels = {};
+};
+
+
+TEST_F(ScanTest, MatchesStdExclusiveScan)
+{
+    for (const size_t len : Lengths)
+    {
+        const std::vector<cl_uint> xHost    = MakeRandomUints(len);
+        std::vector<cl_uint>       yHost    = {};
+        std::vector<cl_uint>       solution(len);
+
+        // Sums of random cl_uints wrap around, on the host as on the device.
+        std::exclusive_scan(xHost.begin(), xHost.end(), solution.begin(), cl_uint(0));
+
+        ExecScan(scan::Kind::Exclusive, xHost, false, yHost);
+
+        ASSERT_EQ(yHost, solution) << "Exclusive scans of " << len << " elements differ";
+    }
+}
+
+
+TEST_F(ScanTest, MatchesStdInclusiveScanInPlace)
+{
+    for (const size_t len : Lengths)
+    {
+        const std::vector<cl_uint> xHost    = MakeRandomUints(len);
+        std::vector<cl_uint>       yHost    = {};
+        std::vector<cl_uint>       solution(len);
+
+        std::inclusive_scan(xHost.begin(), xHost.end(), solution.begin());
+
+        ExecScan(scan::Kind::Inclusive, xHost, true, yHost);
+
+        ASSERT_EQ(yHost, solution) << "Inclusive scans of " << len << " elements differ";
+    }
+}
+
+
+TEST_F(ScanTest, CompactionMatchesStdCopyIf)
+{
+    std::mt19937                          generator(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (const size_t len : Lengths)
+    {
+        for (const float density : { 0.0f, 0.01f, 0.5f, 1.0f })
+        {
+            std::vector<float>   valuesHost(len);
+            std::vector<cl_uint> flagsHost(len);
+            std::vector<float>   outHost  = {};
+            std::vector<float>   solution = {};
+
+            // Any non-zero flag keeps its value.
+            for (size_t i = 0; i < len; i++)
+            {
+                valuesHost[i] = static_cast<float>(i);
+                flagsHost[i]  = (unit(generator) < density) ? (static_cast<cl_uint>(generator()) | 1) : 0;
+            }
+
+            for (size_t i = 0; i < len; i++)
+            {
+                if (flagsHost[i] != 0)
+                {
+                    solution.push_back(valuesHost[i]);
+                }
+            }
+
+            ExecCompact(valuesHost, flagsHost, outHost);
+
+            ASSERT_EQ(outHost, solution) << "Compactions of " << len << " elements at density " << density << " differ";
+        }
+    }
+}
+
+
+// Zero-sized buffers are invalid, so one-element buffers stand in for empty ones, which nothing may touch.
+TEST_F(ScanTest, HandlesEmptyInputs)
+{
+    const cl_mem xDevice      = CreateBuffer(std::vector<cl_uint>{ 7 });
+    const cl_mem yDevice      = CreateBuffer(std::vector<cl_uint>{ 9 });
+    const cl_mem valuesDevice = CreateBuffer(std::vector<float>{ 1.0f });
+    const cl_mem flagsDevice  = CreateBuffer(std::vector<cl_uint>{ 1 });
+    const cl_mem outDevice    = CreateBuffer(std::vector<float>{ 5.0f });
+    const cl_mem countDevice  = CreateBuffer(std::vector<cl_uint>{ 123 });
+
+    for (const scan::Kind kind : { scan::Kind::Exclusive, scan::Kind::Inclusive })
+    {
+        cl_event scanComplete = nullptr;
+
+        ASSERT_EQ(scan::EnqueueKernel(kind, xDevice, yDevice, 0, m_queue, m_kernels, {}, scanComplete), CL_SUCCESS);
+
+        EXPECT_EQ(clWaitForEvents(1, &scanComplete), CL_SUCCESS);
+        EXPECT_EQ(clReleaseEvent(scanComplete), CL_SUCCESS);
+    }
+
+    cl_event compactComplete = nullptr;
+
+    ASSERT_EQ(scan::EnqueueCompact(valuesDevice,
+                                   flagsDevice,
+                                   0,
+                                   outDevice,
+                                   countDevice,
+                                   m_queue,
+                                   m_kernels,
+                                   {},
+                                   compactComplete),
+              CL_SUCCESS);
+
+    EXPECT_EQ(clWaitForEvents(1, &compactComplete), CL_SUCCESS);
+    EXPECT_EQ(clReleaseEvent(compactComplete), CL_SUCCESS);
+
+    std::vector<cl_uint> yHost(1);
+    std::vector<float>   outHost(1);
+    std::vector<cl_uint> count(1);
+
+    ReadBuffer(yDevice, yHost);
+    ReadBuffer(outDevice, outHost);
+    ReadBuffer(countDevice, count);
+
+    EXPECT_EQ(yHost[0], 9u);
+    EXPECT_EQ(outHost[0], 5.0f);
+    EXPECT_EQ(count[0], 0u);
+
+    for (const cl_mem buffer : { xDevice, yDevice, valuesDevice, flagsDevice, outDevice, countDevice })
+    {
+        EXPECT_EQ(clReleaseMemObject(buffer), CL_SUCCESS);
+    }
+}
+
+
+TEST_F(ScanTest, DISABLED_ThroughputBenchmark)
+{
+    constexpr size_t Len        = 1 << 25;
+    constexpr size_t Iterations = 16;
+
+    const std::vector<cl_uint> xHost = MakeRandomUints(Len);
+    std::vector<cl_uint>       yHost = {};
+
+    // The first execution absorbs one-off costs, e.g. of allocating device memory.
+    ExecScan(scan::Kind::Exclusive, xHost, false, yHost);
+
+    const double scanSeconds = ExecScan(scan::Kind::Exclusive, xHost, false, yHost, Iterations);
+
+    std::cout << "[ BENCHMARK] Exclusive scan of " << Len << " cl_uints: "
+              << (static_cast<double>(Len) * Iterations) / scanSeconds << " elements/s\n";
+
+    std::vector<float>   valuesHost(Len, 1.0f);
+    std::vector<cl_uint> flagsHost(Len);
+    std::vector<float>   outHost = {};
+
+    std::transform(xHost.begin(), xHost.end(), flagsHost.begin(), [](const cl_uint x) { return x & 1; });
+
+    ExecCompact(valuesHost, flagsHost, outHost);
+
+    const double compactSeconds = ExecCompact(valuesHost, flagsHost, outHost, Iterations);
+
+    std::cout << "[ BENCHMARK] Compaction of " << Len << " floats, half flagged: "
+              << (static_cast<double>(Len) * Iterations) / compactSeconds << " elements/s\n";
+}
+
+
+TEST(Scan, RejectsInvalidArguments)
+{
+    const std::array<cl_kernel, build::scan::clKernelNames.size() - 1> tooFewKernels = {};
+    const std::array<cl_kernel, build::scan::clKernelNames.size()>     kernels       = {};
+    cl_event                                                           complete      = nullptr;
+
+    EXPECT_EQ(scan::EnqueueKernel(scan::Kind::Exclusive, nullptr, nullptr, 1, nullptr, tooFewKernels, {}, complete),
+              CL_INVALID_VALUE);
+
+    EXPECT_EQ(scan::EnqueueCompact(nullptr, nullptr, 1, nullptr, nullptr, nullptr, tooFewKernels, {}, complete),
+              CL_INVALID_VALUE);
+
+    // Positions of compacted values would not fit a cl_uint.
+    EXPECT_EQ(scan::EnqueueCompact(nullptr, nullptr, size_t(UINT32_MAX) + 1, nullptr, nullptr, nullptr, kernels, {}, complete),
+              CL_INVALID_VALUE);
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef SGEMM_BUILD_H
+#define SGEMM_BUILD_H
+
+#include "program_types.h"
+#include "sgemm.cl.h"
+
+#include <array>
+#include <filesystem>
+#include <string>
+
+
+namespace build::sgemm
+{
+    inline extern const std::filesystem::path clBinaryRoot = std::filesystem::current_path() / "Sgemm_CL_Binaries";
+
+    // Indexed by whether A, then B, is transposed.
+    inline extern const std::array<const std::string, 4> clKernelNames
+    {
+        "sgemm_nn",
+        "sgemm_nt",
+        "sgemm_tn",
+        "sgemm_tt"
+    };
+
+    // `sgemm::Build` names the binary of each tiling after its build options.
+    inline extern const program::BinaryCreator binaryCreator
+    {
+        .clBinaryRoot = std::filesystem::current_path() / "Sgemm_CL_Binaries",
+#ifdef _DEBUG
+        .clBinaryFileName = "sgemm_ClBinary_Debug.cl.bin",
+#elif defined(_RELEASE)
+        .clBinaryFileName = "sgemm_ClBinary_Release.cl.bin",
+#endif // _RELEASE
+        .clSourceHash     = embedded::cl::sgemm::sourceHash
+    };
+
+    // Tiles are "-D" build options, which SPIR-V would have been compiled without, so programs build from source.
+    inline extern const program::SourceCreator sourceCreator
+    {
+        .clSourceRoot      = {},
+        .clSourceFileNames = {},
+        .clSources         = { embedded::cl::sgemm::source },
+        .clIl              = {}
+    };
+
+#ifdef _DEBUG
+    inline extern const std::string options = "-D _DEBUG -cl-opt-disable -Werror -cl-std=CL2.0 -g";
+#elif defined(_RELEASE)
+    inline extern const std::string options = "-D _RELEASE -Werror -cl-std=CL2.0";
+#endif // _RELEASE
+}
+
+
+#endif // SGEMM_BUILD_H
\ No newline at end of file
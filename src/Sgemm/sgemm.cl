@@ -0,0 +1,280 @@
+// Tunables, all passed as "-D" build options:
+//   SGEMM_TILE_M, SGEMM_TILE_N  rows and columns of C one work-group computes;
+//   SGEMM_TILE_K                depth of the tiles of op(A) and op(B) staged in local memory per step;
+//   SGEMM_WPT_M, SGEMM_WPT_N    rows and columns of C one work-item accumulates in registers;
+//   SGEMM_VECTOR_WIDTH          elements per vector load from global memory: 1, 2, 4 or 8.
+// The host guarantees that tiles are multiples of the work per work-item and of the vector width.
+#ifndef SGEMM_TILE_M
+#define SGEMM_TILE_M 64
+#endif
+
+#ifndef SGEMM_TILE_N
+#define SGEMM_TILE_N 64
+#endif
+
+#ifndef SGEMM_TILE_K
+#define SGEMM_TILE_K 16
+#endif
+
+#ifndef SGEMM_WPT_M
+#define SGEMM_WPT_M 4
+#endif
+
+#ifndef SGEMM_WPT_N
+#define SGEMM_WPT_N 4
+#endif
+
+#ifndef SGEMM_VECTOR_WIDTH
+#define SGEMM_VECTOR_WIDTH 4
+#endif
+
+#define SGEMM_THREADS_M (SGEMM_TILE_M / SGEMM_WPT_M)
+#define SGEMM_THREADS_N (SGEMM_TILE_N / SGEMM_WPT_N)
+#define SGEMM_THREADS   (SGEMM_THREADS_M * SGEMM_THREADS_N)
+
+#define SGEMM_PASTE(x, y) x ## y
+#define SGEMM_EXPAND_PASTE(x, y) SGEMM_PASTE(x, y)
+
+#if SGEMM_VECTOR_WIDTH == 1
+#define SGEMM_LOAD_VECTOR(values, offset, p) ((values)[0] = (p)[offset])
+#else
+#define SGEMM_LOAD_VECTOR(values, offset, p) \
+    SGEMM_EXPAND_PASTE(vstore, SGEMM_VECTOR_WIDTH)(SGEMM_EXPAND_PASTE(vload, SGEMM_VECTOR_WIDTH)(0, (p) + (offset)), 0, (values))
+#endif
+
+#define SGEMM_KERNEL_ATTRIBUTES __kernel __attribute__((reqd_work_group_size(SGEMM_THREADS_N, SGEMM_THREADS_M, 1)))
+
+
+// Stages the part of op(M) at depths [k0, k0 + SGEMM_TILE_K) and positions [x0, x0 + tileX) of its other dimension
+// in local memory, laid out as tile[depth][position]. op(M) has `extentX` positions and `extentK` depths, and what
+// lies outside of it is staged as zeros, so partial tiles need no special casing later on. M is row-major with
+// leading dimension `ld`; `depthIsContiguous` tells whether depths or positions are contiguous in its rows. Loads
+// run along the contiguous dimension, so neighbouring work-items read neighbouring vectors.
+void stage_tile(__local        float* const restrict tile,
+                __global const float* const restrict pMDevice,
+                         const ulong                 ld,
+                         const ulong                 extentX,
+                         const ulong                 extentK,
+                         const ulong                 x0,
+                         const ulong                 k0,
+                         const uint                  tileX,
+                         const bool                  depthIsContiguous)
+{
+    const uint  tileInner      = depthIsContiguous ? SGEMM_TILE_K : tileX;
+    const uint  tileOuter      = depthIsContiguous ? tileX : SGEMM_TILE_K;
+    const ulong extentInner    = depthIsContiguous ? extentK : extentX;
+    const ulong extentOuter    = depthIsContiguous ? extentX : extentK;
+    const ulong inner0         = depthIsContiguous ? k0 : x0;
+    const ulong outer0         = depthIsContiguous ? x0 : k0;
+    const uint  vectorsPerLine = tileInner / SGEMM_VECTOR_WIDTH;
+    const uint  localId        = (get_local_id(1) * SGEMM_THREADS_N) + get_local_id(0);
+
+    for (uint chunk = localId; chunk < vectorsPerLine * tileOuter; chunk += SGEMM_THREADS)
+    {
+        const uint  outer       = chunk / vectorsPerLine;
+        const uint  inner       = (chunk % vectorsPerLine) * SGEMM_VECTOR_WIDTH;
+        const ulong globalOuter = outer0 + outer;
+        const ulong globalInner = inner0 + inner;
+        const ulong offset      = (globalOuter * ld) + globalInner;
+        float       values[SGEMM_VECTOR_WIDTH];
+
+        if ((globalOuter < extentOuter) && (globalInner + SGEMM_VECTOR_WIDTH <= extentInner))
+        {
+            SGEMM_LOAD_VECTOR(values, offset, pMDevice);
+        }
+        else
+        {
+            __attribute__((opencl_unroll_hint))
+            for (uint v = 0; v < SGEMM_VECTOR_WIDTH; v++)
+            {
+                values[v] = ((globalOuter < extentOuter) && (globalInner + v < extentInner)) ? pMDevice[offset + v] : 0.0f;
+            }
+        }
+
+        __attribute__((opencl_unroll_hint))
+        for (uint v = 0; v < SGEMM_VECTOR_WIDTH; v++)
+        {
+            const uint depth    = depthIsContiguous ? (inner + v) : outer;
+            const uint position = depthIsContiguous ? outer : (inner + v);
+
+            tile[(depth * tileX) + position] = values[v];
+        }
+    }
+}
+
+
+// C = alpha * op(A) * op(B) + beta * C, all row-major; op(A) is m x k and op(B) is k x n. Each work-item accumulates
+// SGEMM_WPT_M x SGEMM_WPT_N elements of C in registers, strided by the work-group extent so that work-items reading
+// neighbouring elements of a tile, and writing neighbouring elements of C, are neighbours themselves.
+void sgemm(         const ulong                 m,
+                    const ulong                 n,
+                    const ulong                 k,
+                    const float                 alpha,
+           __global const float* const restrict pADevice,
+                    const ulong                 lda,
+           __global const float* const restrict pBDevice,
+                    const ulong                 ldb,
+                    const float                 beta,
+           __global       float* const restrict pCDevice,
+                    const ulong                 ldc,
+                    const bool                  transposeA,
+                    const bool                  transposeB,
+           __local        float* const restrict tileA,
+           __local        float* const restrict tileB)
+{
+    const uint  threadN = get_local_id(0);
+    const uint  threadM = get_local_id(1);
+    const ulong col0    = get_group_id(0) * SGEMM_TILE_N;
+    const ulong row0    = get_group_id(1) * SGEMM_TILE_M;
+
+    float accumulators[SGEMM_WPT_M][SGEMM_WPT_N];
+
+    __attribute__((opencl_unroll_hint))
+    for (uint wm = 0; wm < SGEMM_WPT_M; wm++)
+    {
+        __attribute__((opencl_unroll_hint))
+        for (uint wn = 0; wn < SGEMM_WPT_N; wn++)
+        {
+            accumulators[wm][wn] = 0.0f;
+        }
+    }
+
+    for (ulong k0 = 0; k0 < k; k0 += SGEMM_TILE_K)
+    {
+        // Untransposed, the depth of op(A) runs along the rows of A and that of op(B) along the columns of B.
+        stage_tile(tileA, pADevice, lda, m, k, row0, k0, SGEMM_TILE_M, !transposeA);
+        stage_tile(tileB, pBDevice, ldb, n, k, col0, k0, SGEMM_TILE_N, transposeB);
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        __attribute__((opencl_unroll_hint))
+        for (uint depth = 0; depth < SGEMM_TILE_K; depth++)
+        {
+            float a[SGEMM_WPT_M];
+            float b[SGEMM_WPT_N];
+
+            __attribute__((opencl_unroll_hint))
+            for (uint wm = 0; wm < SGEMM_WPT_M; wm++)
+            {
+                a[wm] = tileA[(depth * SGEMM_TILE_M) + threadM + (wm * SGEMM_THREADS_M)];
+            }
+
+            __attribute__((opencl_unroll_hint))
+            for (uint wn = 0; wn < SGEMM_WPT_N; wn++)
+            {
+                b[wn] = tileB[(depth * SGEMM_TILE_N) + threadN + (wn * SGEMM_THREADS_N)];
+            }
+
+            __attribute__((opencl_unroll_hint))
+            for (uint wm = 0; wm < SGEMM_WPT_M; wm++)
+            {
+                __attribute__((opencl_unroll_hint))
+                for (uint wn = 0; wn < SGEMM_WPT_N; wn++)
+                {
+                    accumulators[wm][wn] = fma(a[wm], b[wn], accumulators[wm][wn]);
+                }
+            }
+        }
+
+        // The next step overwrites the tiles the slowest work-item may still read.
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    __attribute__((opencl_unroll_hint))
+    for (uint wm = 0; wm < SGEMM_WPT_M; wm++)
+    {
+        const ulong row = row0 + threadM + (wm * SGEMM_THREADS_M);
+
+        __attribute__((opencl_unroll_hint))
+        for (uint wn = 0; wn < SGEMM_WPT_N; wn++)
+        {
+            const ulong col = col0 + threadN + (wn * SGEMM_THREADS_N);
+
+            if ((row < m) && (col < n))
+            {
+                const ulong offset = (row * ldc) + col;
+
+                // As in BLAS, a zero beta leaves C unread, so it may hold anything, even NaNs.
+                pCDevice[offset] = (beta == 0.0f) ? (alpha * accumulators[wm][wn])
+                                                  : fma(alpha, accumulators[wm][wn], beta * pCDevice[offset]);
+            }
+        }
+    }
+}
+
+
+// One kernel per combination of transposes, so that each loads its tiles along the contiguous dimension.
+SGEMM_KERNEL_ATTRIBUTES void sgemm_nn(         const ulong                 m,
+                                               const ulong                 n,
+                                               const ulong                 k,
+                                               const float                 alpha,
+                                      __global const float* const restrict pADevice,
+                                               const ulong                 lda,
+                                      __global const float* const restrict pBDevice,
+                                               const ulong                 ldb,
+                                               const float                 beta,
+                                      __global       float* const restrict pCDevice,
+                                               const ulong                 ldc)
+{
+    __local float tileA[SGEMM_TILE_K * SGEMM_TILE_M];
+    __local float tileB[SGEMM_TILE_K * SGEMM_TILE_N];
+
+    sgemm(m, n, k, alpha, pADevice, lda, pBDevice, ldb, beta, pCDevice, ldc, false, false, tileA, tileB);
+}
+
+
+SGEMM_KERNEL_ATTRIBUTES void sgemm_nt(         const ulong                 m,
+                                               const ulong                 n,
+                                               const ulong                 k,
+                                               const float                 alpha,
+                                      __global const float* const restrict pADevice,
+                                               const ulong                 lda,
+                                      __global const float* const restrict pBDevice,
+                                               const ulong                 ldb,
+                                               const float                 beta,
+                                      __global       float* const restrict pCDevice,
+                                               const ulong                 ldc)
+{
+    __local float tileA[SGEMM_TILE_K * SGEMM_TILE_M];
+    __local float tileB[SGEMM_TILE_K * SGEMM_TILE_N];
+
+    sgemm(m, n, k, alpha, pADevice, lda, pBDevice, ldb, beta, pCDevice, ldc, false, true, tileA, tileB);
+}
+
+
+SGEMM_KERNEL_ATTRIBUTES void sgemm_tn(         const ulong                 m,
+                                               const ulong                 n,
+                                               const ulong                 k,
+                                               const float                 alpha,
+                                      __global const float* const restrict pADevice,
+                                               const ulong                 lda,
+                                      __global const float* const restrict pBDevice,
+                                               const ulong                 ldb,
+                                               const float                 beta,
+                                      __global       float* const restrict pCDevice,
+                                               const ulong                 ldc)
+{
+    __local float tileA[SGEMM_TILE_K * SGEMM_TILE_M];
+    __local float tileB[SGEMM_TILE_K * SGEMM_TILE_N];
+
+    sgemm(m, n, k, alpha, pADevice, lda, pBDevice, ldb, beta, pCDevice, ldc, true, false, tileA, tileB);
+}
+
+
+SGEMM_KERNEL_ATTRIBUTES void sgemm_tt(         const ulong                 m,
+                                               const ulong                 n,
+                                               const ulong                 k,
+                                               const float                 alpha,
+                                      __global const float* const restrict pADevice,
+                                               const ulong                 lda,
+                                      __global const float* const restrict pBDevice,
+                                               const ulong                 ldb,
+                                               const float                 beta,
+                                      __global       float* const restrict pCDevice,
+                                               const ulong                 ldc)
+{
+    __local float tileA[SGEMM_TILE_K * SGEMM_TILE_M];
+    __local float tileB[SGEMM_TILE_K * SGEMM_TILE_N];
+
+    sgemm(m, n, k, alpha, pADevice, lda, pBDevice, ldb, beta, pCDevice, ldc, true, true, tileA, tileB);
+}
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include "build.h"
+#include "debug.h"
+#include "kernel.h"
+#include "program.h"
+#include "sgemm.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <sstream>
+
+
+namespace
+{
+    // Host blocks of 64 x 64 floats take 16 KiB, so those of A, B and C fit into most L1 and L2 caches together.
+    constexpr size_t HostBlockSize = 64;
+
+
+    bool IsValid(const sgemm::Tiling& tiling)
+    {
+        const bool isValidVectorWidth = (tiling.vectorWidth == 1) || (tiling.vectorWidth == 2) ||
+                                        (tiling.vectorWidth == 4) || (tiling.vectorWidth == 8);
+
+        const bool isPositive = (tiling.tileM > 0) && (tiling.tileN > 0) && (tiling.tileK > 0) &&
+                                (tiling.workPerItemM > 0) && (tiling.workPerItemN > 0);
+
+        // Tiles are split evenly among work-items, and each line of a tile into whole vectors.
+        return isValidVectorWidth && isPositive &&
+               (tiling.tileM % tiling.workPerItemM == 0) && (tiling.tileN % tiling.workPerItemN == 0) &&
+               (tiling.tileM % tiling.vectorWidth == 0)  && (tiling.tileN % tiling.vectorWidth == 0)  &&
+               (tiling.tileK % tiling.vectorWidth == 0);
+    }
+
+
+    // A stored matrix is a number of lines, the rows of row-major or the columns of column-major storage, each
+    // `lineLength` long and `ld` apart.
+    struct Storage
+    {
+        size_t lines;
+        size_t lineLength;
+        size_t ld;
+    };
+
+
+    Storage GetStorage(const sgemm::Layout    layout,
+                       const sgemm::Transpose transpose,
+                       const size_t           opRows,
+                       const size_t           opCols,
+                       const size_t           ld) noexcept
+    {
+        const size_t rows = (transpose == sgemm::Transpose::Yes) ? opCols : opRows;
+        const size_t cols = (transpose == sgemm::Transpose::Yes) ? opRows : opCols;
+
+        return (layout == sgemm::Layout::RowMajor) ? Storage{ .lines = rows, .lineLength = cols, .ld = ld }
+                                                   : Storage{ .lines = cols, .lineLength = rows, .ld = ld };
+    }
+
+
+    size_t GetSize(const Storage& storage) noexcept
+    {
+        return ((storage.lines == 0) || (storage.lineLength == 0)) ? 0
+                                                                   : ((storage.lines - 1) * storage.ld) + storage.lineLength;
+    }
+
+
+    bool IsValid(const sgemm::Problem& problem)
+    {
+        const std::array<Storage, 3> storages =
+        {
+            GetStorage(problem.layout, problem.transposeA, problem.m, problem.k, problem.lda),
+            GetStorage(problem.layout, problem.transposeB, problem.k, problem.n, problem.ldb),
+            GetStorage(problem.layout, sgemm::Transpose::No, problem.m, problem.n, problem.ldc)
+        };
+
+        return std::ranges::all_of(storages, [](const Storage& storage) { return storage.ld >= storage.lineLength; });
+    }
+
+
+    // The element at `row` and `col` of op(M).
+    size_t GetIndex(const sgemm::Layout    layout,
+                    const sgemm::Transpose transpose,
+                    const size_t           ld,
+                    const size_t           row,
+                    const size_t           col) noexcept
+    {
+        const size_t storedRow = (transpose == sgemm::Transpose::Yes) ? col : row;
+        const size_t storedCol = (transpose == sgemm::Transpose::Yes) ? row : col;
+
+        return (layout == sgemm::Layout::RowMajor) ? (storedRow * ld) + storedCol
+                                                   : (storedCol * ld) + storedRow;
+    }
+
+
+    size_t RoundUp(const size_t value,
+                   const size_t multiple) noexcept
+    {
+        return ((value + multiple - 1) / multiple) * multiple;
+    }
+}
+
+
+cl_int sgemm::GetTilingOptions(const Tiling& tiling,
+                               std::string&  clBuildOptions)
+{
+    if (!IsValid(tiling))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    std::ostringstream options = {};
+
+    options << "-D SGEMM_TILE_M="        << tiling.tileM
+            << " -D SGEMM_TILE_N="       << tiling.tileN
+            << " -D SGEMM_TILE_K="       << tiling.tileK
+            << " -D SGEMM_WPT_M="        << tiling.workPerItemM
+            << " -D SGEMM_WPT_N="        << tiling.workPerItemN
+            << " -D SGEMM_VECTOR_WIDTH=" << tiling.vectorWidth;
+
+    clBuildOptions = options.str();
+
+    return CL_SUCCESS;
+}
+
+
+cl_int sgemm::Build(const cl_context context,
+                    const Tiling&    tiling,
+                    cl_program&      program)
+{
+    cl_int      result        = CL_SUCCESS;
+    std::string tilingOptions = {};
+
+    result = GetTilingOptions(tiling, tilingOptions);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    const std::string clBuildOptions = build::sgemm::options + " " + tilingOptions;
+
+    // Each tiling caches a binary of its own, which an edited source retires like any other.
+    program::BinaryCreator binCreator = build::sgemm::binaryCreator;
+    binCreator.clBinaryFileName       = program::GetBinaryFileName(binCreator.clBinaryFileName, clBuildOptions);
+
+    result = program::Build(context,
+                            std::cref(binCreator),
+                            build::sgemm::sourceCreator,
+                            clBuildOptions,
+                            program);
+
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
+
+
+cl_int sgemm::EnqueueKernel(const Tiling&                    tiling,
+                            const Problem&                   problem,
+                            const cl_mem                     aDevice,
+                            const cl_mem                     bDevice,
+                            const cl_mem                     cDevice,
+                            const cl_command_queue           sgemmQueue,
+                            const std::span<const cl_kernel> sgemmKernels,
+                            const std::span<const cl_event>  eventsToWaitOn,
+                            cl_event&                        sgemmComplete)
+{
+    if (!IsValid(tiling) || !IsValid(problem) || (sgemmKernels.size() != build::sgemm::clKernelNames.size()))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    cl_int result = CL_SUCCESS;
+
+    if ((problem.m == 0) || (problem.n == 0))
+    {
+        result = clEnqueueMarkerWithWaitList(sgemmQueue,
+                                             static_cast<cl_uint>(eventsToWaitOn.size()),
+                                             eventsToWaitOn.data(),
+                                             &sgemmComplete);
+
+        OPENCL_PRINT_ON_ERROR(result);
+        return result;
+    }
+
+    // The kernels are row-major. A column-major matrix read as row-major is its transpose, so a column-major
+    // C = op(A) * op(B) is computed as the row-major C^T = op(B)^T * op(A)^T: the operands swap, and so do m and n.
+    const bool columnMajor = (problem.layout == Layout::ColumnMajor);
+
+    const cl_ulong  m           = columnMajor ? problem.n : problem.m;
+    const cl_ulong  n           = columnMajor ? problem.m : problem.n;
+    const cl_ulong  k           = problem.k;
+    const cl_mem    firstMem    = columnMajor ? bDevice : aDevice;
+    const cl_ulong  firstLd     = columnMajor ? problem.ldb : problem.lda;
+    const cl_mem    secondMem   = columnMajor ? aDevice : bDevice;
+    const cl_ulong  secondLd    = columnMajor ? problem.lda : problem.ldb;
+    const cl_ulong  ldc         = problem.ldc;
+    const bool      transFirst  = ((columnMajor ? problem.transposeB : problem.transposeA) == Transpose::Yes);
+    const bool      transSecond = ((columnMajor ? problem.transposeA : problem.transposeB) == Transpose::Yes);
+    const cl_kernel sgemmKernel = sgemmKernels[(transFirst ? 2 : 0) + (transSecond ? 1 : 0)];
+
+    const std::array<kernel::Arg, 11> kernelArgs =
+    { {
+            { .index = 0,  .sizeInBytes = sizeof(m),             .pValue = &m             },
+            { .index = 1,  .sizeInBytes = sizeof(n),             .pValue = &n             },
+            { .index = 2,  .sizeInBytes = sizeof(k),             .pValue = &k             },
+            { .index = 3,  .sizeInBytes = sizeof(problem.alpha), .pValue = &problem.alpha },
+            { .index = 4,  .sizeInBytes = sizeof(firstMem),      .pValue = &firstMem      },
+            { .index = 5,  .sizeInBytes = sizeof(firstLd),       .pValue = &firstLd       },
+            { .index = 6,  .sizeInBytes = sizeof(secondMem),     .pValue = &secondMem     },
+            { .index = 7,  .sizeInBytes = sizeof(secondLd),      .pValue = &secondLd      },
+            { .index = 8,  .sizeInBytes = sizeof(problem.beta),  .pValue = &problem.beta  },
+            { .index = 9,  .sizeInBytes = sizeof(cDevice),       .pValue = &cDevice       },
+            { .index = 10, .sizeInBytes = sizeof(ldc),           .pValue = &ldc           }
+    } };
+
+    result = kernel::SetArgs(sgemmKernel, kernelArgs);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // The first dimension runs along the rows of C, so neighbouring work-items write neighbouring elements.
+    const std::array<size_t, 2> localWorkSize =
+    {
+        tiling.tileN / tiling.workPerItemN,
+        tiling.tileM / tiling.workPerItemM
+    };
+
+    const std::array<size_t, 2> globalWorkSize =
+    {
+        (RoundUp(n, tiling.tileN) / tiling.tileN) * localWorkSize[0],
+        (RoundUp(m, tiling.tileM) / tiling.tileM) * localWorkSize[1]
+    };
+
+    result = clEnqueueNDRangeKernel(sgemmQueue,
+                                    sgemmKernel,
+                                    2,
+                                    nullptr,
+                                    globalWorkSize.data(),
+                                    localWorkSize.data(),
+                                    static_cast<cl_uint>(eventsToWaitOn.size()),
+                                    eventsToWaitOn.data(),
+                                    &sgemmComplete);
+
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
+
+
+size_t sgemm::GetSizeA(const Problem& problem) noexcept
+{
+    return GetSize(GetStorage(problem.layout, problem.transposeA, problem.m, problem.k, problem.lda));
+}
+
+
+size_t sgemm::GetSizeB(const Problem& problem) noexcept
+{
+    return GetSize(GetStorage(problem.layout, problem.transposeB, problem.k, problem.n, problem.ldb));
+}
+
+
+size_t sgemm::GetSizeC(const Problem& problem) noexcept
+{
+    return GetSize(GetStorage(problem.layout, Transpose::No, problem.m, problem.n, problem.ldc));
+}
+
+
+void sgemm::HostExec(const Problem&     problem,
+                     const float* const pAHost,
+                     const float* const pBHost,
+                     float* const       pCHost)
+{
+    const auto a = [&](const size_t row, const size_t col)
+    {
+        return pAHost[GetIndex(problem.layout, problem.transposeA, problem.lda, row, col)];
+    };
+
+    const auto b = [&](const size_t row, const size_t col)
+    {
+        return pBHost[GetIndex(problem.layout, problem.transposeB, problem.ldb, row, col)];
+    };
+
+    const auto c = [&](const size_t row, const size_t col) -> float&
+    {
+        return pCHost[GetIndex(problem.layout, Transpose::No, problem.ldc, row, col)];
+    };
+
+    // As in BLAS, a zero beta leaves C unread.
+    for (size_t row = 0; row < problem.m; row++)
+    {
+        for (size_t col = 0; col < problem.n; col++)
+        {
+            c(row, col) = (problem.beta == 0.0f) ? 0.0f : problem.beta * c(row, col);
+        }
+    }
+
+    for (size_t row0 = 0; row0 < problem.m; row0 += HostBlockSize)
+    {
+        const size_t rowEnd = std::min(row0 + HostBlockSize, problem.m);
+
+        for (size_t depth0 = 0; depth0 < problem.k; depth0 += HostBlockSize)
+        {
+            const size_t depthEnd = std::min(depth0 + HostBlockSize, problem.k);
+
+            for (size_t col0 = 0; col0 < problem.n; col0 += HostBlockSize)
+            {
+                const size_t colEnd = std::min(col0 + HostBlockSize, problem.n);
+
+                for (size_t row = row0; row < rowEnd; row++)
+                {
+                    for (size_t depth = depth0; depth < depthEnd; depth++)
+                    {
+                        const float scaledA = problem.alpha * a(row, depth);
+
+                        for (size_t col = col0; col < colEnd; col++)
+                        {
+                            c(row, col) += scaledA * b(depth, col);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "build.h"
+#include "program.h"
+#include "sgemm.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    struct Shape
+    {
+        size_t m;
+        size_t n;
+        size_t k;
+    };
+
+
+    // The length of the lines of a stored matrix, which its leading dimension must cover.
+    size_t GetLineLength(const sgemm::Layout    layout,
+                         const sgemm::Transpose transpose,
+                         const size_t           opRows,
+                         const size_t           opCols) noexcept
+    {
+        const size_t rows = (transpose == sgemm::Transpose::Yes) ? opCols : opRows;
+        const size_t cols = (transpose == sgemm::Transpose::Yes) ? opRows : opCols;
+
+        return (layout == sgemm::Layout::RowMajor) ? cols : rows;
+    }
+}
+
+
+class SgemmTest : public test_fixture::ContextTest
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        ContextTest::SetUpTestSuite();
+
+        if (s_context != nullptr)
+        {
+            const cl_int result = sgemm::Build(s_context, sgemm::DefaultTiling, s_program);
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            test_fixture::UnloadCompiler(s_platform.value());
+        }
+    }
+
+    void SetUp() override final
+    {
+        cl_int result = CL_SUCCESS;
+
+        result = program::CreateKernels(s_program,
+                                        build::sgemm::clKernelNames,
+                                        m_kernels);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        ContextTest::SetUp();
+    }
+
+    void TearDown() noexcept override final
+    {
+        ReleaseKernels(m_kernels);
+
+        ContextTest::TearDown();
+    }
+
+    static sgemm::Problem MakeProblem(const sgemm::Layout    layout,
+                                      const sgemm::Transpose transposeA,
+                                      const sgemm::Transpose transposeB,
+                                      const Shape&           shape,
+                                      const size_t           ldPadding) noexcept
+    {
+        return
+        {
+            .layout     = layout,
+            .transposeA = transposeA,
+            .transposeB = transposeB,
+            .m          = shape.m,
+            .n          = shape.n,
+            .k          = shape.k,
+            .alpha      = Alpha,
+            .beta       = Beta,
+            .lda        = GetLineLength(layout, transposeA, shape.m, shape.k) + ldPadding,
+            .ldb        = GetLineLength(layout, transposeB, shape.k, shape.n) + ldPadding,
+            .ldc        = GetLineLength(layout, sgemm::Transpose::No, shape.m, shape.n) + ldPadding
+        };
+    }
+
+    // Uploads the operands, runs `problem` and downloads C into `cHost`.
+    void ExecOnDevice(const sgemm::Tiling&             tiling,
+                      const std::span<const cl_kernel> kernels,
+                      const sgemm::Problem&            problem,
+                      const std::vector<float>&        aHost,
+                      const std::vector<float>&        bHost,
+                      std::vector<float>&              cHost) noexcept
+    {
+        cl_int   result        = CL_SUCCESS;
+        cl_event sgemmComplete = nullptr;
+
+        // Zero-sized buffers are invalid, so every buffer holds at least one element.
+        const cl_mem aDevice = clCreateBuffer(s_context,
+                                              CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                              aHost.size() * sizeof(float),
+                                              const_cast<float*>(aHost.data()),
+                                              &result);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        const cl_mem bDevice = clCreateBuffer(s_context,
+                                              CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                              bHost.size() * sizeof(float),
+                                              const_cast<float*>(bHost.data()),
+                                              &result);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        const cl_mem cDevice = clCreateBuffer(s_context,
+                                              CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                              cHost.size() * sizeof(float),
+                                              cHost.data(),
+                                              &result);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = sgemm::EnqueueKernel(tiling,
+                                      problem,
+                                      aDevice,
+                                      bDevice,
+                                      cDevice,
+                                      m_queue,
+                                      kernels,
+                                      {},
+                                      sgemmComplete);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = clEnqueueReadBuffer(m_queue,
+                                     cDevice,
+                                     CL_TRUE,
+                                     0,
+                                     cHost.size() * sizeof(float),
+                                     cHost.data(),
+                                     1,
+                                     &sgemmComplete,
+                                     nullptr);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        EXPECT_EQ(clReleaseEvent(sgemmComplete), CL_SUCCESS);
+        EXPECT_EQ(clReleaseMemObject(aDevice), CL_SUCCESS);
+        EXPECT_EQ(clReleaseMemObject(bDevice), CL_SUCCESS);
+        EXPECT_EQ(clReleaseMemObject(cDevice), CL_SUCCESS);
+    }
+
+    // Summation orders differ between host and device, and each of the `k` products may round differently.
+    void ExpectMatchesHostReference(const sgemm::Tiling&             tiling,
+                                    const std::span<const cl_kernel> kernels,
+                                    const sgemm::Problem&            problem) noexcept
+    {
+        std::vector<float> aHost(std::max<size_t>(sgemm::GetSizeA(problem), 1));
+        std::vector<float> bHost(std::max<size_t>(sgemm::GetSizeB(problem), 1));
+        std::vector<float> cHost(std::max<size_t>(sgemm::GetSizeC(problem), 1));
+
+        std::generate(aHost.begin(), aHost.end(), test_fixture::GetRandUnitFloat);
+        std::generate(bHost.begin(), bHost.end(), test_fixture::GetRandUnitFloat);
+        std::generate(cHost.begin(), cHost.end(), test_fixture::GetRandUnitFloat);
+
+        std::vector<float> solution = cHost;
+
+        sgemm::HostExec(problem, aHost.data(), bHost.data(), solution.data());
+        ExecOnDevice(tiling, kernels, problem, aHost, bHost, cHost);
+
+        const float tolerance = 4.0f * static_cast<float>(problem.k + 1) * std::numeric_limits<float>::epsilon();
+
+        for (size_t i = 0; i < cHost.size(); i++)
+        {
+            ASSERT_NEAR(cHost[i], solution[i], tolerance) <<
+                "Host and device sgemm execution results differ at element " << i << " of a " <<
+                problem.m << " x " << problem.n << " x " << problem.k << " problem";
+        }
+    }
+
+    std::array<cl_kernel, build::sgemm::clKernelNames.size()> m_kernels = {};
+
+    static const std::array<Shape, 6> Shapes;
+    static const float                Alpha;
+    static const float                Beta;
+};
+
+// Single elements, partial tiles in every dimension, whole tiles, and an empty shared dimension.
+const std::array<Shape, 6> SgemmTest::Shapes =
+{ {
+    { .m = 1,   .n = 1,   .k = 1   },
+    { .m = 33,  .n = 17,  .k = 9   },
+    { .m = 64,  .n = 64,  .k = 64  },
+    { .m = 65,  .n = 130, .k = 47  },
+    { .m = 100, .n = 3,   .k = 257 },
+    { .m = 5,   .n = 70,  .k = 0   }
+} };
+
+const float SgemmTest::Alpha = 1.5;
+const float SgemmTest::Beta  = 0.5;
+
+
+TEST_F(SgemmTest, MatchesHostReferenceInEveryLayout)
+{
+    for (const Shape& shape : Shapes)
+    {
+        for (const sgemm::Layout layout : { sgemm::Layout::RowMajor, sgemm::Layout::ColumnMajor })
+        {
+            for (const sgemm::Transpose transposeA : { sgemm::Transpose::No, sgemm::Transpose::Yes })
+            {
+                for (const sgemm::Transpose transposeB : { sgemm::Transpose::No, sgemm::Transpose::Yes })
+                {
+                    // Padded leading dimensions leave rows misaligned for vector loads.
+                    for (const size_t ldPadding : { size_t(0), size_t(3) })
+                    {
+                        const sgemm::Problem problem = MakeProblem(layout, transposeA, transposeB, shape, ldPadding);
+
+                        ExpectMatchesHostReference(sgemm::DefaultTiling, m_kernels, problem);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+TEST_F(SgemmTest, ZeroBetaLeavesCUnread)
+{
+    sgemm::Problem problem = MakeProblem(sgemm::Layout::RowMajor,
+                                         sgemm::Transpose::No,
+                                         sgemm::Transpose::No,
+                                         Shapes[3],
+                                         0);
+
+    problem.beta = 0.0f;
+
+    std::vector<float> aHost(sgemm::GetSizeA(problem));
+    std::vector<float> bHost(sgemm::GetSizeB(problem));
+    std::vector<float> cHost(sgemm::GetSizeC(problem), std::numeric_limits<float>::quiet_NaN());
+
+    std::generate(aHost.begin(), aHost.end(), test_fixture::GetRandUnitFloat);
+    std::generate(bHost.begin(), bHost.end(), test_fixture::GetRandUnitFloat);
+
+    ExecOnDevice(sgemm::DefaultTiling, m_kernels, problem, aHost, bHost, cHost);
+
+    EXPECT_TRUE(std::none_of(cHost.cbegin(), cHost.cend(), [](const float c) { return std::isnan(c); })) <<
+        "A zero beta must not propagate the NaNs of C";
+}
+
+
+TEST_F(SgemmTest, TunedTilingsMatchHostReference)
+{
+    constexpr std::array<sgemm::Tiling, 3> Tilings =
+    { {
+        { .tileM = 32,  .tileN = 32, .tileK = 8,  .workPerItemM = 2, .workPerItemN = 2, .vectorWidth = 2 },
+        { .tileM = 128, .tileN = 64, .tileK = 8,  .workPerItemM = 8, .workPerItemN = 4, .vectorWidth = 8 },
+        { .tileM = 16,  .tileN = 16, .tileK = 16, .workPerItemM = 1, .workPerItemN = 1, .vectorWidth = 1 }
+    } };
+
+    for (const sgemm::Tiling& tiling : Tilings)
+    {
+        cl_int                                                    result  = CL_SUCCESS;
+        cl_program                                                program = nullptr;
+        std::array<cl_kernel, build::sgemm::clKernelNames.size()> kernels = {};
+
+        // Each tiling builds, or loads from the binary cache, a program of its own.
+        result = sgemm::Build(s_context, tiling, program);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = program::CreateKernels(program,
+                                        build::sgemm::clKernelNames,
+                                        kernels);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        for (const sgemm::Layout layout : { sgemm::Layout::RowMajor, sgemm::Layout::ColumnMajor })
+        {
+            const sgemm::Problem problem = MakeProblem(layout,
+                                                       sgemm::Transpose::Yes,
+                                                       sgemm::Transpose::No,
+                                                       Shapes[3],
+                                                       1);
+
+            ExpectMatchesHostReference(tiling, kernels, problem);
+        }
+
+        ReleaseKernels(kernels);
+
+        EXPECT_EQ(clReleaseProgram(program), CL_SUCCESS);
+    }
+}
+
+
+TEST_F(SgemmTest, DISABLED_ThroughputBenchmark)
+{
+    constexpr Shape  BenchmarkShape = { .m = 1024, .n = 1024, .k = 1024 };
+    constexpr size_t Iterations     = 16;
+
+    const sgemm::Problem problem = MakeProblem(sgemm::Layout::RowMajor,
+                                               sgemm::Transpose::No,
+                                               sgemm::Transpose::No,
+                                               BenchmarkShape,
+                                               0);
+
+    std::vector<float> aHost(sgemm::GetSizeA(problem));
+    std::vector<float> bHost(sgemm::GetSizeB(problem));
+    std::vector<float> cHost(sgemm::GetSizeC(problem));
+
+    std::generate(aHost.begin(), aHost.end(), test_fixture::GetRandUnitFloat);
+    std::generate(bHost.begin(), bHost.end(), test_fixture::GetRandUnitFloat);
+    std::generate(cHost.begin(), cHost.end(), test_fixture::GetRandUnitFloat);
+
+    // The first execution absorbs one-off costs, e.g. of allocating device memory.
+    ExecOnDevice(sgemm::DefaultTiling, m_kernels, problem, aHost, bHost, cHost);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < Iterations; i++)
+    {
+        ExecOnDevice(sgemm::DefaultTiling, m_kernels, problem, aHost, bHost, cHost);
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double flops = 2.0 * BenchmarkShape.m * BenchmarkShape.n * BenchmarkShape.k * Iterations;
+
+    std::cout << "[ BENCHMARK] " << BenchmarkShape.m << " x " << BenchmarkShape.n << " x " << BenchmarkShape.k << ": "
+              << flops / elapsed.count() / 1e9 << " GFLOP/s including transfers\n";
+}
+
+
+TEST(Sgemm, RejectsInvalidTilings)
+{
+    std::string clBuildOptions = {};
+
+    sgemm::Tiling tiling = sgemm::DefaultTiling;
+
+    EXPECT_EQ(sgemm::GetTilingOptions(tiling, clBuildOptions), CL_SUCCESS);
+    EXPECT_NE(clBuildOptions.find("-D SGEMM_TILE_M=64"), std::string::npos);
+
+    tiling.vectorWidth = 3;
+    EXPECT_EQ(sgemm::GetTilingOptions(tiling, clBuildOptions), CL_INVALID_VALUE);
+
+    tiling              = sgemm::DefaultTiling;
+    tiling.workPerItemM = 3;
+    EXPECT_EQ(sgemm::GetTilingOptions(tiling, clBuildOptions), CL_INVALID_VALUE);
+
+    tiling       = sgemm::DefaultTiling;
+    tiling.tileK = 6;
+    EXPECT_EQ(sgemm::GetTilingOptions(tiling, clBuildOptions), CL_INVALID_VALUE);
+}
+
+
+TEST(Sgemm, HostReferenceMatchesNaiveProduct)
+{
+    // Column-major 2 x 3 times the transpose of a column-major 2 x 3, so C = A * B^T is 2 x 2.
+    const std::array<float, 6> a = { 1, 4, 2, 5, 3, 6 };
+    const std::array<float, 6> b = { 7, 10, 8, 11, 9, 12 };
+    std::array<float, 4>       c = { 1, 1, 1, 1 };
+
+    const sgemm::Problem problem =
+    {
+        .layout     = sgemm::Layout::ColumnMajor,
+        .transposeA = sgemm::Transpose::No,
+        .transposeB = sgemm::Transpose::Yes,
+        .m          = 2,
+        .n          = 2,
+        .k          = 3,
+        .alpha      = 1.0f,
+        .beta       = 2.0f,
+        .lda        = 2,
+        .ldb        = 2,
+        .ldc        = 2
+    };
+
+    sgemm::HostExec(problem, a.data(), b.data(), c.data());
+
+    // [1 2 3; 4 5 6] * [7 10; 8 11; 9 12] = [50 68; 122 167], plus 2 * C.
+    EXPECT_EQ(c, (std::array<float, 4>{ 52, 124, 70, 169 }));
+}
\ No newline at end of file
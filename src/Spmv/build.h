@@ -0,0 +1,64 @@
+#ifndef SPMV_BUILD_H
+#define SPMV_BUILD_H
+
+#include "program_types.h"
+#include "spmv.cl.h"
+
+#ifdef EMBEDDED_SPIRV_SPMV
+#include "spmv.spv.h"
+#endif // EMBEDDED_SPIRV_SPMV
+
+#include <array>
+#include <filesystem>
+#include <string>
+
+
+namespace build::spmv
+{
+    inline extern const std::filesystem::path clBinaryRoot = std::filesystem::current_path() / "Spmv_CL_Binaries";
+
+    // In the order of the bins of `spmv::RowBins`.
+    inline extern const std::array<const std::string, 3> clKernelNames
+    {
+        "spmv_scalar",
+        "spmv_vector",
+        "spmv_work_group"
+    };
+
+    inline extern const program::BinaryCreator binaryCreator
+    {
+        .clBinaryRoot = std::filesystem::current_path() / "Spmv_CL_Binaries",
+#ifdef _DEBUG
+        .clBinaryFileName = "spmv_ClBinary_Debug.cl.bin",
+#elif defined(_RELEASE)
+        .clBinaryFileName = "spmv_ClBinary_Release.cl.bin",
+#endif // _RELEASE
+#ifdef EMBEDDED_SPIRV_SPMV
+        // Programs are built from the SPIR-V module when devices accept it, so a new module versions the binaries too.
+        .clSourceHash     = embedded::cl::spmv::sourceHash ^ embedded::spirv::spmv::ilHash
+#else
+        .clSourceHash     = embedded::cl::spmv::sourceHash
+#endif // EMBEDDED_SPIRV_SPMV
+    };
+
+    inline extern const program::SourceCreator sourceCreator
+    {
+        .clSourceRoot      = {},
+        .clSourceFileNames = {},
+        .clSources         = { embedded::cl::spmv::source },
+#ifdef EMBEDDED_SPIRV_SPMV
+        .clIl              = embedded::spirv::spmv::il
+#else
+        .clIl              = {}
+#endif // EMBEDDED_SPIRV_SPMV
+    };
+
+#ifdef _DEBUG
+    inline extern const std::string options = "-D _DEBUG -cl-opt-disable -Werror -cl-std=CL2.0 -g";
+#elif defined(_RELEASE)
+    inline extern const std::string options = "-D _RELEASE -Werror -cl-std=CL2.0";
+#endif // _RELEASE
+}
+
+
+#endif // SPMV_BUILD_H
\ No newline at end of file
@@ -0,0 +1,133 @@
+// y = alpha * A * x + beta * y for the rows of a CSR matrix A listed in `pRows`, one bin of rows per kernel. As in
+// BLAS, a zero beta leaves y unread.
+float spmv_result(const float alpha,
+                  const float dot,
+                  const float beta,
+                  const float y)
+{
+    return (beta == 0.0f) ? (alpha * dot) : fma(alpha, dot, beta * y);
+}
+
+
+// One work-item per row, for rows so short that more work-items would mostly idle.
+__kernel void spmv_scalar(__global const uint*  const restrict pRows,
+                                   const ulong                 rowCount,
+                          __global const uint*  const restrict pRowOffsets,
+                          __global const uint*  const restrict pColumnIndices,
+                          __global const float* const restrict pValues,
+                          __global const float* const restrict pXDevice,
+                                   const float                 alpha,
+                                   const float                 beta,
+                          __global       float* const restrict pYDevice)
+{
+    const ulong id = get_global_id(0);
+
+    if (id >= rowCount)
+    {
+        return;
+    }
+
+    const uint row = pRows[id];
+    float      dot = 0.0f;
+
+    for (uint i = pRowOffsets[row]; i < pRowOffsets[row + 1]; i++)
+    {
+        dot = fma(pValues[i], pXDevice[pColumnIndices[i]], dot);
+    }
+
+    pYDevice[row] = spmv_result(alpha, dot, beta, pYDevice[row]);
+}
+
+
+// `lanesPerRow` neighbouring work-items per row, which read its non-zeros in neighbouring elements and reduce their
+// partial dot products in local memory. Both `lanesPerRow` and the work-group size are powers of two.
+__kernel void spmv_vector(__global const uint*  const restrict pRows,
+                                   const ulong                 rowCount,
+                          __global const uint*  const restrict pRowOffsets,
+                          __global const uint*  const restrict pColumnIndices,
+                          __global const float* const restrict pValues,
+                          __global const float* const restrict pXDevice,
+                                   const float                 alpha,
+                                   const float                 beta,
+                          __global       float* const restrict pYDevice,
+                                   const uint                  lanesPerRow,
+                          __local        float* const restrict partials)
+{
+    const uint  localId  = get_local_id(0);
+    const uint  lane     = localId & (lanesPerRow - 1);
+    const ulong id       = get_global_id(0) / lanesPerRow;
+    const bool  isActive = (id < rowCount);
+    const uint  row      = isActive ? pRows[id] : 0;
+
+    float dot = 0.0f;
+
+    if (isActive)
+    {
+        for (uint i = pRowOffsets[row] + lane; i < pRowOffsets[row + 1]; i += lanesPerRow)
+        {
+            dot = fma(pValues[i], pXDevice[pColumnIndices[i]], dot);
+        }
+    }
+
+    partials[localId] = dot;
+
+    // Inactive work-items still take part, as every work-item of a work-group must reach each barrier.
+    for (uint width = lanesPerRow / 2; width > 0; width /= 2)
+    {
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (lane < width)
+        {
+            partials[localId] += partials[localId + width];
+        }
+    }
+
+    if (isActive && (lane == 0))
+    {
+        pYDevice[row] = spmv_result(alpha, partials[localId], beta, pYDevice[row]);
+    }
+}
+
+
+// One work-group per row, for rows long enough to keep a whole work-group busy. The work-group size is a power of
+// two. Launches beyond the first start at a global offset of whole work-groups.
+__kernel void spmv_work_group(__global const uint*  const restrict pRows,
+                                       const ulong                 rowCount,
+                              __global const uint*  const restrict pRowOffsets,
+                              __global const uint*  const restrict pColumnIndices,
+                              __global const float* const restrict pValues,
+                              __global const float* const restrict pXDevice,
+                                       const float                 alpha,
+                                       const float                 beta,
+                              __global       float* const restrict pYDevice,
+                              __local        float* const restrict partials)
+{
+    const uint  localId   = get_local_id(0);
+    const uint  localSize = get_local_size(0);
+    const ulong id        = (get_global_offset(0) / localSize) + get_group_id(0);
+    const uint  row       = pRows[id];
+
+    float dot = 0.0f;
+
+    for (uint i = pRowOffsets[row] + localId; i < pRowOffsets[row + 1]; i += localSize)
+    {
+        dot = fma(pValues[i], pXDevice[pColumnIndices[i]], dot);
+    }
+
+    partials[localId] = dot;
+
+    for (uint width = localSize / 2; width > 0; width /= 2)
+    {
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (localId < width)
+        {
+            partials[localId] += partials[localId + width];
+        }
+    }
+
+    if ((localId == 0) && (id < rowCount))
+    {
+        pYDevice[row] = spmv_result(alpha, partials[0], beta, pYDevice[row]);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "build.h"
+#include "debug.h"
+#include "kernel.h"
+#include "launch.h"
+#include "spmv.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+
+namespace
+{
+    // Indices into `build::spmv::clKernelNames`, and into the bins of `spmv::AdaptiveCsr`.
+    enum KernelIndex : size_t
+    {
+        Scalar = 0,
+        Vector,
+        WorkGroup,
+        Count,
+    };
+
+
+    // A warp of neighbouring work-items per row of the vector bin, and up to 256 work-items per work-group of the
+    // vector and work-group bins, whose reductions only lengthen beyond that.
+    constexpr size_t MaxLanesPerRow         = 32;
+    constexpr size_t MaxReduceWorkGroupSize = 256;
+
+
+    bool IsValid(const spmv::HostCsr& csr)
+    {
+        if (csr.rowOffsets.empty() || (csr.rowOffsets.front() != 0) ||
+            (csr.rowOffsets.back() != csr.columnIndices.size()) || (csr.columnIndices.size() != csr.values.size()))
+        {
+            return false;
+        }
+
+        return std::ranges::is_sorted(csr.rowOffsets) &&
+               std::ranges::all_of(csr.columnIndices, [&](const cl_uint col) { return col < csr.n; });
+    }
+
+
+    // Zero-sized buffers are invalid, so empty data leaves `buffer` null, which kernels may take for a pointer they
+    // never dereference.
+    template <typename T>
+    cl_int CreateBuffer(const cl_context         context,
+                        const std::span<const T> data,
+                        cl_mem&                  buffer)
+    {
+        cl_int result = CL_SUCCESS;
+
+        buffer = nullptr;
+
+        if (data.empty())
+        {
+            return result;
+        }
+
+        buffer = clCreateBuffer(context,
+                                CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                data.size_bytes(),
+                                const_cast<T*>(data.data()),
+                                &result);
+
+        OPENCL_PRINT_ON_ERROR(result);
+
+        return result;
+    }
+
+
+    // Reductions halve their work-group, so its size is a power of two.
+    size_t ChooseReduceWorkGroupSize(const launch::KernelResources& resources) noexcept
+    {
+        const size_t maxLocalWorkSize = std::min({ resources.maxWorkGroupSize, resources.maxWorkItemSize, MaxReduceWorkGroupSize });
+
+        return std::bit_floor(std::max<size_t>(maxLocalWorkSize, 1));
+    }
+}
+
+
+spmv::RowBins spmv::BinRows(const std::span<const cl_uint> rowOffsets)
+{
+    RowBins bins = {};
+
+    for (size_t row = 0; row + 1 < rowOffsets.size(); row++)
+    {
+        const size_t rowLength = rowOffsets[row + 1] - rowOffsets[row];
+
+        std::vector<cl_uint>& bin = (rowLength <= MaxScalarRowLength) ? bins.scalar :
+                                    (rowLength <= MaxVectorRowLength) ? bins.vector :
+                                                                        bins.workGroup;
+
+        bin.push_back(static_cast<cl_uint>(row));
+    }
+
+    return bins;
+}
+
+
+spmv::AdaptiveCsr::~AdaptiveCsr() noexcept
+{
+    Release();
+}
+
+
+cl_int spmv::AdaptiveCsr::Init(const cl_context context,
+                               const HostCsr&   csr)
+{
+    Release();
+
+    if (!IsValid(csr))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    cl_int        result = CL_SUCCESS;
+    const RowBins bins   = BinRows(csr.rowOffsets);
+
+    m_rowCount     = csr.rowOffsets.size() - 1;
+    m_columnCount  = csr.n;
+    m_nonZeroCount = csr.values.size();
+
+    result = CreateBuffer(context, csr.rowOffsets, m_rowOffsets);
+
+    if (result == CL_SUCCESS)
+    {
+        result = CreateBuffer(context, csr.columnIndices, m_columnIndices);
+    }
+
+    if (result == CL_SUCCESS)
+    {
+        result = CreateBuffer(context, csr.values, m_values);
+    }
+
+    const std::array<const std::vector<cl_uint>*, KernelIndex::Count> binRows =
+    {
+        &bins.scalar,
+        &bins.vector,
+        &bins.workGroup
+    };
+
+    for (size_t i = 0; (i < m_bins.size()) && (result == CL_SUCCESS); i++)
+    {
+        m_bins[i].rowCount = binRows[i]->size();
+
+        result = CreateBuffer(context, std::span<const cl_uint>(*binRows[i]), m_bins[i].rows);
+    }
+
+    // A matrix is either complete or empty, never half initialized.
+    if (result != CL_SUCCESS)
+    {
+        Release();
+    }
+
+    OPENCL_PRINT_ON_ERROR(result);
+    return result;
+}
+
+
+void spmv::AdaptiveCsr::Release() noexcept
+{
+    for (cl_mem* const buffer : { &m_rowOffsets, &m_columnIndices, &m_values,
+                                  &m_bins[0].rows, &m_bins[1].rows, &m_bins[2].rows })
+    {
+        if (*buffer != nullptr)
+        {
+            clReleaseMemObject(*buffer);
+            *buffer = nullptr;
+        }
+    }
+
+    m_bins         = {};
+    m_rowCount     = 0;
+    m_columnCount  = 0;
+    m_nonZeroCount = 0;
+}
+
+
+cl_int spmv::AdaptiveCsr::EnqueueKernel(const cl_mem                     xDevice,
+                                        const cl_mem                     yDevice,
+                                        const cl_command_queue           spmvQueue,
+                                        const std::span<const cl_kernel> spmvKernels,
+                                        const std::span<const cl_event>  eventsToWaitOn,
+                                        cl_event&                        spmvComplete) const
+{
+    return EnqueueKernel(1.0f,
+                         xDevice,
+                         0.0f,
+                         yDevice,
+                         spmvQueue,
+                         spmvKernels,
+                         eventsToWaitOn,
+                         spmvComplete);
+}
+
+
+cl_int spmv::AdaptiveCsr::EnqueueKernel(const float                      alpha,
+                                        const cl_mem                     xDevice,
+                                        const float                      beta,
+                                        const cl_mem                     yDevice,
+                                        const cl_command_queue           spmvQueue,
+                                        const std::span<const cl_kernel> spmvKernels,
+                                        const std::span<const cl_event>  eventsToWaitOn,
+                                        cl_event&                        spmvComplete) const
+{
+    if (spmvKernels.size() != KernelIndex::Count)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    cl_int       result          = CL_SUCCESS;
+    cl_device_id executingDevice = nullptr;
+
+    result = clGetCommandQueueInfo(spmvQueue,
+                                   CL_QUEUE_DEVICE,
+                                   sizeof(executingDevice),
+                                   &executingDevice,
+                                   nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // Bins write disjoint rows of y, so their kernels may run concurrently.
+    std::vector<cl_event> launches = {};
+
+    for (size_t i = 0; (i < m_bins.size()) && (result == CL_SUCCESS); i++)
+    {
+        if (m_bins[i].rowCount == 0)
+        {
+            continue;
+        }
+
+        const cl_kernel         spmvKernel = spmvKernels[i];
+        const cl_ulong          rowCount   = m_bins[i].rowCount;
+        launch::KernelResources resources  = {};
+
+        result = launch::QueryKernelResources(spmvKernel, executingDevice, resources);
+
+        if (result != CL_SUCCESS)
+        {
+            break;
+        }
+
+        const std::array<kernel::Arg, 9> kernelArgs =
+        { {
+                { .index = 0, .sizeInBytes = sizeof(m_bins[i].rows),  .pValue = &m_bins[i].rows  },
+                { .index = 1, .sizeInBytes = sizeof(rowCount),        .pValue = &rowCount        },
+                { .index = 2, .sizeInBytes = sizeof(m_rowOffsets),    .pValue = &m_rowOffsets    },
+                { .index = 3, .sizeInBytes = sizeof(m_columnIndices), .pValue = &m_columnIndices },
+                { .index = 4, .sizeInBytes = sizeof(m_values),        .pValue = &m_values        },
+                { .index = 5, .sizeInBytes = sizeof(xDevice),         .pValue = &xDevice         },
+                { .index = 6, .sizeInBytes = sizeof(alpha),           .pValue = &alpha           },
+                { .index = 7, .sizeInBytes = sizeof(beta),            .pValue = &beta            },
+                { .index = 8, .sizeInBytes = sizeof(yDevice),         .pValue = &yDevice         }
+        } };
+
+        result = kernel::SetArgs(spmvKernel, kernelArgs);
+
+        if (result != CL_SUCCESS)
+        {
+            break;
+        }
+
+        size_t localWorkSize = 0;
+        size_t nWorkItems    = 0;
+
+        if (i == KernelIndex::Scalar)
+        {
+            localWorkSize = launch::ChooseLocalWorkSize(resources, m_bins[i].rowCount);
+            nWorkItems    = m_bins[i].rowCount;
+        }
+        else
+        {
+            localWorkSize = ChooseReduceWorkGroupSize(resources);
+
+            // The vector bin packs several rows into a work-group, the work-group bin gives each row a whole one.
+            const cl_uint lanesPerRow = static_cast<cl_uint>((i == KernelIndex::Vector) ? std::min(MaxLanesPerRow, localWorkSize)
+                                                                                        : localWorkSize);
+
+            nWorkItems = m_bins[i].rowCount * lanesPerRow;
+
+            if (i == KernelIndex::Vector)
+            {
+                result = clSetKernelArg(spmvKernel, 9, sizeof(lanesPerRow), &lanesPerRow);
+            }
+
+            // One float of local memory per work-item holds its partial dot product.
+            if (result == CL_SUCCESS)
+            {
+                result = clSetKernelArg(spmvKernel,
+                                        (i == KernelIndex::Vector) ? 10 : 9,
+                                        localWorkSize * sizeof(float),
+                                        nullptr);
+            }
+
+            if (result != CL_SUCCESS)
+            {
+                break;
+            }
+        }
+
+        cl_event launched = nullptr;
+
+        result = launch::EnqueueSplit(spmvQueue,
+                                      spmvKernel,
+                                      nWorkItems,
+                                      localWorkSize,
+                                      eventsToWaitOn,
+                                      launched);
+
+        if (result == CL_SUCCESS)
+        {
+            launches.push_back(launched);
+        }
+    }
+
+    // One event stands for every bin. A matrix without rows completes once the events it waits on do.
+    if (result == CL_SUCCESS)
+    {
+        const std::span<const cl_event> completeAfter = launches.empty() ? eventsToWaitOn
+                                                                         : std::span<const cl_event>(launches);
+
+        result = clEnqueueMarkerWithWaitList(spmvQueue,
+                                             static_cast<cl_uint>(completeAfter.size()),
+                                             completeAfter.data(),
+                                             &spmvComplete);
+    }
+
+    for (const cl_event launched : launches)
+    {
+        clReleaseEvent(launched);
+    }
+
+    OPENCL_PRINT_ON_ERROR(result);
+    return result;
+}
+
+
+void spmv::HostExec(const HostCsr&     csr,
+                    const float        alpha,
+                    const float* const pXHost,
+                    const float        beta,
+                    float* const       pYHost)
+{
+    for (size_t row = 0; row + 1 < csr.rowOffsets.size(); row++)
+    {
+        float dot = 0.0f;
+
+        for (size_t i = csr.rowOffsets[row]; i < csr.rowOffsets[row + 1]; i++)
+        {
+            dot += csr.values[i] * pXHost[csr.columnIndices[i]];
+        }
+
+        // As in BLAS, a zero beta leaves y unread.
+        pYHost[row] = (beta == 0.0f) ? (alpha * dot) : (alpha * dot) + (beta * pYHost[row]);
+    }
+}
\ No newline at end of file
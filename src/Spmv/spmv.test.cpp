@@ -0,0 +1,477 @@
+#include "build.h"
+#include "program.h"
+#include "spmv.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+
+namespace
+{
+    struct OwnedCsr
+    {
+        size_t               n;
+        std::vector<cl_uint> rowOffsets;
+        std::vector<cl_uint> columnIndices;
+        std::vector<float>   values;
+
+        spmv::HostCsr Get() const noexcept
+        {
+            return
+            {
+                .n             = n,
+                .rowOffsets    = rowOffsets,
+                .columnIndices = columnIndices,
+                .values        = values
+            };
+        }
+    };
+
+
+    // Row lengths follow a power law, as in web and social graphs: the share of rows longer than l falls as
+    // l^(1 - exponent), so most rows are nearly empty and a few span a large part of the columns.
+    OwnedCsr MakePowerLawCsr(const size_t m,
+                             const size_t n,
+                             const double exponent,
+                             const unsigned int seed)
+    {
+        std::mt19937                           generator(seed);
+        std::uniform_real_distribution<double> unit(std::numeric_limits<double>::min(), 1.0);
+        std::uniform_real_distribution<float>  value(-1.0f, 1.0f);
+        std::uniform_int_distribution<cl_uint> column(0, static_cast<cl_uint>(n - 1));
+
+        OwnedCsr csr = { .n = n, .rowOffsets = { 0 }, .columnIndices = {}, .values = {} };
+
+        for (size_t row = 0; row < m; row++)
+        {
+            // Clamped before the conversion, as the tail of the distribution reaches beyond any integer.
+            const double rowLength = std::min(std::floor(std::pow(unit(generator), -1.0 / (exponent - 1.0))) - 1.0,
+                                              static_cast<double>(n));
+
+            for (size_t i = 0; i < static_cast<size_t>(rowLength); i++)
+            {
+                csr.columnIndices.push_back(column(generator));
+                csr.values.push_back(value(generator));
+            }
+
+            csr.rowOffsets.push_back(static_cast<cl_uint>(csr.values.size()));
+        }
+
+        return csr;
+    }
+}
+
+
+class SpmvTest : public test_fixture::ContextTest
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        ContextTest::SetUpTestSuite();
+
+        if (s_context != nullptr)
+        {
+            BuildProgram(build::spmv::binaryCreator,
+                         build::spmv::sourceCreator,
+                         build::spmv::options);
+        }
+    }
+
+    void SetUp() override final
+    {
+        cl_int result = CL_SUCCESS;
+
+        result = program::CreateKernels(s_program,
+                                        build::spmv::clKernelNames,
+                                        m_kernels);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        ContextTest::SetUp();
+    }
+
+    void TearDown() noexcept override final
+    {
+        ReleaseKernels(m_kernels);
+
+        ContextTest::TearDown();
+    }
+
+    // Runs y = alpha * A * x + beta * y `iterations` times, or y = A * x without `scaling`, and downloads y into
+    // `yHost`. Returns the seconds the runs took.
+    double ExecOnDevice(const spmv::AdaptiveCsr&                  matrix,
+                        const std::optional<std::array<float, 2>> scaling,
+                        const std::vector<float>&                 xHost,
+                        std::vector<float>&                       yHost,
+                        const size_t                              iterations = 1) noexcept
+    {
+        cl_int result = CL_SUCCESS;
+
+        const cl_mem xDevice = clCreateBuffer(s_context,
+                                              CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                              xHost.size() * sizeof(float),
+                                              const_cast<float*>(xHost.data()),
+                                              &result);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        const cl_mem yDevice = clCreateBuffer(s_context,
+                                              CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                              yHost.size() * sizeof(float),
+                                              yHost.data(),
+                                              &result);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+        EXPECT_EQ(clFinish(m_queue), CL_SUCCESS);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; i++)
+        {
+            cl_event spmvComplete = nullptr;
+
+            result = scaling.has_value() ? matrix.EnqueueKernel(scaling.value()[0],
+                                                                xDevice,
+                                                                scaling.value()[1],
+                                                                yDevice,
+                                                                m_queue,
+                                                                m_kernels,
+                                                                {},
+                                                                spmvComplete)
+                                         : matrix.EnqueueKernel(xDevice,
+                                                                yDevice,
+                                                                m_queue,
+                                                                m_kernels,
+                                                                {},
+                                                                spmvComplete);
+
+            EXPECT_EQ(result, CL_SUCCESS);
+
+            if (result == CL_SUCCESS)
+            {
+                EXPECT_EQ(clReleaseEvent(spmvComplete), CL_SUCCESS);
+            }
+        }
+
+        EXPECT_EQ(clFinish(m_queue), CL_SUCCESS);
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        result = clEnqueueReadBuffer(m_queue,
+                                     yDevice,
+                                     CL_TRUE,
+                                     0,
+                                     yHost.size() * sizeof(float),
+                                     yHost.data(),
+                                     0,
+                                     nullptr,
+                                     nullptr);
+
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        EXPECT_EQ(clReleaseMemObject(xDevice), CL_SUCCESS);
+        EXPECT_EQ(clReleaseMemObject(yDevice), CL_SUCCESS);
+
+        return elapsed.count();
+    }
+
+    std::array<cl_kernel, build::spmv::clKernelNames.size()> m_kernels = {};
+};
+
+
+TEST_F(SpmvTest, MatchesHostReferenceOnPowerLawMatrices)
+{
+    constexpr size_t Rows    = 4096;
+    constexpr size_t Columns = 3000;
+
+    // Steeper power laws leave fewer long rows, down to none reaching the work-group bin.
+    for (const double exponent : { 1.3, 2.0, 3.0 })
+    {
+        const OwnedCsr                        csr    = MakePowerLawCsr(Rows, Columns, exponent, 42);
+        spmv::AdaptiveCsr                     matrix = {};
+        std::mt19937                          generator(7);
+        std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+        ASSERT_EQ(matrix.Init(s_context, csr.Get()), CL_SUCCESS);
+
+        std::vector<float> xHost(Columns);
+        std::generate(xHost.begin(), xHost.end(), [&]() { return value(generator); });
+
+        // Without scaling, a zero beta must not propagate the NaNs of y.
+        for (const std::optional<std::array<float, 2>> scaling : { std::optional<std::array<float, 2>>(),
+                                                                   std::optional<std::array<float, 2>>({ 1.5f, 0.5f }),
+                                                                   std::optional<std::array<float, 2>>({ -2.0f, 1.0f }) })
+        {
+            std::vector<float> yHost(Rows, scaling.has_value() ? 1.0f : std::numeric_limits<float>::quiet_NaN());
+            std::vector<float> solution = yHost;
+
+            spmv::HostExec(csr.Get(),
+                           scaling.has_value() ? scaling.value()[0] : 1.0f,
+                           xHost.data(),
+                           scaling.has_value() ? scaling.value()[1] : 0.0f,
+                           solution.data());
+
+            ExecOnDevice(matrix, scaling, xHost, yHost);
+
+            for (size_t row = 0; row < Rows; row++)
+            {
+                // Summation orders differ between host and device, and each product may round differently.
+                const size_t rowLength = csr.rowOffsets[row + 1] - csr.rowOffsets[row];
+                const float  tolerance = 8.0f * static_cast<float>(rowLength + 1) * std::numeric_limits<float>::epsilon();
+
+                ASSERT_NEAR(yHost[row], solution[row], tolerance) <<
+                    "Host and device spmv execution results differ in row " << row << " of " << rowLength << " non-zeros";
+            }
+        }
+    }
+}
+
+
+TEST_F(SpmvTest, HandlesMatricesWithoutNonZeros)
+{
+    constexpr size_t Rows    = 100;
+    constexpr size_t Columns = 10;
+
+    // Without non-zeros, the buffers of column indices and values are null, and every row lands in the scalar bin.
+    const OwnedCsr    csr    = { .n = Columns, .rowOffsets = std::vector<cl_uint>(Rows + 1, 0), .columnIndices = {}, .values = {} };
+    spmv::AdaptiveCsr matrix = {};
+
+    ASSERT_EQ(matrix.Init(s_context, csr.Get()), CL_SUCCESS);
+    EXPECT_EQ(matrix.GetNonZeroCount(), size_t(0));
+
+    const std::vector<float> xHost(Columns, 1.0f);
+    std::vector<float>       yHost(Rows, std::numeric_limits<float>::quiet_NaN());
+
+    ExecOnDevice(matrix, std::nullopt, xHost, yHost);
+
+    EXPECT_TRUE(std::ranges::all_of(yHost, [](const float y) { return y == 0.0f; })) << "Empty rows must yield zero";
+
+    std::fill(yHost.begin(), yHost.end(), 2.0f);
+
+    ExecOnDevice(matrix, std::array<float, 2>{ 3.0f, 0.5f }, xHost, yHost);
+
+    EXPECT_TRUE(std::ranges::all_of(yHost, [](const float y) { return y == 1.0f; })) << "Empty rows must only scale y";
+
+    // Without rows, nothing launches, and the product completes once the events it waits on do.
+    const std::array<cl_uint, 1> noRows      = { 0 };
+    spmv::AdaptiveCsr            emptyMatrix = {};
+    cl_event                     complete    = nullptr;
+
+    ASSERT_EQ(emptyMatrix.Init(s_context, { .n = Columns, .rowOffsets = noRows, .columnIndices = {}, .values = {} }),
+              CL_SUCCESS);
+
+    ASSERT_EQ(emptyMatrix.EnqueueKernel(nullptr, nullptr, m_queue, m_kernels, {}, complete), CL_SUCCESS);
+    EXPECT_EQ(clWaitForEvents(1, &complete), CL_SUCCESS);
+    EXPECT_EQ(clReleaseEvent(complete), CL_SUCCESS);
+}
+
+
+TEST_F(SpmvTest, CompletesAfterEveryBin)
+{
+    constexpr size_t Columns = 4096;
+
+    // On an out-of-order queue, only the completion event orders the launches of one product before the next.
+    const std::array<const cl_queue_properties, 3> queueProperties
+    {
+        CL_QUEUE_PROPERTIES,
+        CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
+        0
+    };
+
+    ContextTest::TearDown();
+    CreateQueue(queueProperties);
+
+    // Rows of 1, 100 and 2000 non-zeros fill one bin each, so every product runs as three launches.
+    OwnedCsr csr = { .n = Columns, .rowOffsets = { 0 }, .columnIndices = {}, .values = {} };
+
+    for (size_t row = 0; row < 3000; row++)
+    {
+        const size_t rowLength = (row % 3 == 0) ? 1 : (row % 3 == 1) ? 100 : 2000;
+
+        for (size_t i = 0; i < rowLength; i++)
+        {
+            csr.columnIndices.push_back(static_cast<cl_uint>((row + i) % Columns));
+            csr.values.push_back(1.0f);
+        }
+
+        csr.rowOffsets.push_back(static_cast<cl_uint>(csr.values.size()));
+    }
+
+    const spmv::RowBins bins = spmv::BinRows(csr.rowOffsets);
+
+    ASSERT_FALSE(bins.scalar.empty() || bins.vector.empty() || bins.workGroup.empty());
+
+    spmv::AdaptiveCsr  matrix = {};
+    cl_int             result = CL_SUCCESS;
+    std::vector<float> xHost(Columns, 1.0f);
+    std::vector<float> yHost(csr.rowOffsets.size() - 1, 0.0f);
+
+    ASSERT_EQ(matrix.Init(s_context, csr.Get()), CL_SUCCESS);
+
+    const cl_mem xDevice = clCreateBuffer(s_context,
+                                          CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                          xHost.size() * sizeof(float),
+                                          xHost.data(),
+                                          &result);
+
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    const cl_mem yDevice = clCreateBuffer(s_context,
+                                          CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                          yHost.size() * sizeof(float),
+                                          yHost.data(),
+                                          &result);
+
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    // y = A * x + y, chained through the completion events, sums every row length once per product.
+    constexpr size_t Products = 4;
+    cl_event         previous = nullptr;
+
+    for (size_t i = 0; i < Products; i++)
+    {
+        const std::span<const cl_event> waitList = (previous != nullptr) ? std::span<const cl_event>(&previous, 1)
+                                                                         : std::span<const cl_event>();
+        cl_event                        complete = nullptr;
+
+        result = matrix.EnqueueKernel(1.0f,
+                                      xDevice,
+                                      1.0f,
+                                      yDevice,
+                                      m_queue,
+                                      m_kernels,
+                                      waitList,
+                                      complete);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        if (previous != nullptr)
+        {
+            EXPECT_EQ(clReleaseEvent(previous), CL_SUCCESS);
+        }
+
+        previous = complete;
+    }
+
+    result = clEnqueueReadBuffer(m_queue,
+                                 yDevice,
+                                 CL_TRUE,
+                                 0,
+                                 yHost.size() * sizeof(float),
+                                 yHost.data(),
+                                 1,
+                                 &previous,
+                                 nullptr);
+
+    EXPECT_EQ(result, CL_SUCCESS);
+
+    for (size_t row = 0; row < yHost.size(); row++)
+    {
+        const size_t rowLength = csr.rowOffsets[row + 1] - csr.rowOffsets[row];
+
+        ASSERT_EQ(yHost[row], static_cast<float>(Products * rowLength)) << "Row " << row << " of " << rowLength << " non-zeros";
+    }
+
+    EXPECT_EQ(clReleaseEvent(previous), CL_SUCCESS);
+    EXPECT_EQ(clReleaseMemObject(xDevice), CL_SUCCESS);
+    EXPECT_EQ(clReleaseMemObject(yDevice), CL_SUCCESS);
+}
+
+
+TEST_F(SpmvTest, ReleasesPartialMatricesOnFailure)
+{
+    const std::array<cl_uint, 3> rowOffsets    = { 0, 1, 2 };
+    const std::array<cl_uint, 2> columnIndices = { 0, 1 };
+    const std::array<float, 2>   values        = { 1.0f, 2.0f };
+    spmv::AdaptiveCsr            matrix        = {};
+
+    ASSERT_EQ(matrix.Init(s_context, { .n = 2, .rowOffsets = rowOffsets, .columnIndices = columnIndices, .values = values }),
+              CL_SUCCESS);
+
+    // A well-formed matrix on no context fails to create its buffers, and must not keep those of the matrix before.
+    EXPECT_NE(matrix.Init(nullptr, { .n = 2, .rowOffsets = rowOffsets, .columnIndices = columnIndices, .values = values }),
+              CL_SUCCESS);
+
+    EXPECT_EQ(matrix.GetRowCount(), size_t(0));
+    EXPECT_EQ(matrix.GetColumnCount(), size_t(0));
+    EXPECT_EQ(matrix.GetNonZeroCount(), size_t(0));
+}
+
+
+TEST_F(SpmvTest, DISABLED_PowerLawBenchmark)
+{
+    constexpr size_t Rows       = 1 << 20;
+    constexpr size_t Iterations = 16;
+
+    // Flatter power laws would give rows of ~sqrt(n) non-zeros on average.
+    for (const double exponent : { 2.0, 2.5, 3.0 })
+    {
+        const OwnedCsr     csr    = MakePowerLawCsr(Rows, Rows, exponent, 42);
+        spmv::AdaptiveCsr  matrix = {};
+        std::vector<float> xHost(Rows, 1.0f);
+        std::vector<float> yHost(Rows, 0.0f);
+
+        ASSERT_EQ(matrix.Init(s_context, csr.Get()), CL_SUCCESS);
+
+        // The first execution absorbs one-off costs, e.g. of allocating device memory.
+        ExecOnDevice(matrix, std::nullopt, xHost, yHost);
+
+        const double seconds = ExecOnDevice(matrix, std::nullopt, xHost, yHost, Iterations);
+
+        const spmv::RowBins bins = spmv::BinRows(csr.rowOffsets);
+
+        std::cout << "[ BENCHMARK] Power law " << exponent << ", " << Rows << " rows, " << matrix.GetNonZeroCount()
+                  << " non-zeros in bins of " << bins.scalar.size() << " / " << bins.vector.size() << " / "
+                  << bins.workGroup.size() << " rows: "
+                  << (2.0 * matrix.GetNonZeroCount() * Iterations) / seconds / 1e9 << " GFLOP/s\n";
+    }
+}
+
+
+TEST(Spmv, BinsRowsByLength)
+{
+    // Rows of 0, 8, 9, 1024 and 1025 non-zeros straddle both thresholds.
+    const std::array<cl_uint, 6> rowOffsets = { 0, 0, 8, 17, 1041, 2066 };
+
+    const spmv::RowBins bins = spmv::BinRows(rowOffsets);
+
+    EXPECT_EQ(bins.scalar,    (std::vector<cl_uint>{ 0, 1 }));
+    EXPECT_EQ(bins.vector,    (std::vector<cl_uint>{ 2, 3 }));
+    EXPECT_EQ(bins.workGroup, (std::vector<cl_uint>{ 4 }));
+}
+
+
+TEST(Spmv, RejectsMalformedMatrices)
+{
+    const std::array<cl_uint, 3> rowOffsets    = { 0, 1, 2 };
+    const std::array<cl_uint, 2> columnIndices = { 0, 3 };
+    const std::array<float, 2>   values        = { 1.0f, 2.0f };
+    spmv::AdaptiveCsr            matrix        = {};
+
+    // The second column index lies past the last column.
+    EXPECT_EQ(matrix.Init(nullptr, { .n = 3, .rowOffsets = rowOffsets, .columnIndices = columnIndices, .values = values }),
+              CL_INVALID_VALUE);
+
+    // Offsets must end at the number of non-zeros.
+    EXPECT_EQ(matrix.Init(nullptr, { .n = 4, .rowOffsets = std::span(rowOffsets).first(2), .columnIndices = columnIndices, .values = values }),
+              CL_INVALID_VALUE);
+
+    // Offsets must not decrease.
+    const std::array<cl_uint, 3> decreasing = { 0, 2, 1 };
+
+    EXPECT_EQ(matrix.Init(nullptr, { .n = 4, .rowOffsets = decreasing, .columnIndices = columnIndices, .values = values }),
+              CL_INVALID_VALUE);
+}
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include "binary_cache.h"
+#include "debug.h"
+#include "hash.h"
+#include "settings.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+
+namespace
+{
+    constexpr std::array<char, 8> PackMagic   = { 'C', 'L', 'B', 'I', 'N', 'P', 'A', 'K' };
+    constexpr uint32_t            PackVersion = 1;
+    constexpr uint32_t            RecordMagic = 0x44434552; // "RECD"
+    constexpr uint64_t            Alignment   = 8;
+
+    struct PackHeader
+    {
+        std::array<char, 8> magic;
+        uint32_t            version;
+        uint32_t            reserved;
+    };
+
+    struct RecordHeader
+    {
+        uint32_t magic;
+        uint32_t keySizeInBytes;
+        uint64_t binarySizeInBytes;
+        uint64_t checksum;
+    };
+
+    static_assert(sizeof(PackHeader)   % Alignment == 0);
+    static_assert(sizeof(RecordHeader) % Alignment == 0);
+
+
+    constexpr uint64_t AlignUp(const uint64_t sizeInBytes) noexcept
+    {
+        return (sizeInBytes + Alignment - 1) & ~(Alignment - 1);
+    }
+
+
+    uint64_t ComputeChecksum(const std::string_view               key,
+                             const std::span<const unsigned char> binary) noexcept
+    {
+        return hash::Fnv1a(std::as_bytes(binary), hash::Fnv1a(key));
+    }
+
+
+    bool WriteRecord(std::ostream&                        oStream,
+                     const std::string_view               key,
+                     const std::span<const unsigned char> binary)
+    {
+        static constexpr std::array<char, Alignment> padding = {};
+
+        const RecordHeader header
+        {
+            .magic             = RecordMagic,
+            .keySizeInBytes    = static_cast<uint32_t>(key.size()),
+            .binarySizeInBytes = binary.size(),
+            .checksum          = ComputeChecksum(key, binary)
+        };
+
+        const uint64_t recordSizeInBytes = sizeof(header) + key.size() + binary.size();
+
+        oStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        oStream.write(key.data(), key.size());
+        oStream.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+        oStream.write(padding.data(), AlignUp(recordSizeInBytes) - recordSizeInBytes);
+
+        return !oStream.fail();
+    }
+
+
+    bool WritePack(const std::filesystem::path&                packFilePath,
+                   const binary_cache::Pack&                   existingPack,
+                   const std::span<const binary_cache::Record> records)
+    {
+        std::ofstream packOfStream(packFilePath,
+                                   std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+
+        if (!packOfStream.is_open())
+        {
+            MSG_STD_ERR("Failed to open output stream for program binary pack: ", packFilePath);
+            return false;
+        }
+
+        const PackHeader header = { .magic = PackMagic, .version = PackVersion, .reserved = 0 };
+        packOfStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (const auto& [key, binary] : existingPack.GetRecords())
+        {
+            const std::string slot       = binary_cache::GetSlot(key);
+            const bool        superseded = std::any_of(records.begin(), records.end(),
+                                                       [&](const binary_cache::Record& record) { return binary_cache::GetSlot(record.key) == slot; });
+
+            if (!superseded)
+            {
+                WriteRecord(packOfStream, key, binary);
+            }
+        }
+
+        for (const binary_cache::Record& record : records)
+        {
+            WriteRecord(packOfStream, record.key, record.binary);
+        }
+
+        packOfStream.close();
+
+        if (packOfStream.fail())
+        {
+            MSG_STD_ERR("Failed to write program binary pack: ", packFilePath);
+            return false;
+        }
+
+        // The pack is renamed over the old one next, which must not publish data still in flight to the disk.
+        return file::FlushToDisk(packFilePath);
+    }
+
+
+    struct CachedPack
+    {
+        std::shared_ptr<const binary_cache::Pack> pack;
+        std::filesystem::file_time_type           lastWriteTime;
+        uintmax_t                                 fileSizeInBytes;
+    };
+
+    std::mutex                                  openPacksMutex = {};
+    std::unordered_map<std::string, CachedPack> openPacks      = {};
+}
+
+
+std::string binary_cache::GetSlot(const std::string_view key)
+{
+    const size_t nameStart = key.rfind('/');
+
+    if ((nameStart == std::string_view::npos) || (nameStart == 0))
+    {
+        return std::string(key);
+    }
+
+    const size_t versionStart = key.rfind('/', nameStart - 1);
+    const size_t prefixEnd    = (versionStart == std::string_view::npos) ? 0 : versionStart;
+
+    return std::string(key.substr(0, prefixEnd)).append(key.substr(nameStart));
+}
+
+
+std::optional<binary_cache::Record> binary_cache::Pack::FindInSlot(const std::string_view key) const
+{
+    const auto it = m_slots.find(GetSlot(key));
+
+    if (it == m_slots.cend())
+    {
+        return std::nullopt;
+    }
+
+    return Record{ .key = std::string(it->second), .binary = m_index.at(it->second) };
+}
+
+
+std::optional<std::span<const unsigned char>> binary_cache::Pack::Find(const std::string_view key) const
+{
+    const auto it = m_index.find(key);
+
+    if (it == m_index.cend())
+    {
+        return std::nullopt;
+    }
+
+    return it->second;
+}
+
+
+bool binary_cache::Pack::Load(const std::filesystem::path& packFilePath)
+{
+    m_index.clear();
+    m_slots.clear();
+    m_liveSizeInBytes  = 0;
+    m_deadSizeInBytes  = 0;
+    m_validSizeInBytes = 0;
+
+    if (!m_mapping.Map(packFilePath))
+    {
+        return false;
+    }
+
+    const std::span<const std::byte> view = m_mapping.View();
+
+    if (view.size() < sizeof(PackHeader))
+    {
+        return true;
+    }
+
+    PackHeader packHeader = {};
+    std::memcpy(&packHeader, view.data(), sizeof(packHeader));
+
+    if (packHeader.magic != PackMagic || packHeader.version != PackVersion)
+    {
+        MSG_STD_ERR("Ignoring program binary pack with unrecognized header: ", packFilePath);
+        return true;
+    }
+
+    uint64_t offset    = sizeof(PackHeader);
+    m_validSizeInBytes = offset;
+
+    while (view.size() - offset >= sizeof(RecordHeader))
+    {
+        RecordHeader recordHeader = {};
+        std::memcpy(&recordHeader, view.data() + offset, sizeof(recordHeader));
+
+        if (recordHeader.magic != RecordMagic || recordHeader.binarySizeInBytes > view.size())
+        {
+            break;
+        }
+
+        const uint64_t payloadSizeInBytes = uint64_t{recordHeader.keySizeInBytes} + recordHeader.binarySizeInBytes;
+        const uint64_t recordSizeInBytes  = AlignUp(sizeof(RecordHeader) + payloadSizeInBytes);
+
+        if (recordSizeInBytes > view.size() - offset)
+        {
+            break;
+        }
+
+        const char* const      pKey = reinterpret_cast<const char*>(view.data() + offset + sizeof(RecordHeader));
+        const std::string_view key(pKey, recordHeader.keySizeInBytes);
+
+        const std::span<const unsigned char> binary(reinterpret_cast<const unsigned char*>(pKey) + key.size(),
+                                                    recordHeader.binarySizeInBytes);
+
+        if (ComputeChecksum(key, binary) != recordHeader.checksum)
+        {
+            break;
+        }
+
+        // A record supersedes the one of the same key, and any other version in its slot.
+        std::string slot   = GetSlot(key);
+        const auto  slotIt = m_slots.find(slot);
+
+        if (slotIt != m_slots.cend())
+        {
+            const std::string_view supersededKey         = slotIt->second;
+            const uint64_t         supersededSizeInBytes = AlignUp(sizeof(RecordHeader) + supersededKey.size() + m_index.at(supersededKey).size());
+
+            m_liveSizeInBytes -= supersededSizeInBytes;
+            m_deadSizeInBytes += supersededSizeInBytes;
+
+            m_index.erase(supersededKey);
+        }
+
+        m_index.insert_or_assign(key, binary);
+        m_slots.insert_or_assign(std::move(slot), key);
+        m_liveSizeInBytes += recordSizeInBytes;
+
+        offset            += recordSizeInBytes;
+        m_validSizeInBytes = offset;
+    }
+
+    DBG_BOOL_COND_MSG_STD_OUT(m_validSizeInBytes != view.size(),
+                              "Ignoring torn tail of program binary pack: ", packFilePath);
+
+    return true;
+}
+
+
+bool binary_cache::Open(const std::filesystem::path& packFilePath,
+                        std::shared_ptr<const Pack>& pack)
+{
+    pack.reset();
+
+    std::error_code ec = {};
+
+    if (!std::filesystem::exists(packFilePath, ec) || ec)
+    {
+        pack = std::make_shared<const Pack>();
+        return true;
+    }
+
+    const uintmax_t                       fileSizeInBytes = std::filesystem::file_size(packFilePath, ec);
+    const std::filesystem::file_time_type lastWriteTime   = std::filesystem::last_write_time(packFilePath, ec);
+
+    if (ec)
+    {
+        MSG_STD_ERR("Failed to query status of program binary pack ", packFilePath, ": ", ec.message());
+        return false;
+    }
+
+    const std::string key = packFilePath.string();
+
+    {
+        const std::lock_guard lock(openPacksMutex);
+        const auto            it = openPacks.find(key);
+
+        if (it != openPacks.cend() &&
+            it->second.fileSizeInBytes == fileSizeInBytes &&
+            it->second.lastWriteTime   == lastWriteTime)
+        {
+            pack = it->second.pack;
+            return true;
+        }
+    }
+
+    auto loadedPack = std::make_shared<Pack>();
+
+    if (!loadedPack->Load(packFilePath))
+    {
+        return false;
+    }
+
+    DBG_MSG_STD_OUT("Mapped program binary pack: ", packFilePath);
+
+    pack = std::move(loadedPack);
+
+    const std::lock_guard lock(openPacksMutex);
+    openPacks.insert_or_assign(key, CachedPack{ .pack = pack, .lastWriteTime = lastWriteTime, .fileSizeInBytes = fileSizeInBytes });
+
+    return true;
+}
+
+
+bool binary_cache::Append(const std::filesystem::path& packFilePath,
+                          const std::span<const Record> records)
+{
+    std::error_code ec = {};
+
+    std::filesystem::create_directories(packFilePath.parent_path(), ec);
+
+    if (ec)
+    {
+        MSG_STD_ERR("Failed to create directory ", packFilePath.parent_path(), " to store program binary pack: ", ec.message());
+        return false;
+    }
+
+    std::filesystem::path lockFilePath = packFilePath;
+    lockFilePath += ".lock";
+
+    file::ExclusiveLock lock = {};
+
+    if (!lock.Acquire(lockFilePath))
+    {
+        return false;
+    }
+
+    // The pack must be re-read under the lock, as another process may have appended to it since it was last opened.
+    Pack existingPack = {};
+
+    if (std::filesystem::exists(packFilePath, ec) && !existingPack.Load(packFilePath))
+    {
+        return false;
+    }
+
+    uint64_t deadSizeInBytes = existingPack.GetDeadSizeInBytes();
+
+    for (const Record& record : records)
+    {
+        const auto superseded = existingPack.FindInSlot(record.key);
+
+        if (superseded.has_value())
+        {
+            deadSizeInBytes += AlignUp(sizeof(RecordHeader) + superseded->key.size() + superseded->binary.size());
+        }
+    }
+
+    const bool packIsEmpty         = existingPack.GetValidSizeInBytes() == 0;
+    const bool packHasTornTail     = existingPack.GetValidSizeInBytes() != existingPack.GetFileSizeInBytes();
+    const bool packNeedsCompaction = deadSizeInBytes > settings::programBinaryPackCompactionThresholdInBytes &&
+                                     deadSizeInBytes > existingPack.GetLiveSizeInBytes();
+
+    // Never append after bytes that readers would stop at, and reclaim superseded records once they dominate.
+    if (packIsEmpty || packHasTornTail || packNeedsCompaction)
+    {
+        std::filesystem::path tmpFilePath = packFilePath;
+        tmpFilePath += ".tmp";
+
+        if (!WritePack(tmpFilePath, existingPack, records))
+        {
+            return false;
+        }
+
+        // 1. Readers that mapped the old pack keep a consistent view of it; new readers see the rewritten pack.
+        // 2. On Windows a pack that is still mapped cannot be replaced, so our own view must be released first.
+        //    Should another process hold a view, the rewrite fails here and is retried by the next writer.
+        existingPack = {};
+
+        {
+            const std::lock_guard openPacksLock(openPacksMutex);
+            openPacks.erase(packFilePath.string());
+        }
+
+        std::filesystem::rename(tmpFilePath, packFilePath, ec);
+
+        if (ec)
+        {
+            MSG_STD_ERR("Failed to replace program binary pack ", packFilePath, ": ", ec.message());
+            std::filesystem::remove(tmpFilePath, ec);
+            return false;
+        }
+
+        DBG_MSG_STD_OUT("Rewrote program binary pack: ", packFilePath);
+
+        return true;
+    }
+
+    {
+        std::ofstream packOfStream(packFilePath,
+                                   std::ios_base::out | std::ios_base::binary | std::ios_base::app);
+
+        if (!packOfStream.is_open())
+        {
+            MSG_STD_ERR("Failed to open output stream for program binary pack: ", packFilePath);
+            return false;
+        }
+
+        for (const Record& record : records)
+        {
+            if (!WriteRecord(packOfStream, record.key, record.binary))
+            {
+                MSG_STD_ERR("Failed to append program binary ", record.key, " to pack: ", packFilePath);
+                return false;
+            }
+        }
+
+        packOfStream.flush();
+
+        if (packOfStream.fail())
+        {
+            MSG_STD_ERR("Failed to append program binaries to pack: ", packFilePath);
+            return false;
+        }
+    }
+
+    const std::lock_guard openPacksLock(openPacksMutex);
+    openPacks.erase(packFilePath.string());
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef UTILITIES_BINARY_CACHE_H
+#define UTILITIES_BINARY_CACHE_H
+
+#include "file.h"
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+// Program binaries are persisted in a single pack file per binary root:
+//
+//     [PackHeader] [RecordHeader key binary padding] [RecordHeader key binary padding] ...
+//
+// 1. Records are only ever appended, under an inter-process lock, so concurrent writers cannot interleave.
+// 2. Every record is checksummed, so readers ignore a torn tail left behind by a writer that died mid-append.
+// 3. When a key is appended again, the newest record wins. Superseded records are reclaimed by compacting
+//    the live records into a temporary file that atomically replaces the pack.
+// 4. Keys are paths whose next-to-last component versions the binary, e.g. by the hash of its sources. Keys that
+//    differ in that component only share a slot, in which the newest record supersedes the others, so binaries of
+//    stale sources or build options are reclaimed too rather than accumulating forever.
+namespace binary_cache
+{
+    // `key` without its version component, e.g. "device/name" for "device/0123456789abcdef/name".
+    [[nodiscard]] std::string GetSlot(std::string_view key);
+
+    struct Record
+    {
+        std::string                    key;
+        std::span<const unsigned char> binary;
+    };
+
+    // An immutable, memory-mapped snapshot of a pack file.
+    class Pack
+    {
+    public:
+        [[nodiscard]] std::optional<std::span<const unsigned char>> Find(std::string_view key) const;
+
+        // The live record in the slot of `key`, whatever its version.
+        [[nodiscard]] std::optional<Record> FindInSlot(std::string_view key) const;
+
+        [[nodiscard]] bool Load(const std::filesystem::path& packFilePath);
+
+        [[nodiscard]] const auto& GetRecords() const noexcept { return m_index; }
+
+        [[nodiscard]] uint64_t GetLiveSizeInBytes() const noexcept { return m_liveSizeInBytes; }
+        [[nodiscard]] uint64_t GetDeadSizeInBytes() const noexcept { return m_deadSizeInBytes; }
+        [[nodiscard]] uint64_t GetValidSizeInBytes() const noexcept { return m_validSizeInBytes; }
+        [[nodiscard]] uint64_t GetFileSizeInBytes() const noexcept { return m_mapping.View().size(); }
+
+    private:
+        file::ReadOnlyMapping                                                m_mapping          = {};
+        std::unordered_map<std::string_view, std::span<const unsigned char>> m_index            = {};
+        std::unordered_map<std::string, std::string_view>                    m_slots            = {};
+        uint64_t                                                             m_liveSizeInBytes  = 0;
+        uint64_t                                                             m_deadSizeInBytes  = 0;
+        uint64_t                                                             m_validSizeInBytes = 0;
+    };
+
+    // Snapshots are shared process-wide, so many programs and devices are served by a single mapping
+    // until the pack file changes on disk. A missing pack file yields an empty snapshot.
+    [[nodiscard]] bool Open(const std::filesystem::path& packFilePath,
+                            std::shared_ptr<const Pack>& pack);
+
+    [[nodiscard]] bool Append(const std::filesystem::path& packFilePath,
+                              std::span<const Record>      records);
+}
+
+
+#endif // UTILITIES_BINARY_CACHE_H
\ No newline at end of file
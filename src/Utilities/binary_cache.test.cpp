@@ -0,0 +1,310 @@
+#include "binary_cache.h"
+#include "program.h"
+#include "settings.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    // A pack file in a directory of its own, removed along with the test.
+    class PackFile
+    {
+    public:
+        PackFile() :
+            m_directory(std::filesystem::temp_directory_path() /
+                        ("binary_cache_test_" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name())))
+        {
+            std::filesystem::remove_all(m_directory);
+        }
+
+        ~PackFile() noexcept
+        {
+            std::error_code ec = {};
+            std::filesystem::remove_all(m_directory, ec);
+        }
+
+        [[nodiscard]] std::filesystem::path GetPath() const { return m_directory / "ClBinaries.pack"; }
+
+    private:
+        std::filesystem::path m_directory;
+    };
+
+
+    std::vector<unsigned char> MakeBinary(const size_t sizeInBytes,
+                                          const unsigned char seed)
+    {
+        std::vector<unsigned char> binary(sizeInBytes);
+
+        for (size_t i = 0; i < binary.size(); i++)
+        {
+            binary[i] = static_cast<unsigned char>(seed + i);
+        }
+
+        return binary;
+    }
+
+
+    std::vector<unsigned char> FindBinary(const binary_cache::Pack& pack,
+                                          const std::string_view    key)
+    {
+        const auto binary = pack.Find(key);
+
+        return binary.has_value() ? std::vector<unsigned char>(binary->begin(), binary->end())
+                                  : std::vector<unsigned char>{};
+    }
+}
+
+
+TEST(BinaryCache, SlotsIgnoreTheVersionComponent)
+{
+    EXPECT_EQ(binary_cache::GetSlot("device/0123456789abcdef/saxpy.bin"), "device/saxpy.bin");
+    EXPECT_EQ(binary_cache::GetSlot("a/b/0123456789abcdef/saxpy.bin"),    "a/b/saxpy.bin");
+    EXPECT_EQ(binary_cache::GetSlot("0123456789abcdef/saxpy.bin"),        "/saxpy.bin");
+    EXPECT_EQ(binary_cache::GetSlot("saxpy.bin"),                         "saxpy.bin");
+}
+
+
+TEST(BinaryCache, BuildOptionsKeepSlotsOfTheirOwn)
+{
+    const std::string first  = program::GetBinaryFileName("sgemm_ClBinary_Debug.cl.bin", "-D SGEMM_TILE_M=64");
+    const std::string second = program::GetBinaryFileName("sgemm_ClBinary_Debug.cl.bin", "-D SGEMM_TILE_M=32");
+
+    EXPECT_TRUE(first.starts_with("sgemm_ClBinary_Debug_"));
+    EXPECT_TRUE(first.ends_with(".cl.bin"));
+    EXPECT_EQ(first, program::GetBinaryFileName("sgemm_ClBinary_Debug.cl.bin", "-D SGEMM_TILE_M=64"));
+
+    EXPECT_NE(binary_cache::GetSlot("device/0123456789abcdef/" + first),
+              binary_cache::GetSlot("device/0123456789abcdef/" + second));
+    EXPECT_EQ(binary_cache::GetSlot("device/0123456789abcdef/" + first),
+              binary_cache::GetSlot("device/fedcba9876543210/" + first));
+}
+
+
+TEST(BinaryCache, RoundTripsRecords)
+{
+    const PackFile                   packFile = {};
+    const std::vector<unsigned char> first    = MakeBinary(13, 1);
+    const std::vector<unsigned char> second   = MakeBinary(4096, 7);
+    const std::vector<unsigned char> third    = MakeBinary(0, 0);
+
+    const std::array<binary_cache::Record, 2> records =
+    { {
+        { .key = "gpu/0000000000000001/a.bin", .binary = first  },
+        { .key = "cpu/0000000000000001/a.bin", .binary = second }
+    } };
+
+    ASSERT_TRUE(binary_cache::Append(packFile.GetPath(), records));
+
+    // Appended to, rather than rewriting, a pack that exists.
+    const std::array<binary_cache::Record, 1> moreRecords = { { { .key = "gpu/0000000000000001/b.bin", .binary = third } } };
+
+    ASSERT_TRUE(binary_cache::Append(packFile.GetPath(), moreRecords));
+
+    std::shared_ptr<const binary_cache::Pack> pack = nullptr;
+    ASSERT_TRUE(binary_cache::Open(packFile.GetPath(), pack));
+
+    EXPECT_EQ(pack->GetRecords().size(), size_t(3));
+    EXPECT_EQ(FindBinary(*pack, "gpu/0000000000000001/a.bin"), first);
+    EXPECT_EQ(FindBinary(*pack, "cpu/0000000000000001/a.bin"), second);
+    EXPECT_TRUE(pack->Find("gpu/0000000000000001/b.bin").has_value());
+    EXPECT_FALSE(pack->Find("gpu/0000000000000001/c.bin").has_value());
+    EXPECT_EQ(pack->GetDeadSizeInBytes(), uint64_t(0));
+    EXPECT_EQ(pack->GetValidSizeInBytes(), pack->GetFileSizeInBytes());
+}
+
+
+TEST(BinaryCache, IgnoresCorruptedAndTornRecords)
+{
+    const PackFile                   packFile = {};
+    const std::vector<unsigned char> first    = MakeBinary(64, 1);
+    const std::vector<unsigned char> second   = MakeBinary(64, 2);
+
+    const std::array<binary_cache::Record, 1> firstRecord  = { { { .key = "gpu/0000000000000001/a.bin", .binary = first  } } };
+    const std::array<binary_cache::Record, 1> secondRecord = { { { .key = "gpu/0000000000000001/b.bin", .binary = second } } };
+
+    ASSERT_TRUE(binary_cache::Append(packFile.GetPath(), firstRecord));
+    ASSERT_TRUE(binary_cache::Append(packFile.GetPath(), secondRecord));
+
+    // Flip a byte of the last binary, so its checksum fails.
+    const uintmax_t fileSizeInBytes = std::filesystem::file_size(packFile.GetPath());
+
+    {
+        std::fstream packStream(packFile.GetPath(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        packStream.seekp(static_cast<std::streamoff>(fileSizeInBytes - 8));
+        packStream.put(static_cast<char>(0xFF));
+    }
+
+    std::shared_ptr<const binary_cache::Pack> pack = nullptr;
+    ASSERT_TRUE(binary_cache::Open(packFile.GetPath(), pack));
+
+    EXPECT_EQ(FindBinary(*pack, "gpu/0000000000000001/a.bin"), first);
+    EXPECT_FALSE(pack->Find("gpu/0000000000000001/b.bin").has_value());
+    EXPECT_LT(pack->GetValidSizeInBytes(), pack->GetFileSizeInBytes());
+
+    // The next writer must not append behind the corrupted record, where readers would never look. Mapped packs
+    // cannot be replaced on Windows, so the snapshot goes first.
+    pack.reset();
+
+    ASSERT_TRUE(binary_cache::Append(packFile.GetPath(), secondRecord));
+    ASSERT_TRUE(binary_cache::Open(packFile.GetPath(), pack));
+
+    EXPECT_EQ(FindBinary(*pack, "gpu/0000000000000001/a.bin"), first);
+    EXPECT_EQ(FindBinary(*pack, "gpu/0000000000000001/b.bin"), second);
+    EXPECT_EQ(pack->GetValidSizeInBytes(), pack->GetFileSizeInBytes());
+
+    // A truncated file only loses its torn record.
+    const uint64_t rewrittenSizeInBytes = pack->GetFileSizeInBytes();
+
+    pack.reset();
+    std::filesystem::resize_file(packFile.GetPath(), rewrittenSizeInBytes - 3);
+    ASSERT_TRUE(binary_cache::Open(packFile.GetPath(), pack));
+
+    EXPECT_EQ(FindBinary(*pack, "gpu/0000000000000001/a.bin"), first);
+    EXPECT_FALSE(pack->Find("gpu/0000000000000001/b.bin").has_value());
+}
+
+
+TEST(BinaryCache, SerializesConcurrentAppends)
+{
+    constexpr size_t Writers          = 8;
+    constexpr size_t AppendsPerWriter = 16;
+
+    const PackFile packFile = {};
+
+    const auto MakeKey = [](const size_t writer, const size_t i)
+    {
+        return "gpu/0000000000000001/" + std::to_string(writer) + "_" + std::to_string(i) + ".bin";
+    };
+
+    // Writers lock the pack through a file of their own each, as separate processes would.
+    std::vector<std::thread> writers = {};
+
+    for (size_t writer = 0; writer < Writers; writer++)
+    {
+        writers.emplace_back([&, writer]()
+        {
+            for (size_t i = 0; i < AppendsPerWriter; i++)
+            {
+                const std::vector<unsigned char>          binary = MakeBinary(100 + i, static_cast<unsigned char>(writer));
+                const std::array<binary_cache::Record, 1> record = { { { .key = MakeKey(writer, i), .binary = binary } } };
+
+                EXPECT_TRUE(binary_cache::Append(packFile.GetPath(), record));
+            }
+        });
+    }
+
+    for (std::thread& writer : writers)
+    {
+        writer.join();
+    }
+
+    std::shared_ptr<const binary_cache::Pack> pack = nullptr;
+    ASSERT_TRUE(binary_cache::Open(packFile.GetPath(), pack));
+
+    EXPECT_EQ(pack->GetRecords().size(), Writers * AppendsPerWriter);
+    EXPECT_EQ(pack->GetValidSizeInBytes(), pack->GetFileSizeInBytes());
+
+    for (size_t writer = 0; writer < Writers; writer++)
+    {
+        for (size_t i = 0; i < AppendsPerWriter; i++)
+        {
+            EXPECT_EQ(FindBinary(*pack, MakeKey(writer, i)), MakeBinary(100 + i, static_cast<unsigned char>(writer)));
+        }
+    }
+}
+
+
+TEST(BinaryCache, CompactsSupersededRecords)
+{
+    // Each binary is more than half the threshold, so the third append leaves more dead bytes than both the
+    // threshold and the live ones.
+    const size_t   binarySizeInBytes = (settings::programBinaryPackCompactionThresholdInBytes / 2) + 4096;
+    const PackFile packFile          = {};
+
+    std::shared_ptr<const binary_cache::Pack> pack = nullptr;
+
+    for (unsigned char seed = 1; seed <= 3; seed++)
+    {
+        const std::vector<unsigned char>          binary = MakeBinary(binarySizeInBytes, seed);
+        const std::array<binary_cache::Record, 1> record = { { { .key = "gpu/0000000000000001/a.bin", .binary = binary } } };
+
+        pack.reset();
+
+        ASSERT_TRUE(binary_cache::Append(packFile.GetPath(), record));
+        ASSERT_TRUE(binary_cache::Open(packFile.GetPath(), pack));
+
+        EXPECT_EQ(FindBinary(*pack, "gpu/0000000000000001/a.bin"), binary);
+
+        // The second append only supersedes the first record.
+        if (seed == 2)
+        {
+            EXPECT_GT(pack->GetDeadSizeInBytes(), uint64_t(0));
+        }
+    }
+
+    // The rewritten pack holds the newest record alone.
+    EXPECT_EQ(pack->GetRecords().size(), size_t(1));
+    EXPECT_EQ(pack->GetDeadSizeInBytes(), uint64_t(0));
+    EXPECT_LT(pack->GetFileSizeInBytes(), 2 * binarySizeInBytes);
+    EXPECT_EQ(pack->GetValidSizeInBytes(), pack->GetFileSizeInBytes());
+}
+
+
+TEST(BinaryCache, EvictsStaleVersionsOfASlot)
+{
+    const PackFile                   packFile = {};
+    const std::vector<unsigned char> stale    = MakeBinary(256, 1);
+    const std::vector<unsigned char> fresh    = MakeBinary(256, 2);
+    const std::vector<unsigned char> other    = MakeBinary(256, 3);
+
+    const std::array<binary_cache::Record, 2> staleRecords =
+    { {
+        { .key = "gpu/0000000000000001/a.bin", .binary = stale },
+        { .key = "gpu/0000000000000001/b.bin", .binary = other }
+    } };
+
+    const std::array<binary_cache::Record, 1> freshRecord = { { { .key = "gpu/0000000000000002/a.bin", .binary = fresh } } };
+
+    ASSERT_TRUE(binary_cache::Append(packFile.GetPath(), staleRecords));
+    ASSERT_TRUE(binary_cache::Append(packFile.GetPath(), freshRecord));
+
+    std::shared_ptr<const binary_cache::Pack> pack = nullptr;
+    ASSERT_TRUE(binary_cache::Open(packFile.GetPath(), pack));
+
+    // Edited sources hash differently, which retires the binary built from the old ones.
+    EXPECT_FALSE(pack->Find("gpu/0000000000000001/a.bin").has_value());
+    EXPECT_EQ(FindBinary(*pack, "gpu/0000000000000002/a.bin"), fresh);
+    EXPECT_EQ(FindBinary(*pack, "gpu/0000000000000001/b.bin"), other);
+    EXPECT_EQ(pack->GetRecords().size(), size_t(2));
+    EXPECT_GT(pack->GetDeadSizeInBytes(), uint64_t(0));
+
+    const auto slotRecord = pack->FindInSlot("gpu/0000000000000003/a.bin");
+
+    ASSERT_TRUE(slotRecord.has_value());
+    EXPECT_EQ(slotRecord->key, "gpu/0000000000000002/a.bin");
+
+    // A rewrite, here forced by a torn tail, leaves the stale record behind.
+    {
+        std::ofstream packStream(packFile.GetPath(), std::ios_base::out | std::ios_base::binary | std::ios_base::app);
+        packStream.write("torn", 4);
+    }
+
+    pack.reset();
+
+    ASSERT_TRUE(binary_cache::Append(packFile.GetPath(), freshRecord));
+    ASSERT_TRUE(binary_cache::Open(packFile.GetPath(), pack));
+
+    EXPECT_EQ(pack->GetRecords().size(), size_t(2));
+    EXPECT_EQ(pack->GetDeadSizeInBytes(), uint64_t(0));
+    EXPECT_EQ(pack->GetValidSizeInBytes(), pack->GetFileSizeInBytes());
+    EXPECT_EQ(FindBinary(*pack, "gpu/0000000000000002/a.bin"), fresh);
+}
\ No newline at end of file
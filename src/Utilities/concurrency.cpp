@@ -0,0 +1,67 @@
+#include "concurrency.h"
+
+
+concurrency::ThreadPool::ThreadPool(const size_t nThreads) :
+    m_threadTasks(nThreads)
+{
+    m_threads.reserve(nThreads);
+
+    for (size_t i = 0; i < nThreads; i++)
+    {
+        m_threads.emplace_back(&ThreadPool::ExecuteTasks, this, i);
+    }
+}
+
+
+concurrency::ThreadPool::~ThreadPool() noexcept
+{
+    {
+        const std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_tasksAvailable.notify_all();
+
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+
+void concurrency::ThreadPool::ExecuteTasks(const size_t threadIndex)
+{
+    std::deque<std::function<void()>>& threadTasks = m_threadTasks[threadIndex];
+
+    while (true)
+    {
+        std::function<void()> task = {};
+
+        {
+            std::unique_lock lock(m_mutex);
+
+            m_tasksAvailable.wait(lock, [&]() { return m_stopping || !threadTasks.empty() || !m_tasks.empty(); });
+
+            // Outstanding tasks are drained before stopping, so no future is ever left without a value.
+            std::deque<std::function<void()>>& tasks = !threadTasks.empty() ? threadTasks : m_tasks;
+
+            if (tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+
+concurrency::ThreadPool& concurrency::GetHostThreadPool()
+{
+    static ThreadPool hostThreadPool(std::max(std::thread::hardware_concurrency(), 1u));
+
+    return hostThreadPool;
+}
\ No newline at end of file
@@ -1,10 +1,24 @@
 #include "context.h"
 #include "debug.h"
+#include "metrics.h"
 #include "platform.h"
+#include "tracing.h"
 
 #include <array>
 
 
+namespace
+{
+    metrics::Counter& GetContextsCreated()
+    {
+        static metrics::Counter& contextsCreated = metrics::GetCounter("contexts_created_total",
+                                                                       "OpenCL contexts created.");
+
+        return contextsCreated;
+    }
+}
+
+
 cl_int context::GetDevices(const cl_context           context,
                            std::vector<cl_device_id>& devices)
 {
@@ -67,11 +81,82 @@ cl_int context::Create(platform::UniSelectionStrategy strategy,
                                   &result);
 
         OPENCL_PRINT_ON_ERROR(result);
+
+        if (result == CL_SUCCESS)
+        {
+            GetContextsCreated().Increment();
+        }
     }
     else
     {
         MSG_STD_OUT("No OpenCL platform was selected.");
     }
 
+    return result;
+}
+
+
+cl_int context::Create(platform::PolySelectionStrategy strategy,
+                       std::vector<cl_platform_id>&    selectedPlatforms,
+                       std::vector<cl_context>&        contexts)
+{
+    selectedPlatforms.resize(0);
+    contexts.resize(0);
+
+    cl_int                                 result              = CL_SUCCESS;
+    std::vector<cl_platform_id>            conformantPlatforms = {};
+    std::vector<std::vector<cl_device_id>> selectedDevices     = {};
+
+    result = platform::GetAllConformant(conformantPlatforms);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = strategy(conformantPlatforms, selectedPlatforms, selectedDevices);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    if (selectedPlatforms.empty())
+    {
+        MSG_STD_OUT("No OpenCL platform was selected.");
+        return result;
+    }
+
+    contexts.reserve(selectedPlatforms.size());
+
+    for (size_t i = 0; i < selectedPlatforms.size(); i++)
+    {
+        const std::array<const cl_context_properties, 3> properties
+        {
+            CL_CONTEXT_PLATFORM,
+            reinterpret_cast<cl_context_properties>(selectedPlatforms[i]),
+            0
+        };
+
+        const cl_context context = clCreateContext(properties.data(),
+                                                   static_cast<cl_uint>(selectedDevices[i].size()),
+                                                   selectedDevices[i].data(),
+                                                   nullptr,
+                                                   nullptr,
+                                                   &result);
+
+        OPENCL_PRINT_ON_ERROR(result);
+
+        if (result != CL_SUCCESS)
+        {
+            // Either every selected platform gets a context or none does.
+            for (const cl_context createdContext : contexts)
+            {
+                clReleaseContext(createdContext);
+            }
+
+            selectedPlatforms.resize(0);
+            contexts.resize(0);
+
+            return result;
+        }
+
+        contexts.push_back(context);
+    }
+
+    GetContextsCreated().Increment(contexts.size());
+
     return result;
 }
\ No newline at end of file
@@ -6,10 +6,8 @@ void debug::DisplayOpenClError(const cl_int           error,
                                const std::string_view callerName,
                                const uint32_t         lineNumber)
 {
-    std::cerr << "\nOPENCL ERROR\n";
-
-    std::cerr << "File: "       << fileName   << "\n";
-    std::cerr << "Function: "   << callerName << "\n";
-    std::cerr << "Line: "       << lineNumber << "\n";
-    std::cerr << "Error code: " << error      << "\n";
+    if (logging::IsEnabled<logging::Level::Error>())
+    {
+        logging::Write(std::cerr, "OPENCL ERROR", fileName, callerName, lineNumber, "Error code: ", error);
+    }
 }
\ No newline at end of file
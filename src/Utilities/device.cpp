@@ -1,8 +1,82 @@
 #include "debug.h"
 #include "device.h"
+#include "discovery.h"
+#include "hash.h"
 #include "program_types.h"
+#include "settings.h"
+#include "tracing.h"
 
+#include <algorithm>
 #include <array>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+
+namespace
+{
+    // Rough priors for devices without a measured profile. They only have to rank devices sensibly, not predict
+    // absolute performance: a GPU compute unit is assumed to hold 64 lanes, and the global memory bandwidth, which
+    // OpenCL cannot query, is guessed from the kind of device.
+    constexpr double GpuLanesPerComputeUnit         = 64.0;
+    constexpr double AcceleratorLanesPerComputeUnit = 16.0;
+    constexpr double DiscreteGpuBandwidthInGBps     = 256.0;
+    constexpr double IntegratedGpuBandwidthInGBps   = 64.0;
+    constexpr double AcceleratorBandwidthInGBps     = 128.0;
+    constexpr double CpuBandwidthInGBps             = 32.0;
+
+    // Flops per byte of a streaming kernel such as saxpy: two flops per 12 bytes moved.
+    constexpr double StreamingArithmeticIntensity = 2.0 / 12.0;
+
+    // Devices sharing memory with the host skip the copies between host and device memory.
+    constexpr double UnifiedMemoryBonus = 1.25;
+
+
+    const device::MeasuredProfile* FindMeasuredProfile(const device::MeasuredProfiles& profiles,
+                                                       const std::string&              uniqueId)
+    {
+        const auto profile = profiles.find(uniqueId);
+
+        return (profile != profiles.end()) ? &profile->second : nullptr;
+    }
+
+
+    cl_int Partition(const cl_device_id                                device,
+                     const std::span<const cl_device_partition_property> properties,
+                     std::vector<cl_device_id>&                        subDevices)
+    {
+        subDevices.resize(0);
+
+        cl_int  result      = CL_SUCCESS;
+        cl_uint nSubDevices = 0;
+
+        result = clCreateSubDevices(device,
+                                    properties.data(),
+                                    0,
+                                    nullptr,
+                                    &nSubDevices);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        subDevices.resize(nSubDevices);
+
+        result = clCreateSubDevices(device,
+                                    properties.data(),
+                                    nSubDevices,
+                                    subDevices.data(),
+                                    nullptr);
+
+        OPENCL_PRINT_ON_ERROR(result);
+
+        if (result != CL_SUCCESS)
+        {
+            subDevices.resize(0);
+        }
+
+        return result;
+    }
+}
 
 
 cl_int device::GetAllAvailable(const cl_platform_id       platform,
@@ -83,6 +157,41 @@ cl_int device::QueryParamValue(const cl_device_id   device,
 }
 
 
+// `QueryParamValue` is only defined in this translation unit, so every parameter type used elsewhere is instantiated here.
+// `size_t` and `cl_device_type` share their representation with `cl_ulong`, and `cl_bool` with `cl_uint`.
+template cl_int device::QueryParamValue<cl_uint>(cl_device_id, cl_device_info, cl_uint&);
+template cl_int device::QueryParamValue<cl_ulong>(cl_device_id, cl_device_info, cl_ulong&);
+
+
+cl_int device::QueryParamValue(const cl_device_id   device,
+                               const cl_device_info paramName,
+                               std::vector<size_t>& paramValue)
+{
+    cl_int result                = CL_SUCCESS;
+    size_t paramValueSizeInBytes = 0;
+
+    result = clGetDeviceInfo(device,
+                             paramName,
+                             0,
+                             nullptr,
+                             &paramValueSizeInBytes);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    paramValue.resize(paramValueSizeInBytes / sizeof(size_t));
+
+    result = clGetDeviceInfo(device,
+                             paramName,
+                             paramValueSizeInBytes,
+                             paramValue.data(),
+                             nullptr);
+
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
+
+
 cl_int device::DisplayGeneralInfo(const cl_device_id device)
 {
     const std::array<const cl_device_info, 9> paramNames
@@ -151,15 +260,143 @@ cl_int device::IsGpu(const cl_device_id device,
 }
 
 
+cl_int device::SupportsIl(const cl_device_id     device,
+                          const std::string_view ilPrefix,
+                          bool&                  supportsIl)
+{
+    supportsIl = false;
+
+    cl_int      result      = CL_SUCCESS;
+    std::string ilVersions  = {};
+    size_t      sizeInBytes = 0;
+
+    result = clGetDeviceInfo(device,
+                             CL_DEVICE_IL_VERSION,
+                             0,
+                             nullptr,
+                             &sizeInBytes);
+
+    // Devices predating OpenCL 2.1 do not recognize the query, which simply means that they accept no IL.
+    if (result == CL_INVALID_VALUE)
+    {
+        return CL_SUCCESS;
+    }
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = QueryParamValue(device,
+                             CL_DEVICE_IL_VERSION,
+                             ilVersions);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // `CL_DEVICE_IL_VERSION` is a space-separated list of "<IL prefix>_<major>.<minor>" entries.
+    supportsIl = ilVersions.find(ilPrefix) != std::string::npos;
+
+    return result;
+}
+
+
+cl_int device::GetOpenClVersion(const cl_device_id device,
+                                cl_uint&           major,
+                                cl_uint&           minor)
+{
+    major = 0;
+    minor = 0;
+
+    cl_int                       result     = CL_SUCCESS;
+    const discovery::DeviceInfo* deviceInfo = nullptr;
+
+    result = discovery::GetDeviceInfo(device, deviceInfo);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // `CL_DEVICE_VERSION` reads "OpenCL <major>.<minor> <vendor-specific information>".
+    std::istringstream versionStream(deviceInfo->version);
+    std::string        openCl = {};
+    char               dot    = '\0';
+
+    versionStream >> openCl >> major >> dot >> minor;
+
+    if (versionStream.fail() || (openCl != "OpenCL") || (dot != '.'))
+    {
+        MSG_STD_ERR("Unrecognized device version: ", deviceInfo->version);
+
+        major = 0;
+        minor = 0;
+    }
+
+    return result;
+}
+
+
+cl_int device::SupportsNonUniformWorkGroups(const cl_device_id device,
+                                           bool&              supportsNonUniformWorkGroups)
+{
+    supportsNonUniformWorkGroups = false;
+
+    cl_int  result = CL_SUCCESS;
+    cl_uint major  = 0;
+    cl_uint minor  = 0;
+
+    result = GetOpenClVersion(device, major, minor);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    if (major < 2)
+    {
+        return result;
+    }
+
+    // Mandatory in OpenCL 2.x, but optional again from OpenCL 3.0 onwards.
+    if (major == 2)
+    {
+        supportsNonUniformWorkGroups = true;
+        return result;
+    }
+
+    cl_bool isSupported = CL_FALSE;
+
+    result = QueryParamValue(device,
+                             CL_DEVICE_NON_UNIFORM_WORK_GROUP_SUPPORT,
+                             isSupported);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    supportsNonUniformWorkGroups = (isSupported == CL_TRUE);
+
+    return result;
+}
+
+
 cl_int device::GetUniqueId(const cl_device_id device,
                            std::string&       uniqueId)
 {
-    UNUSED_PARAMETER(device);
+    const std::array<const cl_device_info, 4> paramNames
+    {
+        CL_DEVICE_NAME,
+        CL_DEVICE_VENDOR,
+        CL_DEVICE_VERSION,
+        CL_DRIVER_VERSION
+    };
 
-    cl_int result = CL_SUCCESS;
+    cl_int   result       = CL_SUCCESS;
+    uint64_t uniqueIdHash = hash::Fnv1aOffsetBasis;
+
+    // Devices of the same model, vendor and driver produce interchangeable program binaries.
+    for (const cl_device_info paramName : paramNames)
+    {
+        std::string paramValue = {};
+
+        result = QueryParamValue(device, paramName, paramValue);
+        OPENCL_RETURN_ON_ERROR(result);
 
-    // TODO: create a hash of device characteristics.
-    uniqueId = "QuadroP1000";
+        uniqueIdHash = hash::Fnv1a(paramValue, uniqueIdHash);
+        uniqueIdHash = hash::Fnv1a(std::string_view("\0", 1), uniqueIdHash);
+    }
+
+    std::ostringstream uniqueIdStr = {};
+    uniqueIdStr << std::hex << std::setfill('0') << std::setw(16) << uniqueIdHash;
+
+    uniqueId = uniqueIdStr.str();
 
     return result;
 }
@@ -169,35 +406,307 @@ cl_int device::GetClBinaryDir(const std::filesystem::path& clBinaryRoot,
                               const cl_device_id           device,
                               std::filesystem::path&       clBinaryDir)
 {
-    cl_int      result       = CL_SUCCESS;
-    std::string deviceVendor = {};
-    std::string uniqueId     = {};
+    cl_int                       result     = CL_SUCCESS;
+    const discovery::DeviceInfo* deviceInfo = nullptr;
 
-    result = QueryParamValue(device,
-                             CL_DEVICE_VENDOR,
-                             deviceVendor);
+    result = discovery::GetDeviceInfo(device, deviceInfo);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    clBinaryDir = clBinaryRoot / deviceInfo->vendor / deviceInfo->uniqueId;
+
+    return result;
+}
+
+
+cl_int device::GetClBinaryKey(const program::BinaryCreator& binCreator,
+                              const cl_device_id            device,
+                              std::string&                  clBinaryKey)
+{
+    cl_int                result           = CL_SUCCESS;
+    std::filesystem::path clBinaryFilePath = {};
 
+    result = GetClBinaryDir({}, device, clBinaryFilePath);
     OPENCL_RETURN_ON_ERROR(result);
 
-    result = GetUniqueId(device, uniqueId);
+    // Binaries built from stale sources must never be loaded, so the source hash is part of the key.
+    std::ostringstream clSourceHashStr = {};
+    clSourceHashStr << std::hex << std::setfill('0') << std::setw(16) << binCreator.clSourceHash;
+
+    clBinaryFilePath /= clSourceHashStr.view();
+    clBinaryFilePath /= binCreator.clBinaryFileName;
+    clBinaryKey       = clBinaryFilePath.generic_string();
+
+    return result;
+}
+
+
+device::MeasuredProfiles device::LoadMeasuredProfiles(const std::filesystem::path& profilesFilePath)
+{
+    MeasuredProfiles profiles = {};
+    std::ifstream    profilesIfStream(profilesFilePath);
+    std::string      line     = {};
+
+    while (std::getline(profilesIfStream, line))
+    {
+        if (line.empty() || line.front() == '#')
+        {
+            continue;
+        }
+
+        std::istringstream lineStream(line);
+        std::string        uniqueId = {};
+        MeasuredProfile    profile  = {};
+
+        lineStream >> uniqueId >> profile.computeInGflops >> profile.memoryBandwidthInGBps;
+
+        if (lineStream.fail() || profile.computeInGflops <= 0.0 || profile.memoryBandwidthInGBps <= 0.0)
+        {
+            MSG_STD_ERR("Ignoring malformed device profile: ", line);
+            continue;
+        }
+
+        lineStream >> profile.zeroCopyBandwidthInGBps >> profile.transferBandwidthInGBps;
+
+        if (lineStream.fail() || profile.zeroCopyBandwidthInGBps <= 0.0 || profile.transferBandwidthInGBps <= 0.0)
+        {
+            profile.zeroCopyBandwidthInGBps = 0.0;
+            profile.transferBandwidthInGBps = 0.0;
+        }
+
+        profiles.insert_or_assign(std::move(uniqueId), profile);
+    }
+
+    return profiles;
+}
+
+
+const device::MeasuredProfiles& device::GetMeasuredProfiles()
+{
+    static const MeasuredProfiles profiles = LoadMeasuredProfiles(settings::deviceProfilesFilePath);
+
+    return profiles;
+}
+
+
+cl_int device::EstimateThroughput(const cl_device_id device,
+                                  double&            throughputInGflops)
+{
+    throughputInGflops = 0.0;
+
+    cl_int                       result     = CL_SUCCESS;
+    const discovery::DeviceInfo* deviceInfo = nullptr;
+
+    result = discovery::GetDeviceInfo(device, deviceInfo);
     OPENCL_RETURN_ON_ERROR(result);
 
-    clBinaryDir = clBinaryRoot / deviceVendor / uniqueId;
+    throughputInGflops = EstimateThroughput(*deviceInfo, GetMeasuredProfiles());
 
     return result;
 }
 
 
-cl_int device::GetClBinaryFilePath(const program::BinaryCreator& binCreator,
-                                   const cl_device_id            device,
-                                   std::filesystem::path&        clBinaryFilePath)
+double device::EstimateThroughput(const discovery::DeviceInfo& deviceInfo,
+                                  const MeasuredProfiles&      profiles) noexcept
 {
-    cl_int result = CL_SUCCESS;
+    double computeInGflops       = 0.0;
+    double memoryBandwidthInGBps = 0.0;
+
+    if (const MeasuredProfile* const profile = FindMeasuredProfile(profiles, deviceInfo.uniqueId))
+    {
+        computeInGflops       = profile->computeInGflops;
+        memoryBandwidthInGBps = profile->memoryBandwidthInGBps;
+    }
+    else
+    {
+        double lanesPerComputeUnit = 0.0;
+
+        if (deviceInfo.type & CL_DEVICE_TYPE_GPU)
+        {
+            lanesPerComputeUnit   = GpuLanesPerComputeUnit;
+            memoryBandwidthInGBps = deviceInfo.hostUnifiedMemory ? IntegratedGpuBandwidthInGBps
+                                                                 : DiscreteGpuBandwidthInGBps;
+        }
+        else if (deviceInfo.type & CL_DEVICE_TYPE_ACCELERATOR)
+        {
+            lanesPerComputeUnit   = AcceleratorLanesPerComputeUnit;
+            memoryBandwidthInGBps = AcceleratorBandwidthInGBps;
+        }
+        else
+        {
+            // CPU compute units are cores, whose lanes are those of their SIMD units.
+            lanesPerComputeUnit   = std::max(deviceInfo.preferredVectorWidthFloat, 1u);
+            memoryBandwidthInGBps = CpuBandwidthInGBps;
+        }
+
+        // One fused multiply-add, i.e. two flops, per lane and cycle.
+        computeInGflops = 2.0 * lanesPerComputeUnit
+                              * deviceInfo.maxComputeUnits
+                              * deviceInfo.maxClockFrequencyInMHz / 1000.0;
+    }
+
+    if (computeInGflops <= 0.0)
+    {
+        return 0.0;
+    }
+
+    // A soft roofline: whichever of compute and memory bandwidth is scarcer dominates.
+    const double memoryBoundInGflops = memoryBandwidthInGBps * StreamingArithmeticIntensity;
+    double       throughputInGflops  = 1.0 / (1.0 / computeInGflops + 1.0 / memoryBoundInGflops);
+
+    if (deviceInfo.hostUnifiedMemory)
+    {
+        throughputInGflops *= UnifiedMemoryBonus;
+    }
+
+    return throughputInGflops;
+}
 
-    result = GetClBinaryDir(binCreator.clBinaryRoot, device, clBinaryFilePath);
+
+cl_int device::PrefersZeroCopy(const cl_device_id device,
+                               bool&              prefersZeroCopy)
+{
+    prefersZeroCopy = false;
+
+    cl_int                       result     = CL_SUCCESS;
+    const discovery::DeviceInfo* deviceInfo = nullptr;
+
+    result = discovery::GetDeviceInfo(device, deviceInfo);
     OPENCL_RETURN_ON_ERROR(result);
 
-    clBinaryFilePath /= binCreator.clBinaryFileName;
+    const MeasuredProfile* const profile = FindMeasuredProfile(GetMeasuredProfiles(), deviceInfo->uniqueId);
+
+    if ((profile != nullptr) && (profile->zeroCopyBandwidthInGBps > 0.0))
+    {
+        // Streaming each byte once: in place over the host link, or copied and then read from device memory.
+        const double zeroCopyTime     = 1.0 / profile->zeroCopyBandwidthInGBps;
+        const double explicitCopyTime = 1.0 / profile->transferBandwidthInGBps + 1.0 / profile->memoryBandwidthInGBps;
+
+        prefersZeroCopy = (zeroCopyTime <= explicitCopyTime);
+    }
+    else
+    {
+        // Without a measurement, zero-copy pays wherever host memory is the device memory.
+        prefersZeroCopy = (deviceInfo->type & CL_DEVICE_TYPE_CPU) || deviceInfo->hostUnifiedMemory;
+    }
 
     return result;
+}
+
+
+cl_int device::SupportsPartitioning(const cl_device_id                 device,
+                                    const cl_device_partition_property partitionType,
+                                    bool&                              supportsPartitioning)
+{
+    supportsPartitioning = false;
+
+    cl_int result                = CL_SUCCESS;
+    size_t paramValueSizeInBytes = 0;
+
+    result = clGetDeviceInfo(device,
+                             CL_DEVICE_PARTITION_PROPERTIES,
+                             0,
+                             nullptr,
+                             &paramValueSizeInBytes);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    std::vector<cl_device_partition_property> partitionTypes(paramValueSizeInBytes / sizeof(cl_device_partition_property));
+
+    result = clGetDeviceInfo(device,
+                             CL_DEVICE_PARTITION_PROPERTIES,
+                             paramValueSizeInBytes,
+                             partitionTypes.data(),
+                             nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // Devices that cannot be partitioned report a single 0.
+    supportsPartitioning = (partitionType != 0) &&
+                           (std::find(partitionTypes.cbegin(), partitionTypes.cend(), partitionType) != partitionTypes.cend());
+
+    return result;
+}
+
+
+cl_int device::SupportsAffinityDomain(const cl_device_id              device,
+                                      const cl_device_affinity_domain affinityDomain,
+                                      bool&                           supportsAffinityDomain)
+{
+    supportsAffinityDomain = false;
+
+    cl_int                    result            = CL_SUCCESS;
+    cl_device_affinity_domain affinityDomains   = 0;
+    bool                      supportsPartition = false;
+
+    result = SupportsPartitioning(device,
+                                  CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN,
+                                  supportsPartition);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    if (!supportsPartition)
+    {
+        return result;
+    }
+
+    result = QueryParamValue(device,
+                             CL_DEVICE_PARTITION_AFFINITY_DOMAIN,
+                             affinityDomains);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    supportsAffinityDomain = ((affinityDomains & affinityDomain) == affinityDomain);
+
+    return result;
+}
+
+
+cl_int device::PartitionEqually(const cl_device_id         device,
+                                const cl_uint              computeUnitsPerSubDevice,
+                                std::vector<cl_device_id>& subDevices)
+{
+    const std::array<const cl_device_partition_property, 3> properties
+    {
+        CL_DEVICE_PARTITION_EQUALLY,
+        static_cast<cl_device_partition_property>(computeUnitsPerSubDevice),
+        0
+    };
+
+    return Partition(device, properties, subDevices);
+}
+
+
+cl_int device::PartitionByCounts(const cl_device_id             device,
+                                 const std::span<const cl_uint> computeUnitCounts,
+                                 std::vector<cl_device_id>&     subDevices)
+{
+    std::vector<cl_device_partition_property> properties = {};
+
+    properties.reserve(computeUnitCounts.size() + 3);
+    properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS);
+
+    for (const cl_uint computeUnitCount : computeUnitCounts)
+    {
+        properties.push_back(static_cast<cl_device_partition_property>(computeUnitCount));
+    }
+
+    properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS_LIST_END);
+    properties.push_back(0);
+
+    return Partition(device, properties, subDevices);
+}
+
+
+cl_int device::PartitionByAffinityDomain(const cl_device_id              device,
+                                         const cl_device_affinity_domain affinityDomain,
+                                         std::vector<cl_device_id>&      subDevices)
+{
+    const std::array<const cl_device_partition_property, 3> properties
+    {
+        CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN,
+        static_cast<cl_device_partition_property>(affinityDomain),
+        0
+    };
+
+    return Partition(device, properties, subDevices);
 }
\ No newline at end of file
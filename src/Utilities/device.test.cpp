@@ -0,0 +1,144 @@
+#include "device.h"
+#include "discovery_types.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+
+namespace
+{
+    // Flops per byte of saxpy, which the estimates assume.
+    constexpr double StreamingArithmeticIntensity = 2.0 / 12.0;
+
+
+    discovery::DeviceInfo MakeDeviceInfo(const cl_device_type type,
+                                         const cl_uint        computeUnits,
+                                         const cl_uint        clockFrequencyInMHz,
+                                         const bool           hostUnifiedMemory)
+    {
+        discovery::DeviceInfo deviceInfo = {};
+
+        deviceInfo.type                   = type;
+        deviceInfo.uniqueId               = "00000000000000aa";
+        deviceInfo.maxComputeUnits        = computeUnits;
+        deviceInfo.maxClockFrequencyInMHz = clockFrequencyInMHz;
+        deviceInfo.hostUnifiedMemory      = hostUnifiedMemory;
+
+        return deviceInfo;
+    }
+
+
+    double SoftRoofline(const double computeInGflops,
+                        const double memoryBandwidthInGBps)
+    {
+        return 1.0 / (1.0 / computeInGflops + 1.0 / (memoryBandwidthInGBps * StreamingArithmeticIntensity));
+    }
+}
+
+
+TEST(Device, EstimatesThroughputFromPriors)
+{
+    const device::MeasuredProfiles noProfiles = {};
+
+    // 64 lanes per compute unit, each doing a fused multiply-add per cycle, and 256 GB/s of device memory.
+    const discovery::DeviceInfo discreteGpu = MakeDeviceInfo(CL_DEVICE_TYPE_GPU, 80, 1500, false);
+
+    EXPECT_DOUBLE_EQ(device::EstimateThroughput(discreteGpu, noProfiles), SoftRoofline(2.0 * 64 * 80 * 1.5, 256.0));
+
+    // Integrated GPUs share the slower memory of the host, but skip copies into it.
+    const discovery::DeviceInfo integratedGpu = MakeDeviceInfo(CL_DEVICE_TYPE_GPU, 24, 1300, true);
+
+    EXPECT_DOUBLE_EQ(device::EstimateThroughput(integratedGpu, noProfiles), 1.25 * SoftRoofline(2.0 * 64 * 24 * 1.3, 64.0));
+
+    const discovery::DeviceInfo accelerator = MakeDeviceInfo(CL_DEVICE_TYPE_ACCELERATOR, 32, 1000, false);
+
+    EXPECT_DOUBLE_EQ(device::EstimateThroughput(accelerator, noProfiles), SoftRoofline(2.0 * 16 * 32 * 1.0, 128.0));
+
+    // The lanes of CPU cores are those of their SIMD units, and at least one.
+    discovery::DeviceInfo cpu     = MakeDeviceInfo(CL_DEVICE_TYPE_CPU, 16, 3000, true);
+    cpu.preferredVectorWidthFloat = 8;
+
+    EXPECT_DOUBLE_EQ(device::EstimateThroughput(cpu, noProfiles), 1.25 * SoftRoofline(2.0 * 8 * 16 * 3.0, 32.0));
+
+    cpu.preferredVectorWidthFloat = 0;
+
+    EXPECT_DOUBLE_EQ(device::EstimateThroughput(cpu, noProfiles), 1.25 * SoftRoofline(2.0 * 1 * 16 * 3.0, 32.0));
+
+    // Whatever a runtime failed to report promises nothing.
+    EXPECT_EQ(device::EstimateThroughput(MakeDeviceInfo(CL_DEVICE_TYPE_GPU, 0, 1500, false), noProfiles), 0.0);
+    EXPECT_EQ(device::EstimateThroughput(MakeDeviceInfo(CL_DEVICE_TYPE_GPU, 80, 0, false), noProfiles), 0.0);
+}
+
+
+TEST(Device, PrefersMeasuredProfiles)
+{
+    const discovery::DeviceInfo discreteGpu = MakeDeviceInfo(CL_DEVICE_TYPE_GPU, 80, 1500, false);
+
+    const device::MeasuredProfiles profiles =
+    {
+        { discreteGpu.uniqueId, { .computeInGflops         = 100.0,
+                                  .memoryBandwidthInGBps   = 600.0,
+                                  .zeroCopyBandwidthInGBps = 0.0,
+                                  .transferBandwidthInGBps = 0.0 } }
+    };
+
+    EXPECT_DOUBLE_EQ(device::EstimateThroughput(discreteGpu, profiles), SoftRoofline(100.0, 600.0));
+
+    // Profiles of other devices leave the priors in place.
+    discovery::DeviceInfo otherGpu = discreteGpu;
+    otherGpu.uniqueId              = "00000000000000bb";
+
+    EXPECT_DOUBLE_EQ(device::EstimateThroughput(otherGpu, profiles), device::EstimateThroughput(otherGpu, {}));
+}
+
+
+TEST(Device, LoadsMeasuredProfiles)
+{
+    const std::filesystem::path profilesFilePath = std::filesystem::temp_directory_path() / "device_test_profiles.txt";
+
+    {
+        std::ofstream profilesOfStream(profilesFilePath, std::ios_base::out | std::ios_base::trunc);
+
+        profilesOfStream << "# <unique ID> <compute> <memory bandwidth> [<zero-copy bandwidth> <transfer bandwidth>]\n"
+                         << "\n"
+                         << "computeOnly 1000 200\n"
+                         << "withTransfers 500.5 100 20 12\n"
+                         << "partialTransfers 10 20 30\n"
+                         << "zeroTransfers 10 20 30 0\n"
+                         << "malformed fast 200\n"
+                         << "negative 1000 -1\n"
+                         << "overridden 1 1\n"
+                         << "overridden 2 2\n";
+    }
+
+    const device::MeasuredProfiles profiles = device::LoadMeasuredProfiles(profilesFilePath);
+
+    std::filesystem::remove(profilesFilePath);
+
+    ASSERT_EQ(profiles.size(), size_t(5));
+
+    EXPECT_EQ(profiles.at("computeOnly").computeInGflops, 1000.0);
+    EXPECT_EQ(profiles.at("computeOnly").memoryBandwidthInGBps, 200.0);
+    EXPECT_EQ(profiles.at("computeOnly").zeroCopyBandwidthInGBps, 0.0);
+    EXPECT_EQ(profiles.at("computeOnly").transferBandwidthInGBps, 0.0);
+
+    EXPECT_EQ(profiles.at("withTransfers").computeInGflops, 500.5);
+    EXPECT_EQ(profiles.at("withTransfers").zeroCopyBandwidthInGBps, 20.0);
+    EXPECT_EQ(profiles.at("withTransfers").transferBandwidthInGBps, 12.0);
+
+    // Transfer bandwidths count only in pairs of positive values.
+    EXPECT_EQ(profiles.at("partialTransfers").zeroCopyBandwidthInGBps, 0.0);
+    EXPECT_EQ(profiles.at("zeroTransfers").zeroCopyBandwidthInGBps, 0.0);
+    EXPECT_EQ(profiles.at("zeroTransfers").transferBandwidthInGBps, 0.0);
+
+    // Later lines win.
+    EXPECT_EQ(profiles.at("overridden").computeInGflops, 2.0);
+
+    // A missing file lists no profiles.
+    EXPECT_TRUE(device::LoadMeasuredProfiles(profilesFilePath).empty());
+}
\ No newline at end of file
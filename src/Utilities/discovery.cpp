@@ -0,0 +1,489 @@
+#include "debug.h"
+#include "device.h"
+#include "discovery.h"
+#include "file.h"
+#include "platform.h"
+#include "required.h"
+#include "settings.h"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <unordered_map>
+
+
+namespace
+{
+    constexpr std::string_view SnapshotMagic   = "ClDiscoverySnapshot";
+    constexpr uint32_t         SnapshotVersion = 1;
+
+    // Strings of a snapshot are far shorter; a larger size means the snapshot is corrupted.
+    constexpr size_t MaxSnapshotStringSizeInBytes = 64 * 1024;
+
+
+    cl_int QueryDeviceInfo(const cl_device_id     device,
+                           discovery::DeviceInfo& deviceInfo)
+    {
+        cl_int  result            = CL_SUCCESS;
+        cl_bool hostUnifiedMemory = CL_FALSE;
+
+        deviceInfo.id = device;
+
+        result = device::QueryParamValue(device, CL_DEVICE_TYPE, deviceInfo.type);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_NAME, deviceInfo.name);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_VENDOR, deviceInfo.vendor);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_VERSION, deviceInfo.version);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DRIVER_VERSION, deviceInfo.driverVersion);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_OPENCL_C_VERSION, deviceInfo.openClCVersion);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_MAX_COMPUTE_UNITS, deviceInfo.maxComputeUnits);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_MAX_CLOCK_FREQUENCY, deviceInfo.maxClockFrequencyInMHz);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_ADDRESS_BITS, deviceInfo.addressBits);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, deviceInfo.memBaseAddrAlignInBits);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT, deviceInfo.preferredVectorWidthFloat);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_GLOBAL_MEM_SIZE, deviceInfo.globalMemSizeInBytes);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_GLOBAL_MEM_CACHE_SIZE, deviceInfo.globalMemCacheSizeInBytes);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, deviceInfo.maxMemAllocSizeInBytes);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_LOCAL_MEM_SIZE, deviceInfo.localMemSizeInBytes);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, deviceInfo.maxWorkGroupSize);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_MAX_WORK_ITEM_SIZES, deviceInfo.maxWorkItemSizes);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = device::QueryParamValue(device, CL_DEVICE_HOST_UNIFIED_MEMORY, hostUnifiedMemory);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        deviceInfo.hostUnifiedMemory = (hostUnifiedMemory == CL_TRUE);
+
+        bool supportsSpirV = false;
+
+        result = device::SupportsIl(device, "SPIR-V", supportsSpirV);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        if (supportsSpirV)
+        {
+            result = device::QueryParamValue(device, CL_DEVICE_IL_VERSION, deviceInfo.ilVersions);
+            OPENCL_RETURN_ON_ERROR(result);
+        }
+
+        result = device::GetUniqueId(device, deviceInfo.uniqueId);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        return result;
+    }
+
+
+    cl_int QueryPlatformInfo(const cl_platform_id     platform,
+                             discovery::PlatformInfo& platformInfo)
+    {
+        cl_int                    result  = CL_SUCCESS;
+        std::vector<cl_device_id> devices = {};
+
+        platformInfo.id = platform;
+
+        result = platform::QueryParamValue(platform, CL_PLATFORM_PROFILE, platformInfo.profile);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = platform::QueryParamValue(platform, CL_PLATFORM_VERSION, platformInfo.version);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = platform::QueryParamValue(platform, CL_PLATFORM_NAME, platformInfo.name);
+        OPENCL_RETURN_ON_ERROR(result);
+        result = platform::QueryParamValue(platform, CL_PLATFORM_VENDOR, platformInfo.vendor);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        platformInfo.isConformant = (platformInfo.profile == required::PlatformProfile);
+
+        result = device::GetAllAvailable(platform, devices);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        platformInfo.devices.resize(devices.size());
+
+        for (size_t i = 0; i < devices.size(); i++)
+        {
+            result = QueryDeviceInfo(devices[i], platformInfo.devices[i]);
+            OPENCL_RETURN_ON_ERROR(result);
+        }
+
+        return result;
+    }
+
+
+    void WriteString(std::ostream& oStream, const std::string& str)
+    {
+        oStream << str.size() << ' ' << str << '\n';
+    }
+
+
+    bool ReadString(std::istream& iStream, std::string& str)
+    {
+        size_t sizeInBytes = 0;
+
+        if (!(iStream >> sizeInBytes) || iStream.get() != ' ' || sizeInBytes > MaxSnapshotStringSizeInBytes)
+        {
+            return false;
+        }
+
+        str.resize(sizeInBytes);
+        iStream.read(str.data(), sizeInBytes);
+
+        return !iStream.fail();
+    }
+
+
+    cl_int CreateSnapshot(discovery::Snapshot& snapshot)
+    {
+        cl_int                      result    = CL_SUCCESS;
+        std::vector<cl_platform_id> platforms = {};
+
+        if (settings::persistDiscoverySnapshot)
+        {
+            std::optional<discovery::Snapshot> restored = std::nullopt;
+
+            result = discovery::Restore(settings::discoverySnapshotFilePath, restored);
+            OPENCL_RETURN_ON_ERROR(result);
+
+            if (restored.has_value())
+            {
+                DBG_MSG_STD_OUT("Restored discovery snapshot: ", settings::discoverySnapshotFilePath);
+
+                snapshot = std::move(restored.value());
+                return result;
+            }
+        }
+
+        result = platform::GetAllAvailable(platforms);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        snapshot.platforms.resize(platforms.size());
+
+        for (size_t i = 0; i < platforms.size(); i++)
+        {
+            result = QueryPlatformInfo(platforms[i], snapshot.platforms[i]);
+            OPENCL_RETURN_ON_ERROR(result);
+        }
+
+        if (settings::persistDiscoverySnapshot)
+        {
+            discovery::Persist(snapshot, settings::discoverySnapshotFilePath);
+        }
+
+        return result;
+    }
+
+
+    std::once_flag      snapshotCreated = {};
+    discovery::Snapshot snapshot        = {};
+    cl_int              snapshotResult  = CL_SUCCESS;
+
+    // Devices that are not part of the snapshot, such as sub-devices, are described on demand.
+    std::mutex                                                                      extraDevicesMutex = {};
+    std::unordered_map<cl_device_id, std::unique_ptr<const discovery::DeviceInfo>> extraDevices      = {};
+}
+
+
+const discovery::PlatformInfo* discovery::Snapshot::FindPlatform(const cl_platform_id platform) const noexcept
+{
+    for (const PlatformInfo& platformInfo : platforms)
+    {
+        if (platformInfo.id == platform)
+        {
+            return &platformInfo;
+        }
+    }
+
+    return nullptr;
+}
+
+
+const discovery::DeviceInfo* discovery::Snapshot::FindDevice(const cl_device_id device) const noexcept
+{
+    for (const PlatformInfo& platformInfo : platforms)
+    {
+        for (const DeviceInfo& deviceInfo : platformInfo.devices)
+        {
+            if (deviceInfo.id == device)
+            {
+                return &deviceInfo;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+
+cl_int discovery::GetSnapshot(const Snapshot*& pSnapshot)
+{
+    std::call_once(snapshotCreated, []() { snapshotResult = CreateSnapshot(snapshot); });
+
+    pSnapshot = (snapshotResult == CL_SUCCESS) ? &snapshot : nullptr;
+
+    return snapshotResult;
+}
+
+
+cl_int discovery::GetDeviceInfo(const cl_device_id device,
+                                const DeviceInfo*& deviceInfo)
+{
+    cl_int          result    = CL_SUCCESS;
+    const Snapshot* pSnapshot = nullptr;
+
+    result = GetSnapshot(pSnapshot);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    deviceInfo = pSnapshot->FindDevice(device);
+
+    if (deviceInfo != nullptr)
+    {
+        return result;
+    }
+
+    const std::lock_guard lock(extraDevicesMutex);
+
+    auto it = extraDevices.find(device);
+
+    if (it == extraDevices.end())
+    {
+        auto extraDeviceInfo = std::make_unique<DeviceInfo>();
+
+        result = QueryDeviceInfo(device, *extraDeviceInfo);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        it = extraDevices.emplace(device, std::move(extraDeviceInfo)).first;
+    }
+
+    deviceInfo = it->second.get();
+
+    return result;
+}
+
+
+void discovery::Persist(const Snapshot&              snapshot,
+                        const std::filesystem::path& snapshotFilePath)
+{
+    const std::filesystem::path tmpFilePath = file::GetTempPath(snapshotFilePath);
+
+    {
+        std::ofstream snapshotOfStream(tmpFilePath, std::ios_base::out | std::ios_base::trunc);
+
+        snapshotOfStream << SnapshotMagic << ' ' << SnapshotVersion << '\n';
+        snapshotOfStream << snapshot.platforms.size() << '\n';
+
+        for (const PlatformInfo& platformInfo : snapshot.platforms)
+        {
+            WriteString(snapshotOfStream, platformInfo.profile);
+            WriteString(snapshotOfStream, platformInfo.version);
+            WriteString(snapshotOfStream, platformInfo.name);
+            WriteString(snapshotOfStream, platformInfo.vendor);
+
+            snapshotOfStream << platformInfo.devices.size() << '\n';
+
+            for (const DeviceInfo& deviceInfo : platformInfo.devices)
+            {
+                WriteString(snapshotOfStream, deviceInfo.name);
+                WriteString(snapshotOfStream, deviceInfo.vendor);
+                WriteString(snapshotOfStream, deviceInfo.version);
+                WriteString(snapshotOfStream, deviceInfo.driverVersion);
+                WriteString(snapshotOfStream, deviceInfo.openClCVersion);
+                WriteString(snapshotOfStream, deviceInfo.ilVersions);
+                WriteString(snapshotOfStream, deviceInfo.uniqueId);
+
+                snapshotOfStream << deviceInfo.type                      << ' '
+                                 << deviceInfo.maxComputeUnits           << ' '
+                                 << deviceInfo.maxClockFrequencyInMHz    << ' '
+                                 << deviceInfo.addressBits               << ' '
+                                 << deviceInfo.memBaseAddrAlignInBits    << ' '
+                                 << deviceInfo.preferredVectorWidthFloat << ' '
+                                 << deviceInfo.globalMemSizeInBytes      << ' '
+                                 << deviceInfo.globalMemCacheSizeInBytes << ' '
+                                 << deviceInfo.maxMemAllocSizeInBytes    << ' '
+                                 << deviceInfo.localMemSizeInBytes       << ' '
+                                 << deviceInfo.maxWorkGroupSize          << ' '
+                                 << deviceInfo.hostUnifiedMemory         << ' '
+                                 << deviceInfo.maxWorkItemSizes.size();
+
+                for (const size_t maxWorkItemSize : deviceInfo.maxWorkItemSizes)
+                {
+                    snapshotOfStream << ' ' << maxWorkItemSize;
+                }
+
+                snapshotOfStream << '\n';
+            }
+        }
+
+        snapshotOfStream.flush();
+
+        if (snapshotOfStream.fail())
+        {
+            MSG_STD_ERR("Failed to write discovery snapshot: ", tmpFilePath);
+            return;
+        }
+    }
+
+    std::error_code ec = {};
+    std::filesystem::rename(tmpFilePath, snapshotFilePath, ec);
+
+    if (ec)
+    {
+        MSG_STD_ERR("Failed to persist discovery snapshot ", snapshotFilePath, ": ", ec.message());
+        std::filesystem::remove(tmpFilePath, ec);
+    }
+}
+
+
+// Platform and device handles are only meaningful within a process, so a persisted snapshot is matched against
+// the handles enumerated now. It is only trusted when the platform and device counts match, and each device still
+// has the unique ID and work-item dimensions recorded for it; otherwise the hardware or driver changed, or the
+// snapshot is corrupted, and a full probe follows. Counts are validated before anything is sized from them.
+cl_int discovery::Restore(const std::filesystem::path& snapshotFilePath,
+                          std::optional<Snapshot>&     snapshot)
+{
+    snapshot.reset();
+
+    cl_int                      result    = CL_SUCCESS;
+    std::vector<cl_platform_id> platforms = {};
+    std::ifstream               snapshotIfStream(snapshotFilePath);
+
+    if (!snapshotIfStream.is_open())
+    {
+        return result;
+    }
+
+    std::string magic      = {};
+    uint32_t    version    = 0;
+    size_t      nPlatforms = 0;
+
+    snapshotIfStream >> magic >> version >> nPlatforms;
+
+    if (snapshotIfStream.fail() || magic != SnapshotMagic || version != SnapshotVersion)
+    {
+        return result;
+    }
+
+    result = platform::GetAllAvailable(platforms);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    if (platforms.size() != nPlatforms)
+    {
+        return result;
+    }
+
+    Snapshot restored = {};
+    restored.platforms.resize(nPlatforms);
+
+    for (size_t i = 0; i < nPlatforms; i++)
+    {
+        PlatformInfo&  platformInfo = restored.platforms[i];
+        std::vector<cl_device_id> devices      = {};
+        size_t                    nDevices     = 0;
+
+        snapshotIfStream >> std::ws;
+
+        if (!ReadString(snapshotIfStream, platformInfo.profile) ||
+            !ReadString(snapshotIfStream, platformInfo.version) ||
+            !ReadString(snapshotIfStream, platformInfo.name)    ||
+            !ReadString(snapshotIfStream, platformInfo.vendor)  ||
+            !(snapshotIfStream >> nDevices))
+        {
+            return result;
+        }
+
+        platformInfo.id           = platforms[i];
+        platformInfo.isConformant = (platformInfo.profile == required::PlatformProfile);
+
+        result = device::GetAllAvailable(platforms[i], devices);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        if (devices.size() != nDevices)
+        {
+            return result;
+        }
+
+        platformInfo.devices.resize(nDevices);
+
+        for (size_t j = 0; j < nDevices; j++)
+        {
+            DeviceInfo& deviceInfo     = platformInfo.devices[j];
+            size_t                 nWorkItemSizes = 0;
+
+            snapshotIfStream >> std::ws;
+
+            if (!ReadString(snapshotIfStream, deviceInfo.name)           ||
+                !ReadString(snapshotIfStream, deviceInfo.vendor)         ||
+                !ReadString(snapshotIfStream, deviceInfo.version)        ||
+                !ReadString(snapshotIfStream, deviceInfo.driverVersion)  ||
+                !ReadString(snapshotIfStream, deviceInfo.openClCVersion) ||
+                !ReadString(snapshotIfStream, deviceInfo.ilVersions)     ||
+                !ReadString(snapshotIfStream, deviceInfo.uniqueId))
+            {
+                return result;
+            }
+
+            // The unique ID covers the name, vendor, version and driver version of the device.
+            std::string uniqueId        = {};
+            cl_uint     maxWorkItemDims = 0;
+
+            result = device::GetUniqueId(devices[j], uniqueId);
+            OPENCL_RETURN_ON_ERROR(result);
+            result = device::QueryParamValue(devices[j], CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS, maxWorkItemDims);
+            OPENCL_RETURN_ON_ERROR(result);
+
+            if (uniqueId != deviceInfo.uniqueId)
+            {
+                return result;
+            }
+
+            snapshotIfStream >> deviceInfo.type
+                             >> deviceInfo.maxComputeUnits
+                             >> deviceInfo.maxClockFrequencyInMHz
+                             >> deviceInfo.addressBits
+                             >> deviceInfo.memBaseAddrAlignInBits
+                             >> deviceInfo.preferredVectorWidthFloat
+                             >> deviceInfo.globalMemSizeInBytes
+                             >> deviceInfo.globalMemCacheSizeInBytes
+                             >> deviceInfo.maxMemAllocSizeInBytes
+                             >> deviceInfo.localMemSizeInBytes
+                             >> deviceInfo.maxWorkGroupSize
+                             >> deviceInfo.hostUnifiedMemory
+                             >> nWorkItemSizes;
+
+            if (snapshotIfStream.fail() || nWorkItemSizes != maxWorkItemDims)
+            {
+                return result;
+            }
+
+            deviceInfo.maxWorkItemSizes.resize(nWorkItemSizes);
+
+            for (size_t& maxWorkItemSize : deviceInfo.maxWorkItemSizes)
+            {
+                snapshotIfStream >> maxWorkItemSize;
+            }
+
+            if (snapshotIfStream.fail())
+            {
+                return result;
+            }
+
+            deviceInfo.id = devices[j];
+        }
+    }
+
+    snapshot = std::move(restored);
+
+    return result;
+}
\ No newline at end of file
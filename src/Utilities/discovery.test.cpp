@@ -0,0 +1,215 @@
+#include "discovery.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+
+namespace
+{
+    void ExpectEqual(const discovery::DeviceInfo& expected,
+                     const discovery::DeviceInfo& actual)
+    {
+        EXPECT_EQ(expected.id, actual.id);
+        EXPECT_EQ(expected.type, actual.type);
+        EXPECT_EQ(expected.name, actual.name);
+        EXPECT_EQ(expected.vendor, actual.vendor);
+        EXPECT_EQ(expected.version, actual.version);
+        EXPECT_EQ(expected.driverVersion, actual.driverVersion);
+        EXPECT_EQ(expected.openClCVersion, actual.openClCVersion);
+        EXPECT_EQ(expected.ilVersions, actual.ilVersions);
+        EXPECT_EQ(expected.uniqueId, actual.uniqueId);
+        EXPECT_EQ(expected.maxComputeUnits, actual.maxComputeUnits);
+        EXPECT_EQ(expected.maxClockFrequencyInMHz, actual.maxClockFrequencyInMHz);
+        EXPECT_EQ(expected.addressBits, actual.addressBits);
+        EXPECT_EQ(expected.memBaseAddrAlignInBits, actual.memBaseAddrAlignInBits);
+        EXPECT_EQ(expected.preferredVectorWidthFloat, actual.preferredVectorWidthFloat);
+        EXPECT_EQ(expected.globalMemSizeInBytes, actual.globalMemSizeInBytes);
+        EXPECT_EQ(expected.globalMemCacheSizeInBytes, actual.globalMemCacheSizeInBytes);
+        EXPECT_EQ(expected.maxMemAllocSizeInBytes, actual.maxMemAllocSizeInBytes);
+        EXPECT_EQ(expected.localMemSizeInBytes, actual.localMemSizeInBytes);
+        EXPECT_EQ(expected.maxWorkGroupSize, actual.maxWorkGroupSize);
+        EXPECT_EQ(expected.maxWorkItemSizes, actual.maxWorkItemSizes);
+        EXPECT_EQ(expected.hostUnifiedMemory, actual.hostUnifiedMemory);
+    }
+
+
+    // The device to alter, if any platform has one.
+    discovery::DeviceInfo* FindFirstDevice(discovery::Snapshot& snapshot)
+    {
+        for (discovery::PlatformInfo& platformInfo : snapshot.platforms)
+        {
+            if (!platformInfo.devices.empty())
+            {
+                return &platformInfo.devices.front();
+            }
+        }
+
+        return nullptr;
+    }
+
+
+    void ExpectEqual(const discovery::Snapshot& expected,
+                     const discovery::Snapshot& actual)
+    {
+        ASSERT_EQ(expected.platforms.size(), actual.platforms.size());
+
+        for (size_t i = 0; i < expected.platforms.size(); i++)
+        {
+            const discovery::PlatformInfo& expectedPlatform = expected.platforms[i];
+            const discovery::PlatformInfo& actualPlatform   = actual.platforms[i];
+
+            EXPECT_EQ(expectedPlatform.id, actualPlatform.id);
+            EXPECT_EQ(expectedPlatform.profile, actualPlatform.profile);
+            EXPECT_EQ(expectedPlatform.version, actualPlatform.version);
+            EXPECT_EQ(expectedPlatform.name, actualPlatform.name);
+            EXPECT_EQ(expectedPlatform.vendor, actualPlatform.vendor);
+            EXPECT_EQ(expectedPlatform.isConformant, actualPlatform.isConformant);
+
+            ASSERT_EQ(expectedPlatform.devices.size(), actualPlatform.devices.size());
+
+            for (size_t j = 0; j < expectedPlatform.devices.size(); j++)
+            {
+                ExpectEqual(expectedPlatform.devices[j], actualPlatform.devices[j]);
+            }
+        }
+    }
+}
+
+
+// Persists variations of the snapshot of this process, which restoring must match against the live platforms.
+class DiscoveryTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        const cl_int result = discovery::GetSnapshot(m_snapshot);
+
+        if ((result != CL_SUCCESS) || m_snapshot->platforms.empty())
+        {
+            GTEST_SKIP() << "No OpenCL platform is available.";
+        }
+
+        m_snapshotFilePath = std::filesystem::temp_directory_path() /
+                             ("discovery_test_" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()));
+    }
+
+    void TearDown() noexcept override
+    {
+        std::error_code ec = {};
+        std::filesystem::remove(m_snapshotFilePath, ec);
+    }
+
+    std::optional<discovery::Snapshot> PersistAndRestore(const discovery::Snapshot& snapshot) const
+    {
+        std::optional<discovery::Snapshot> restored = std::nullopt;
+
+        discovery::Persist(snapshot, m_snapshotFilePath);
+
+        const cl_int result = discovery::Restore(m_snapshotFilePath, restored);
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        return restored;
+    }
+
+    const discovery::Snapshot* m_snapshot         = nullptr;
+    std::filesystem::path      m_snapshotFilePath = {};
+};
+
+
+TEST_F(DiscoveryTest, RestoresPersistedSnapshots)
+{
+    const std::optional<discovery::Snapshot> restored = PersistAndRestore(*m_snapshot);
+
+    ASSERT_TRUE(restored.has_value());
+    ExpectEqual(*m_snapshot, restored.value());
+}
+
+
+TEST_F(DiscoveryTest, RejectsSnapshotsOfOtherPlatforms)
+{
+    discovery::Snapshot extraPlatform = *m_snapshot;
+    extraPlatform.platforms.push_back(m_snapshot->platforms.front());
+
+    EXPECT_FALSE(PersistAndRestore(extraPlatform).has_value());
+
+    discovery::Snapshot missingPlatform = *m_snapshot;
+    missingPlatform.platforms.pop_back();
+
+    EXPECT_FALSE(PersistAndRestore(missingPlatform).has_value());
+
+    discovery::Snapshot extraDevice = *m_snapshot;
+    extraDevice.platforms.front().devices.push_back({});
+
+    EXPECT_FALSE(PersistAndRestore(extraDevice).has_value());
+}
+
+
+TEST_F(DiscoveryTest, RejectsSnapshotsOfOtherDevices)
+{
+    discovery::Snapshot          otherDevice = *m_snapshot;
+    discovery::DeviceInfo* const deviceInfo  = FindFirstDevice(otherDevice);
+
+    if (deviceInfo == nullptr)
+    {
+        GTEST_SKIP() << "No OpenCL device is available.";
+    }
+
+    // As after a driver update, which changes the unique ID.
+    deviceInfo->uniqueId = "0123456789abcdef";
+
+    EXPECT_FALSE(PersistAndRestore(otherDevice).has_value());
+
+    discovery::Snapshot otherDimensions = *m_snapshot;
+    FindFirstDevice(otherDimensions)->maxWorkItemSizes.push_back(1);
+
+    EXPECT_FALSE(PersistAndRestore(otherDimensions).has_value());
+}
+
+
+TEST_F(DiscoveryTest, RejectsUnreadableSnapshots)
+{
+    std::optional<discovery::Snapshot> restored = std::nullopt;
+    cl_int                             result   = CL_SUCCESS;
+
+    // Without any snapshot yet.
+    result = discovery::Restore(m_snapshotFilePath, restored);
+    EXPECT_EQ(result, CL_SUCCESS);
+    EXPECT_FALSE(restored.has_value());
+
+    discovery::Persist(*m_snapshot, m_snapshotFilePath);
+
+    std::string persisted = {};
+    {
+        std::ifstream      snapshotIfStream(m_snapshotFilePath);
+        std::ostringstream contents = {};
+
+        contents << snapshotIfStream.rdbuf();
+        persisted = std::move(contents).str();
+    }
+
+    const size_t versionEnd = persisted.find('\n');
+    ASSERT_NE(versionEnd, std::string::npos);
+
+    // Written by another version, and cut off while written.
+    const std::string otherVersion = "ClDiscoverySnapshot 0" + persisted.substr(versionEnd);
+    const std::string truncated    = persisted.substr(0, persisted.size() / 2);
+
+    for (const std::string& contents : { otherVersion, truncated })
+    {
+        {
+            std::ofstream snapshotOfStream(m_snapshotFilePath, std::ios_base::out | std::ios_base::trunc);
+            snapshotOfStream << contents;
+        }
+
+        result = discovery::Restore(m_snapshotFilePath, restored);
+        EXPECT_EQ(result, CL_SUCCESS);
+        EXPECT_FALSE(restored.has_value());
+    }
+}
\ No newline at end of file
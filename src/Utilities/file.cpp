@@ -0,0 +1,320 @@
+#include "debug.h"
+#include "file.h"
+
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+
+file::ReadOnlyMapping::~ReadOnlyMapping() noexcept
+{
+    Unmap();
+}
+
+
+file::ReadOnlyMapping::ReadOnlyMapping(ReadOnlyMapping&& other) noexcept
+    : m_pView(std::exchange(other.m_pView, nullptr)),
+      m_sizeInBytes(std::exchange(other.m_sizeInBytes, 0))
+{
+}
+
+
+file::ReadOnlyMapping& file::ReadOnlyMapping::operator=(ReadOnlyMapping&& other) noexcept
+{
+    if (this != &other)
+    {
+        Unmap();
+
+        m_pView       = std::exchange(other.m_pView, nullptr);
+        m_sizeInBytes = std::exchange(other.m_sizeInBytes, 0);
+    }
+
+    return *this;
+}
+
+
+bool file::ReadOnlyMapping::Map(const std::filesystem::path& filePath)
+{
+    Unmap();
+
+#ifdef _WIN32
+    const HANDLE fileHandle = CreateFileW(filePath.c_str(),
+                                          GENERIC_READ,
+                                          FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                          nullptr,
+                                          OPEN_EXISTING,
+                                          FILE_ATTRIBUTE_NORMAL,
+                                          nullptr);
+
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        MSG_STD_ERR("Failed to open file for mapping: ", filePath);
+        return false;
+    }
+
+    LARGE_INTEGER fileSizeInBytes = {};
+
+    if (!GetFileSizeEx(fileHandle, &fileSizeInBytes))
+    {
+        MSG_STD_ERR("Failed to determine size in bytes of file: ", filePath);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    // Empty files cannot be mapped, but are trivially viewable.
+    if (fileSizeInBytes.QuadPart == 0)
+    {
+        CloseHandle(fileHandle);
+        return true;
+    }
+
+    const HANDLE mappingHandle = CreateFileMappingW(fileHandle,
+                                                    nullptr,
+                                                    PAGE_READONLY,
+                                                    0,
+                                                    0,
+                                                    nullptr);
+
+    // The view keeps the file alive, so neither handle is needed beyond this point.
+    CloseHandle(fileHandle);
+
+    if (mappingHandle == nullptr)
+    {
+        MSG_STD_ERR("Failed to create file mapping for file: ", filePath);
+        return false;
+    }
+
+    m_pView = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mappingHandle);
+
+    if (m_pView == nullptr)
+    {
+        MSG_STD_ERR("Failed to map view of file: ", filePath);
+        return false;
+    }
+
+    m_sizeInBytes = static_cast<size_t>(fileSizeInBytes.QuadPart);
+#else
+    const int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+    {
+        MSG_STD_ERR("Failed to open file for mapping: ", filePath);
+        return false;
+    }
+
+    struct stat fileStatus = {};
+
+    if (fstat(fd, &fileStatus) == -1)
+    {
+        MSG_STD_ERR("Failed to determine size in bytes of file: ", filePath);
+        close(fd);
+        return false;
+    }
+
+    // Empty files cannot be mapped, but are trivially viewable.
+    if (fileStatus.st_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    void* const pView = mmap(nullptr,
+                             static_cast<size_t>(fileStatus.st_size),
+                             PROT_READ,
+                             MAP_SHARED,
+                             fd,
+                             0);
+
+    // The mapping keeps the file alive, so the descriptor is not needed beyond this point.
+    close(fd);
+
+    if (pView == MAP_FAILED)
+    {
+        MSG_STD_ERR("Failed to map file: ", filePath);
+        return false;
+    }
+
+    m_pView       = pView;
+    m_sizeInBytes = static_cast<size_t>(fileStatus.st_size);
+#endif // _WIN32
+
+    return true;
+}
+
+
+void file::ReadOnlyMapping::Unmap() noexcept
+{
+    if (m_pView != nullptr)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_pView);
+#else
+        munmap(m_pView, m_sizeInBytes);
+#endif // _WIN32
+    }
+
+    m_pView       = nullptr;
+    m_sizeInBytes = 0;
+}
+
+
+std::span<const std::byte> file::ReadOnlyMapping::View() const noexcept
+{
+    return { static_cast<const std::byte*>(m_pView), m_sizeInBytes };
+}
+
+
+file::ExclusiveLock::~ExclusiveLock() noexcept
+{
+    Release();
+}
+
+
+bool file::ExclusiveLock::Acquire(const std::filesystem::path& lockFilePath)
+{
+    Release();
+
+#ifdef _WIN32
+    const HANDLE handle = CreateFileW(lockFilePath.c_str(),
+                                      GENERIC_READ | GENERIC_WRITE,
+                                      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                      nullptr,
+                                      OPEN_ALWAYS,
+                                      FILE_ATTRIBUTE_NORMAL,
+                                      nullptr);
+
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        MSG_STD_ERR("Failed to open lock file: ", lockFilePath);
+        return false;
+    }
+
+    OVERLAPPED overlapped = {};
+
+    if (!LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped))
+    {
+        MSG_STD_ERR("Failed to lock file: ", lockFilePath);
+        CloseHandle(handle);
+        return false;
+    }
+
+    m_handle = handle;
+#else
+    const int fd = open(lockFilePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+    if (fd == -1)
+    {
+        MSG_STD_ERR("Failed to open lock file: ", lockFilePath);
+        return false;
+    }
+
+    if (flock(fd, LOCK_EX) == -1)
+    {
+        MSG_STD_ERR("Failed to lock file: ", lockFilePath);
+        close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+#endif // _WIN32
+
+    return true;
+}
+
+
+void file::ExclusiveLock::Release() noexcept
+{
+#ifdef _WIN32
+    if (m_handle != nullptr)
+    {
+        OVERLAPPED overlapped = {};
+
+        UnlockFileEx(m_handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+        CloseHandle(m_handle);
+
+        m_handle = nullptr;
+    }
+#else
+    if (m_fd != -1)
+    {
+        flock(m_fd, LOCK_UN);
+        close(m_fd);
+
+        m_fd = -1;
+    }
+#endif // _WIN32
+}
+
+
+bool file::FlushToDisk(const std::filesystem::path& filePath)
+{
+#ifdef _WIN32
+    const HANDLE handle = CreateFileW(filePath.c_str(),
+                                      GENERIC_WRITE,
+                                      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                      nullptr,
+                                      OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL,
+                                      nullptr);
+
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        MSG_STD_ERR("Failed to open file to flush: ", filePath);
+        return false;
+    }
+
+    const bool isFlushed = FlushFileBuffers(handle) != 0;
+
+    CloseHandle(handle);
+#else
+    const int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+    {
+        MSG_STD_ERR("Failed to open file to flush: ", filePath);
+        return false;
+    }
+
+    const bool isFlushed = fsync(fd) == 0;
+
+    close(fd);
+#endif // _WIN32
+
+    if (!isFlushed)
+    {
+        MSG_STD_ERR("Failed to flush file to disk: ", filePath);
+    }
+
+    return isFlushed;
+}
+
+
+std::filesystem::path file::GetTempPath(const std::filesystem::path& filePath)
+{
+#ifdef _WIN32
+    const unsigned long processId = GetCurrentProcessId();
+#else
+    const long processId = static_cast<long>(getpid());
+#endif // _WIN32
+
+    std::filesystem::path tmpFilePath = filePath;
+    tmpFilePath += "." + std::to_string(processId) + ".tmp";
+
+    return tmpFilePath;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "json.h"
+
+
+void json::WriteString(std::ostream&          oStream,
+                       const std::string_view string)
+{
+    constexpr std::string_view HexDigits = "0123456789abcdef";
+
+    oStream << '"';
+
+    for (const char character : string)
+    {
+        const unsigned char code = static_cast<unsigned char>(character);
+
+        switch (character)
+        {
+        case '"':  oStream << "\\\""; break;
+        case '\\': oStream << "\\\\"; break;
+        default:
+            // JSON forbids control characters inside strings.
+            if (code < 0x20)
+            {
+                oStream << "\\u00" << HexDigits[code >> 4] << HexDigits[code & 0xF];
+            }
+            else
+            {
+                oStream << character;
+            }
+        }
+    }
+
+    oStream << '"';
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef UTILITIES_JSON_H
+#define UTILITIES_JSON_H
+
+#include <ostream>
+#include <string_view>
+
+
+namespace json
+{
+    // Writes `string` quoted, escaping quotes, backslashes and every control character, e.g. "\u000a" for a line feed.
+    void WriteString(std::ostream&    oStream,
+                     std::string_view string);
+}
+
+
+#endif // UTILITIES_JSON_H
\ No newline at end of file
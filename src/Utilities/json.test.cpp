@@ -0,0 +1,53 @@
+#include "json.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <string_view>
+
+
+namespace
+{
+    std::string WriteString(const std::string_view string)
+    {
+        std::ostringstream oStream = {};
+
+        json::WriteString(oStream, string);
+
+        return std::move(oStream).str();
+    }
+}
+
+
+TEST(Json, EscapesQuotesAndBackslashes)
+{
+    EXPECT_EQ(WriteString(""), "\"\"");
+    EXPECT_EQ(WriteString("plain text"), "\"plain text\"");
+    EXPECT_EQ(WriteString("say \"hi\""), "\"say \\\"hi\\\"\"");
+    EXPECT_EQ(WriteString("C:\\path\\"), "\"C:\\\\path\\\\\"");
+}
+
+
+TEST(Json, EscapesEveryControlCharacter)
+{
+    for (int code = 0; code < 0x20; code++)
+    {
+        const char        character = static_cast<char>(code);
+        std::stringstream expected  = {};
+
+        expected << "\"\\u00" << std::hex << (code >> 4) << (code & 0xF) << "\"";
+
+        EXPECT_EQ(WriteString({ &character, 1 }), expected.str()) << "Control character " << code;
+    }
+
+    EXPECT_EQ(WriteString("a\nb\tc\r"), "\"a\\u000ab\\u0009c\\u000d\"");
+}
+
+
+TEST(Json, KeepsOtherCharacters)
+{
+    // Printable ASCII, DEL and the bytes of UTF-8 sequences are all valid inside JSON strings.
+    EXPECT_EQ(WriteString(" ~\x7F"), "\" ~\x7F\"");
+    EXPECT_EQ(WriteString("\xC3\xA9t\xC3\xA9"), "\"\xC3\xA9t\xC3\xA9\"");
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "debug.h"
+#include "device.h"
+#include "kernel.h"
+#include "program.h"
+#include "tracing.h"
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+
+namespace
+{
+    // Pools are told apart by an ID that is never reused, unlike their addresses. Entries of destroyed pools thus
+    // linger harmlessly in the maps of threads that used them.
+    std::atomic<uint64_t> nextPoolId = 0;
+
+
+    std::unordered_map<uint64_t, const kernel::Pool::Instance*>& GetThreadInstances()
+    {
+        thread_local std::unordered_map<uint64_t, const kernel::Pool::Instance*> threadInstances = {};
+
+        return threadInstances;
+    }
+
+
+    cl_int SupportsClone(const cl_program program,
+                         bool&            supportsClone)
+    {
+        supportsClone = false;
+
+        cl_int                    result  = CL_SUCCESS;
+        std::vector<cl_device_id> devices = {};
+
+        result = program::GetDevices(program, devices);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        for (const cl_device_id device : devices)
+        {
+            cl_uint major = 0;
+            cl_uint minor = 0;
+
+            result = device::GetOpenClVersion(device, major, minor);
+            OPENCL_RETURN_ON_ERROR(result);
+
+            if ((major < 2) || ((major == 2) && (minor < 1)))
+            {
+                return result;
+            }
+        }
+
+        supportsClone = true;
+
+        return result;
+    }
+}
+
+
+cl_int kernel::SetArgs(const cl_kernel            kernel,
+                       const std::span<const Arg> args)
+{
+    cl_int result = CL_SUCCESS;
+
+    for (const Arg& arg : args)
+    {
+        result = clSetKernelArg(kernel,
+                                arg.index,
+                                arg.sizeInBytes,
+                                arg.pValue);
+
+        OPENCL_RETURN_ON_ERROR(result);
+    }
+
+    return result;
+}
+
+
+cl_int kernel::Clone(const cl_kernel kernel,
+                     cl_kernel&      clone)
+{
+    cl_int      result        = CL_SUCCESS;
+    cl_program  program       = nullptr;
+    bool        supportsClone = false;
+    std::string functionName  = {};
+    size_t      sizeInBytes   = 0;
+
+    result = clGetKernelInfo(kernel,
+                             CL_KERNEL_PROGRAM,
+                             sizeof(program),
+                             &program,
+                             nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = SupportsClone(program, supportsClone);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    if (supportsClone)
+    {
+        clone = clCloneKernel(kernel, &result);
+        OPENCL_PRINT_ON_ERROR(result);
+
+        return result;
+    }
+
+    result = clGetKernelInfo(kernel,
+                             CL_KERNEL_FUNCTION_NAME,
+                             0,
+                             nullptr,
+                             &sizeInBytes);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // `sizeInBytes` includes the NULL terminator, hence "-1".
+    functionName.resize(sizeInBytes - 1);
+
+    result = clGetKernelInfo(kernel,
+                             CL_KERNEL_FUNCTION_NAME,
+                             sizeInBytes,
+                             functionName.data(),
+                             nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    clone = clCreateKernel(program, functionName.c_str(), &result);
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
+
+
+kernel::Pool::Pool(const cl_kernel                  prototype,
+                   const cl_device_id               device,
+                   std::vector<cl_queue_properties> queueProperties) :
+    m_id(nextPoolId++),
+    m_prototype(prototype),
+    m_device(device),
+    m_queueProperties(std::move(queueProperties))
+{
+}
+
+
+kernel::Pool::~Pool() noexcept
+{
+    for (const std::unique_ptr<Instance>& instance : m_instances)
+    {
+        clReleaseCommandQueue(instance->queue);
+        clReleaseKernel(instance->kernel);
+    }
+}
+
+
+cl_int kernel::Pool::Acquire(const Instance*& instance)
+{
+    auto&      threadInstances = GetThreadInstances();
+    const auto threadInstance  = threadInstances.find(m_id);
+
+    if (threadInstance != threadInstances.end())
+    {
+        instance = threadInstance->second;
+        return CL_SUCCESS;
+    }
+
+    cl_int                    result      = CL_SUCCESS;
+    cl_context                context     = nullptr;
+    std::unique_ptr<Instance> newInstance = std::make_unique<Instance>(Instance{ .kernel = nullptr, .queue = nullptr });
+
+    result = clGetKernelInfo(m_prototype,
+                             CL_KERNEL_CONTEXT,
+                             sizeof(context),
+                             &context,
+                             nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    newInstance->queue = clCreateCommandQueueWithProperties(context,
+                                                            m_device,
+                                                            m_queueProperties.empty() ? nullptr
+                                                                                      : m_queueProperties.data(),
+                                                            &result);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    {
+        // Cloning reads the arguments of the prototype, and `clCloneKernel` is not thread-safe for the same kernel.
+        const std::lock_guard lock(m_mutex);
+
+        result = Clone(m_prototype, newInstance->kernel);
+
+        if (result != CL_SUCCESS)
+        {
+            OPENCL_PRINT_ON_ERROR(result);
+            clReleaseCommandQueue(newInstance->queue);
+
+            return result;
+        }
+
+        instance = newInstance.get();
+        m_instances.push_back(std::move(newInstance));
+    }
+
+    threadInstances.emplace(m_id, instance);
+
+    return result;
+}
+
+
+size_t kernel::Pool::GetInstanceCount() const
+{
+    const std::lock_guard lock(m_mutex);
+
+    return m_instances.size();
+}
\ No newline at end of file
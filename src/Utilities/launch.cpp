@@ -0,0 +1,292 @@
+#include "debug.h"
+#include "discovery.h"
+#include "launch.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+namespace
+{
+    // Typical residency limits of a GPU compute unit, e.g. 16 to 32 work-groups and 1536 to 2560 work-items on
+    // recent NVIDIA and AMD hardware. They only steer the choice of size; devices enforce their own limits.
+    constexpr size_t MaxResidentWorkGroupsPerComputeUnit = 16;
+    constexpr size_t MaxResidentWorkItemsPerComputeUnit  = 2048;
+
+
+    size_t RoundUp(const size_t value,
+                   const size_t multiple) noexcept
+    {
+        return ((value + multiple - 1) / multiple) * multiple;
+    }
+
+
+    // On most GPUs, local memory and the private memory a compiler spills share the on-chip memory of a compute unit,
+    // so their footprint bounds how many work-groups are resident at once. None are when one alone does not fit.
+    size_t GetResidentWorkItems(const launch::KernelResources& resources,
+                                const size_t                   localWorkSize) noexcept
+    {
+        const cl_ulong footprintInBytes = resources.localMemSizeInBytes + (resources.privateMemSizeInBytes * localWorkSize);
+        cl_ulong       residentGroups   = MaxResidentWorkGroupsPerComputeUnit;
+
+        if ((footprintInBytes > 0) && (resources.deviceLocalMemSizeInBytes > 0))
+        {
+            residentGroups = std::min<cl_ulong>(resources.deviceLocalMemSizeInBytes / footprintInBytes,
+                                                MaxResidentWorkGroupsPerComputeUnit);
+        }
+
+        return std::min<size_t>(static_cast<size_t>(residentGroups) * localWorkSize, MaxResidentWorkItemsPerComputeUnit);
+    }
+}
+
+
+cl_int launch::QueryKernelResources(const cl_kernel    kernel,
+                                    const cl_device_id device,
+                                    KernelResources&   resources)
+{
+    cl_int                       result     = CL_SUCCESS;
+    const discovery::DeviceInfo* deviceInfo = nullptr;
+
+    resources = {};
+
+    result = clGetKernelWorkGroupInfo(kernel,
+                                      device,
+                                      CL_KERNEL_WORK_GROUP_SIZE,
+                                      sizeof(resources.maxWorkGroupSize),
+                                      &resources.maxWorkGroupSize,
+                                      nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = clGetKernelWorkGroupInfo(kernel,
+                                      device,
+                                      CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE,
+                                      sizeof(resources.preferredWorkGroupSizeMultiple),
+                                      &resources.preferredWorkGroupSizeMultiple,
+                                      nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = clGetKernelWorkGroupInfo(kernel,
+                                      device,
+                                      CL_KERNEL_LOCAL_MEM_SIZE,
+                                      sizeof(resources.localMemSizeInBytes),
+                                      &resources.localMemSizeInBytes,
+                                      nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = clGetKernelWorkGroupInfo(kernel,
+                                      device,
+                                      CL_KERNEL_PRIVATE_MEM_SIZE,
+                                      sizeof(resources.privateMemSizeInBytes),
+                                      &resources.privateMemSizeInBytes,
+                                      nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // Device properties come from discovery, which queried them once.
+    result = discovery::GetDeviceInfo(device, deviceInfo);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    resources.deviceLocalMemSizeInBytes = deviceInfo->localMemSizeInBytes;
+    resources.computeUnits              = deviceInfo->maxComputeUnits;
+    resources.maxWorkItemSize           = deviceInfo->maxWorkItemSizes.empty() ? resources.maxWorkGroupSize
+                                                                               : deviceInfo->maxWorkItemSizes.front();
+
+    return result;
+}
+
+
+size_t launch::ChooseLocalWorkSize(const KernelResources& resources,
+                                   const size_t           nWorkItems) noexcept
+{
+    const size_t maxLocalWorkSize = std::max<size_t>(std::min(resources.maxWorkGroupSize, resources.maxWorkItemSize), 1);
+    const size_t granule          = std::clamp<size_t>(resources.preferredWorkGroupSizeMultiple, 1, maxLocalWorkSize);
+
+    // Ties go to the narrower size, which spreads the same residency over more work-groups.
+    size_t localWorkSize     = granule;
+    size_t residentWorkItems = GetResidentWorkItems(resources, granule);
+
+    for (size_t candidate = 2 * granule;
+         (candidate <= maxLocalWorkSize) && (residentWorkItems < MaxResidentWorkItemsPerComputeUnit);
+         candidate += granule)
+    {
+        const size_t candidateResidentWorkItems = GetResidentWorkItems(resources, candidate);
+
+        if (candidateResidentWorkItems > residentWorkItems)
+        {
+            localWorkSize     = candidate;
+            residentWorkItems = candidateResidentWorkItems;
+        }
+    }
+
+    // Every compute unit should get a work-group before any gets a wide one.
+    if (resources.computeUnits > 0)
+    {
+        const size_t workItemsPerComputeUnit = (nWorkItems / resources.computeUnits) +
+                                               ((nWorkItems % resources.computeUnits) != 0);
+
+        if (workItemsPerComputeUnit < localWorkSize)
+        {
+            localWorkSize = std::max(granule, RoundUp(workItemsPerComputeUnit, granule));
+        }
+    }
+
+    return localWorkSize;
+}
+
+
+launch::Config launch::Plan(const KernelResources& resources,
+                            const size_t           nWorkItems) noexcept
+{
+    const size_t localWorkSize = ChooseLocalWorkSize(resources, nWorkItems);
+
+    return
+    {
+        .localWorkSize  = localWorkSize,
+        .globalWorkSize = RoundUp(nWorkItems, localWorkSize)
+    };
+}
+
+
+std::vector<launch::Range> launch::Split(const size_t count,
+                                        const size_t multiple,
+                                        const size_t maxCountPerRange)
+{
+    const size_t       granule       = std::max<size_t>(multiple, 1);
+    const size_t       countPerRange = std::max(granule, maxCountPerRange - (maxCountPerRange % granule));
+    std::vector<Range> ranges        = {};
+
+    ranges.reserve((count / countPerRange) + 1);
+
+    for (size_t offset = 0; offset < count; offset += countPerRange)
+    {
+        ranges.push_back(
+        {
+            .offset = offset,
+            .count  = std::min(countPerRange, count - offset)
+        });
+    }
+
+    return ranges;
+}
+
+
+cl_int launch::Plan(const cl_kernel    kernel,
+                    const cl_device_id device,
+                    const size_t       nWorkItems,
+                    Config&            config)
+{
+    cl_int          result    = CL_SUCCESS;
+    KernelResources resources = {};
+
+    result = QueryKernelResources(kernel, device, resources);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    config = Plan(resources, nWorkItems);
+
+    return result;
+}
+
+
+cl_int launch::EnqueueNdRanges(const cl_command_queue          queue,
+                               const cl_kernel                 kernel,
+                               const std::span<const NdRange>  ndRanges,
+                               const std::span<const cl_event> eventsToWaitOn,
+                               cl_event&                       complete)
+{
+    cl_int                result   = CL_SUCCESS;
+    std::vector<cl_event> launches = {};
+
+    launches.reserve(ndRanges.size());
+
+    for (const NdRange& ndRange : ndRanges)
+    {
+        cl_event launched = nullptr;
+
+        // A single launch completes the problem by itself.
+        result = clEnqueueNDRangeKernel(queue,
+                                        kernel,
+                                        1,
+                                        &ndRange.globalWorkOffset,
+                                        &ndRange.globalWorkSize,
+                                        &ndRange.localWorkSize,
+                                        static_cast<cl_uint>(eventsToWaitOn.size()),
+                                        eventsToWaitOn.data(),
+                                        (ndRanges.size() == 1) ? &complete : &launched);
+
+        if (result != CL_SUCCESS)
+        {
+            break;
+        }
+
+        if (launched != nullptr)
+        {
+            launches.push_back(launched);
+        }
+    }
+
+    if ((result == CL_SUCCESS) && (ndRanges.size() != 1))
+    {
+        const std::span<const cl_event> completeAfter = launches.empty() ? eventsToWaitOn
+                                                                         : std::span<const cl_event>(launches);
+
+        result = clEnqueueMarkerWithWaitList(queue,
+                                             static_cast<cl_uint>(completeAfter.size()),
+                                             completeAfter.data(),
+                                             &complete);
+    }
+
+    for (const cl_event launched : launches)
+    {
+        clReleaseEvent(launched);
+    }
+
+    OPENCL_PRINT_ON_ERROR(result);
+    return result;
+}
+
+
+cl_int launch::EnqueueSplit(const cl_command_queue          queue,
+                            const cl_kernel                 kernel,
+                            const size_t                    nWorkItems,
+                            const size_t                    localWorkSize,
+                            const std::span<const cl_event> eventsToWaitOn,
+                            cl_event&                       complete)
+{
+    return EnqueueSplit(queue,
+                        kernel,
+                        nWorkItems,
+                        localWorkSize,
+                        MaxWorkItemsPerLaunch,
+                        eventsToWaitOn,
+                        complete);
+}
+
+
+cl_int launch::EnqueueSplit(const cl_command_queue          queue,
+                            const cl_kernel                 kernel,
+                            const size_t                    nWorkItems,
+                            const size_t                    localWorkSize,
+                            const size_t                    maxWorkItemsPerLaunch,
+                            const std::span<const cl_event> eventsToWaitOn,
+                            cl_event&                       complete)
+{
+    assert(localWorkSize > 0);
+
+    std::vector<NdRange> ndRanges = {};
+
+    for (const Range& range : Split(nWorkItems, localWorkSize, std::min(maxWorkItemsPerLaunch, MaxWorkItemsPerLaunch)))
+    {
+        ndRanges.push_back(
+        {
+            .globalWorkOffset = range.offset,
+            .globalWorkSize   = RoundUp(range.count, localWorkSize),
+            .localWorkSize    = localWorkSize
+        });
+    }
+
+    return EnqueueNdRanges(queue, kernel, ndRanges, eventsToWaitOn, complete);
+}
\ No newline at end of file
@@ -0,0 +1,376 @@
+#include "context.h"
+#include "launch.h"
+#include "program.h"
+#include "program_types.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+    constexpr size_t TwoToThe31 = size_t(1) << 31;
+    constexpr size_t TwoToThe32 = size_t(1) << 32;
+
+    constexpr std::array<size_t, 9> BoundaryCounts =
+    {
+        TwoToThe31 - 1, TwoToThe31, TwoToThe31 + 1,
+        TwoToThe32 - 1, TwoToThe32, TwoToThe32 + 1,
+        (2 * TwoToThe32) - 1, 2 * TwoToThe32, (3 * TwoToThe32) + 5
+    };
+
+    constexpr launch::KernelResources GpuLikeResources =
+    {
+        .maxWorkGroupSize               = 1024,
+        .preferredWorkGroupSizeMultiple = 32,
+        .localMemSizeInBytes            = 0,
+        .privateMemSizeInBytes          = 0,
+        .deviceLocalMemSizeInBytes      = 48 * 1024,
+        .computeUnits                   = 80,
+        .maxWorkItemSize                = 1024
+    };
+
+
+    // `probe` reserves a known amount of local memory, so its reported footprint can be checked. `count` counts the
+    // launches covering each work-item, which every launch of a split must add to exactly once.
+    constexpr std::string_view ProbeSource = R"(
+        kernel void probe(global float* out)
+        {
+            local float scratch[256];
+
+            scratch[get_local_id(0) % 256] = (float)get_local_id(0);
+            barrier(CLK_LOCAL_MEM_FENCE);
+            out[get_global_id(0)] = scratch[(get_local_id(0) + 1) % 256];
+        }
+
+        kernel void count(global uint* counts)
+        {
+            counts[get_global_id(0)] += 1;
+        }
+    )";
+
+    const std::array<const std::string, 2> ProbeKernelNames = { "probe", "count" };
+
+
+    void ExpectContiguousCover(const std::vector<launch::Range>& ranges,
+                               const size_t                      count,
+                               const size_t                      multiple,
+                               const size_t                      maxCountPerRange)
+    {
+        size_t offset = 0;
+
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+            EXPECT_EQ(ranges[i].offset, offset);
+            EXPECT_GT(ranges[i].count, size_t(0));
+            EXPECT_LE(ranges[i].count, maxCountPerRange);
+
+            if (i + 1 < ranges.size())
+            {
+                EXPECT_EQ(ranges[i].count % multiple, size_t(0));
+            }
+
+            offset += ranges[i].count;
+        }
+
+        EXPECT_EQ(offset, count);
+    }
+}
+
+
+TEST(Launch, SplitsWorkItemsAtTheLaunchLimit)
+{
+    for (const size_t localWorkSize : { size_t(1), size_t(64), size_t(256), size_t(1000) })
+    {
+        const size_t maxWorkItemsPerRange = launch::MaxWorkItemsPerLaunch - (launch::MaxWorkItemsPerLaunch % localWorkSize);
+
+        for (const size_t nWorkItems : BoundaryCounts)
+        {
+            const std::vector<launch::Range> ranges = launch::Split(nWorkItems, localWorkSize, launch::MaxWorkItemsPerLaunch);
+
+            ExpectContiguousCover(ranges, nWorkItems, localWorkSize, launch::MaxWorkItemsPerLaunch);
+
+            EXPECT_EQ(ranges.size(), (nWorkItems + maxWorkItemsPerRange - 1) / maxWorkItemsPerRange) <<
+                nWorkItems << " work-items in work-groups of " << localWorkSize;
+
+            // Rounding the last launch up to whole work-groups must not push it past the limit either.
+            const size_t lastWorkItems = ranges.back().count;
+            const size_t lastRoundedUp = lastWorkItems + ((localWorkSize - (lastWorkItems % localWorkSize)) % localWorkSize);
+
+            EXPECT_LE(lastRoundedUp, launch::MaxWorkItemsPerLaunch);
+        }
+    }
+}
+
+
+TEST(Launch, SplitsElementsAtTheAllocationLimit)
+{
+    constexpr size_t PageInElements = 4096 / sizeof(float);
+
+    for (const size_t maxAllocSizeInBytes : { TwoToThe31, TwoToThe32, TwoToThe32 + 12345 })
+    {
+        const size_t maxElementsPerBuffer = maxAllocSizeInBytes / sizeof(float);
+
+        for (const size_t nElements : BoundaryCounts)
+        {
+            const std::vector<launch::Range> parts = launch::Split(nElements, PageInElements, maxElementsPerBuffer);
+
+            ExpectContiguousCover(parts, nElements, PageInElements, maxElementsPerBuffer);
+        }
+    }
+}
+
+
+TEST(Launch, SplitsEdgeCases)
+{
+    EXPECT_TRUE(launch::Split(0, 64, 1024).empty());
+
+    const std::vector<launch::Range> whole = launch::Split(1000, 64, 1024);
+
+    ASSERT_EQ(whole.size(), size_t(1));
+    EXPECT_EQ(whole.front().count, size_t(1000));
+
+    // A limit below the multiple still yields ranges of one multiple each.
+    const std::vector<launch::Range> narrow = launch::Split(100, 32, 16);
+
+    ASSERT_EQ(narrow.size(), size_t(4));
+    EXPECT_EQ(narrow.back().offset, size_t(96));
+    EXPECT_EQ(narrow.back().count, size_t(4));
+}
+
+
+TEST(Launch, ChoosesLocalWorkSizesWithinLimits)
+{
+    for (const size_t nWorkItems : { size_t(1), size_t(100), size_t(5000), size_t(1) << 20, TwoToThe32 })
+    {
+        const launch::Config config = launch::Plan(GpuLikeResources, nWorkItems);
+
+        EXPECT_EQ(config.localWorkSize % GpuLikeResources.preferredWorkGroupSizeMultiple, size_t(0));
+        EXPECT_LE(config.localWorkSize, GpuLikeResources.maxWorkGroupSize);
+        EXPECT_EQ(config.globalWorkSize % config.localWorkSize, size_t(0));
+        EXPECT_GE(config.globalWorkSize, nWorkItems);
+        EXPECT_LT(config.globalWorkSize - nWorkItems, config.localWorkSize);
+    }
+
+    // Small problems are spread across every compute unit.
+    const size_t smallProblem = GpuLikeResources.computeUnits * GpuLikeResources.preferredWorkGroupSizeMultiple;
+
+    EXPECT_GE(launch::Plan(GpuLikeResources, smallProblem).globalWorkSize / launch::ChooseLocalWorkSize(GpuLikeResources, smallProblem),
+              GpuLikeResources.computeUnits);
+
+    // When local memory lets fewer work-groups reside per compute unit, each of them gets wider.
+    launch::KernelResources localMemoryBound = GpuLikeResources;
+    localMemoryBound.localMemSizeInBytes     = 16 * 1024;
+
+    EXPECT_GT(launch::ChooseLocalWorkSize(localMemoryBound, TwoToThe32),
+              launch::ChooseLocalWorkSize(GpuLikeResources, TwoToThe32));
+
+    // The first dimension of the device limits work-groups as much as the kernel does.
+    launch::KernelResources narrowDevice = localMemoryBound;
+    narrowDevice.maxWorkItemSize         = 64;
+
+    EXPECT_LE(launch::ChooseLocalWorkSize(narrowDevice, TwoToThe32), size_t(64));
+}
+
+TEST(Launch, ChoosesTheLocalWorkSizeOfHighestResidency)
+{
+    // Without an on-chip footprint, 16 resident work-groups of 128 work-items reach the residency cap first.
+    EXPECT_EQ(launch::ChooseLocalWorkSize(GpuLikeResources, TwoToThe32), size_t(128));
+
+    // 16 KiB of local memory per work-group leaves room for 3 of them, which need 704 work-items each to reach it.
+    launch::KernelResources localMemoryBound = GpuLikeResources;
+    localMemoryBound.localMemSizeInBytes     = 16 * 1024;
+
+    EXPECT_EQ(launch::ChooseLocalWorkSize(localMemoryBound, TwoToThe32), size_t(704));
+
+    // Spilled private memory grows with the work-group, so wider ones gain nothing past 64 work-items, and those
+    // beyond 768 work-items do not fit on a compute unit at all.
+    launch::KernelResources privateMemoryBound = GpuLikeResources;
+    privateMemoryBound.privateMemSizeInBytes   = 64;
+
+    EXPECT_EQ(launch::ChooseLocalWorkSize(privateMemoryBound, TwoToThe32), size_t(64));
+
+    // When not even the narrowest work-group fits, it is still the one chosen.
+    launch::KernelResources oversized = GpuLikeResources;
+    oversized.localMemSizeInBytes     = 64 * 1024;
+
+    EXPECT_EQ(launch::ChooseLocalWorkSize(oversized, TwoToThe32), GpuLikeResources.preferredWorkGroupSizeMultiple);
+
+    // 80 compute units share 1000 work-items, 13 each, which one preferred multiple covers.
+    EXPECT_EQ(launch::ChooseLocalWorkSize(GpuLikeResources, 1000), size_t(32));
+}
+
+
+TEST(Launch, ChoosesLocalWorkSizesForDegenerateResources)
+{
+    // Resources a runtime failed to report still yield a launchable size.
+    const launch::KernelResources unknown = {};
+
+    EXPECT_EQ(launch::ChooseLocalWorkSize(unknown, 0), size_t(1));
+    EXPECT_EQ(launch::ChooseLocalWorkSize(unknown, TwoToThe32), size_t(1));
+
+    // A preferred multiple wider than the kernel allows is clamped to the kernel's limit.
+    launch::KernelResources wideMultiple        = GpuLikeResources;
+    wideMultiple.maxWorkGroupSize               = 48;
+    wideMultiple.preferredWorkGroupSizeMultiple = 64;
+
+    EXPECT_EQ(launch::ChooseLocalWorkSize(wideMultiple, TwoToThe32), size_t(48));
+
+    // No work at all still gets one preferred multiple.
+    EXPECT_EQ(launch::ChooseLocalWorkSize(GpuLikeResources, 0), GpuLikeResources.preferredWorkGroupSizeMultiple);
+
+    const launch::Config empty = launch::Plan(GpuLikeResources, 0);
+
+    EXPECT_EQ(empty.globalWorkSize, size_t(0));
+}
+
+
+class LaunchTest : public test_fixture::ContextTest
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        ContextTest::SetUpTestSuite();
+
+        if (s_context != nullptr)
+        {
+            const program::SourceCreator srcCreator =
+            {
+                .clSourceRoot      = {},
+                .clSourceFileNames = {},
+                .clSources         = { ProbeSource },
+                .clIl              = {}
+            };
+
+            // Built from source every time, as a cached binary would outlive the source embedded here.
+            const cl_int result = program::Build(s_context, std::nullopt, srcCreator, "", s_program);
+            ASSERT_EQ(result, CL_SUCCESS);
+        }
+    }
+
+    void SetUp() override final
+    {
+        const cl_int result = program::CreateKernels(s_program, ProbeKernelNames, m_kernels);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        ContextTest::SetUp();
+    }
+
+    void TearDown() noexcept override final
+    {
+        ReleaseKernels(m_kernels);
+
+        ContextTest::TearDown();
+    }
+
+    std::array<cl_kernel, 2> m_kernels = {};
+};
+
+
+TEST_F(LaunchTest, QueriesKernelResources)
+{
+    cl_int                    result  = CL_SUCCESS;
+    std::vector<cl_device_id> devices = {};
+
+    result = context::GetDevices(s_context, devices);
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    for (const cl_device_id device : devices)
+    {
+        launch::KernelResources resources = {};
+
+        result = launch::QueryKernelResources(m_kernels[0], device, resources);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        EXPECT_GT(resources.maxWorkGroupSize, size_t(0));
+        EXPECT_GT(resources.preferredWorkGroupSizeMultiple, size_t(0));
+        EXPECT_GE(resources.localMemSizeInBytes, cl_ulong(256 * sizeof(float)));
+        EXPECT_LE(resources.localMemSizeInBytes, resources.deviceLocalMemSizeInBytes);
+        EXPECT_GT(resources.computeUnits, cl_uint(0));
+        EXPECT_GT(resources.maxWorkItemSize, size_t(0));
+
+        // Planning from the kernel queries the same resources.
+        launch::Config config = {};
+
+        result = launch::Plan(m_kernels[0], device, 1 << 20, config);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        EXPECT_EQ(config.localWorkSize, launch::Plan(resources, 1 << 20).localWorkSize);
+        EXPECT_LE(config.localWorkSize, std::min(resources.maxWorkGroupSize, resources.maxWorkItemSize));
+    }
+
+    // Invalid kernels are reported rather than planned for.
+    launch::KernelResources resources = {};
+
+    EXPECT_NE(launch::QueryKernelResources(nullptr, devices[0], resources), CL_SUCCESS);
+}
+
+
+TEST_F(LaunchTest, EnqueuesSplitLaunches)
+{
+    constexpr size_t LocalWorkSize         = 64;
+    constexpr size_t MaxWorkItemsPerLaunch = 256;
+    constexpr size_t MaxWorkItems          = 1024;
+
+    cl_int       result = CL_SUCCESS;
+    const cl_mem counts = clCreateBuffer(s_context, CL_MEM_READ_WRITE, MaxWorkItems * sizeof(cl_uint), nullptr, &result);
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    result = clSetKernelArg(m_kernels[1], 0, sizeof(counts), &counts);
+    ASSERT_EQ(result, CL_SUCCESS);
+
+    // Several launches, the last rounded up to a whole work-group; a single one; and none at all, which still
+    // completes.
+    for (const size_t nWorkItems : { size_t(1000), size_t(200), size_t(0) })
+    {
+        const cl_uint zero     = 0;
+        cl_event      complete = nullptr;
+
+        result = clEnqueueFillBuffer(m_queue, counts, &zero, sizeof(zero), 0, MaxWorkItems * sizeof(cl_uint), 0, nullptr, nullptr);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = launch::EnqueueSplit(m_queue, m_kernels[1], nWorkItems, LocalWorkSize, MaxWorkItemsPerLaunch, {}, complete);
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        std::vector<cl_uint> hostCounts(MaxWorkItems);
+
+        result = clEnqueueReadBuffer(m_queue,
+                                     counts,
+                                     CL_TRUE,
+                                     0,
+                                     MaxWorkItems * sizeof(cl_uint),
+                                     hostCounts.data(),
+                                     1,
+                                     &complete,
+                                     nullptr);
+
+        ASSERT_EQ(result, CL_SUCCESS);
+
+        result = clReleaseEvent(complete);
+        EXPECT_EQ(result, CL_SUCCESS);
+
+        // Exactly the work-items of whole work-groups covering the problem ran, each once.
+        const size_t nLaunchedWorkItems = ((nWorkItems + LocalWorkSize - 1) / LocalWorkSize) * LocalWorkSize;
+
+        for (size_t i = 0; i < MaxWorkItems; i++)
+        {
+            EXPECT_EQ(hostCounts[i], (i < nLaunchedWorkItems) ? cl_uint(1) : cl_uint(0)) <<
+                "Work-item " << i << " of " << nWorkItems;
+        }
+
+        EXPECT_EQ(std::accumulate(hostCounts.begin(), hostCounts.end(), size_t(0)), nLaunchedWorkItems);
+    }
+
+    result = clReleaseMemObject(counts);
+    EXPECT_EQ(result, CL_SUCCESS);
+}
\ No newline at end of file
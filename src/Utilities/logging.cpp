@@ -0,0 +1,291 @@
+#include "logging.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    // A power of two, so that positions map onto cells with a mask.
+    constexpr size_t CellCount = 4096;
+
+    // The sequence of a cell is twice the lap of the position it holds, plus one once the record is committed.
+    // Zero-initialized cells are thus free for the first lap.
+    struct Cell
+    {
+        std::atomic<size_t>     sequence;
+        logging::detail::Record record;
+    };
+
+    // Everything here is trivially destructible, so messages logged during static destruction still find the ring.
+    std::array<Cell, CellCount> cells               = {};
+    std::atomic<size_t>         enqueuePosition     = 0;
+    std::atomic<size_t>         dequeuePosition     = 0;
+    std::atomic<size_t>         flushedPosition     = 0;
+    std::atomic<size_t>         flushPosition       = 0;
+    std::atomic<bool>           drainThreadSleeping = false;
+    std::atomic<bool>           drainThreadStopped  = false;
+    std::atomic_flag            fallbackDrainLock   = ATOMIC_FLAG_INIT;
+
+
+    size_t GetLap(const size_t position) noexcept
+    {
+        return position / CellCount;
+    }
+
+
+    bool IsCommitted(const size_t position) noexcept
+    {
+        return cells[position % CellCount].sequence.load() == 2 * GetLap(position) + 1;
+    }
+
+
+    void Emit(logging::detail::Record& record)
+    {
+        std::ostream& oStream = *record.oStream;
+
+        oStream << "\n" << record.title << "\n";
+
+        oStream << "File: "     << record.fileName   << "\n";
+        oStream << "Function: " << record.callerName << "\n";
+        oStream << "Line: "     << record.lineNumber << "\n";
+
+        record.emit(oStream, record.args.data());
+
+        oStream << "\n";
+    }
+
+
+    // Only ever called by one consumer at a time: the drain thread, or a committing thread once it has stopped.
+    std::ostream* DrainOne()
+    {
+        const size_t position = dequeuePosition.load(std::memory_order_relaxed);
+
+        if (!IsCommitted(position))
+        {
+            return nullptr;
+        }
+
+        Cell&               cell    = cells[position % CellCount];
+        std::ostream* const oStream = cell.record.oStream;
+
+        Emit(cell.record);
+
+        cell.sequence.store(2 * (GetLap(position) + 1), std::memory_order_release);
+        dequeuePosition.store(position + 1, std::memory_order_release);
+
+        return oStream;
+    }
+
+
+    // Drains the records before `endPosition` that are committed, so producers that keep logging cannot hold it up.
+    void FallbackDrain(const size_t endPosition)
+    {
+        while (fallbackDrainLock.test_and_set(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+
+        while (dequeuePosition.load(std::memory_order_relaxed) < endPosition)
+        {
+            std::ostream* const oStream = DrainOne();
+
+            if (oStream == nullptr)
+            {
+                break;
+            }
+
+            oStream->flush();
+        }
+
+        flushedPosition.store(dequeuePosition.load(std::memory_order_relaxed), std::memory_order_release);
+        fallbackDrainLock.clear(std::memory_order_release);
+    }
+
+
+    void WakeDrainThread()
+    {
+        if (drainThreadSleeping.exchange(false))
+        {
+            drainThreadSleeping.notify_one();
+        }
+    }
+
+
+    // Formats and writes records in the background, flushing the streams it wrote to whenever the ring runs empty, or
+    // once it has written every record a pending `Flush` waits for.
+    class DrainThread
+    {
+    public:
+        DrainThread() :
+            m_thread(&DrainThread::Drain, this)
+        {
+        }
+
+        ~DrainThread() noexcept
+        {
+            m_stopping.store(true);
+            WakeDrainThread();
+            m_thread.join();
+
+            // Records committed from now on are drained by their producers.
+            drainThreadStopped.store(true);
+            FallbackDrain(enqueuePosition.load());
+        }
+
+        DrainThread(const DrainThread&)            = delete;
+        DrainThread& operator=(const DrainThread&) = delete;
+
+    private:
+        static void FlushStreams(std::vector<std::ostream*>& writtenStreams)
+        {
+            for (std::ostream* const oStream : writtenStreams)
+            {
+                oStream->flush();
+            }
+
+            writtenStreams.clear();
+
+            flushedPosition.store(dequeuePosition.load(std::memory_order_relaxed), std::memory_order_release);
+            flushedPosition.notify_all();
+        }
+
+        void Drain()
+        {
+            std::vector<std::ostream*> writtenStreams = {};
+
+            while (true)
+            {
+                while (std::ostream* const oStream = DrainOne())
+                {
+                    if (std::find(writtenStreams.cbegin(), writtenStreams.cend(), oStream) == writtenStreams.cend())
+                    {
+                        writtenStreams.push_back(oStream);
+                    }
+
+                    // Producers that keep logging may never let the ring run empty, which must not starve a flush.
+                    const size_t position = dequeuePosition.load(std::memory_order_relaxed);
+                    const size_t awaited  = flushPosition.load(std::memory_order_acquire);
+
+                    if ((flushedPosition.load(std::memory_order_relaxed) < awaited) && (position >= awaited))
+                    {
+                        FlushStreams(writtenStreams);
+                    }
+                }
+
+                FlushStreams(writtenStreams);
+
+                // Producers check for sleep after committing, so either they see it or this sees their record.
+                drainThreadSleeping.store(true);
+
+                if (IsCommitted(dequeuePosition.load(std::memory_order_relaxed)))
+                {
+                    drainThreadSleeping.store(false);
+                    continue;
+                }
+
+                if (m_stopping.load())
+                {
+                    return;
+                }
+
+                drainThreadSleeping.wait(true);
+            }
+        }
+
+        std::atomic<bool> m_stopping = false;
+        std::thread       m_thread   = {};
+    };
+
+
+    void StartDrainThread()
+    {
+        static DrainThread drainThread = {};
+    }
+}
+
+
+logging::detail::Record& logging::detail::Reserve(size_t& position)
+{
+    StartDrainThread();
+
+    position = enqueuePosition.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        const size_t sequence = cells[position % CellCount].sequence.load(std::memory_order_acquire);
+        const size_t free     = 2 * GetLap(position);
+
+        if (sequence == free)
+        {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                return cells[position % CellCount].record;
+            }
+        }
+        else if (sequence < free)
+        {
+            // The ring is full until the record of the previous lap is drained.
+            if (drainThreadStopped.load())
+            {
+                FallbackDrain(position);
+            }
+            else
+            {
+                WakeDrainThread();
+                std::this_thread::yield();
+            }
+
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+
+void logging::detail::Commit(const size_t position)
+{
+    cells[position % CellCount].sequence.store(2 * GetLap(position) + 1, std::memory_order_seq_cst);
+
+    if (drainThreadStopped.load())
+    {
+        FallbackDrain(position + 1);
+    }
+    else if (drainThreadSleeping.load())
+    {
+        WakeDrainThread();
+    }
+}
+
+
+void logging::Flush()
+{
+    const size_t position = enqueuePosition.load(std::memory_order_acquire);
+
+    if (drainThreadStopped.load())
+    {
+        FallbackDrain(position);
+        return;
+    }
+
+    // Only the records captured before this call are waited for, however many are captured meanwhile.
+    size_t awaited = flushPosition.load(std::memory_order_relaxed);
+
+    while ((awaited < position) &&
+           !flushPosition.compare_exchange_weak(awaited, position, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+
+    WakeDrainThread();
+
+    for (size_t flushed = flushedPosition.load(std::memory_order_acquire);
+         flushed < position;
+         flushed = flushedPosition.load(std::memory_order_acquire))
+    {
+        flushedPosition.wait(flushed);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "logging.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    // More than the cells of the ring, so producers wrap around it several times.
+    constexpr size_t MessagesPerRing = 3 * 4096 + 5;
+
+
+    // Larger than the arguments a record holds inline.
+    struct LargeArg
+    {
+        std::array<char, 256> text;
+    };
+
+
+    std::ostream& operator<<(std::ostream& oStream, const LargeArg& largeArg)
+    {
+        return oStream << std::string_view(largeArg.text.data());
+    }
+
+
+    // The lines of `oStream` holding the arguments of messages that start with `prefix`.
+    std::vector<std::string> GetMessages(const std::ostringstream& oStream,
+                                         const std::string_view    prefix)
+    {
+        std::istringstream       iStream(oStream.str());
+        std::vector<std::string> messages = {};
+
+        for (std::string line = {}; std::getline(iStream, line); )
+        {
+            if (line.starts_with(prefix))
+            {
+                messages.push_back(line);
+            }
+        }
+
+        return messages;
+    }
+}
+
+
+TEST(Logging, WritesEveryMessageAcrossRingWraps)
+{
+    std::ostringstream oStream = {};
+
+    for (size_t i = 0; i < MessagesPerRing; i++)
+    {
+        LOGGING_WRITE(logging::Level::Error, oStream, "LOGGING TEST", "message ", i);
+    }
+
+    logging::Flush();
+
+    const std::vector<std::string> messages = GetMessages(oStream, "message ");
+
+    ASSERT_EQ(messages.size(), MessagesPerRing);
+
+    for (size_t i = 0; i < messages.size(); i++)
+    {
+        EXPECT_EQ(messages[i], "message " + std::to_string(i));
+    }
+}
+
+
+TEST(Logging, WritesArgumentsTooLargeForTheRecord)
+{
+    static_assert(sizeof(LargeArg) > logging::detail::Record::ArgsCapacityInBytes);
+
+    std::ostringstream oStream  = {};
+    LargeArg           largeArg = {};
+
+    std::string_view("large argument").copy(largeArg.text.data(), largeArg.text.size() - 1);
+
+    LOGGING_WRITE(logging::Level::Error, oStream, "LOGGING TEST", "message ", largeArg, " ", 1);
+    LOGGING_WRITE(logging::Level::Error, oStream, "LOGGING TEST", "message ", 2);
+
+    logging::Flush();
+
+    const std::vector<std::string> messages = GetMessages(oStream, "message ");
+
+    ASSERT_EQ(messages.size(), size_t(2));
+    EXPECT_EQ(messages[0], "message large argument 1");
+    EXPECT_EQ(messages[1], "message 2");
+}
+
+
+TEST(Logging, DropsMessagesBelowTheRuntimeLevel)
+{
+    std::ostringstream oStream      = {};
+    const auto         initialLevel = logging::GetLevel();
+    size_t             nEvaluations = 0;
+
+    const auto evaluate = [&nEvaluations]() { return ++nEvaluations; };
+
+    logging::SetLevel(logging::Level::Error);
+
+    LOGGING_WRITE(logging::Level::Info,  oStream, "LOGGING TEST", "message dropped ", evaluate());
+    LOGGING_WRITE(logging::Level::Error, oStream, "LOGGING TEST", "message kept");
+
+    logging::SetLevel(logging::Level::Off);
+
+    LOGGING_WRITE(logging::Level::Error, oStream, "LOGGING TEST", "message dropped ", evaluate());
+
+    logging::SetLevel(initialLevel);
+    logging::Flush();
+
+    const std::vector<std::string> messages = GetMessages(oStream, "message ");
+
+    ASSERT_EQ(messages.size(), size_t(1));
+    EXPECT_EQ(messages[0], "message kept");
+    EXPECT_EQ(nEvaluations, size_t(0)) << "Arguments of dropped messages were evaluated";
+}
+
+
+TEST(Logging, KeepsTheOrderOfEachProducer)
+{
+    constexpr size_t MessagesPerThread = MessagesPerRing / 4;
+
+    const size_t             nThreads = std::max<size_t>(std::thread::hardware_concurrency(), 4);
+    std::ostringstream       oStream  = {};
+    std::vector<std::thread> threads  = {};
+
+    for (size_t thread = 0; thread < nThreads; thread++)
+    {
+        threads.emplace_back([&oStream, thread]()
+        {
+            for (size_t i = 0; i < MessagesPerThread; i++)
+            {
+                LOGGING_WRITE(logging::Level::Error, oStream, "LOGGING TEST", "message ", thread, " ", i);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    logging::Flush();
+
+    const std::vector<std::string> messages = GetMessages(oStream, "message ");
+    std::vector<size_t>            nextIndices(nThreads, 0);
+
+    ASSERT_EQ(messages.size(), nThreads * MessagesPerThread);
+
+    for (const std::string& message : messages)
+    {
+        std::istringstream iStream(message.substr(std::string_view("message ").size()));
+        size_t             thread = 0;
+        size_t             index  = 0;
+
+        ASSERT_TRUE(iStream >> thread >> index) << message;
+        ASSERT_LT(thread, nThreads) << message;
+        EXPECT_EQ(index, nextIndices[thread]++) << "Messages of one thread were reordered";
+    }
+}
+
+
+TEST(Logging, FlushReturnsWhileOthersKeepLogging)
+{
+    std::ostringstream oStream        = {};
+    std::ostringstream producerStream = {};
+    std::atomic<bool>  stopProducing  = false;
+
+    std::thread producer([&producerStream, &stopProducing]()
+    {
+        for (size_t i = 0; !stopProducing.load(std::memory_order_relaxed); i++)
+        {
+            LOGGING_WRITE(logging::Level::Error, producerStream, "LOGGING TEST", "message ", i);
+        }
+    });
+
+    for (size_t i = 0; i < 64; i++)
+    {
+        LOGGING_WRITE(logging::Level::Error, oStream, "LOGGING TEST", "message ", i);
+
+        logging::Flush();
+
+        ASSERT_EQ(GetMessages(oStream, "message ").size(), i + 1) << "A flush returned before its messages were written";
+    }
+
+    stopProducing.store(true);
+    producer.join();
+
+    logging::Flush();
+}
\ No newline at end of file
@@ -0,0 +1,551 @@
+#include "context.h"
+#include "debug.h"
+#include "device.h"
+#include "discovery.h"
+#include "memory.h"
+#include "tracing.h"
+
+#include <cstring>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif // _WIN32
+
+
+namespace
+{
+    size_t RoundUp(const size_t sizeInBytes,
+                   const size_t alignmentInBytes)
+    {
+        return ((sizeInBytes + alignmentInBytes - 1) / alignmentInBytes) * alignmentInBytes;
+    }
+
+
+#ifndef _WIN32
+    bool BindToNumaNode(void* const        pMemory,
+                        const size_t       sizeInBytes,
+                        const unsigned int numaNode)
+    {
+        constexpr size_t BitsPerMask = 8 * sizeof(unsigned long);
+
+        std::vector<unsigned long> nodeMask(numaNode / BitsPerMask + 1, 0);
+        nodeMask[numaNode / BitsPerMask] = 1ul << (numaNode % BitsPerMask);
+
+        // The kernel ignores the last bit of `maxnode`, hence "+ 1".
+        return syscall(SYS_mbind,
+                       pMemory,
+                       sizeInBytes,
+                       MPOL_BIND,
+                       nodeMask.data(),
+                       nodeMask.size() * BitsPerMask + 1,
+                       0) == 0;
+    }
+#endif // _WIN32
+
+
+    cl_int IsAlignedForAllDevices(const cl_context context,
+                                  const void*      pHost,
+                                  bool&            isAligned)
+    {
+        isAligned = true;
+
+        cl_int                    result  = CL_SUCCESS;
+        std::vector<cl_device_id> devices = {};
+
+        result = context::GetDevices(context, devices);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        for (const cl_device_id device : devices)
+        {
+            const discovery::DeviceInfo* deviceInfo = nullptr;
+
+            result = discovery::GetDeviceInfo(device, deviceInfo);
+            OPENCL_RETURN_ON_ERROR(result);
+
+            const size_t alignmentInBytes = deviceInfo->memBaseAddrAlignInBits / 8;
+
+            if ((alignmentInBytes != 0) && (reinterpret_cast<uintptr_t>(pHost) % alignmentInBytes != 0))
+            {
+                isAligned = false;
+            }
+        }
+
+        return result;
+    }
+}
+
+
+memory::HostAllocation::~HostAllocation() noexcept
+{
+    Free();
+}
+
+
+memory::HostAllocation::HostAllocation(HostAllocation&& other) noexcept
+    : m_pAllocation(std::exchange(other.m_pAllocation, nullptr)),
+      m_pView(std::exchange(other.m_pView, nullptr)),
+      m_allocationSizeInBytes(std::exchange(other.m_allocationSizeInBytes, 0)),
+      m_sizeInBytes(std::exchange(other.m_sizeInBytes, 0)),
+      m_isHugePageBacked(std::exchange(other.m_isHugePageBacked, false))
+{
+}
+
+
+memory::HostAllocation& memory::HostAllocation::operator=(HostAllocation&& other) noexcept
+{
+    if (this != &other)
+    {
+        Free();
+
+        m_pAllocation           = std::exchange(other.m_pAllocation, nullptr);
+        m_pView                 = std::exchange(other.m_pView, nullptr);
+        m_allocationSizeInBytes = std::exchange(other.m_allocationSizeInBytes, 0);
+        m_sizeInBytes           = std::exchange(other.m_sizeInBytes, 0);
+        m_isHugePageBacked      = std::exchange(other.m_isHugePageBacked, false);
+    }
+
+    return *this;
+}
+
+
+bool memory::HostAllocation::Allocate(const size_t                      sizeInBytes,
+                                      const std::optional<unsigned int> numaNode)
+{
+    Free();
+
+    if (sizeInBytes == 0)
+    {
+        return true;
+    }
+
+    const size_t pagedSizeInBytes = RoundUp(sizeInBytes, HugePageSizeInBytes);
+
+#ifdef _WIN32
+    const DWORD  preferredNode    = numaNode.has_value() ? static_cast<DWORD>(numaNode.value()) : NUMA_NO_PREFERRED_NODE;
+    const size_t largePageMinimum = GetLargePageMinimum();
+
+    // Large pages require the "Lock pages in memory" privilege, without which the allocation simply fails.
+    if ((largePageMinimum != 0) && (HugePageSizeInBytes % largePageMinimum == 0))
+    {
+        m_pAllocation = VirtualAllocExNuma(GetCurrentProcess(),
+                                           nullptr,
+                                           pagedSizeInBytes,
+                                           MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                           PAGE_READWRITE,
+                                           preferredNode);
+
+        m_pView                 = m_pAllocation;
+        m_allocationSizeInBytes = pagedSizeInBytes;
+        m_isHugePageBacked      = (m_pAllocation != nullptr);
+    }
+
+    // Ordinary allocations are only 64 KiB aligned, so one page more is reserved to align within it.
+    if (m_pAllocation == nullptr)
+    {
+        m_allocationSizeInBytes = pagedSizeInBytes + HugePageSizeInBytes;
+        m_pAllocation           = VirtualAllocExNuma(GetCurrentProcess(),
+                                                     nullptr,
+                                                     m_allocationSizeInBytes,
+                                                     MEM_RESERVE | MEM_COMMIT,
+                                                     PAGE_READWRITE,
+                                                     preferredNode);
+
+        if (m_pAllocation == nullptr)
+        {
+            MSG_STD_ERR("Failed to allocate host memory of size in bytes: ", sizeInBytes);
+
+            m_allocationSizeInBytes = 0;
+            return false;
+        }
+
+        m_pView = reinterpret_cast<void*>(RoundUp(reinterpret_cast<uintptr_t>(m_pAllocation), HugePageSizeInBytes));
+    }
+#else
+    // Explicit huge pages come from a pool the administrator reserves, which is commonly empty.
+    m_pAllocation = mmap(nullptr,
+                         pagedSizeInBytes,
+                         PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                         -1,
+                         0);
+
+    if (m_pAllocation != MAP_FAILED)
+    {
+        m_allocationSizeInBytes = pagedSizeInBytes;
+        m_isHugePageBacked      = true;
+    }
+    else
+    {
+        // Otherwise, an aligned region is carved out of a larger one and offered to transparent huge pages.
+        const size_t paddedSizeInBytes = pagedSizeInBytes + HugePageSizeInBytes;
+        void* const  pPadded           = mmap(nullptr,
+                                              paddedSizeInBytes,
+                                              PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS,
+                                              -1,
+                                              0);
+
+        if (pPadded == MAP_FAILED)
+        {
+            MSG_STD_ERR("Failed to allocate host memory of size in bytes: ", sizeInBytes);
+
+            m_pAllocation = nullptr;
+            return false;
+        }
+
+        const uintptr_t paddedBegin  = reinterpret_cast<uintptr_t>(pPadded);
+        const uintptr_t alignedBegin = RoundUp(paddedBegin, HugePageSizeInBytes);
+        const uintptr_t alignedEnd   = alignedBegin + pagedSizeInBytes;
+
+        if (alignedBegin != paddedBegin)
+        {
+            munmap(pPadded, alignedBegin - paddedBegin);
+        }
+
+        if (alignedEnd != paddedBegin + paddedSizeInBytes)
+        {
+            munmap(reinterpret_cast<void*>(alignedEnd), paddedBegin + paddedSizeInBytes - alignedEnd);
+        }
+
+        m_pAllocation           = reinterpret_cast<void*>(alignedBegin);
+        m_allocationSizeInBytes = pagedSizeInBytes;
+        m_isHugePageBacked      = madvise(m_pAllocation, pagedSizeInBytes, MADV_HUGEPAGE) == 0;
+    }
+
+    m_pView = m_pAllocation;
+
+    // Binding takes effect as pages are first touched, which has not happened yet.
+    if (numaNode.has_value() && !BindToNumaNode(m_pAllocation, m_allocationSizeInBytes, numaNode.value()))
+    {
+        MSG_STD_ERR("Failed to bind host memory to NUMA node: ", numaNode.value());
+    }
+#endif // _WIN32
+
+    m_sizeInBytes = sizeInBytes;
+
+    return true;
+}
+
+
+void memory::HostAllocation::Free() noexcept
+{
+    if (m_pAllocation != nullptr)
+    {
+#ifdef _WIN32
+        VirtualFree(m_pAllocation, 0, MEM_RELEASE);
+#else
+        munmap(m_pAllocation, m_allocationSizeInBytes);
+#endif // _WIN32
+    }
+
+    m_pAllocation           = nullptr;
+    m_pView                 = nullptr;
+    m_allocationSizeInBytes = 0;
+    m_sizeInBytes           = 0;
+    m_isHugePageBacked      = false;
+}
+
+
+std::span<std::byte> memory::HostAllocation::View() const noexcept
+{
+    return { static_cast<std::byte*>(m_pView), m_sizeInBytes };
+}
+
+
+cl_int memory::CreateBuffer(const cl_context                 context,
+                            const cl_mem_flags               flags,
+                            const std::span<const std::byte> hostMemory,
+                            cl_mem&                          buffer)
+{
+    cl_int result    = CL_SUCCESS;
+    bool   isAligned = false;
+
+    result = IsAlignedForAllDevices(context, hostMemory.data(), isAligned);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    // Misaligned host memory is legal, but silently copied by most implementations, defeating zero-copy access.
+    if (!isAligned)
+    {
+        MSG_STD_ERR("Host memory is not aligned to the base address alignment of every device of: ", context);
+        return CL_INVALID_VALUE;
+    }
+
+    // The host memory is only written by the device if the flags allow it.
+    buffer = clCreateBuffer(context,
+                            flags | CL_MEM_USE_HOST_PTR,
+                            hostMemory.size(),
+                            const_cast<std::byte*>(hostMemory.data()),
+                            &result);
+
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
+
+
+memory::HostBuffer::~HostBuffer() noexcept
+{
+    Release();
+}
+
+
+memory::HostBuffer::HostBuffer(HostBuffer&& other) noexcept
+    : m_queue(std::exchange(other.m_queue, nullptr)),
+      m_buffer(std::exchange(other.m_buffer, nullptr)),
+      m_pHost(std::exchange(other.m_pHost, nullptr)),
+      m_sizeInBytes(std::exchange(other.m_sizeInBytes, 0)),
+      m_strategy(other.m_strategy)
+{
+}
+
+
+memory::HostBuffer& memory::HostBuffer::operator=(HostBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+
+        m_queue       = std::exchange(other.m_queue, nullptr);
+        m_buffer      = std::exchange(other.m_buffer, nullptr);
+        m_pHost       = std::exchange(other.m_pHost, nullptr);
+        m_sizeInBytes = std::exchange(other.m_sizeInBytes, 0);
+        m_strategy    = other.m_strategy;
+    }
+
+    return *this;
+}
+
+
+cl_int memory::HostBuffer::Init(const cl_command_queue queue,
+                                const cl_mem_flags     access,
+                                std::byte* const       pHost,
+                                const size_t           sizeInBytes)
+{
+    Release();
+
+    cl_int       result          = CL_SUCCESS;
+    cl_context   context         = nullptr;
+    cl_device_id device          = nullptr;
+    bool         prefersZeroCopy = false;
+
+    result = clGetCommandQueueInfo(queue,
+                                   CL_QUEUE_CONTEXT,
+                                   sizeof(context),
+                                   &context,
+                                   nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = clGetCommandQueueInfo(queue,
+                                   CL_QUEUE_DEVICE,
+                                   sizeof(device),
+                                   &device,
+                                   nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    result = device::PrefersZeroCopy(device, prefersZeroCopy);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    cl_mem_flags flags = access;
+    void*        pUsed = nullptr;
+
+    if (prefersZeroCopy)
+    {
+        bool isAligned = false;
+
+        result = IsAlignedForAllDevices(context, pHost, isAligned);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        m_strategy = isAligned ? Strategy::InPlace : Strategy::MappedStaging;
+    }
+    else
+    {
+        m_strategy = Strategy::ExplicitCopy;
+    }
+
+    switch (m_strategy)
+    {
+    case Strategy::InPlace:
+        flags |= CL_MEM_USE_HOST_PTR;
+        pUsed  = pHost;
+        break;
+    case Strategy::MappedStaging:
+        flags |= CL_MEM_ALLOC_HOST_PTR;
+        break;
+    case Strategy::ExplicitCopy:
+        break;
+    }
+
+    m_buffer = clCreateBuffer(context,
+                              flags,
+                              sizeInBytes,
+                              pUsed,
+                              &result);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    m_queue       = queue;
+    m_pHost       = pHost;
+    m_sizeInBytes = sizeInBytes;
+
+    return result;
+}
+
+
+cl_int memory::HostBuffer::InitInput(const cl_command_queue           queue,
+                                     const std::span<const std::byte> hostInput,
+                                     cl_event&                        uploaded)
+{
+    cl_int result = CL_SUCCESS;
+
+    // The device only reads input buffers, so the host memory is never written through this pointer.
+    result = Init(queue, CL_MEM_READ_ONLY, const_cast<std::byte*>(hostInput.data()), hostInput.size());
+    OPENCL_RETURN_ON_ERROR(result);
+
+    switch (m_strategy)
+    {
+    case Strategy::InPlace:
+    {
+        result = clEnqueueMarkerWithWaitList(m_queue,
+                                             0,
+                                             nullptr,
+                                             &uploaded);
+
+        OPENCL_PRINT_ON_ERROR(result);
+        break;
+    }
+    case Strategy::MappedStaging:
+    {
+        void* const pMapped = clEnqueueMapBuffer(m_queue,
+                                                 m_buffer,
+                                                 CL_TRUE,
+                                                 CL_MAP_WRITE_INVALIDATE_REGION,
+                                                 0,
+                                                 m_sizeInBytes,
+                                                 0,
+                                                 nullptr,
+                                                 nullptr,
+                                                 &result);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        std::memcpy(pMapped, m_pHost, m_sizeInBytes);
+
+        result = clEnqueueUnmapMemObject(m_queue,
+                                         m_buffer,
+                                         pMapped,
+                                         0,
+                                         nullptr,
+                                         &uploaded);
+
+        OPENCL_PRINT_ON_ERROR(result);
+        break;
+    }
+    case Strategy::ExplicitCopy:
+    {
+        result = clEnqueueWriteBuffer(m_queue,
+                                      m_buffer,
+                                      CL_FALSE,
+                                      0,
+                                      m_sizeInBytes,
+                                      m_pHost,
+                                      0,
+                                      nullptr,
+                                      &uploaded);
+
+        OPENCL_PRINT_ON_ERROR(result);
+        break;
+    }
+    }
+
+    return result;
+}
+
+
+cl_int memory::HostBuffer::InitOutput(const cl_command_queue     queue,
+                                      const std::span<std::byte> hostOutput)
+{
+    return Init(queue, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, hostOutput.data(), hostOutput.size());
+}
+
+
+void memory::HostBuffer::Release() noexcept
+{
+    if (m_buffer != nullptr)
+    {
+        clReleaseMemObject(m_buffer);
+    }
+
+    m_queue       = nullptr;
+    m_buffer      = nullptr;
+    m_pHost       = nullptr;
+    m_sizeInBytes = 0;
+}
+
+
+cl_int memory::HostBuffer::Download(const std::span<const cl_event> eventsToWaitOn)
+{
+    cl_int result = CL_SUCCESS;
+
+    if (m_strategy == Strategy::ExplicitCopy)
+    {
+        result = clEnqueueReadBuffer(m_queue,
+                                     m_buffer,
+                                     CL_TRUE,
+                                     0,
+                                     m_sizeInBytes,
+                                     m_pHost,
+                                     static_cast<cl_uint>(eventsToWaitOn.size()),
+                                     eventsToWaitOn.data(),
+                                     nullptr);
+
+        OPENCL_PRINT_ON_ERROR(result);
+
+        return result;
+    }
+
+    // Mapping makes the host memory of an in-place buffer coherent, so only staging memory needs copying.
+    void* const pMapped = clEnqueueMapBuffer(m_queue,
+                                             m_buffer,
+                                             CL_TRUE,
+                                             CL_MAP_READ,
+                                             0,
+                                             m_sizeInBytes,
+                                             static_cast<cl_uint>(eventsToWaitOn.size()),
+                                             eventsToWaitOn.data(),
+                                             nullptr,
+                                             &result);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    if (m_strategy == Strategy::MappedStaging)
+    {
+        std::memcpy(m_pHost, pMapped, m_sizeInBytes);
+    }
+
+    result = clEnqueueUnmapMemObject(m_queue,
+                                     m_buffer,
+                                     pMapped,
+                                     0,
+                                     nullptr,
+                                     nullptr);
+
+    OPENCL_PRINT_ON_ERROR(result);
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "debug.h"
+#include "json.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <variant>
+
+
+namespace
+{
+    struct Entry
+    {
+        std::string                                                                          help;
+        std::variant<std::unique_ptr<metrics::Counter>, std::unique_ptr<metrics::Histogram>> metric;
+    };
+
+
+    // Ordered by name, so that snapshots are stable across exports.
+    struct Registry
+    {
+        std::mutex                                mutex   = {};
+        std::map<std::string, Entry, std::less<>> entries = {};
+    };
+
+
+    Registry& GetRegistry()
+    {
+        // Leaked, so metrics updated during static destruction never find it gone.
+        static Registry* const registry = new Registry();
+
+        return *registry;
+    }
+
+
+    void FormatPrometheusBound(std::ostream& oStream,
+                               const double  bound)
+    {
+        if (bound == std::numeric_limits<double>::infinity())
+        {
+            oStream << "+Inf";
+        }
+        else
+        {
+            oStream << bound;
+        }
+    }
+
+
+    void FormatPrometheus(std::ostream&      oStream,
+                          const std::string& name,
+                          const Entry&       entry)
+    {
+        oStream << "# HELP " << name << " " << entry.help << "\n";
+
+        if (const auto* const counter = std::get_if<std::unique_ptr<metrics::Counter>>(&entry.metric))
+        {
+            oStream << "# TYPE " << name << " counter\n";
+            oStream << name << " " << (*counter)->Read() << "\n";
+        }
+        else
+        {
+            const metrics::Histogram::Snapshot snapshot =
+                std::get<std::unique_ptr<metrics::Histogram>>(entry.metric)->Read();
+
+            oStream << "# TYPE " << name << " histogram\n";
+
+            // Prometheus buckets are cumulative.
+            uint64_t cumulativeCount = 0;
+
+            for (size_t i = 0; i < snapshot.bucketCounts.size(); i++)
+            {
+                const double bound = (i < snapshot.upperBounds.size()) ? snapshot.upperBounds[i]
+                                                                        : std::numeric_limits<double>::infinity();
+
+                cumulativeCount += snapshot.bucketCounts[i];
+
+                oStream << name << "_bucket{le=\"";
+                FormatPrometheusBound(oStream, bound);
+                oStream << "\"} " << cumulativeCount << "\n";
+            }
+
+            oStream << name << "_sum "   << snapshot.sum   << "\n";
+            oStream << name << "_count " << snapshot.count << "\n";
+        }
+    }
+
+
+    void FormatJson(std::ostream&      oStream,
+                    const std::string& name,
+                    const Entry&       entry)
+    {
+        json::WriteString(oStream, name);
+        oStream << ": { \"help\": ";
+        json::WriteString(oStream, entry.help);
+
+        if (const auto* const counter = std::get_if<std::unique_ptr<metrics::Counter>>(&entry.metric))
+        {
+            oStream << ", \"type\": \"counter\", \"value\": " << (*counter)->Read() << " }";
+        }
+        else
+        {
+            const metrics::Histogram::Snapshot snapshot =
+                std::get<std::unique_ptr<metrics::Histogram>>(entry.metric)->Read();
+
+            oStream << ", \"type\": \"histogram\", \"buckets\": [";
+
+            for (size_t i = 0; i < snapshot.bucketCounts.size(); i++)
+            {
+                oStream << ((i == 0) ? " " : ", ") << "{ \"le\": ";
+
+                // JSON has no infinity, so the overflow bucket has no bound.
+                if (i < snapshot.upperBounds.size())
+                {
+                    oStream << snapshot.upperBounds[i];
+                }
+                else
+                {
+                    oStream << "null";
+                }
+
+                oStream << ", \"count\": " << snapshot.bucketCounts[i] << " }";
+            }
+
+            oStream << " ], \"sum\": " << snapshot.sum << ", \"count\": " << snapshot.count << " }";
+        }
+    }
+}
+
+
+size_t metrics::GetThreadShard() noexcept
+{
+    static std::atomic<size_t> nextShard   = 0;
+    thread_local const size_t  threadShard = nextShard.fetch_add(1, std::memory_order_relaxed) % ShardCount;
+
+    return threadShard;
+}
+
+
+uint64_t metrics::Counter::Read() const noexcept
+{
+    uint64_t value = 0;
+
+    for (const Shard& shard : m_shards)
+    {
+        value += shard.value.load(std::memory_order_relaxed);
+    }
+
+    return value;
+}
+
+
+metrics::Histogram::Histogram(const std::span<const double> upperBounds) :
+    m_upperBounds(upperBounds.begin(), upperBounds.end())
+{
+    std::sort(m_upperBounds.begin(), m_upperBounds.end());
+
+    // Histograms are declared by a handful of call sites in this code base, so too many bounds is a programming error.
+    if (m_upperBounds.size() > MaxBoundCount)
+    {
+        MSG_STD_ERR("Histogram has more than ", MaxBoundCount, " bounds: ", m_upperBounds.size());
+        std::terminate();
+    }
+}
+
+
+void metrics::Histogram::Observe(const double value) noexcept
+{
+    const size_t bucket = std::lower_bound(m_upperBounds.cbegin(), m_upperBounds.cend(), value) - m_upperBounds.cbegin();
+    Shard&       shard  = m_shards[GetThreadShard()];
+
+    shard.bucketCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+
+metrics::Histogram::Snapshot metrics::Histogram::Read() const
+{
+    Snapshot snapshot =
+    {
+        .upperBounds  = m_upperBounds,
+        .bucketCounts = std::vector<uint64_t>(m_upperBounds.size() + 1, 0),
+        .sum          = 0.0,
+        .count        = 0
+    };
+
+    for (const Shard& shard : m_shards)
+    {
+        for (size_t i = 0; i < snapshot.bucketCounts.size(); i++)
+        {
+            const uint64_t bucketCount = shard.bucketCounts[i].load(std::memory_order_relaxed);
+
+            snapshot.bucketCounts[i] += bucketCount;
+            snapshot.count           += bucketCount;
+        }
+
+        snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+
+    return snapshot;
+}
+
+
+std::vector<double> metrics::ExponentialBuckets(const double start,
+                                                const double factor,
+                                                const size_t count)
+{
+    std::vector<double> upperBounds(count);
+    double              upperBound = start;
+
+    for (double& bound : upperBounds)
+    {
+        bound       = upperBound;
+        upperBound *= factor;
+    }
+
+    return upperBounds;
+}
+
+
+metrics::Counter& metrics::GetCounter(const std::string_view name,
+                                      const std::string_view help)
+{
+    Registry&             registry = GetRegistry();
+    const std::lock_guard lock(registry.mutex);
+
+    auto entry = registry.entries.find(name);
+
+    if (entry == registry.entries.end())
+    {
+        entry = registry.entries.emplace(std::string(name),
+                                         Entry{ std::string(help), std::make_unique<Counter>() }).first;
+    }
+
+    if (auto* const counter = std::get_if<std::unique_ptr<Counter>>(&entry->second.metric))
+    {
+        return **counter;
+    }
+
+    // A name is registered by a handful of call sites in this code base, so a clash is a programming error.
+    MSG_STD_ERR("Metric is not a counter: ", name);
+    std::terminate();
+}
+
+
+metrics::Histogram& metrics::GetHistogram(const std::string_view        name,
+                                          const std::string_view        help,
+                                          const std::span<const double> upperBounds)
+{
+    Registry&             registry = GetRegistry();
+    const std::lock_guard lock(registry.mutex);
+
+    auto entry = registry.entries.find(name);
+
+    if (entry == registry.entries.end())
+    {
+        entry = registry.entries.emplace(std::string(name),
+                                         Entry{ std::string(help), std::make_unique<Histogram>(upperBounds) }).first;
+    }
+
+    if (auto* const histogram = std::get_if<std::unique_ptr<Histogram>>(&entry->second.metric))
+    {
+        return **histogram;
+    }
+
+    MSG_STD_ERR("Metric is not a histogram: ", name);
+    std::terminate();
+}
+
+
+std::string metrics::FormatSnapshot(const Format format)
+{
+    Registry&             registry = GetRegistry();
+    const std::lock_guard lock(registry.mutex);
+    std::ostringstream    snapshot = {};
+
+    snapshot << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+    if (format == Format::Json)
+    {
+        snapshot << "{";
+    }
+
+    bool isFirst = true;
+
+    for (const auto& [name, entry] : registry.entries)
+    {
+        if (format == Format::Json)
+        {
+            snapshot << (isFirst ? "\n    " : ",\n    ");
+            FormatJson(snapshot, name, entry);
+        }
+        else
+        {
+            FormatPrometheus(snapshot, name, entry);
+        }
+
+        isFirst = false;
+    }
+
+    if (format == Format::Json)
+    {
+        snapshot << "\n}\n";
+    }
+
+    return std::move(snapshot).str();
+}
+
+
+bool metrics::ExportSnapshot(const std::filesystem::path& filePath,
+                             const Format                 format)
+{
+    std::filesystem::path temporaryFilePath = filePath;
+    temporaryFilePath += ".tmp";
+
+    {
+        std::ofstream snapshotOfStream(temporaryFilePath, std::ios::binary | std::ios::trunc);
+        snapshotOfStream << FormatSnapshot(format);
+
+        if (!snapshotOfStream.flush())
+        {
+            MSG_STD_ERR("Failed to write metrics snapshot: ", temporaryFilePath);
+            return false;
+        }
+    }
+
+    std::error_code errorCode = {};
+    std::filesystem::rename(temporaryFilePath, filePath, errorCode);
+
+    if (errorCode)
+    {
+        MSG_STD_ERR("Failed to replace metrics snapshot: ", filePath, ": ", errorCode.message());
+        return false;
+    }
+
+    return true;
+}
\ No newline at end of file
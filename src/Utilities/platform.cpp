@@ -1,11 +1,39 @@
 #include "debug.h"
 #include "device.h"
+#include "discovery.h"
 #include "platform.h"
 #include "required.h"
 #include "settings.h"
+#include "tracing.h"
 
+#include <algorithm>
 #include <array>
 #include <sstream>
+#include <utility>
+
+
+namespace
+{
+    cl_int SelectDeviceGroup(const discovery::PlatformInfo& platformInfo,
+                             std::vector<cl_device_id>&     selectedDevices,
+                             double&                        selectedThroughput)
+    {
+        cl_int result = CL_SUCCESS;
+
+        if (settings::displayGeneralDeviceInfo)
+        {
+            for (const discovery::DeviceInfo& deviceInfo : platformInfo.devices)
+            {
+                result = device::DisplayGeneralInfo(deviceInfo.id);
+                OPENCL_RETURN_ON_ERROR(result);
+            }
+        }
+
+        platform::SelectFastestDeviceGroup(platformInfo, device::GetMeasuredProfiles(), selectedDevices, selectedThroughput);
+
+        return result;
+    }
+}
 
 
 cl_int platform::GetAllAvailable(std::vector<cl_platform_id>& platforms)
@@ -122,30 +150,25 @@ cl_int platform::IsConformant(const cl_platform_id platform,
 
 cl_int platform::GetAllConformant(std::vector<cl_platform_id>& conformantPlatforms)
 {
-    cl_int                      result             = CL_SUCCESS;
-    std::vector<cl_platform_id> availablePlatforms = {};
+    cl_int                     result   = CL_SUCCESS;
+    const discovery::Snapshot* snapshot = nullptr;
 
-    result = platform::GetAllAvailable(availablePlatforms);
+    result = discovery::GetSnapshot(snapshot);
     OPENCL_RETURN_ON_ERROR(result);
 
-    conformantPlatforms.reserve(availablePlatforms.size());
+    conformantPlatforms.reserve(snapshot->platforms.size());
 
-    for (const cl_platform_id platform : availablePlatforms)
+    for (const discovery::PlatformInfo& platformInfo : snapshot->platforms)
     {
         if (settings::displayPlatformInfo)
         {
-            result = platform::DisplayInfo(platform);
+            result = platform::DisplayInfo(platformInfo.id);
             OPENCL_RETURN_ON_ERROR(result);
         }
 
-        bool platformIsConformant = false;
-
-        result = platform::IsConformant(platform, platformIsConformant);
-        OPENCL_RETURN_ON_ERROR(result);
-
-        if (platformIsConformant)
+        if (platformInfo.isConformant)
         {
-            conformantPlatforms.push_back(platform);
+            conformantPlatforms.push_back(platformInfo.id);
         }
     }
 
@@ -160,32 +183,33 @@ cl_int platform::MostGpus(const std::span<const cl_platform_id> platforms,
     selectedPlatform.reset();
     selectedDevices.resize(0);
 
-    cl_int result = CL_SUCCESS;
+    cl_int                     result   = CL_SUCCESS;
+    const discovery::Snapshot* snapshot = nullptr;
+
+    result = discovery::GetSnapshot(snapshot);
+    OPENCL_RETURN_ON_ERROR(result);
 
     for (const cl_platform_id platform : platforms)
     {
-        std::vector<cl_device_id> availableDevices = {};
-        std::vector<cl_device_id> conformantGpus   = {};
+        const discovery::PlatformInfo* const platformInfo   = snapshot->FindPlatform(platform);
+        std::vector<cl_device_id>            conformantGpus = {};
 
-        result = device::GetAllAvailable(platform, availableDevices);
-        OPENCL_RETURN_ON_ERROR(result);
+        if (platformInfo == nullptr)
+        {
+            return CL_INVALID_PLATFORM;
+        }
 
-        for (const cl_device_id device : availableDevices)
+        for (const discovery::DeviceInfo& deviceInfo : platformInfo->devices)
         {
             if (settings::displayGeneralDeviceInfo)
             {
-                result = device::DisplayGeneralInfo(device);
+                result = device::DisplayGeneralInfo(deviceInfo.id);
                 OPENCL_RETURN_ON_ERROR(result);
             }
 
-            bool deviceIsGpu = false;
-
-            result = device::IsGpu(device, deviceIsGpu);
-            OPENCL_RETURN_ON_ERROR(result);
-
-            if (deviceIsGpu)
+            if (deviceInfo.type == CL_DEVICE_TYPE_GPU)
             {
-                conformantGpus.push_back(device);
+                conformantGpus.push_back(deviceInfo.id);
             }
         }
 
@@ -197,4 +221,165 @@ cl_int platform::MostGpus(const std::span<const cl_platform_id> platforms,
     }
 
     return result;
+}
+
+
+cl_int platform::HighestThroughput(const std::span<const cl_platform_id> platforms,
+                                   std::optional<cl_platform_id>&        selectedPlatform,
+                                   std::vector<cl_device_id>&            selectedDevices)
+{
+    selectedPlatform.reset();
+    selectedDevices.resize(0);
+
+    cl_int                     result             = CL_SUCCESS;
+    const discovery::Snapshot* snapshot           = nullptr;
+    double                     selectedThroughput = 0.0;
+
+    result = discovery::GetSnapshot(snapshot);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    for (const cl_platform_id platform : platforms)
+    {
+        const discovery::PlatformInfo* const platformInfo = snapshot->FindPlatform(platform);
+        std::vector<cl_device_id>            devices      = {};
+        double                               throughput   = 0.0;
+
+        if (platformInfo == nullptr)
+        {
+            return CL_INVALID_PLATFORM;
+        }
+
+        result = SelectDeviceGroup(*platformInfo, devices, throughput);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        if (throughput > selectedThroughput)
+        {
+            selectedPlatform   = platform;
+            selectedDevices    = std::move(devices);
+            selectedThroughput = throughput;
+        }
+    }
+
+    return result;
+}
+
+
+cl_int platform::HighestThroughputPerPlatform(const std::span<const cl_platform_id>   platforms,
+                                              std::vector<cl_platform_id>&            selectedPlatforms,
+                                              std::vector<std::vector<cl_device_id>>& selectedDevices)
+{
+    selectedPlatforms.resize(0);
+    selectedDevices.resize(0);
+
+    cl_int                     result   = CL_SUCCESS;
+    const discovery::Snapshot* snapshot = nullptr;
+
+    struct Selection
+    {
+        cl_platform_id            platform;
+        std::vector<cl_device_id> devices;
+        double                    throughput;
+        bool                      isCpuGroup;
+    };
+
+    std::vector<Selection> selections = {};
+
+    result = discovery::GetSnapshot(snapshot);
+    OPENCL_RETURN_ON_ERROR(result);
+
+    for (const cl_platform_id platform : platforms)
+    {
+        const discovery::PlatformInfo* const platformInfo = snapshot->FindPlatform(platform);
+
+        Selection selection =
+        {
+            .platform   = platform,
+            .devices    = {},
+            .throughput = 0.0,
+            .isCpuGroup = false
+        };
+
+        if (platformInfo == nullptr)
+        {
+            return CL_INVALID_PLATFORM;
+        }
+
+        result = SelectDeviceGroup(*platformInfo, selection.devices, selection.throughput);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        if (!selection.devices.empty())
+        {
+            selection.isCpuGroup = snapshot->FindDevice(selection.devices.front())->type & CL_DEVICE_TYPE_CPU;
+            selections.push_back(std::move(selection));
+        }
+    }
+
+    std::ranges::sort(selections, std::ranges::greater{}, &Selection::throughput);
+
+    // Several runtimes (e.g. a vendor runtime and PoCL) commonly expose the same host CPU. Sharding work across both
+    // would only oversubscribe its cores, so only the fastest CPU platform is kept.
+    bool cpuGroupSelected = false;
+
+    for (Selection& selection : selections)
+    {
+        if (selection.isCpuGroup)
+        {
+            if (cpuGroupSelected)
+            {
+                continue;
+            }
+
+            cpuGroupSelected = true;
+        }
+
+        selectedPlatforms.push_back(selection.platform);
+        selectedDevices.push_back(std::move(selection.devices));
+    }
+
+    return result;
+}
+
+
+void platform::SelectFastestDeviceGroup(const discovery::PlatformInfo&  platformInfo,
+                                        const device::MeasuredProfiles& profiles,
+                                        std::vector<cl_device_id>&      selectedDevices,
+                                        double&                         selectedThroughput)
+{
+    selectedDevices.resize(0);
+    selectedThroughput = 0.0;
+
+    std::vector<std::pair<double, const discovery::DeviceInfo*>> scoredDevices = {};
+
+    for (const discovery::DeviceInfo& deviceInfo : platformInfo.devices)
+    {
+        const double throughput = device::EstimateThroughput(deviceInfo, profiles);
+
+        if (throughput > 0.0)
+        {
+            scoredDevices.emplace_back(throughput, &deviceInfo);
+        }
+    }
+
+    std::ranges::stable_sort(scoredDevices, std::ranges::greater{}, &std::pair<double, const discovery::DeviceInfo*>::first);
+
+    for (const cl_device_type deviceType : { CL_DEVICE_TYPE_GPU, CL_DEVICE_TYPE_ACCELERATOR, CL_DEVICE_TYPE_CPU })
+    {
+        std::vector<cl_device_id> devices    = {};
+        double                    throughput = 0.0;
+
+        for (const auto& [deviceThroughput, deviceInfo] : scoredDevices)
+        {
+            if (deviceInfo->type & deviceType)
+            {
+                devices.push_back(deviceInfo->id);
+                throughput = std::max(throughput, deviceThroughput);
+            }
+        }
+
+        if (throughput > selectedThroughput)
+        {
+            selectedDevices    = std::move(devices);
+            selectedThroughput = throughput;
+        }
+    }
 }
\ No newline at end of file
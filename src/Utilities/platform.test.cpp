@@ -0,0 +1,138 @@
+#include "device.h"
+#include "discovery_types.h"
+#include "platform.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    // Handles that are never passed to OpenCL, only told apart.
+    cl_device_id MakeDeviceId(const uintptr_t index)
+    {
+        return reinterpret_cast<cl_device_id>(index + 1);
+    }
+
+
+    discovery::DeviceInfo MakeDeviceInfo(const uintptr_t      index,
+                                         const cl_device_type type,
+                                         const cl_uint        computeUnits,
+                                         const bool           hostUnifiedMemory)
+    {
+        discovery::DeviceInfo deviceInfo = {};
+
+        deviceInfo.id                        = MakeDeviceId(index);
+        deviceInfo.type                      = type;
+        deviceInfo.uniqueId                  = "device" + std::to_string(index);
+        deviceInfo.maxComputeUnits           = computeUnits;
+        deviceInfo.maxClockFrequencyInMHz    = 1500;
+        deviceInfo.preferredVectorWidthFloat = 8;
+        deviceInfo.hostUnifiedMemory         = hostUnifiedMemory;
+
+        return deviceInfo;
+    }
+}
+
+
+TEST(Platform, SelectsTheGroupOfTheFastestDevice)
+{
+    const device::MeasuredProfiles noProfiles = {};
+
+    // A CPU, a slower and a faster discrete GPU.
+    discovery::PlatformInfo platformInfo = {};
+
+    platformInfo.devices =
+    {
+        MakeDeviceInfo(0, CL_DEVICE_TYPE_CPU, 16, true),
+        MakeDeviceInfo(1, CL_DEVICE_TYPE_GPU, 20, false),
+        MakeDeviceInfo(2, CL_DEVICE_TYPE_GPU, 80, false)
+    };
+
+    std::vector<cl_device_id> selectedDevices    = {};
+    double                    selectedThroughput = 0.0;
+
+    platform::SelectFastestDeviceGroup(platformInfo, noProfiles, selectedDevices, selectedThroughput);
+
+    // The GPUs, fastest first, scored as the fastest of them rather than their sum.
+    EXPECT_EQ(selectedDevices, std::vector<cl_device_id>({ MakeDeviceId(2), MakeDeviceId(1) }));
+    EXPECT_DOUBLE_EQ(selectedThroughput, device::EstimateThroughput(platformInfo.devices[2], noProfiles));
+
+    // Without GPUs, an accelerator beats the CPU.
+    platformInfo.devices[1] = MakeDeviceInfo(1, CL_DEVICE_TYPE_ACCELERATOR, 64, false);
+    platformInfo.devices.pop_back();
+
+    platform::SelectFastestDeviceGroup(platformInfo, noProfiles, selectedDevices, selectedThroughput);
+
+    EXPECT_EQ(selectedDevices, std::vector<cl_device_id>({ MakeDeviceId(1) }));
+
+    // And a CPU alone is still selected, as on machines running only PoCL.
+    platformInfo.devices.pop_back();
+
+    platform::SelectFastestDeviceGroup(platformInfo, noProfiles, selectedDevices, selectedThroughput);
+
+    EXPECT_EQ(selectedDevices, std::vector<cl_device_id>({ MakeDeviceId(0) }));
+    EXPECT_GT(selectedThroughput, 0.0);
+}
+
+
+TEST(Platform, SelectsByMeasuredProfiles)
+{
+    discovery::PlatformInfo platformInfo = {};
+
+    platformInfo.devices =
+    {
+        MakeDeviceInfo(0, CL_DEVICE_TYPE_CPU, 16, true),
+        MakeDeviceInfo(1, CL_DEVICE_TYPE_GPU, 80, false)
+    };
+
+    std::vector<cl_device_id> selectedDevices    = {};
+    double                    selectedThroughput = 0.0;
+
+    platform::SelectFastestDeviceGroup(platformInfo, {}, selectedDevices, selectedThroughput);
+
+    ASSERT_EQ(selectedDevices, std::vector<cl_device_id>({ MakeDeviceId(1) }));
+
+    // A measured GPU far slower than its priors, e.g. one throttled or shared with a display, loses to the CPU.
+    const device::MeasuredProfiles profiles =
+    {
+        { platformInfo.devices[1].uniqueId, { .computeInGflops         = 10.0,
+                                              .memoryBandwidthInGBps   = 10.0,
+                                              .zeroCopyBandwidthInGBps = 0.0,
+                                              .transferBandwidthInGBps = 0.0 } }
+    };
+
+    platform::SelectFastestDeviceGroup(platformInfo, profiles, selectedDevices, selectedThroughput);
+
+    EXPECT_EQ(selectedDevices, std::vector<cl_device_id>({ MakeDeviceId(0) }));
+    EXPECT_DOUBLE_EQ(selectedThroughput, device::EstimateThroughput(platformInfo.devices[0], profiles));
+}
+
+
+TEST(Platform, SelectsNothingWithoutUsableDevices)
+{
+    discovery::PlatformInfo   platformInfo       = {};
+    std::vector<cl_device_id> selectedDevices    = { MakeDeviceId(7) };
+    double                    selectedThroughput = 1.0;
+
+    platform::SelectFastestDeviceGroup(platformInfo, {}, selectedDevices, selectedThroughput);
+
+    EXPECT_TRUE(selectedDevices.empty());
+    EXPECT_EQ(selectedThroughput, 0.0);
+
+    // Devices that report no compute units are left out, even from the group of their type.
+    platformInfo.devices =
+    {
+        MakeDeviceInfo(0, CL_DEVICE_TYPE_GPU, 0, false),
+        MakeDeviceInfo(1, CL_DEVICE_TYPE_GPU, 40, false)
+    };
+
+    platform::SelectFastestDeviceGroup(platformInfo, {}, selectedDevices, selectedThroughput);
+
+    EXPECT_EQ(selectedDevices, std::vector<cl_device_id>({ MakeDeviceId(1) }));
+}
\ No newline at end of file
@@ -1,20 +1,36 @@
+#include "binary_cache.h"
+#include "concurrency.h"
 #include "context.h"
 #include "debug.h"
 #include "device.h"
+#include "hash.h"
+#include "metrics.h"
 #include "program.h"
 #include "program_types.h"
 #include "settings.h"
+#include "tracing.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <iomanip>
+#include <memory>
 #include <sstream>
-#include <stdint.h>
-#include <system_error>
 
 
 namespace
 {
+    std::filesystem::path GetClBinaryPackFilePath(const program::BinaryCreator& binCreator)
+    {
+        return binCreator.clBinaryRoot / settings::programBinaryPackFileName;
+    }
+
+
     cl_int CreateFromBinary(const cl_context              context,
                             const program::BinaryCreator& binCreator,
                             std::optional<cl_program>&    program)
@@ -26,114 +42,132 @@ namespace
 
         result = context::GetDevices(context, devices);
         OPENCL_RETURN_ON_ERROR(result);
-    
-        std::vector<std::vector<unsigned char>> clBinaries(devices.size());
-        uint32_t nClBinariesAcquired = 0;
-    
-        for (size_t i = 0; i < devices.size(); i++)
-        {
-            std::filesystem::path clBinaryFilePath = {};
-            std::error_code       ec               = {};
 
-            result = device::GetClBinaryFilePath(binCreator, devices[i], clBinaryFilePath);
-            OPENCL_RETURN_ON_ERROR(result);
-    
-            const bool clBinaryExists = std::filesystem::exists(clBinaryFilePath, ec);
-    
-            if (!ec && clBinaryExists)
-            {
-                std::ifstream clBinaryIfStream(clBinaryFilePath,
-                                               std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
-    
-                if (!clBinaryIfStream.is_open())
-                {
-                    MSG_STD_ERR("Failed to open input stream for OpenCL program binary: ", clBinaryFilePath);
-                    break;
-                }
-    
-                const auto clBinaryEndPos   = clBinaryIfStream.tellg();
-                clBinaryIfStream.seekg(std::ios_base::beg);
-                const auto clBinaryBeginPos = clBinaryIfStream.tellg();
-    
-                if (clBinaryIfStream.fail())
-                {
-                    MSG_STD_ERR("Failed to determine size in bytes of OpenCL program binary: ", clBinaryFilePath);
-                    break;
-                }
-    
-                clBinaries[i].resize(clBinaryEndPos - clBinaryBeginPos);
-    
-                clBinaryIfStream.read(reinterpret_cast<char*>(clBinaries[i].data()),
-                                      clBinaries[i].size());
-                
-                if (clBinaryIfStream.fail())
-                {
-                    MSG_STD_ERR("Failed to read OpenCL program binary from file: ", clBinaryFilePath);
-                    break;
-                }
-    
-                DBG_MSG_STD_OUT("Context ", context, " acquired OpenCL binary file: ", clBinaryFilePath);
-    
-                nClBinariesAcquired++;
-            }
-            else
-            {
-                DBG_MSG_STD_OUT("Must create program for context ", context, " from source: ", clBinaryFilePath, " does not exist.");
-                break;
-            }
+        const std::filesystem::path               clBinaryPackFilePath = GetClBinaryPackFilePath(binCreator);
+        std::shared_ptr<const binary_cache::Pack> clBinaryPack         = nullptr;
+
+        if (!binary_cache::Open(clBinaryPackFilePath, clBinaryPack))
+        {
+            MSG_STD_ERR("Failed to open OpenCL program binary pack: ", clBinaryPackFilePath);
+            return result;
         }
 
-        if (nClBinariesAcquired == devices.size())
+        // The binaries are handed to the driver straight from the mapped pack, which `clBinaryPack` keeps alive.
+        std::vector<const unsigned char*> clBinaryPtrs  = {};
+        std::vector<size_t>               clBinarySizes = {};
+
+        clBinaryPtrs.reserve( devices.size());
+        clBinarySizes.reserve(devices.size());
+
+        for (const cl_device_id device : devices)
         {
-            std::vector<const unsigned char*> clBinaryPtrs(    nClBinariesAcquired);
-            std::vector<size_t>               clBinarySizes(   nClBinariesAcquired);
-            std::vector<cl_int>               clBinaryStatuses(nClBinariesAcquired);
+            std::string clBinaryKey = {};
+
+            result = device::GetClBinaryKey(binCreator, device, clBinaryKey);
+            OPENCL_RETURN_ON_ERROR(result);
 
-            for (size_t i = 0; i < nClBinariesAcquired; i++)
+            const auto clBinary = clBinaryPack->Find(clBinaryKey);
+
+            if (!clBinary.has_value())
             {
-                clBinaryPtrs[i]  = clBinaries[i].data();
-                clBinarySizes[i] = clBinaries[i].size();
+                DBG_MSG_STD_OUT("Must create program for context ", context, " from source: ", clBinaryKey,
+                                " does not exist in ", clBinaryPackFilePath);
+                return result;
             }
 
-            program = clCreateProgramWithBinary(context,
-                                                static_cast<cl_uint>(devices.size()),
-                                                devices.data(),
-                                                clBinarySizes.data(),
-                                                clBinaryPtrs.data(),
-                                                clBinaryStatuses.data(),
-                                                &result);
+            DBG_MSG_STD_OUT("Context ", context, " acquired OpenCL binary: ", clBinaryKey);
+
+            clBinaryPtrs.push_back( clBinary->data());
+            clBinarySizes.push_back(clBinary->size());
+        }
+
+        std::vector<cl_int> clBinaryStatuses(devices.size());
+
+        program = clCreateProgramWithBinary(context,
+                                            static_cast<cl_uint>(devices.size()),
+                                            devices.data(),
+                                            clBinarySizes.data(),
+                                            clBinaryPtrs.data(),
+                                            clBinaryStatuses.data(),
+                                            &result);
 
 #ifdef _DEBUG
-            if (result == CL_SUCCESS)
-            {
-                DBG_MSG_STD_OUT("Successfully created program ", program.value(), " from binary for context: ", context);
-            }
-            else
+        if (result == CL_SUCCESS)
+        {
+            DBG_MSG_STD_OUT("Successfully created program ", program.value(), " from binary for context: ", context);
+        }
+        else
+        {
+            for (size_t i = 0; i < devices.size(); i++)
             {
-                for (size_t i = 0; i < devices.size(); i++)
+                if (clBinaryStatuses[i] != CL_SUCCESS)
                 {
-                    if (clBinaryStatuses[i] != CL_SUCCESS)
-                    {
-                        std::string uniqueId = {};
+                    std::string uniqueId = {};
 
-                        const cl_int dbgResult = device::GetUniqueId(devices[i], uniqueId);
-                        OPENCL_RETURN_ON_ERROR(dbgResult);
+                    const cl_int dbgResult = device::GetUniqueId(devices[i], uniqueId);
+                    OPENCL_RETURN_ON_ERROR(dbgResult);
 
-                        DBG_MSG_STD_ERR("Error loading program binary for ", uniqueId, ": ", clBinaryStatuses[i]);
-                    }
+                    DBG_MSG_STD_ERR("Error loading program binary for ", uniqueId, ": ", clBinaryStatuses[i]);
                 }
-
-                return result;
             }
+
+            return result;
+        }
 #endif // _DEBUG
 
+        OPENCL_RETURN_ON_ERROR(result);
+
+        return result;
+    }
+
+
+    cl_int CreateFromIl(const cl_context              context,
+                        const program::SourceCreator& srcCreator,
+                        std::optional<cl_program>&    program)
+    {
+        program.reset();
+
+        cl_int                    result  = CL_SUCCESS;
+        std::vector<cl_device_id> devices = {};
+
+        if (srcCreator.clIl.empty())
+        {
+            return result;
+        }
+
+        result = context::GetDevices(context, devices);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        for (const cl_device_id device : devices)
+        {
+            bool deviceSupportsSpirV = false;
+
+            result = device::SupportsIl(device, "SPIR-V", deviceSupportsSpirV);
             OPENCL_RETURN_ON_ERROR(result);
+
+            if (!deviceSupportsSpirV)
+            {
+                DBG_MSG_STD_OUT("Must create program for context ", context, " from source: device ", device, " does not accept SPIR-V");
+                return result;
+            }
         }
-        else
+
+        const cl_program programCreatedFromIl = clCreateProgramWithIL(context,
+                                                                      srcCreator.clIl.data(),
+                                                                      srcCreator.clIl.size(),
+                                                                      &result);
+
+        // The source remains available to fall back on, so a rejected module is not an error.
+        if (result != CL_SUCCESS)
         {
-            // TODO: add debug message saying not all binaries were found.
+            DBG_MSG_STD_ERR("Failed to create program from SPIR-V for context ", context, " (error code: ", result, ")");
+            return CL_SUCCESS;
         }
 
+        DBG_MSG_STD_OUT("Successfully created program ", programCreatedFromIl, " from SPIR-V for context: ", context);
+
+        program = programCreatedFromIl;
+
         return result;
     }
 
@@ -146,6 +180,19 @@ namespace
         std::vector<const char*> clSourceCStrs = {};
         std::vector<size_t>      clSourceSizes = {};
 
+        // In-memory sources, such as those embedded at compile time, require no file I/O.
+        for (const std::string_view clSourceView : srcCreator.clSources)
+        {
+            clSourceCStrs.push_back(clSourceView.data());
+            clSourceSizes.push_back(clSourceView.size());
+        }
+
+        DBG_BOOL_COND_MSG_STD_OUT(!srcCreator.clSources.empty(),
+                                  "Context ", context, " acquired ", srcCreator.clSources.size(), " in-memory OpenCL source(s)");
+
+        // Pointers into `clSource` are retained, so it must never reallocate.
+        clSource.reserve(srcCreator.clSourceFileNames.size());
+
         for (const std::string& clSourceFileName : srcCreator.clSourceFileNames)
         {
             const std::filesystem::path clSourceFilePath = srcCreator.clSourceRoot / clSourceFileName;
@@ -277,173 +324,486 @@ namespace
 
         OPENCL_RETURN_ON_ERROR(result);
     
-        uint32_t nClBinariesPersisted = 0;
-    
+        std::vector<binary_cache::Record> clBinaryRecords(devices.size());
+
         for (size_t i = 0; i < devices.size(); i++)
         {
-            std::filesystem::path clBinaryDir = {};
-    
-            result = device::GetClBinaryDir(binCreator.clBinaryRoot, devices[i], clBinaryDir);
+            result = device::GetClBinaryKey(binCreator, devices[i], clBinaryRecords[i].key);
             OPENCL_RETURN_ON_ERROR(result);
-    
-            try
-            {
-                std::filesystem::create_directories(clBinaryDir);
-            }
-            catch (const std::filesystem::filesystem_error& e)
-            {
-                MSG_STD_ERR("Failed to create directory ", binCreator.clBinaryRoot, " to store program binary ",
-                    binCreator.clBinaryFileName, ": ", e.what(), " (error code: ", e.code(), ")");
-                break;
-            }
 
-            const std::filesystem::path clBinaryFilePath = clBinaryDir / binCreator.clBinaryFileName;
-    
-            std::ofstream clBinaryOfStream(clBinaryFilePath,
-                                           std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
-    
-            if (!clBinaryOfStream.is_open())
-            {
-                MSG_STD_ERR("Failed to open output stream for OpenCL program binary: ", clBinaryFilePath);
-                break;
-            }
-    
-            clBinaryOfStream.write(reinterpret_cast<const char*>(clBinaries[i].data()),
-                                   clBinaries[i].size());
-    
-            if (clBinaryOfStream.fail())
+            clBinaryRecords[i].binary = clBinaries[i];
+        }
+
+        const std::filesystem::path clBinaryPackFilePath = GetClBinaryPackFilePath(binCreator);
+
+        // All binaries of the program are appended in one locked batch, so concurrent processes never tear them.
+        if (!binary_cache::Append(clBinaryPackFilePath, clBinaryRecords))
+        {
+            MSG_STD_ERR("Failed to persist binaries for program ", program, " to: ", clBinaryPackFilePath);
+            return result;
+        }
+
+        DBG_MSG_STD_OUT("Successfully persisted all binaries for program ", program, " to: ", clBinaryPackFilePath);
+
+        return result;
+    }
+
+
+    cl_int GetBuildResult(const cl_program                    program,
+                          const std::span<const cl_device_id> devices)
+    {
+        cl_int result = CL_SUCCESS;
+
+        for (const cl_device_id device : devices)
+        {
+            cl_build_status buildStatus = CL_BUILD_NONE;
+
+            result = GetBuildStatus(program, device, buildStatus);
+            OPENCL_RETURN_ON_ERROR(result);
+
+            if (buildStatus != CL_BUILD_SUCCESS)
             {
-                MSG_STD_ERR("Failed to write OpenCL program binary to file: ", clBinaryFilePath);
-                break;
+                return CL_BUILD_PROGRAM_FAILURE;
             }
-    
-            nClBinariesPersisted++;
         }
-    
-        DBG_BOOL_COND_MSG_STD_OUT(nClBinariesPersisted == clBinaries.size(),
-                                  "Successfully persisted all binaries for program: ", program);
-    
+
         return result;
     }
-}
 
 
-cl_int program::GetDevices(const cl_program           program,
-                           std::vector<cl_device_id>& devices)
-{
-    cl_int  result   = CL_SUCCESS;
-    cl_uint nDevices = 0;
+    metrics::Histogram& GetBuildSecondsHistogram()
+    {
+        // From a millisecond to about a minute.
+        static metrics::Histogram& buildSeconds =
+            metrics::GetHistogram("program_build_seconds",
+                                  "Time spent in clBuildProgram, including asynchronous completion.",
+                                  metrics::ExponentialBuckets(0.001, 4.0, 9));
 
-    result = clGetProgramInfo(program,
-                              CL_PROGRAM_NUM_DEVICES,
-                              sizeof(nDevices),
-                              &nDevices,
-                              nullptr);
+        return buildSeconds;
+    }
 
-    OPENCL_RETURN_ON_ERROR(result);
 
-    devices.resize(nDevices);
+    // Creates the program from a cached binary if there is one, otherwise from SPIR-V or source. Forcing creation
+    // from source skips SPIR-V too.
+    cl_int Create(const cl_context                                                          context,
+                  const std::optional<std::reference_wrapper<const program::BinaryCreator>> binCreator,
+                  const program::SourceCreator&                                             srcCreator,
+                  const bool                                                                programBinaryCachingEnabled,
+                  bool&                                                                     isCreatedFromBinary,
+                  bool&                                                                     isCreatedFromIl,
+                  cl_program&                                                               program)
+    {
+        cl_int                    result                   = CL_SUCCESS;
+        std::optional<cl_program> programCreatedFromBinary = std::nullopt;
 
-    result = clGetProgramInfo(program,
-                              CL_PROGRAM_DEVICES,
-                              devices.size() * sizeof(cl_device_id),
-                              devices.data(),
-                              nullptr);
+        if (programBinaryCachingEnabled)
+        {
+            static metrics::Counter& cacheHits   = metrics::GetCounter("program_binary_cache_hits_total",
+                                                                       "Programs created from cached binaries.");
+            static metrics::Counter& cacheMisses = metrics::GetCounter("program_binary_cache_misses_total",
+                                                                       "Programs lacking a cached binary.");
 
-    OPENCL_PRINT_ON_ERROR(result);
+            result = CreateFromBinary(context, binCreator.value(), programCreatedFromBinary);
+            OPENCL_RETURN_ON_ERROR(result);
 
-    return result;
-}
+            (programCreatedFromBinary.has_value() ? cacheHits : cacheMisses).Increment();
+        }
 
+        isCreatedFromBinary = programCreatedFromBinary.has_value() && !settings::forceCreateProgramFromSource;
 
-cl_int program::Build(const cl_context                                                 context,
-                      const std::optional<std::reference_wrapper<const BinaryCreator>> binCreator,
-                      const SourceCreator&                                             srcCreator,
-                      const std::string&                                               clBuildOptions,
-                      cl_program&                                                      program)
-{
-    cl_int                    result                      = CL_SUCCESS;
-    std::optional<cl_program> programCreatedFromBinary    = std::nullopt;
-    const bool                programBinaryCachingEnabled = settings::enableProgramBinaryCaching &&
-                                                            binCreator.has_value();
+        if (isCreatedFromBinary)
+        {
+            program = programCreatedFromBinary.value();
+            return result;
+        }
 
-    if (programBinaryCachingEnabled)
-    {
-        result = CreateFromBinary(context, binCreator.value(), programCreatedFromBinary);
-        OPENCL_RETURN_ON_ERROR(result);
+        std::optional<cl_program> programCreatedFromIl = std::nullopt;
+
+        if (!settings::forceCreateProgramFromSource)
+        {
+            result = CreateFromIl(context, srcCreator, programCreatedFromIl);
+            OPENCL_RETURN_ON_ERROR(result);
+        }
+
+        isCreatedFromIl = programCreatedFromIl.has_value();
+
+        if (isCreatedFromIl)
+        {
+            program = programCreatedFromIl.value();
+        }
+        else
+        {
+            result = CreateFromSource(context, srcCreator, program);
+            OPENCL_RETURN_ON_ERROR(result);
+        }
+
+        return result;
     }
 
-    if (settings::forceCreateProgramFromSource || !programCreatedFromBinary.has_value())
+
+    // A driver may accept a SPIR-V module that it then fails to build, while the source still builds. The program
+    // created from the module is replaced by one created from source.
+    cl_int RecreateFromSource(const cl_context              context,
+                              const program::SourceCreator& srcCreator,
+                              cl_program&                   program)
     {
+        DBG_MSG_STD_ERR("Failed to build program ", program, " from SPIR-V, so it is created from source for context: ", context);
+
+        cl_int result = CL_SUCCESS;
+
+        result = clReleaseProgram(program);
+        OPENCL_RETURN_ON_ERROR(result);
+
+        program = nullptr;
+
         result = CreateFromSource(context, srcCreator, program);
         OPENCL_RETURN_ON_ERROR(result);
+
+        return result;
     }
-    else
+
+
+    // Reports the outcome `result` of building `program`, and caches the binaries of a program built from source.
+    cl_int Finish(const cl_context                                                          context,
+                  const std::optional<std::reference_wrapper<const program::BinaryCreator>> binCreator,
+                  const bool                                                                programBinaryCachingEnabled,
+                  const bool                                                                isCreatedFromBinary,
+                  const std::span<const cl_device_id>                                       devices,
+                  cl_int                                                                    result,
+                  const cl_program                                                          program)
     {
-        program = programCreatedFromBinary.value();
-    }
+        // Only debug builds report the context.
+        UNUSED_PARAMETER(context);
 
-    std::vector<cl_device_id> devices = {};
+        switch (result)
+        {
+        case CL_BUILD_PROGRAM_FAILURE:
+        {
+            for (const cl_device_id device : devices)
+            {
+                cl_build_status buildStatus = CL_BUILD_NONE;
 
-    result = context::GetDevices(context, devices);
-    OPENCL_RETURN_ON_ERROR(result);
+                result = GetBuildStatus(program, device, buildStatus);
+                OPENCL_RETURN_ON_ERROR(result);
 
-    result = clBuildProgram(program,
-                            static_cast<cl_uint>(devices.size()),
-                            devices.data(),
-                            clBuildOptions.c_str(),
-                            nullptr,
-                            nullptr);
+                if (buildStatus != CL_BUILD_SUCCESS)
+                {
+                    MSG_STD_ERR("Failed to build program ", program, " for device: ", device);
 
-    switch (result)
-    {
-    case CL_BUILD_PROGRAM_FAILURE:
+                    std::string buildLog = {};
+
+                    result = GetBuildLog(program, device, buildLog);
+                    OPENCL_RETURN_ON_ERROR(result);
+
+                    MSG_STD_ERR(buildLog);
+                }
+            }
+
+            return CL_BUILD_PROGRAM_FAILURE;
+        }
+
+        case CL_SUCCESS:
+        {
+            DBG_MSG_STD_OUT("Successfully built program ", program, " for context: ", context);
+
+            if (programBinaryCachingEnabled && !isCreatedFromBinary)
+            {
+                result = StoreBinaries(program, binCreator.value());
+                OPENCL_RETURN_ON_ERROR(result);
+            }
+
+            break;
+        }
+
+        default:
+            OPENCL_PRINT_ON_ERROR(result);
+            return result;
+        }
+
+        return result;
+    }
+
+
+    cl_int Build(const cl_context                                                          context,
+                 const std::optional<std::reference_wrapper<const program::BinaryCreator>> binCreator,
+                 const program::SourceCreator&                                             srcCreator,
+                 const std::string&                                                        clBuildOptions,
+                 cl_program&                                                               program)
     {
-        for (const cl_device_id device : devices)
+        cl_int                    result                      = CL_SUCCESS;
+        bool                      isCreatedFromBinary         = false;
+        bool                      isCreatedFromIl             = false;
+        std::vector<cl_device_id> devices                     = {};
+        const bool                programBinaryCachingEnabled = settings::enableProgramBinaryCaching &&
+                                                                binCreator.has_value();
+
+        result = Create(context,
+                        binCreator,
+                        srcCreator,
+                        programBinaryCachingEnabled,
+                        isCreatedFromBinary,
+                        isCreatedFromIl,
+                        program);
+
+        OPENCL_RETURN_ON_ERROR(result);
+
+        result = context::GetDevices(context, devices);
+        OPENCL_RETURN_ON_ERROR(result);
+
         {
-            cl_build_status buildStatus = CL_BUILD_NONE;
+            const metrics::ScopedTimer buildTimer(GetBuildSecondsHistogram());
 
-            result = GetBuildStatus(program, device, buildStatus);
-            OPENCL_RETURN_ON_ERROR(result);
+            result = clBuildProgram(program,
+                                    static_cast<cl_uint>(devices.size()),
+                                    devices.data(),
+                                    clBuildOptions.c_str(),
+                                    nullptr,
+                                    nullptr);
 
-            if (buildStatus != CL_BUILD_SUCCESS)
+            if ((result == CL_BUILD_PROGRAM_FAILURE) && isCreatedFromIl)
             {
-                MSG_STD_ERR("Failed to build program ", program, " for device: ", device);
+                result = RecreateFromSource(context, srcCreator, program);
+
+                if (result == CL_SUCCESS)
+                {
+                    result = clBuildProgram(program,
+                                            static_cast<cl_uint>(devices.size()),
+                                            devices.data(),
+                                            clBuildOptions.c_str(),
+                                            nullptr,
+                                            nullptr);
+                }
+            }
+        }
 
-                std::string buildLog = {};
+        return Finish(context, binCreator, programBinaryCachingEnabled, isCreatedFromBinary, devices, result, program);
+    }
 
-                result = GetBuildLog(program, device, buildLog);
-                OPENCL_RETURN_ON_ERROR(result);
 
-                MSG_STD_ERR(buildLog);
+    // One asynchronous build, shared by the pool tasks that start and finish it and the driver callback in between.
+    struct AsyncBuild
+    {
+        cl_context                                                          context;
+        std::optional<std::reference_wrapper<const program::BinaryCreator>> binCreator;
+        const program::SourceCreator&                                       srcCreator;
+        std::string                                                         clBuildOptions;
+        cl_program&                                                         program;
+        bool                                                                programBinaryCachingEnabled;
+        bool                                                                isCreatedFromBinary;
+        bool                                                                isCreatedFromIl;
+        std::vector<cl_device_id>                                           devices;
+        std::chrono::steady_clock::time_point                               start;
+        std::promise<cl_int>                                                buildComplete;
+
+        // Some drivers call back from within a build call that then still fails, so whichever of the callback and
+        // the failed call sets the flag of the attempt first finishes it, and the other leaves it alone. The first
+        // attempt may build SPIR-V, and the second the source it falls back on.
+        std::array<std::atomic_flag, 2>                                     isFinishing;
+    };
+
+
+    // The reference to a build that the driver callback of one of its attempts owns.
+    struct AsyncBuildAttempt
+    {
+        std::shared_ptr<AsyncBuild> build;
+        size_t                      index;
+    };
+
+
+    void StartBuild(const std::shared_ptr<AsyncBuild>& build,
+                    size_t                             attempt);
+
+
+    void FinishAsync(const std::shared_ptr<AsyncBuild>& build,
+                     const size_t                       attempt,
+                     cl_int                             result)
+    {
+        // The build call itself succeeding says nothing about the outcome of an asynchronous build.
+        if (result == CL_SUCCESS)
+        {
+            result = GetBuildResult(build->program, build->devices);
+        }
+
+        if ((result == CL_BUILD_PROGRAM_FAILURE) && build->isCreatedFromIl)
+        {
+            build->isCreatedFromIl = false;
+
+            result = RecreateFromSource(build->context, build->srcCreator, build->program);
+
+            if (result == CL_SUCCESS)
+            {
+                StartBuild(build, attempt + 1);
+                return;
             }
         }
 
-        return CL_BUILD_PROGRAM_FAILURE;
+        GetBuildSecondsHistogram().Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - build->start).count());
+
+        build->buildComplete.set_value(Finish(build->context,
+                                              build->binCreator,
+                                              build->programBinaryCachingEnabled,
+                                              build->isCreatedFromBinary,
+                                              build->devices,
+                                              result,
+                                              build->program));
     }
 
-    case CL_SUCCESS:
+
+    // Runs on a driver thread, which hands the rest of the build, e.g. storing binaries, back to the pool.
+    void CL_CALLBACK NotifyBuildComplete(const cl_program program,
+                                         void* const      pUserData)
     {
-        DBG_MSG_STD_OUT("Successfully built program ", program, " for context: ", context);
+        UNUSED_PARAMETER(program);
+
+        auto* const pAttemptRef = static_cast<AsyncBuildAttempt*>(pUserData);
 
-        if (programBinaryCachingEnabled && !programCreatedFromBinary.has_value())
+        // The failed build call got here first, and frees the reference itself.
+        if (pAttemptRef->build->isFinishing[pAttemptRef->index].test_and_set())
         {
-            result = StoreBinaries(program, binCreator.value());
-            OPENCL_RETURN_ON_ERROR(result);
+            return;
         }
 
-        break;
+        const std::unique_ptr<AsyncBuildAttempt> pAttempt(pAttemptRef);
+
+        static_cast<void>(concurrency::GetHostThreadPool().Submit([build = pAttempt->build, attempt = pAttempt->index]()
+        {
+            FinishAsync(build, attempt, CL_SUCCESS);
+        }));
     }
 
-    default:
-        OPENCL_PRINT_ON_ERROR(result);
-        return result;
+
+    void StartBuild(const std::shared_ptr<AsyncBuild>& build,
+                    const size_t                       attempt)
+    {
+        assert(attempt < build->isFinishing.size());
+
+        // The callback takes ownership of its reference to the build, unless the build call fails first: a build the
+        // driver rejects outright never calls back, so the reference is freed here instead.
+        auto pAttempt = std::make_unique<AsyncBuildAttempt>(AsyncBuildAttempt{ .build = build, .index = attempt });
+
+        const cl_int result = clBuildProgram(build->program,
+                                             static_cast<cl_uint>(build->devices.size()),
+                                             build->devices.data(),
+                                             build->clBuildOptions.c_str(),
+                                             NotifyBuildComplete,
+                                             pAttempt.get());
+
+        // Once the build call succeeds, or the callback finished the attempt first, the reference is the callback's.
+        if ((result == CL_SUCCESS) || build->isFinishing[attempt].test_and_set())
+        {
+            static_cast<void>(pAttempt.release());
+        }
+        else
+        {
+            FinishAsync(build, attempt, result);
+        }
+    }
+
+
+    // Creates the program and starts its build, without waiting for the build on the pool thread that runs this: a
+    // pool thread blocked on a build could deadlock tasks that the build is itself waited on by.
+    void StartAsync(const std::shared_ptr<AsyncBuild>& build)
+    {
+        cl_int result = CL_SUCCESS;
+
+        result = Create(build->context,
+                        build->binCreator,
+                        build->srcCreator,
+                        build->programBinaryCachingEnabled,
+                        build->isCreatedFromBinary,
+                        build->isCreatedFromIl,
+                        build->program);
+
+        if (result == CL_SUCCESS)
+        {
+            result = context::GetDevices(build->context, build->devices);
+        }
+
+        if (result != CL_SUCCESS)
+        {
+            OPENCL_PRINT_ON_ERROR(result);
+            build->buildComplete.set_value(result);
+            return;
+        }
+
+        build->start = std::chrono::steady_clock::now();
+
+        StartBuild(build, 0);
     }
+}
+
+
+cl_int program::GetDevices(const cl_program           program,
+                           std::vector<cl_device_id>& devices)
+{
+    cl_int  result   = CL_SUCCESS;
+    cl_uint nDevices = 0;
+
+    result = clGetProgramInfo(program,
+                              CL_PROGRAM_NUM_DEVICES,
+                              sizeof(nDevices),
+                              &nDevices,
+                              nullptr);
+
+    OPENCL_RETURN_ON_ERROR(result);
+
+    devices.resize(nDevices);
+
+    result = clGetProgramInfo(program,
+                              CL_PROGRAM_DEVICES,
+                              devices.size() * sizeof(cl_device_id),
+                              devices.data(),
+                              nullptr);
+
+    OPENCL_PRINT_ON_ERROR(result);
 
     return result;
 }
 
 
+cl_int program::Build(const cl_context                                                 context,
+                      const std::optional<std::reference_wrapper<const BinaryCreator>> binCreator,
+                      const SourceCreator&                                             srcCreator,
+                      const std::string&                                               clBuildOptions,
+                      cl_program&                                                      program)
+{
+    return ::Build(context, binCreator, srcCreator, clBuildOptions, program);
+}
+
+
+std::future<cl_int> program::BuildAsync(const cl_context                                                 context,
+                                        const std::optional<std::reference_wrapper<const BinaryCreator>> binCreator,
+                                        const SourceCreator&                                             srcCreator,
+                                        const std::string&                                               clBuildOptions,
+                                        cl_program&                                                      program)
+{
+    // Built in place, as its flags can be neither copied nor moved.
+    const std::shared_ptr<AsyncBuild> build(new AsyncBuild
+    {
+        .context                     = context,
+        .binCreator                  = binCreator,
+        .srcCreator                  = srcCreator,
+        .clBuildOptions              = clBuildOptions,
+        .program                     = program,
+        .programBinaryCachingEnabled = settings::enableProgramBinaryCaching && binCreator.has_value(),
+        .isCreatedFromBinary         = false,
+        .isCreatedFromIl             = false,
+        .devices                     = {},
+        .start                       = {},
+        .buildComplete               = {},
+        .isFinishing                 = {}
+    });
+
+    std::future<cl_int> buildComplete = build->buildComplete.get_future();
+
+    // Creation, which may read sources or binaries from disk, happens on the pool too, so the caller never blocks.
+    // No pool thread waits for the build itself, whose completion callback resumes it on the pool.
+    static_cast<void>(concurrency::GetHostThreadPool().Submit([build]() { StartAsync(build); }));
+
+    return buildComplete;
+}
+
+
 cl_int program::CreateKernels(const cl_program                   program,
                               const std::span<const std::string> kernelNames,
                               const std::span<cl_kernel>         kernels)
@@ -464,4 +824,18 @@ cl_int program::CreateKernels(const cl_program                   program,
     }
 
     return result;
+}
+
+std::string program::GetBinaryFileName(const std::string_view clBinaryFileName,
+                                       const std::string_view clBuildOptions)
+{
+    // Options may hold anything, e.g. paths, so only their hash goes into the name, ahead of the extensions.
+    const size_t       extensionOffset = std::min(clBinaryFileName.find('.'), clBinaryFileName.size());
+    std::ostringstream fileName        = {};
+
+    fileName << clBinaryFileName.substr(0, extensionOffset)
+             << "_" << std::hex << std::setfill('0') << std::setw(16) << hash::Fnv1a(clBuildOptions)
+             << clBinaryFileName.substr(extensionOffset);
+
+    return std::move(fileName).str();
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "program.h"
+#include "program_types.h"
+#include "test_fixture.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <future>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+    constexpr std::string_view ValidSource = R"(
+        kernel void fill(global float* out, const float value)
+        {
+            out[get_global_id(0)] = value;
+        }
+    )";
+
+    constexpr std::string_view InvalidSource = R"(
+        kernel void fill(global float* out)
+        {
+            out[get_global_id(0)] = undeclared;
+        }
+    )";
+
+    const std::array<const std::string, 1> KernelNames = { "fill" };
+
+
+    program::SourceCreator MakeSourceCreator(const std::string_view clSource)
+    {
+        return
+        {
+            .clSourceRoot      = {},
+            .clSourceFileNames = {},
+            .clSources         = { clSource },
+            .clIl              = {}
+        };
+    }
+}
+
+
+class ProgramTest : public test_fixture::ContextTest
+{
+protected:
+    static void ReleasePrograms(const std::span<const cl_program> programs) noexcept
+    {
+        for (const cl_program program : programs)
+        {
+            if (program != nullptr)
+            {
+                const cl_int result = clReleaseProgram(program);
+                EXPECT_EQ(result, CL_SUCCESS);
+            }
+        }
+    }
+};
+
+
+TEST_F(ProgramTest, BuildsAsynchronously)
+{
+    const program::SourceCreator srcCreator = MakeSourceCreator(ValidSource);
+    cl_program                   program    = nullptr;
+
+    // Built from source every time, as a cached binary would outlive the source embedded here.
+    std::future<cl_int> build = program::BuildAsync(s_context, std::nullopt, srcCreator, "", program);
+
+    ASSERT_EQ(build.get(), CL_SUCCESS);
+    ASSERT_NE(program, nullptr);
+
+    std::array<cl_kernel, 1> kernels = {};
+
+    const cl_int result = program::CreateKernels(program, KernelNames, kernels);
+    EXPECT_EQ(result, CL_SUCCESS);
+
+    ReleaseKernels(kernels);
+    ReleasePrograms({ &program, 1 });
+}
+
+
+TEST_F(ProgramTest, ReportsAsynchronousBuildFailures)
+{
+    const program::SourceCreator srcCreator = MakeSourceCreator(InvalidSource);
+    cl_program                   program    = nullptr;
+
+    std::future<cl_int> build = program::BuildAsync(s_context, std::nullopt, srcCreator, "", program);
+
+    // The future is set exactly once, however the driver reports the failure.
+    EXPECT_EQ(build.get(), CL_BUILD_PROGRAM_FAILURE);
+
+    ReleasePrograms({ &program, 1 });
+}
+
+
+TEST_F(ProgramTest, BuildsManyProgramsConcurrently)
+{
+    constexpr size_t Builds = 32;
+
+    const program::SourceCreator validCreator   = MakeSourceCreator(ValidSource);
+    const program::SourceCreator invalidCreator = MakeSourceCreator(InvalidSource);
+
+    // Every fourth build fails, so failures complete among successes. Distinct options keep drivers from reusing
+    // one build for all of them.
+    std::vector<cl_program>          programs(Builds, nullptr);
+    std::vector<std::string>         options(Builds);
+    std::vector<std::future<cl_int>> builds = {};
+
+    for (size_t i = 0; i < Builds; i++)
+    {
+        options[i] = "-DBUILD_INDEX=" + std::to_string(i);
+
+        builds.push_back(program::BuildAsync(s_context,
+                                             std::nullopt,
+                                             (i % 4 == 3) ? invalidCreator : validCreator,
+                                             options[i],
+                                             programs[i]));
+    }
+
+    for (size_t i = 0; i < Builds; i++)
+    {
+        EXPECT_EQ(builds[i].get(), (i % 4 == 3) ? CL_BUILD_PROGRAM_FAILURE : CL_SUCCESS) << "Build " << i;
+    }
+
+    ReleasePrograms(programs);
+}
\ No newline at end of file
@@ -1,6 +1,10 @@
 #ifndef UTILITIES_SETTINGS_H
 #define UTILITIES_SETTINGS_H
 
+#include <filesystem>
+#include <stdint.h>
+#include <string_view>
+
 
 namespace settings
 {
@@ -12,12 +16,23 @@ namespace settings
     inline extern const bool displayGeneralDeviceInfo     = false;
     inline extern const bool enableProgramBinaryCaching   = true;
     inline extern const bool forceCreateProgramFromSource = true;
+    inline extern const bool persistDiscoverySnapshot     = false;
 #elif defined(_RELEASE)
     inline extern const bool displayPlatformInfo          = false;
     inline extern const bool displayGeneralDeviceInfo     = false;
     inline extern const bool enableProgramBinaryCaching   = true;
     inline extern const bool forceCreateProgramFromSource = false;
+    inline extern const bool persistDiscoverySnapshot     = true;
 #endif // _RELEASE
+
+    inline extern const std::string_view programBinaryPackFileName                   = "ClBinaries.pack";
+    inline extern const uint64_t         programBinaryPackCompactionThresholdInBytes = 16 * 1024 * 1024;
+
+    inline extern const uint32_t specializationHitsBeforeBuild = 8;
+
+    inline extern const std::filesystem::path discoverySnapshotFilePath = std::filesystem::current_path() / "ClDiscovery.snapshot";
+    inline extern const std::filesystem::path deviceProfilesFilePath    = std::filesystem::current_path() / "ClDeviceProfiles.txt";
+    inline extern const std::filesystem::path apiTraceFilePath          = std::filesystem::current_path() / "ClApiTrace.json";
 }
 
 
@@ -0,0 +1,188 @@
+#include "debug.h"
+#include "program.h"
+#include "settings.h"
+#include "specialization.h"
+#include "tracing.h"
+
+#include <chrono>
+#include <functional>
+
+
+specialization::Cache::Cache(const program::BinaryCreator& binCreator,
+                             const program::SourceCreator& srcCreator,
+                             std::string                   clBuildOptions) :
+    Cache(binCreator, srcCreator, std::move(clBuildOptions), settings::specializationHitsBeforeBuild)
+{
+}
+
+
+specialization::Cache::Cache(const program::BinaryCreator& binCreator,
+                             const program::SourceCreator& srcCreator,
+                             std::string                   clBuildOptions,
+                             const uint32_t                hitsBeforeSpecializing) :
+    m_binCreator(binCreator),
+    // SPIR-V is compiled before any "-D" option could apply, so specializations are always built from source.
+    m_srcCreator{ srcCreator.clSourceRoot, srcCreator.clSourceFileNames, srcCreator.clSources, {} },
+    m_clBuildOptions(std::move(clBuildOptions)),
+    m_hitsBeforeSpecializing(hitsBeforeSpecializing)
+{
+}
+
+
+specialization::Cache::~Cache() noexcept
+{
+    const std::lock_guard lock(m_mutex);
+
+    // Outstanding builds write to their entries, so they must finish before anything is released.
+    for (auto& [key, entry] : m_entries)
+    {
+        if (entry.state == State::Building)
+        {
+            CompleteBuild(entry);
+        }
+
+        if (entry.program != nullptr)
+        {
+            clReleaseProgram(entry.program);
+        }
+    }
+}
+
+
+specialization::Cache::Entry& specialization::Cache::GetEntry(const cl_context   context,
+                                                              const std::string& specializationOptions)
+{
+    const auto [entry, inserted] = m_entries.try_emplace({ context, specializationOptions });
+
+    if (inserted)
+    {
+        entry->second.clBuildOptions = m_clBuildOptions + " " + specializationOptions;
+
+        // Each specialization caches a binary of its own, which an edited source retires like any other.
+        entry->second.binCreator                  = m_binCreator;
+        entry->second.binCreator.clBinaryFileName = program::GetBinaryFileName(m_binCreator.clBinaryFileName,
+                                                                               entry->second.clBuildOptions);
+
+        entry->second.hits    = 0;
+        entry->second.state   = State::Counting;
+        entry->second.program = nullptr;
+    }
+
+    return entry->second;
+}
+
+
+void specialization::Cache::StartBuild(const cl_context context,
+                                       Entry&           entry)
+{
+    // `std::map` never moves its entries, so they safely outlive the build referring to them.
+    entry.state = State::Building;
+    entry.build = program::BuildAsync(context,
+                                      std::cref(entry.binCreator),
+                                      m_srcCreator,
+                                      entry.clBuildOptions,
+                                      entry.program);
+}
+
+
+void specialization::Cache::CompleteBuild(Entry& entry)
+{
+    const cl_int result = entry.build.get();
+
+    if (result == CL_SUCCESS)
+    {
+        entry.state = State::Built;
+        return;
+    }
+
+    // A specialization that failed once fails again, so it is never retried and callers keep the generic program.
+    MSG_STD_ERR("Failed to build specialization: ", entry.clBuildOptions);
+
+    entry.state = State::Failed;
+
+    if (entry.program != nullptr)
+    {
+        clReleaseProgram(entry.program);
+        entry.program = nullptr;
+    }
+}
+
+
+cl_int specialization::Cache::Find(const cl_context           context,
+                                   const std::string&         specializationOptions,
+                                   std::optional<cl_program>& program)
+{
+    program.reset();
+
+    const std::lock_guard lock(m_mutex);
+    Entry&                entry = GetEntry(context, specializationOptions);
+
+    switch (entry.state)
+    {
+    case State::Counting:
+        if (++entry.hits >= m_hitsBeforeSpecializing)
+        {
+            StartBuild(context, entry);
+        }
+
+        break;
+
+    case State::Building:
+        if (entry.build.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            CompleteBuild(entry);
+        }
+
+        break;
+
+    case State::Built:
+    case State::Failed:
+        break;
+    }
+
+    if (entry.state == State::Built)
+    {
+        program = entry.program;
+    }
+
+    return CL_SUCCESS;
+}
+
+
+cl_int specialization::Cache::Specialize(const cl_context   context,
+                                         const std::string& specializationOptions,
+                                         cl_program&        program)
+{
+    std::unique_lock           lock(m_mutex);
+    Entry&                     entry = GetEntry(context, specializationOptions);
+    std::shared_future<cl_int> build = {};
+
+    if (entry.state == State::Counting)
+    {
+        StartBuild(context, entry);
+    }
+
+    if (entry.state == State::Building)
+    {
+        build = entry.build;
+
+        lock.unlock();
+        build.wait();
+        lock.lock();
+
+        // A concurrent `Find` may have completed the build in the meantime.
+        if (entry.state == State::Building)
+        {
+            CompleteBuild(entry);
+        }
+    }
+
+    if (entry.state == State::Failed)
+    {
+        return CL_BUILD_PROGRAM_FAILURE;
+    }
+
+    program = entry.program;
+
+    return CL_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#ifndef UTILITIES_TEST_FIXTURE_H
+#define UTILITIES_TEST_FIXTURE_H
+
+#include "context.h"
+#include "platform.h"
+#include "program.h"
+
+#include <CL/cl.h>
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <span>
+#include <stdlib.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace test_fixture
+{
+    // Suites needing an OpenCL context skip all of their tests on machines without one.
+    inline constexpr std::string_view NoContextMessage = "No OpenCL context was created.";
+
+    // A whole number in [0, RAND_MAX].
+    inline float GetRandFloat() noexcept
+    {
+        return static_cast<float>(std::rand());
+    }
+
+    // A whole number in [-RAND_MAX / 2, RAND_MAX / 2].
+    inline float GetRandCenteredFloat() noexcept
+    {
+        return static_cast<float>(std::rand() - (RAND_MAX / 2));
+    }
+
+    // A number in [-1, 1], for sums that must stay small enough to compare with a relative tolerance.
+    inline float GetRandUnitFloat() noexcept
+    {
+        return (2.0f * static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX)) - 1.0f;
+    }
+
+    // Programs are built from source at most once per suite, so the compiler can be unloaded right after.
+    inline void UnloadCompiler(const cl_platform_id platform)
+    {
+        const cl_int result = clUnloadPlatformCompiler(platform);
+        ASSERT_EQ(result, CL_SUCCESS);
+    }
+
+
+    // A context on the platform of highest throughput for a whole suite, with an optional program, and an in-order
+    // queue on its first device for each test. Suites extending `SetUpTestSuite` call it first, and stop unless
+    // `s_context` was created. Benchmarks are named `DISABLED_*Benchmark`, so they only run on request, e.g. with
+    // --gtest_also_run_disabled_tests --gtest_filter=*Benchmark.
+    class ContextTest : public testing::Test
+    {
+    protected:
+        static void SetUpTestSuite()
+        {
+            cl_int                    result  = CL_SUCCESS;
+            std::optional<cl_context> context = std::nullopt;
+
+            result = context::Create(platform::HighestThroughput, s_platform, context);
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            if (context.has_value())
+            {
+                s_context = context.value();
+            }
+            else
+            {
+                GTEST_SKIP() << NoContextMessage;
+            }
+        }
+
+        static void TearDownTestSuite() noexcept
+        {
+            cl_int result = CL_SUCCESS;
+
+            if (s_program != nullptr)
+            {
+                result = clReleaseProgram(s_program);
+                EXPECT_EQ(result, CL_SUCCESS);
+            }
+
+            if (s_context != nullptr)
+            {
+                result = clReleaseContext(s_context);
+                EXPECT_EQ(result, CL_SUCCESS);
+            }
+
+            s_platform.reset();
+            s_context = nullptr;
+            s_program = nullptr;
+        }
+
+        // Builds `s_program` for every device of the context, then unloads the compiler.
+        static void BuildProgram(const program::BinaryCreator& binCreator,
+                                 const program::SourceCreator& srcCreator,
+                                 const std::string&            options)
+        {
+            cl_int result = CL_SUCCESS;
+
+            result = program::Build(s_context,
+                                    std::cref(binCreator),
+                                    srcCreator,
+                                    options,
+                                    s_program);
+
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            UnloadCompiler(s_platform.value());
+        }
+
+        void SetUp() override
+        {
+            CreateQueue({});
+        }
+
+        void TearDown() noexcept override
+        {
+            if (m_queue != nullptr)
+            {
+                const cl_int result = clReleaseCommandQueue(m_queue);
+                EXPECT_EQ(result, CL_SUCCESS);
+            }
+        }
+
+        // Creates `m_queue` on the first device of the context. Unless empty, `queueProperties` must end with 0.
+        void CreateQueue(const std::span<const cl_queue_properties> queueProperties)
+        {
+            cl_int                    result  = CL_SUCCESS;
+            std::vector<cl_device_id> devices = {};
+
+            result = context::GetDevices(s_context, devices);
+            ASSERT_EQ(result, CL_SUCCESS);
+
+            m_queue = clCreateCommandQueueWithProperties(s_context,
+                                                         devices[0],
+                                                         queueProperties.empty() ? nullptr : queueProperties.data(),
+                                                         &result);
+
+            ASSERT_EQ(result, CL_SUCCESS);
+        }
+
+        static void ReleaseKernels(const std::span<const cl_kernel> kernels) noexcept
+        {
+            for (const cl_kernel kernel : kernels)
+            {
+                if (kernel != nullptr)
+                {
+                    const cl_int result = clReleaseKernel(kernel);
+                    EXPECT_EQ(result, CL_SUCCESS);
+                }
+            }
+        }
+
+        cl_command_queue m_queue = nullptr;
+
+        inline static std::optional<cl_platform_id> s_platform = std::nullopt;
+        inline static cl_context                    s_context  = nullptr;
+        inline static cl_program                    s_program  = nullptr;
+    };
+}
+
+
+#endif // UTILITIES_TEST_FIXTURE_H
\ No newline at end of file
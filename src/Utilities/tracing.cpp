@@ -0,0 +1,179 @@
+#include "tracing.h"
+
+#ifdef OPENCL_API_TRACING
+
+#include "debug.h"
+#include "json.h"
+#include "settings.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace
+{
+    // Bounds the memory of a long traced run; latency histograms keep counting beyond it.
+    constexpr size_t MaxEventsPerThread = 1 << 20;
+
+    struct Event
+    {
+        std::string_view apiName;
+        int64_t          startInNs;
+        int64_t          durationInNs;
+        std::string      argsSummary;
+    };
+
+    // Only ever contended while the trace is being written.
+    struct ThreadTrace
+    {
+        std::mutex         mutex          = {};
+        uint32_t           threadIndex    = 0;
+        std::vector<Event> events         = {};
+        size_t             nDroppedEvents = 0;
+    };
+
+    // Never destroyed, so threads still calling OpenCL during exit can keep recording.
+    struct Trace
+    {
+        std::mutex                                mutex   = {};
+        std::chrono::steady_clock::time_point     origin  = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<ThreadTrace>> threads = {};
+    };
+
+
+    Trace& GetTrace();
+
+
+    void WriteTraceOnExit()
+    {
+        if (tracing::WriteTrace(settings::apiTraceFilePath))
+        {
+            DBG_MSG_STD_OUT("Wrote OpenCL API trace: ", settings::apiTraceFilePath);
+        }
+    }
+
+
+    Trace& GetTrace()
+    {
+        static Trace* const trace = []()
+        {
+            std::atexit(WriteTraceOnExit);
+            return new Trace();
+        }();
+
+        return *trace;
+    }
+
+
+    ThreadTrace& GetThreadTrace()
+    {
+        thread_local const std::shared_ptr<ThreadTrace> threadTrace = []()
+        {
+            Trace&                trace       = GetTrace();
+            const std::lock_guard lock(trace.mutex);
+            auto                  threadTrace = std::make_shared<ThreadTrace>();
+
+            threadTrace->threadIndex = static_cast<uint32_t>(trace.threads.size());
+            trace.threads.push_back(threadTrace);
+
+            return threadTrace;
+        }();
+
+        return *threadTrace;
+    }
+}
+
+
+metrics::Histogram& tracing::GetLatencyHistogram(const std::string_view apiName)
+{
+    // Every call gets its histogram before timing starts, so this sets the origin before the first event.
+    GetTrace();
+
+    std::string name = "opencl_api_";
+    name += apiName;
+    name += "_seconds";
+
+    // From 100 ns to about half a second.
+    return metrics::GetHistogram(name,
+                                 "Host time spent in the OpenCL call.",
+                                 metrics::ExponentialBuckets(1e-7, 4.0, 12));
+}
+
+
+void tracing::RecordEvent(const std::string_view                      apiName,
+                          const std::chrono::steady_clock::time_point start,
+                          const std::chrono::steady_clock::time_point end,
+                          std::string&&                               argsSummary)
+{
+    const std::chrono::steady_clock::time_point origin      = GetTrace().origin;
+    ThreadTrace&                                threadTrace = GetThreadTrace();
+    const std::lock_guard                       lock(threadTrace.mutex);
+
+    if (threadTrace.events.size() >= MaxEventsPerThread)
+    {
+        threadTrace.nDroppedEvents++;
+        return;
+    }
+
+    threadTrace.events.push_back(
+    {
+        .apiName      = apiName,
+        .startInNs    = std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin).count(),
+        .durationInNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+        .argsSummary  = std::move(argsSummary)
+    });
+}
+
+
+bool tracing::WriteTrace(const std::filesystem::path& traceFilePath)
+{
+    std::ofstream traceOfStream(traceFilePath, std::ios::binary | std::ios::trunc);
+
+    if (!traceOfStream)
+    {
+        MSG_STD_ERR("Failed to open trace file: ", traceFilePath);
+        return false;
+    }
+
+    Trace&                trace   = GetTrace();
+    const std::lock_guard lock(trace.mutex);
+    bool                  isFirst = true;
+
+    traceOfStream << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+    for (const std::shared_ptr<ThreadTrace>& threadTrace : trace.threads)
+    {
+        const std::lock_guard threadLock(threadTrace->mutex);
+
+        // Timestamps are in microseconds, with fractions down to nanoseconds.
+        for (const Event& event : threadTrace->events)
+        {
+            traceOfStream << (isFirst ? "\n" : ",\n");
+            traceOfStream << "{\"name\": \"" << event.apiName << "\", \"ph\": \"X\", \"pid\": 0, "
+                          << "\"tid\": " << threadTrace->threadIndex << ", "
+                          << "\"ts\": " << event.startInNs / 1000 << "." << std::setw(3) << std::setfill('0') << event.startInNs % 1000 << ", "
+                          << "\"dur\": " << event.durationInNs / 1000 << "." << std::setw(3) << std::setfill('0') << event.durationInNs % 1000 << ", "
+                          << "\"args\": {\"call\": ";
+
+            json::WriteString(traceOfStream, event.argsSummary);
+            traceOfStream << "}}";
+
+            isFirst = false;
+        }
+
+        if (threadTrace->nDroppedEvents != 0)
+        {
+            MSG_STD_ERR("Dropped ", threadTrace->nDroppedEvents, " OpenCL API events of thread ", threadTrace->threadIndex);
+        }
+    }
+
+    traceOfStream << "\n]}\n";
+
+    return traceOfStream.flush().good();
+}
+
+#endif // OPENCL_API_TRACING
\ No newline at end of file
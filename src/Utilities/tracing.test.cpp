@@ -0,0 +1,154 @@
+#include "tracing.h"
+
+#ifdef OPENCL_API_TRACING
+
+#include "metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+
+namespace
+{
+    // A trace file in the temporary directory, removed along with the test.
+    class TraceFile
+    {
+    public:
+        TraceFile() :
+            m_path(std::filesystem::temp_directory_path() /
+                   ("tracing_test_" + std::string(testing::UnitTest::GetInstance()->current_test_info()->name()) + ".json"))
+        {
+        }
+
+        ~TraceFile() noexcept
+        {
+            std::error_code ec = {};
+            std::filesystem::remove(m_path, ec);
+        }
+
+        [[nodiscard]] const std::filesystem::path& GetPath() const { return m_path; }
+
+        [[nodiscard]] std::string Read() const
+        {
+            std::ifstream      traceIfStream(m_path, std::ios::binary);
+            std::ostringstream trace = {};
+
+            trace << traceIfStream.rdbuf();
+
+            return std::move(trace).str();
+        }
+
+    private:
+        std::filesystem::path m_path;
+    };
+
+
+    // The line of the trace holding the event of `apiName`, or an empty string.
+    std::string FindEvent(const std::string&     trace,
+                          const std::string_view apiName)
+    {
+        const std::string name  = "{\"name\": \"" + std::string(apiName) + "\"";
+        const size_t      begin = trace.find(name);
+
+        if (begin == std::string::npos)
+        {
+            return {};
+        }
+
+        return trace.substr(begin, trace.find('\n', begin) - begin);
+    }
+}
+
+
+TEST(Tracing, RecordsCallsThroughTheShim)
+{
+    metrics::Histogram& latency     = tracing::GetLatencyHistogram("clGetPlatformIDs");
+    const uint64_t      countBefore = latency.Read().count;
+
+    // Traced whatever it returns, e.g. on machines without any platform.
+    cl_uint      nPlatforms = 0;
+    const cl_int result     = clGetPlatformIDs(0, nullptr, &nPlatforms);
+
+    EXPECT_EQ(latency.Read().count - countBefore, uint64_t(1));
+
+    const TraceFile traceFile = {};
+
+    ASSERT_TRUE(tracing::WriteTrace(traceFile.GetPath()));
+
+    const std::string event = FindEvent(traceFile.Read(), "clGetPlatformIDs");
+
+    ASSERT_FALSE(event.empty());
+    EXPECT_NE(event.find(" -> " + std::to_string(result) + "\"}}"), std::string::npos) << event;
+}
+
+
+TEST(Tracing, WritesEventsOfEveryThreadAsJson)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    tracing::RecordEvent("tracing_test_main",
+                         start,
+                         start + std::chrono::nanoseconds(1500),
+                         "quote \", backslash \\, line\nfeed, tab\t, bell\a");
+
+    std::thread([start]()
+    {
+        tracing::RecordEvent("tracing_test_worker", start, start + std::chrono::microseconds(2), "worker");
+    }).join();
+
+    const TraceFile traceFile = {};
+
+    ASSERT_TRUE(tracing::WriteTrace(traceFile.GetPath()));
+
+    const std::string trace = traceFile.Read();
+
+    EXPECT_TRUE(trace.starts_with("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n"));
+    EXPECT_TRUE(trace.ends_with("\n]}\n"));
+
+    // Only the lines of the file break it up; everything else inside strings is escaped.
+    EXPECT_TRUE(std::ranges::all_of(trace, [](const char character)
+    {
+        return (character == '\n') || (static_cast<unsigned char>(character) >= 0x20);
+    }));
+
+    const std::string mainEvent   = FindEvent(trace, "tracing_test_main");
+    const std::string workerEvent = FindEvent(trace, "tracing_test_worker");
+
+    ASSERT_FALSE(mainEvent.empty());
+    ASSERT_FALSE(workerEvent.empty());
+
+    EXPECT_NE(mainEvent.find("\"ph\": \"X\""), std::string::npos) << mainEvent;
+    EXPECT_NE(mainEvent.find("\"dur\": 1.500, "), std::string::npos) << mainEvent;
+    EXPECT_NE(mainEvent.find("\"args\": {\"call\": \"quote \\\", backslash \\\\, line\\u000afeed, tab\\u0009, bell\\u0007\"}}"),
+              std::string::npos) << mainEvent;
+    EXPECT_NE(workerEvent.find("\"dur\": 2.000, "), std::string::npos) << workerEvent;
+
+    // Each thread records into a trace of its own, which gets a thread ID of its own.
+    const auto GetThreadId = [](const std::string& event)
+    {
+        const size_t begin = event.find("\"tid\": ");
+        return event.substr(begin, event.find(',', begin) - begin);
+    };
+
+    EXPECT_NE(GetThreadId(mainEvent), GetThreadId(workerEvent));
+}
+
+
+TEST(Tracing, ReportsUnwritableTraces)
+{
+    const std::filesystem::path missingDirectory = std::filesystem::temp_directory_path() / "tracing_test_missing";
+
+    std::filesystem::remove_all(missingDirectory);
+
+    EXPECT_FALSE(tracing::WriteTrace(missingDirectory / "ClApiTrace.json"));
+}
+
+#endif // OPENCL_API_TRACING
\ No newline at end of file
@@ -0,0 +1,75 @@
+# Compiles OpenCL sources ahead of time to SPIR-V, so that devices accepting IL skip the OpenCL C front-end at runtime.
+#
+# For each source `<stem>.cl`, the portable artifact `Spirv/<stem>.spv` is produced and embedded as a header
+# `Embedded/<stem>.spv.h` that defines
+#     embedded::spirv::<stem>::il     - the SPIR-V module, as a constexpr string view.
+#     embedded::spirv::<stem>::ilHash - the FNV-1a hash of the SPIR-V module, computed at compile time.
+# and `EMBEDDED_SPIRV_<STEM>` is defined for the target, so build headers know whether the module exists.
+#
+# Requires clang and llvm-spirv. When either is missing, nothing is generated and programs are built from source.
+
+find_program(CLANG_EXECUTABLE NAMES clang)
+find_program(LLVM_SPIRV_EXECUTABLE NAMES llvm-spirv)
+
+function(compile_cl_sources_to_spirv target)
+    if (NOT CLANG_EXECUTABLE OR NOT LLVM_SPIRV_EXECUTABLE)
+        message(STATUS "clang or llvm-spirv not found: ${target} OpenCL programs will be built from source at runtime")
+        return()
+    endif()
+
+    set(spirvDir    ${CMAKE_CURRENT_BINARY_DIR}/Spirv)
+    set(embeddedDir ${CMAKE_CURRENT_BINARY_DIR}/Embedded)
+    set(embeddedHeaders)
+
+    file(MAKE_DIRECTORY ${spirvDir})
+
+    foreach(clSource IN LISTS ARGN)
+        get_filename_component(clSourcePath ${clSource} ABSOLUTE)
+        get_filename_component(clSourceStem ${clSource} NAME_WE)
+        set(llvmBitcode    ${spirvDir}/${clSourceStem}.bc)
+        set(spirvModule    ${spirvDir}/${clSourceStem}.spv)
+        set(embeddedHeader ${embeddedDir}/${clSourceStem}.spv.h)
+
+        # The defines and language version mirror the runtime build options of each module.
+        add_custom_command(OUTPUT ${spirvModule}
+                           COMMAND ${CLANG_EXECUTABLE}
+                                   -c -target spir64 -cl-std=CL2.0 -emit-llvm
+                                   -Xclang -finclude-default-header
+                                   $<$<CONFIG:Debug>:-D_DEBUG> $<$<CONFIG:Debug>:-O0>
+                                   $<$<CONFIG:Release>:-D_RELEASE> $<$<CONFIG:Release>:-O2>
+                                   -o ${llvmBitcode}
+                                   ${clSourcePath}
+                           COMMAND ${LLVM_SPIRV_EXECUTABLE}
+                                   ${llvmBitcode}
+                                   -o ${spirvModule}
+                           DEPENDS ${clSourcePath}
+                           COMMENT "Compiling OpenCL source ${clSource} to SPIR-V"
+                           VERBATIM
+                           COMMAND_EXPAND_LISTS)
+
+        add_custom_command(OUTPUT ${embeddedHeader}
+                           COMMAND ${CMAKE_COMMAND}
+                                   -DINPUT=${spirvModule}
+                                   -DOUTPUT=${embeddedHeader}
+                                   -DNAMESPACE=embedded::spirv::${clSourceStem}
+                                   -DVARIABLE=il
+                                   -P ${EMBED_CL_SOURCES_SCRIPT}
+                           DEPENDS ${spirvModule} ${EMBED_CL_SOURCES_SCRIPT}
+                           COMMENT "Embedding SPIR-V module ${clSourceStem}.spv"
+                           VERBATIM)
+
+        list(APPEND embeddedHeaders ${embeddedHeader})
+
+        string(MAKE_C_IDENTIFIER ${clSourceStem} clSourceIdentifier)
+        string(TOUPPER ${clSourceIdentifier} clSourceIdentifier)
+
+        target_compile_definitions(${target} PUBLIC
+                                       EMBEDDED_SPIRV_${clSourceIdentifier})
+    endforeach()
+
+    target_sources(${target} PRIVATE
+                       ${embeddedHeaders})
+
+    target_include_directories(${target} PUBLIC
+                                   ${embeddedDir})
+endfunction()
\ No newline at end of file
@@ -0,0 +1,88 @@
+# Embeds OpenCL sources into the binary, so that kernels are not read from the build tree at runtime.
+#
+# For each source `<stem>.cl`, a header `Embedded/<stem>.cl.h` is generated that defines
+#     embedded::cl::<stem>::source     - the source text, as a constexpr string view.
+#     embedded::cl::<stem>::sourceHash - the FNV-1a hash of the source text, computed at compile time.
+#
+# This file doubles as the script that embeds any file when invoked with `cmake -P`, which generates a header
+# defining `<NAMESPACE>::<VARIABLE>` and `<NAMESPACE>::<VARIABLE>Hash` for the contents of `INPUT`.
+
+if (CMAKE_SCRIPT_MODE_FILE)
+    file(READ ${INPUT} sourceHex HEX)
+    string(LENGTH "${sourceHex}" sourceHexLength)
+    math(EXPR sourceSizeInBytes "${sourceHexLength} / 2")
+
+    # 16 bytes per line.
+    string(REGEX REPLACE "([0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f])"
+                         "\\1\n        " sourceHex "${sourceHex}")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "'\\\\x\\1', " sourceBytes "${sourceHex}")
+    string(REGEX REPLACE ", +\n" ",\n" sourceBytes "${sourceBytes}")
+    string(REGEX REPLACE "[, \n]+$" "" sourceBytes "${sourceBytes}")
+    get_filename_component(outputName ${OUTPUT} NAME)
+    string(MAKE_C_IDENTIFIER "EMBEDDED_${outputName}" includeGuard)
+    string(TOUPPER ${includeGuard} includeGuard)
+
+    file(WRITE ${OUTPUT}
+"// Generated from ${INPUT} by EmbedClSources.cmake. Do not edit.
+
+#ifndef ${includeGuard}
+#define ${includeGuard}
+
+#include \"hash.h\"
+
+#include <array>
+#include <stdint.h>
+#include <string_view>
+
+
+namespace ${NAMESPACE}
+{
+    inline constexpr std::array<char, ${sourceSizeInBytes}> ${VARIABLE}Bytes =
+    {
+        ${sourceBytes}
+    };
+
+    inline constexpr std::string_view ${VARIABLE}(${VARIABLE}Bytes.data(), ${VARIABLE}Bytes.size());
+
+    inline constexpr uint64_t ${VARIABLE}Hash = hash::Fnv1a(${VARIABLE});
+}
+
+
+#endif // ${includeGuard}
+")
+
+    return()
+endif()
+
+set(EMBED_CL_SOURCES_SCRIPT ${CMAKE_CURRENT_LIST_FILE})
+
+function(embed_cl_sources target)
+    set(embeddedDir ${CMAKE_CURRENT_BINARY_DIR}/Embedded)
+    set(embeddedHeaders)
+
+    foreach(clSource IN LISTS ARGN)
+        get_filename_component(clSourcePath ${clSource} ABSOLUTE)
+        get_filename_component(clSourceStem ${clSource} NAME_WE)
+        set(embeddedHeader ${embeddedDir}/${clSourceStem}.cl.h)
+
+        add_custom_command(OUTPUT ${embeddedHeader}
+                           COMMAND ${CMAKE_COMMAND}
+                                   -DINPUT=${clSourcePath}
+                                   -DOUTPUT=${embeddedHeader}
+                                   -DNAMESPACE=embedded::cl::${clSourceStem}
+                                   -DVARIABLE=source
+                                   -P ${EMBED_CL_SOURCES_SCRIPT}
+                           DEPENDS ${clSourcePath} ${EMBED_CL_SOURCES_SCRIPT}
+                           COMMENT "Embedding OpenCL source ${clSource}"
+                           VERBATIM)
+
+        list(APPEND embeddedHeaders ${embeddedHeader})
+    endforeach()
+
+    target_sources(${target} PRIVATE
+                       ${embeddedHeaders})
+
+    # Public, as the merged tests of a module include its build header too.
+    target_include_directories(${target} PUBLIC
+                                   ${embeddedDir})
+endfunction()
\ No newline at end of file